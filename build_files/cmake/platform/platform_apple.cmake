@@ -321,6 +321,15 @@ if(WITH_OPENVDB)
   set(OPENVDB_DEFINITIONS)
 endif()
 
+if(WITH_ZSTD)
+  set(ZSTD_INCLUDE_DIRS ${LIBDIR}/zstd/include)
+  set(ZSTD_LIBRARIES ${LIBDIR}/zstd/lib/libzstd.a)
+  if(NOT EXISTS ${ZSTD_INCLUDE_DIRS})
+    message(STATUS "Zstd not found in ${LIBDIR}, disabling it")
+    set(WITH_ZSTD OFF)
+  endif()
+endif()
+
 if(WITH_LLVM)
   set(LLVM_ROOT_DIR ${LIBDIR}/llvm)
   if(EXISTS "${LLVM_ROOT_DIR}/bin/llvm-config")
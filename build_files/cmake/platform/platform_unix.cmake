@@ -275,6 +275,14 @@ if(WITH_OPENVDB)
   endif()
 endif()
 
+if(WITH_ZSTD)
+  find_package_wrapper(Zstd)
+  if(NOT ZSTD_FOUND)
+    set(WITH_ZSTD OFF)
+    message(STATUS "Zstd not found, disabling it")
+  endif()
+endif()
+
 if(WITH_ALEMBIC)
   find_package_wrapper(Alembic)
 
@@ -507,6 +507,15 @@ if(WITH_OPENVDB)
   set(OPENVDB_DEFINITIONS -DNOMINMAX)
 endif()
 
+if(WITH_ZSTD)
+  set(ZSTD_INCLUDE_DIRS ${LIBDIR}/zstd/include)
+  set(ZSTD_LIBRARIES ${LIBDIR}/zstd/lib/zstd_static.lib)
+  if(NOT EXISTS ${ZSTD_INCLUDE_DIRS})
+    message(STATUS "Zstd not found in ${LIBDIR}, disabling it")
+    set(WITH_ZSTD OFF)
+  endif()
+endif()
+
 if(WITH_OPENIMAGEDENOISE)
   set(OPENIMAGEDENOISE ${LIBDIR}/OpenImageDenoise)
   set(OPENIMAGEDENOISE_LIBPATH ${LIBDIR}/OpenImageDenoise/lib)
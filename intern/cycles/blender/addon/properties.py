@@ -345,6 +345,34 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         description="Sample all lights (for indirect samples), rather than randomly picking one",
         default=True,
     )
+    use_adaptive_sampling: BoolProperty(
+        name="Adaptive Sampling",
+        description="Automatically stop sampling pixels once their noise level is below the threshold, "
+        "the number of samples acts as the maximum",
+        default=False,
+    )
+    adaptive_threshold: FloatProperty(
+        name="Adaptive Sampling Threshold",
+        description="Noise level at which pixels stop being sampled, lower values give less noise and take longer",
+        min=0.0, max=1.0,
+        default=0.01,
+        precision=4,
+    )
+    adaptive_min_samples: IntProperty(
+        name="Adaptive Min Samples",
+        description="Minimum number of samples of a pixel before it can stop being sampled, "
+        "zero picks a number based on the maximum number of samples",
+        min=0, max=4096,
+        default=0,
+    )
+
+    use_light_tree: BoolProperty(
+        name="Light Tree",
+        description="Pick lights and emissive triangles based on their estimated contribution to the shading point, "
+        "reduces noise in scenes with many lights",
+        default=False,
+    )
+
     light_sampling_threshold: FloatProperty(
         name="Light Sampling Threshold",
         description="Probabilistically terminate light samples when the light contribution is below this threshold (more noise but faster rendering). "
@@ -728,6 +756,25 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         items=enum_texture_limit
     )
 
+    use_texture_cache: BoolProperty(
+        name="Texture Cache",
+        description="Load image tiles on demand at the resolution needed for rendering, "
+        "instead of loading full images into memory (CPU only)",
+        default=False,
+    )
+    texture_cache_size: IntProperty(
+        name="Cache Size",
+        description="Maximum memory in megabytes used by the texture cache",
+        min=16, max=65536,
+        default=1024,
+    )
+    use_texture_cache_tx: BoolProperty(
+        name="Use .tx Files",
+        description="Use tiled and mipmapped .tx files next to images when available, "
+        "otherwise tiles and mipmaps are generated while rendering",
+        default=True,
+    )
+
     ao_bounces: IntProperty(
         name="AO Bounces",
         default=0,
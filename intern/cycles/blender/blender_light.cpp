@@ -39,6 +39,7 @@ void BlenderSync::sync_light(BL::Object &b_parent,
   BL::Light b_light(b_ob.data());
 
   /* Update if either object or light data changed. */
+  const bool is_new = (light_map.find(key) == NULL);
   if (!light_map.add_or_update(&light, b_ob, b_parent, key)) {
     Shader *shader;
     if (!shader_map.add_or_update(&shader, b_light)) {
@@ -48,6 +49,8 @@ void BlenderSync::sync_light(BL::Object &b_parent,
     }
   }
 
+  Light prevlight = *light;
+
   /* type */
   switch (b_light.type()) {
     case BL::Light::type_POINT: {
@@ -155,8 +158,9 @@ void BlenderSync::sync_light(BL::Object &b_parent,
   light->use_transmission = (visibility & PATH_RAY_TRANSMIT) != 0;
   light->use_scatter = (visibility & PATH_RAY_VOLUME_SCATTER) != 0;
 
-  /* tag */
-  light->tag_update(scene);
+  /* tag, recalc flags are also set for changes that don't affect the light */
+  if (is_new || light->modified(prevlight))
+    light->tag_update(scene);
 }
 
 void BlenderSync::sync_background_light(BL::SpaceView3D &b_v3d, bool use_portal)
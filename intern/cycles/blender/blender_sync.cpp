@@ -295,6 +295,16 @@ void BlenderSync::sync_integrator()
   integrator->sample_all_lights_direct = get_boolean(cscene, "sample_all_lights_direct");
   integrator->sample_all_lights_indirect = get_boolean(cscene, "sample_all_lights_indirect");
   integrator->light_sampling_threshold = get_float(cscene, "light_sampling_threshold");
+  integrator->use_light_tree = get_boolean(cscene, "use_light_tree");
+
+  if (get_boolean(cscene, "use_adaptive_sampling")) {
+    integrator->adaptive_threshold = get_float(cscene, "adaptive_threshold");
+    integrator->adaptive_min_samples = get_int(cscene, "adaptive_min_samples");
+  }
+  else {
+    integrator->adaptive_threshold = 0.0f;
+    integrator->adaptive_min_samples = 0;
+  }
 
   int diffuse_samples = get_int(cscene, "diffuse_samples");
   int glossy_samples = get_int(cscene, "glossy_samples");
@@ -335,6 +345,11 @@ void BlenderSync::sync_integrator()
     integrator->ao_bounces = 0;
   }
 
+  /* The light tree is built along with the light distribution. */
+  if (integrator->light_tree_enabled() != previntegrator.light_tree_enabled()) {
+    scene->light_manager->tag_update(scene);
+  }
+
   if (integrator->modified(previntegrator))
     integrator->tag_update(scene);
 }
@@ -661,6 +676,14 @@ vector<Pass> BlenderSync::sync_render_passes(BL::RenderLayer &b_rlay, BL::ViewLa
   }
   RNA_END;
 
+  /* Internal passes for the error estimate and the number of samples of each pixel. */
+  PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
+  if (get_boolean(cscene, "use_adaptive_sampling") &&
+      get_float(cscene, "adaptive_threshold") > 0.0f) {
+    Pass::add(PASS_ADAPTIVE_AUX_BUFFER, passes);
+    Pass::add(PASS_SAMPLE_COUNT, passes);
+  }
+
   return passes;
 }
 
@@ -726,6 +749,10 @@ SceneParams BlenderSync::get_scene_params(BL::Scene &b_scene, bool background)
     params.texture_limit = 0;
   }
 
+  params.texture_cache = RNA_boolean_get(&cscene, "use_texture_cache");
+  params.texture_cache_size = RNA_int_get(&cscene, "texture_cache_size");
+  params.texture_cache_use_tx = RNA_boolean_get(&cscene, "use_texture_cache_tx");
+
   /* TODO(sergey): Once OSL supports per-microarchitecture optimization get
    * rid of this.
    */
@@ -103,7 +103,7 @@ int BVHStackEntry::encodeIdx() const
 BVH::BVH(const BVHParams &params_,
          const vector<Geometry *> &geometry_,
          const vector<Object *> &objects_)
-    : params(params_), geometry(geometry_), objects(objects_)
+    : params(params_), geometry(geometry_), objects(objects_), bounds(BoundBox::empty)
 {
 }
 
@@ -196,11 +196,15 @@ void BVH::build(Progress &progress, Stats *)
 
 void BVH::refit(Progress &progress)
 {
-  progress.set_substatus("Packing BVH primitives");
-  pack_primitives();
-
-  if (progress.get_cancel())
-    return;
+  /* The top level BVH only contains object instances when refit, their primitives are
+   * packed along with the BVH of each geometry. */
+  if (!params.top_level) {
+    progress.set_substatus("Packing BVH primitives");
+    pack_primitives();
+
+    if (progress.get_cancel())
+      return;
+  }
 
   progress.set_substatus("Refitting BVH nodes");
   refit_nodes();
@@ -208,6 +212,12 @@ void BVH::refit(Progress &progress)
 
 void BVH::refit_primitives(int start, int end, BoundBox &bbox, uint &visibility)
 {
+  if (start < 0) {
+    /* Object instance leaf of the top level BVH, packed as ~prim. */
+    start = ~start;
+    end = start + 1;
+  }
+
   /* Refit range of primitives. */
   for (int prim = start; prim < end; prim++) {
     int pidx = pack.prim_index[prim];
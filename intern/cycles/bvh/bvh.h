@@ -86,6 +86,8 @@ class BVH {
   BVHParams params;
   vector<Geometry *> geometry;
   vector<Object *> objects;
+  /* Bounds of the root, set when refitting the BVH2, BVH4 and BVH8 layouts. */
+  BoundBox bounds;
 
   static BVH *create(const BVHParams &params,
                      const vector<Geometry *> &geometry,
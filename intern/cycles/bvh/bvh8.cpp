@@ -406,11 +406,10 @@ void BVH8::pack_nodes(const BVHNode *root)
 
 void BVH8::refit_nodes()
 {
-  assert(!params.top_level);
-
   BoundBox bbox = BoundBox::empty;
   uint visibility = 0;
   refit_node(0, (pack.root_index == -1) ? true : false, bbox, visibility);
+  bounds = bbox;
 }
 
 void BVH8::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
@@ -418,8 +417,11 @@ void BVH8::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
   if (leaf) {
     int4 *data = &pack.leaf_nodes[idx];
     int4 c = data[0];
+    /* Object instance leaves of the top level BVH are packed as ~prim. */
+    const int start = (c.x < 0) ? ~c.x : c.x;
+    const int end = (c.x < 0) ? start + 1 : c.y;
     /* Refit leaf node. */
-    for (int prim = c.x; prim < c.y; prim++) {
+    for (int prim = start; prim < end; prim++) {
       int pidx = pack.prim_index[prim];
       int tob = pack.prim_object[prim];
       Object *ob = objects[tob];
@@ -360,6 +360,12 @@ class Device {
     return NULL;
   }
 
+  /* on-demand texture cache, only for CPU device */
+  virtual void *texture_cache_memory()
+  {
+    return NULL;
+  }
+
   /* load/compile kernels, must be called before adding tasks */
   virtual bool load_kernels(const DeviceRequestedFeatures & /*requested_features*/)
   {
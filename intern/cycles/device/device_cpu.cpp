@@ -34,6 +34,8 @@
 #include "kernel/kernel_types.h"
 #include "kernel/split/kernel_split_data.h"
 #include "kernel/kernel_globals.h"
+#include "kernel/kernel_adaptive_sampling.h"
+#include "kernel/kernel_texture_cache.h"
 
 #include "kernel/filter/filter.h"
 
@@ -174,6 +176,8 @@ class CPUDevice : public Device {
   OSLGlobals osl_globals;
 #endif
 
+  TextureCacheGlobals texture_cache_globals;
+
   bool use_split_kernel;
 
   DeviceRequestedFeatures requested_features;
@@ -290,6 +294,7 @@ class CPUDevice : public Device {
 #ifdef WITH_OSL
     kernel_globals.osl = &osl_globals;
 #endif
+    kernel_globals.texture_cache = NULL;
     use_split_kernel = DebugFlags().cpu.split_kernel;
     if (use_split_kernel) {
       VLOG(1) << "Will be using split kernel.";
@@ -509,6 +514,11 @@ class CPUDevice : public Device {
 #endif
   }
 
+  void *texture_cache_memory()
+  {
+    return &texture_cache_globals;
+  }
+
   void thread_run(DeviceTask *task)
   {
     if (task->type == DeviceTask::RENDER || task->type == DeviceTask::DENOISE)
@@ -858,11 +868,77 @@ class CPUDevice : public Device {
 
       tile.sample = sample + 1;
 
+      if (task.adaptive_sampling.use && task.adaptive_sampling.need_filter(sample)) {
+        const bool stop = adaptive_sampling_filter(kg, tile, sample);
+        if (stop) {
+          /* All pixels of the tile have converged, account for the samples left out. */
+          const int num_progress_samples = end_sample - sample;
+          tile.sample = end_sample;
+          task.update_progress(&tile, tile.w * tile.h * num_progress_samples);
+          break;
+        }
+      }
+
       task.update_progress(&tile, tile.w * tile.h);
     }
     if (use_coverage) {
       coverage.finalize();
     }
+    if (task.adaptive_sampling.use) {
+      adaptive_sampling_post(tile, kg);
+    }
+  }
+
+  /* Mark converged pixels and spread unconverged regions by one pixel in each direction.
+   * Returns true when all pixels of the tile have converged. */
+  bool adaptive_sampling_filter(KernelGlobals *kg, RenderTile &tile, int sample)
+  {
+    WorkTile wtile;
+    wtile.x = tile.x;
+    wtile.y = tile.y;
+    wtile.w = tile.w;
+    wtile.h = tile.h;
+    wtile.offset = tile.offset;
+    wtile.stride = tile.stride;
+    wtile.buffer = (float *)tile.buffer;
+
+    for (int y = tile.y; y < tile.y + tile.h; ++y) {
+      for (int x = tile.x; x < tile.x + tile.w; ++x) {
+        int index = tile.offset + x + y * tile.stride;
+        float *buffer = wtile.buffer + index * kernel_data.film.pass_stride;
+        if (!kernel_adaptive_pixel_is_converged(kg, buffer)) {
+          kernel_do_adaptive_stopping(kg, buffer, sample + 1);
+        }
+      }
+    }
+
+    bool any = false;
+    for (int y = tile.y; y < tile.y + tile.h; ++y) {
+      any |= kernel_do_adaptive_filter_x(kg, y, &wtile);
+    }
+    for (int x = tile.x; x < tile.x + tile.w; ++x) {
+      any |= kernel_do_adaptive_filter_y(kg, x, &wtile);
+    }
+    return !any;
+  }
+
+  /* Scale pixels which stopped early, so all pixels of the tile can be normalized by the same
+   * number of samples. */
+  void adaptive_sampling_post(const RenderTile &tile, KernelGlobals *kg)
+  {
+    float *render_buffer = (float *)tile.buffer;
+    for (int y = tile.y; y < tile.y + tile.h; y++) {
+      for (int x = tile.x; x < tile.x + tile.w; x++) {
+        int index = tile.offset + x + y * tile.stride;
+        float *buffer = render_buffer + index * kernel_data.film.pass_stride;
+        float *sample_count = buffer + kernel_data.film.pass_sample_count;
+        if (*sample_count < (float)tile.sample) {
+          const float sample_multiplier = (float)tile.sample / max(1.0f, *sample_count);
+          kernel_adaptive_post_adjust(kg, buffer, sample_multiplier);
+          *sample_count = (float)tile.sample;
+        }
+      }
+    }
   }
 
   void denoise(DenoisingTask &denoising, RenderTile &tile)
@@ -1087,6 +1163,7 @@ class CPUDevice : public Device {
     }
     kg.decoupled_volume_steps_index = 0;
     kg.coverage_asset = kg.coverage_object = kg.coverage_material = NULL;
+    kg.texture_cache = (texture_cache_globals.texture_system) ? &texture_cache_globals : NULL;
 #ifdef WITH_OSL
     OSLShader::thread_init(&kg, &kernel_globals, &osl_globals);
 #endif
@@ -136,4 +136,20 @@ void DeviceTask::update_progress(RenderTile *rtile, int pixel_samples)
   }
 }
 
+/* Adaptive Sampling */
+
+AdaptiveSampling::AdaptiveSampling() : use(false), adaptive_step(0), min_samples(0)
+{
+}
+
+/* Tell if the convergence of the pixels is to be checked after the given sample index. This
+ * happens every adaptive_step samples, once the minimum number of samples has been rendered. */
+bool AdaptiveSampling::need_filter(int sample) const
+{
+  if (sample >= min_samples) {
+    return (sample & (adaptive_step - 1)) == (adaptive_step - 1);
+  }
+  return false;
+}
+
 CCL_NAMESPACE_END
@@ -223,7 +223,7 @@ ccl_device_noinline_cpu float3 indirect_primitive_emission(
   {
     /* multiple importance sampling, get triangle light pdf,
      * and compute weight with respect to BSDF pdf */
-    float pdf = triangle_light_pdf(kg, sd, t);
+    float pdf = triangle_light_pdf(kg, sd, t, light_tree_use_for_mis(kg, path_flag));
     float mis_weight = power_heuristic(bsdf_pdf, pdf);
 
     return L * mis_weight;
@@ -241,10 +241,12 @@ ccl_device_noinline_cpu void indirect_lamp_emission(KernelGlobals *kg,
                                                     Ray *ray,
                                                     float3 throughput)
 {
+  const bool use_light_tree = light_tree_use_for_mis(kg, state->flag);
+
   for (int lamp = 0; lamp < kernel_data.integrator.num_all_lights; lamp++) {
     LightSample ls ccl_optional_struct_init;
 
-    if (!lamp_light_eval(kg, lamp, ray->P, ray->D, ray->t, &ls))
+    if (!lamp_light_eval(kg, lamp, ray->P, ray->D, ray->t, use_light_tree, &ls))
       continue;
 
 #ifdef __PASSES__
@@ -333,7 +335,8 @@ ccl_device_noinline_cpu float3 indirect_background(KernelGlobals *kg,
   if (!(state->flag & PATH_RAY_MIS_SKIP) && res_x) {
     /* multiple importance sampling, get background light pdf for ray
      * direction, and compute weight with respect to BSDF pdf */
-    float pdf = background_light_pdf(kg, ray->P, ray->D);
+    float pdf = background_light_pdf(
+        kg, ray->P, ray->D, light_tree_use_for_mis(kg, state->flag));
     float mis_weight = power_heuristic(state->ray_pdf, pdf);
 
     return L * mis_weight;
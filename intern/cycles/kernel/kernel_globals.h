@@ -45,6 +45,8 @@ struct OSLThreadData;
 struct OSLShadingSystem;
 #  endif
 
+struct TextureCacheGlobals;
+
 typedef unordered_map<float, float> CoverageMap;
 
 struct Intersection;
@@ -64,6 +66,9 @@ typedef struct KernelGlobals {
   OSLThreadData *osl_tdata;
 #  endif
 
+  /* Images paged in on demand by the texture cache, NULL when not used. */
+  TextureCacheGlobals *texture_cache;
+
   /* **** Run-time data ****  */
 
   /* Heap-allocated storage for transparent shadows intersections. */
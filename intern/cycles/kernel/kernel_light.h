@@ -496,8 +496,16 @@ background_light_sample(KernelGlobals *kg, float3 P, float randu, float randv, f
   return D;
 }
 
-ccl_device float background_light_pdf(KernelGlobals *kg, float3 P, float3 direction)
+ccl_device float background_light_pdf(KernelGlobals *kg,
+                                      float3 P,
+                                      float3 direction,
+                                      bool use_light_tree)
 {
+  /* Probability of picking the background light, the light tree picks it uniformly among the
+   * lights outside of the tree. */
+  const float pdf_lights = use_light_tree ? kernel_data.integrator.pdf_infinite_lights :
+                                            kernel_data.integrator.pdf_lights;
+
   /* Probability of sampling portals instead of the map. */
   float portal_sampling_pdf = kernel_data.integrator.portal_pdf;
 
@@ -511,7 +519,7 @@ ccl_device float background_light_pdf(KernelGlobals *kg, float3 P, float3 direct
        * If map sampling is possible, it would be used instead,
        * otherwise fallback sampling is used. */
       if (portal_sampling_pdf == 1.0f) {
-        return kernel_data.integrator.pdf_lights / M_4PI_F;
+        return pdf_lights / M_4PI_F;
       }
       else {
         /* Force map sampling. */
@@ -523,14 +531,19 @@ ccl_device float background_light_pdf(KernelGlobals *kg, float3 P, float3 direct
     /* Evaluate PDF of sampling this direction by map sampling. */
     map_pdf = background_map_pdf(kg, direction) * (1.0f - portal_sampling_pdf);
   }
-  return (portal_pdf + map_pdf) * kernel_data.integrator.pdf_lights;
+  return (portal_pdf + map_pdf) * pdf_lights;
 }
 #endif
 
 /* Regular Light */
 
-ccl_device_inline bool lamp_light_sample(
-    KernelGlobals *kg, int lamp, float randu, float randv, float3 P, LightSample *ls)
+ccl_device_inline bool lamp_light_sample(KernelGlobals *kg,
+                                         int lamp,
+                                         float randu,
+                                         float randv,
+                                         float3 P,
+                                         float select_pdf,
+                                         LightSample *ls)
 {
   const ccl_global KernelLight *klight = &kernel_tex_fetch(__lights, lamp);
   LightType type = (LightType)klight->type;
@@ -645,13 +658,18 @@ ccl_device_inline bool lamp_light_sample(
     }
   }
 
-  ls->pdf *= kernel_data.integrator.pdf_lights;
+  ls->pdf *= select_pdf;
 
   return (ls->pdf > 0.0f);
 }
 
-ccl_device bool lamp_light_eval(
-    KernelGlobals *kg, int lamp, float3 P, float3 D, float t, LightSample *ls)
+ccl_device bool lamp_light_eval(KernelGlobals *kg,
+                                int lamp,
+                                float3 P,
+                                float3 D,
+                                float t,
+                                bool use_light_tree,
+                                LightSample *ls)
 {
   const ccl_global KernelLight *klight = &kernel_tex_fetch(__lights, lamp);
   LightType type = (LightType)klight->type;
@@ -783,7 +801,12 @@ ccl_device bool lamp_light_eval(
     return false;
   }
 
-  ls->pdf *= kernel_data.integrator.pdf_lights;
+  if (use_light_tree) {
+    ls->pdf *= light_tree_lamp_pdf(kg, lamp, P);
+  }
+  else {
+    ls->pdf *= kernel_data.integrator.pdf_lights;
+  }
 
   return true;
 }
@@ -822,12 +845,11 @@ ccl_device_inline bool triangle_world_space_vertices(
   return has_motion;
 }
 
-ccl_device_inline float triangle_light_pdf_area(KernelGlobals *kg,
-                                                const float3 Ng,
+ccl_device_inline float triangle_light_pdf_area(const float3 Ng,
                                                 const float3 I,
-                                                float t)
+                                                float t,
+                                                float pdf)
 {
-  float pdf = kernel_data.integrator.pdf_triangles;
   float cos_pi = fabsf(dot(Ng, I));
 
   if (cos_pi == 0.0f)
@@ -836,7 +858,10 @@ ccl_device_inline float triangle_light_pdf_area(KernelGlobals *kg,
   return t * t * pdf / cos_pi;
 }
 
-ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *sd, float t)
+ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg,
+                                                ShaderData *sd,
+                                                float t,
+                                                bool use_light_tree)
 {
   /* A naive heuristic to decide between costly solid angle sampling
    * and simple area sampling, comparing the distance to the triangle plane
@@ -852,6 +877,22 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
   const float3 N = cross(e0, e1);
   const float distance_to_plane = fabsf(dot(N, sd->I * t)) / dot(N, N);
 
+  /* Area of the center frame vertices, from which the light distribution was computed. */
+  float area_pre = 0.5f * len(N);
+  if (has_motion) {
+    float3 V_pre[3];
+    triangle_world_space_vertices(kg, sd->object, sd->prim, -1.0f, V_pre);
+    area_pre = triangle_area(V_pre[0], V_pre[1], V_pre[2]);
+  }
+
+  float pdf_triangles = kernel_data.integrator.pdf_triangles;
+  if (use_light_tree) {
+    /* Turn the probability of picking this triangle into a density over its area. */
+    const float3 Px = sd->P + sd->I * t;
+    const float tree_pdf = light_tree_triangle_pdf(kg, sd->object, sd->prim, Px);
+    pdf_triangles = (area_pre != 0.0f) ? tree_pdf / area_pre : 0.0f;
+  }
+
   if (longest_edge_squared > distance_to_plane * distance_to_plane) {
     /* sd contains the point on the light source
      * calculate Px, the point that we're shading */
@@ -874,21 +915,12 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
       return 0.0f;
     }
     else {
-      float area = 1.0f;
-      if (has_motion) {
-        /* get the center frame vertices, this is what the PDF was calculated from */
-        triangle_world_space_vertices(kg, sd->object, sd->prim, -1.0f, V);
-        area = triangle_area(V[0], V[1], V[2]);
-      }
-      else {
-        area = 0.5f * len(N);
-      }
-      const float pdf = area * kernel_data.integrator.pdf_triangles;
+      const float pdf = area_pre * pdf_triangles;
       return pdf / solid_angle;
     }
   }
   else {
-    float pdf = triangle_light_pdf_area(kg, sd->Ng, sd->I, t);
+    float pdf = triangle_light_pdf_area(sd->Ng, sd->I, t, pdf_triangles);
     if (has_motion) {
       const float area = 0.5f * len(N);
       if (UNLIKELY(area == 0.0f)) {
@@ -897,8 +929,6 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
       /* scale the PDF.
        * area = the area the sample was taken from
        * area_pre = the are from which pdf_triangles was calculated from */
-      triangle_world_space_vertices(kg, sd->object, sd->prim, -1.0f, V);
-      const float area_pre = triangle_area(V[0], V[1], V[2]);
       pdf = pdf * area_pre / area;
     }
     return pdf;
@@ -911,6 +941,8 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg,
                                                   float randu,
                                                   float randv,
                                                   float time,
+                                                  bool use_light_tree,
+                                                  float tree_pdf,
                                                   LightSample *ls,
                                                   const float3 P)
 {
@@ -930,6 +962,21 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg,
   ls->Ng = safe_normalize_len(N0, &Nl);
   float area = 0.5f * Nl;
 
+  /* Area of the center frame vertices, from which the light distribution was computed. */
+  float area_pre = area;
+  if (has_motion) {
+    float3 V_pre[3];
+    triangle_world_space_vertices(kg, object, prim, -1.0f, V_pre);
+    area_pre = triangle_area(V_pre[0], V_pre[1], V_pre[2]);
+  }
+
+  /* With the light tree, turn the probability of picking this triangle into a density over its
+   * area. */
+  float pdf_triangles = kernel_data.integrator.pdf_triangles;
+  if (use_light_tree) {
+    pdf_triangles = (area_pre != 0.0f) ? tree_pdf / area_pre : 0.0f;
+  }
+
   /* flip normal if necessary */
   const int object_flag = kernel_tex_fetch(__object_flag, object);
   if (object_flag & SD_OBJECT_NEGATIVE_SCALE_APPLIED) {
@@ -1031,12 +1078,7 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg,
       return;
     }
     else {
-      if (has_motion) {
-        /* get the center frame vertices, this is what the PDF was calculated from */
-        triangle_world_space_vertices(kg, object, prim, -1.0f, V);
-        area = triangle_area(V[0], V[1], V[2]);
-      }
-      const float pdf = area * kernel_data.integrator.pdf_triangles;
+      const float pdf = area_pre * pdf_triangles;
       ls->pdf = pdf / solid_angle;
     }
   }
@@ -1050,13 +1092,11 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg,
     ls->P = u * V[0] + v * V[1] + t * V[2];
     /* compute incoming direction, distance and pdf */
     ls->D = normalize_len(ls->P - P, &ls->t);
-    ls->pdf = triangle_light_pdf_area(kg, ls->Ng, -ls->D, ls->t);
+    ls->pdf = triangle_light_pdf_area(ls->Ng, -ls->D, ls->t, pdf_triangles);
     if (has_motion && area != 0.0f) {
       /* scale the PDF.
        * area = the area the sample was taken from
        * area_pre = the are from which pdf_triangles was calculated from */
-      triangle_world_space_vertices(kg, object, prim, -1.0f, V);
-      const float area_pre = triangle_area(V[0], V[1], V[2]);
       ls->pdf = ls->pdf * area_pre / area;
     }
     ls->u = u;
@@ -1116,11 +1156,23 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
                                       float time,
                                       float3 P,
                                       int bounce,
+                                      bool use_light_tree,
                                       LightSample *ls)
 {
+  float select_pdf = kernel_data.integrator.pdf_lights;
+
   if (lamp < 0) {
     /* sample index */
-    int index = light_distribution_sample(kg, &randu);
+    int index;
+    if (use_light_tree) {
+      index = light_tree_select(kg, P, &randu, &select_pdf);
+      if (index < 0) {
+        return false;
+      }
+    }
+    else {
+      index = light_distribution_sample(kg, &randu);
+    }
 
     /* fetch light data */
     const ccl_global KernelLightDistribution *kdistribution = &kernel_tex_fetch(
@@ -1131,7 +1183,8 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
       int object = kdistribution->mesh_light.object_id;
       int shader_flag = kdistribution->mesh_light.shader_flag;
 
-      triangle_light_sample(kg, prim, object, randu, randv, time, ls, P);
+      triangle_light_sample(
+          kg, prim, object, randu, randv, time, use_light_tree, select_pdf, ls, P);
       ls->shader |= shader_flag;
       return (ls->pdf > 0.0f);
     }
@@ -1143,7 +1196,7 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
     return false;
   }
 
-  return lamp_light_sample(kg, lamp, randu, randv, P, ls);
+  return lamp_light_sample(kg, lamp, randu, randv, P, select_pdf, ls);
 }
 
 ccl_device_inline int light_select_num_samples(KernelGlobals *kg, int index)
@@ -0,0 +1,200 @@
+/*
+ * Copyright 2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KERNEL_LIGHT_TREE_H__
+#define __KERNEL_LIGHT_TREE_H__
+
+CCL_NAMESPACE_BEGIN
+
+/* Light Tree
+ *
+ * Lamps and emissive triangles are organized in a bounding volume hierarchy. Starting from the
+ * root, a child is picked proportionally to an estimate of its contribution to the shading
+ * point, based on the energy, distance and orientation of the emitters in it. See "Importance
+ * Sampling of Many Lights with Adaptive Tree Splitting" by Conty Estevez and Kulla.
+ *
+ * Distant and background lights are not part of the tree. They are picked uniformly with the
+ * remaining probability, which is stored in pdf_infinite_lights. */
+
+ccl_device float light_tree_node_importance(KernelGlobals *kg, float3 P, int index)
+{
+  const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, index);
+
+  if (knode->energy == 0.0f) {
+    return 0.0f;
+  }
+
+  const float3 bbox_min = make_float3(knode->bbox_min[0], knode->bbox_min[1], knode->bbox_min[2]);
+  const float3 bbox_max = make_float3(knode->bbox_max[0], knode->bbox_max[1], knode->bbox_max[2]);
+  const float3 centroid = 0.5f * (bbox_min + bbox_max);
+  const float radius_squared = 0.25f * len_squared(bbox_max - bbox_min);
+  const float distance_squared = len_squared(P - centroid);
+
+  float cos_theta_prime = 1.0f;
+  if (knode->theta_o < M_PI_F && distance_squared > radius_squared) {
+    /* Smallest angle between the direction to P and any emitter normal, widened by the angle
+     * the bounding sphere subtends at P. */
+    const float3 axis = make_float3(knode->axis[0], knode->axis[1], knode->axis[2]);
+    const float cos_theta = dot(axis, (P - centroid) / sqrtf(distance_squared));
+    const float theta = fast_acosf(clamp(cos_theta, -1.0f, 1.0f));
+    const float theta_u = fast_asinf(sqrtf(radius_squared / distance_squared));
+    const float theta_prime = max(theta - knode->theta_o - theta_u, 0.0f);
+
+    if (theta_prime >= knode->theta_e) {
+      return 0.0f;
+    }
+    cos_theta_prime = fast_cosf(theta_prime);
+  }
+
+  /* Inside the bounds the distance is clamped to avoid the singularity, the epsilon only matters
+   * for a single point light coinciding with P. */
+  return knode->energy * cos_theta_prime / max(max(distance_squared, radius_squared), 1e-10f);
+}
+
+/* Probability of picking the left child of an inner node. */
+ccl_device float light_tree_left_pdf(KernelGlobals *kg, float3 P, int index, int right_child)
+{
+  const float importance_left = light_tree_node_importance(kg, P, index + 1);
+  const float importance_right = light_tree_node_importance(kg, P, right_child);
+  const float importance = importance_left + importance_right;
+
+  return (importance > 0.0f) ? importance_left / importance : -1.0f;
+}
+
+/* Walk down the tree to pick an emitter for shading point P. Returns its index in the light
+ * distribution, or -1 when no emitter in the tree can light P. The random number is rescaled so
+ * it can be reused for sampling a point on the emitter. */
+ccl_device int light_tree_sample(KernelGlobals *kg, float3 P, float *randu, float *pdf)
+{
+  int index = 0;
+  *pdf = 1.0f;
+
+  for (;;) {
+    const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, index);
+
+    if (knode->emitter >= 0) {
+      return knode->emitter;
+    }
+
+    const float pdf_left = light_tree_left_pdf(kg, P, index, knode->right_child);
+    if (pdf_left < 0.0f) {
+      return -1;
+    }
+
+    if (*randu < pdf_left) {
+      *randu = *randu / pdf_left;
+      *pdf *= pdf_left;
+      index = index + 1;
+    }
+    else {
+      const float pdf_right = 1.0f - pdf_left;
+      *randu = min((*randu - pdf_left) / pdf_right, 1.0f);
+      *pdf *= pdf_right;
+      index = knode->right_child;
+    }
+  }
+}
+
+/* Probability of light_tree_sample picking the emitter stored in the given leaf, walking up
+ * from the leaf to the root. */
+ccl_device float light_tree_leaf_pdf(KernelGlobals *kg, float3 P, int index)
+{
+  float pdf = 1.0f;
+
+  while (index != 0) {
+    const int parent = kernel_tex_fetch(__light_tree_nodes, index).parent;
+    const int right_child = kernel_tex_fetch(__light_tree_nodes, parent).right_child;
+    const float pdf_left = light_tree_left_pdf(kg, P, parent, right_child);
+
+    if (pdf_left < 0.0f) {
+      return 0.0f;
+    }
+
+    pdf *= (index == parent + 1) ? pdf_left : 1.0f - pdf_left;
+    index = parent;
+  }
+
+  return pdf;
+}
+
+/* Pick an emitter from the light tree, or one of the distant and background lights. Returns
+ * its index in the light distribution, or -1 if nothing was picked. */
+ccl_device int light_tree_select(KernelGlobals *kg, float3 P, float *randu, float *pdf)
+{
+  const float pdf_light_tree = kernel_data.integrator.pdf_light_tree;
+
+  if (*randu < pdf_light_tree) {
+    *randu = *randu / pdf_light_tree;
+    const int emitter = light_tree_sample(kg, P, randu, pdf);
+    *pdf *= pdf_light_tree;
+    return emitter;
+  }
+
+  const int num_infinite_lights = kernel_data.integrator.num_infinite_lights;
+  if (num_infinite_lights == 0) {
+    return -1;
+  }
+
+  const float r = (*randu - pdf_light_tree) / (1.0f - pdf_light_tree) * num_infinite_lights;
+  const int i = clamp((int)r, 0, num_infinite_lights - 1);
+  *randu = clamp(r - i, 0.0f, 1.0f);
+  *pdf = kernel_data.integrator.pdf_infinite_lights;
+
+  return (int)kernel_tex_fetch(__light_tree_infinite_lights, i);
+}
+
+/* Whether the direct light of the vertex a ray with the given path flag was traced from was
+ * sampled with the light tree, and so whether multiple importance sampling of emission hit by
+ * the ray should use the light tree pdfs. */
+ccl_device_inline bool light_tree_use_for_mis(KernelGlobals *kg, int path_flag)
+{
+  return kernel_data.integrator.use_light_tree && !(path_flag & PATH_RAY_ALL_LIGHTS);
+}
+
+/* Probability of light_tree_select picking the given lamp for shading point P. */
+ccl_device float light_tree_lamp_pdf(KernelGlobals *kg, int lamp, float3 P)
+{
+  const int emitter = kernel_data.integrator.num_distribution -
+                      kernel_data.integrator.num_all_lights + lamp;
+  const uint leaf = kernel_tex_fetch(__light_tree_emitter_to_leaf, emitter);
+
+  if (leaf == ~0u) {
+    return kernel_data.integrator.pdf_infinite_lights;
+  }
+
+  return kernel_data.integrator.pdf_light_tree * light_tree_leaf_pdf(kg, P, (int)leaf);
+}
+
+/* Probability of light_tree_select picking the given triangle for shading point P. */
+ccl_device float light_tree_triangle_pdf(KernelGlobals *kg, int object, int prim, float3 P)
+{
+  const int offset = (int)kernel_tex_fetch(__light_tree_object_to_triangle, object) + prim;
+  if (offset < 0) {
+    return 0.0f;
+  }
+
+  const uint emitter = kernel_tex_fetch(__light_tree_triangle_to_emitter, offset);
+  if (emitter == ~0u) {
+    return 0.0f;
+  }
+
+  const uint leaf = kernel_tex_fetch(__light_tree_emitter_to_leaf, emitter);
+  return kernel_data.integrator.pdf_light_tree * light_tree_leaf_pdf(kg, P, (int)leaf);
+}
+
+CCL_NAMESPACE_END
+
+#endif /* __KERNEL_LIGHT_TREE_H__ */
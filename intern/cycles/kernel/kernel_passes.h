@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include "kernel/kernel_adaptive_sampling.h"
 #include "kernel/kernel_id_passes.h"
 
 CCL_NAMESPACE_BEGIN
@@ -357,6 +358,19 @@ ccl_device_inline void kernel_write_result(KernelGlobals *kg,
 
   kernel_write_light_passes(kg, buffer, L);
 
+  if (kernel_data.film.pass_adaptive_aux_buffer) {
+    /* Every other sample is accumulated with twice the weight, for the error estimate of
+     * adaptive sampling. */
+    if (sample & 1) {
+      kernel_write_pass_float4(
+          buffer + kernel_data.film.pass_adaptive_aux_buffer,
+          make_float4(L_sum.x * 2.0f, L_sum.y * 2.0f, L_sum.z * 2.0f, 0.0f));
+    }
+  }
+  if (kernel_data.film.pass_sample_count) {
+    kernel_write_pass_float(buffer + kernel_data.film.pass_sample_count, 1.0f);
+  }
+
 #ifdef __DENOISING_FEATURES__
   if (kernel_data.film.pass_denoising_data) {
 #  ifdef __SHADOW_TRICKS__
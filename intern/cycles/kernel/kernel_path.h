@@ -30,6 +30,7 @@
 #include "kernel/kernel_write_passes.h"
 #include "kernel/kernel_accumulate.h"
 #include "kernel/kernel_shader.h"
+#include "kernel/kernel_light_tree.h"
 #include "kernel/kernel_light.h"
 #include "kernel/kernel_passes.h"
 
@@ -656,6 +657,11 @@ ccl_device void kernel_path_trace(
 
   buffer += index * pass_stride;
 
+  if (kernel_data.film.pass_adaptive_aux_buffer &&
+      kernel_adaptive_pixel_is_converged(kg, buffer)) {
+    return;
+  }
+
   /* Initialize random numbers and sample ray. */
   uint rng_hash;
   Ray ray;
@@ -523,6 +523,11 @@ ccl_device void kernel_branched_path_trace(
 
   buffer += index * pass_stride;
 
+  if (kernel_data.film.pass_adaptive_aux_buffer &&
+      kernel_adaptive_pixel_is_converged(kg, buffer)) {
+    return;
+  }
+
   /* initialize random numbers and ray */
   uint rng_hash;
   Ray ray;
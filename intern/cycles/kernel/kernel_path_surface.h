@@ -47,6 +47,15 @@ ccl_device_noinline_cpu void kernel_branched_path_surface_connect_light(
     }
   }
 
+  /* Emission hit by the next ray weights its multiple importance sampling with the pdfs of the
+   * strategy used here. */
+  if (sample_all_lights) {
+    state->flag |= PATH_RAY_ALL_LIGHTS;
+  }
+  else {
+    state->flag &= ~PATH_RAY_ALL_LIGHTS;
+  }
+
   for (int i = 0; i < num_lights; i++) {
     /* sample one light at random */
     int num_samples = 1;
@@ -98,9 +107,20 @@ ccl_device_noinline_cpu void kernel_branched_path_surface_connect_light(
           light_u = 0.5f * light_u;
         }
 
+        /* The light tree can't restrict sampling to triangle lights, nor does sampling one lamp
+         * at a time use it. */
         LightSample ls ccl_optional_struct_init;
         const int lamp = is_lamp ? i : -1;
-        if (light_sample(kg, lamp, light_u, light_v, sd->time, sd->P, state->bounce, &ls)) {
+        const bool use_light_tree = kernel_data.integrator.use_light_tree && !sample_all_lights;
+        if (light_sample(kg,
+                         lamp,
+                         light_u,
+                         light_v,
+                         sd->time,
+                         sd->P,
+                         state->bounce,
+                         use_light_tree,
+                         &ls)) {
           /* The sampling probability returned by lamp_light_sample assumes that all lights were
            * sampled. However, this code only samples lamps, so if the scene also had mesh lights,
            * the real probability is twice as high. */
@@ -241,7 +261,15 @@ ccl_device_inline void kernel_path_surface_connect_light(KernelGlobals *kg,
     path_state_rng_2D(kg, state, PRNG_LIGHT_U, &light_u, &light_v);
 
     LightSample ls ccl_optional_struct_init;
-    if (light_sample(kg, -1, light_u, light_v, sd->time, sd->P, state->bounce, &ls)) {
+    if (light_sample(kg,
+                     -1,
+                     light_u,
+                     light_v,
+                     sd->time,
+                     sd->P,
+                     state->bounce,
+                     kernel_data.integrator.use_light_tree,
+                     &ls)) {
       float terminate = path_state_rng_light_termination(kg, state);
       has_emission = direct_emission(
           kg, sd, emission_sd, &ls, state, &light_ray, &L_light, &is_lamp, terminate);
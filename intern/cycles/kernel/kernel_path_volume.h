@@ -38,12 +38,23 @@ ccl_device_inline void kernel_path_volume_connect_light(KernelGlobals *kg,
   light_ray.time = sd->time;
 #    endif
 
+  /* A shadow catcher surface may have sampled all lights before. */
+  state->flag &= ~PATH_RAY_ALL_LIGHTS;
+
   if (kernel_data.integrator.use_direct_light) {
     float light_u, light_v;
     path_state_rng_2D(kg, state, PRNG_LIGHT_U, &light_u, &light_v);
 
     LightSample ls ccl_optional_struct_init;
-    if (light_sample(kg, -1, light_u, light_v, sd->time, sd->P, state->bounce, &ls)) {
+    if (light_sample(kg,
+                     -1,
+                     light_u,
+                     light_v,
+                     sd->time,
+                     sd->P,
+                     state->bounce,
+                     kernel_data.integrator.use_light_tree,
+                     &ls)) {
       float terminate = path_state_rng_light_termination(kg, state);
       has_emission = direct_emission(
           kg, sd, emission_sd, &ls, state, &light_ray, &L_light, &is_lamp, terminate);
@@ -149,6 +160,15 @@ ccl_device void kernel_branched_path_volume_connect_light(KernelGlobals *kg,
     }
   }
 
+  /* Emission hit by the next ray weights its multiple importance sampling with the pdfs of the
+   * strategy used here. */
+  if (sample_all_lights) {
+    state->flag |= PATH_RAY_ALL_LIGHTS;
+  }
+  else {
+    state->flag &= ~PATH_RAY_ALL_LIGHTS;
+  }
+
   for (int i = 0; i < num_lights; ++i) {
     /* sample one light at random */
     int num_samples = 1;
@@ -201,9 +221,20 @@ ccl_device void kernel_branched_path_volume_connect_light(KernelGlobals *kg,
           light_u = 0.5f * light_u;
         }
 
+        /* The light tree can't restrict sampling to triangle lights, nor does sampling one lamp
+         * at a time use it. */
         LightSample ls ccl_optional_struct_init;
         const int lamp = is_lamp ? i : -1;
-        light_sample(kg, lamp, light_u, light_v, sd->time, ray->P, state->bounce, &ls);
+        const bool use_light_tree = kernel_data.integrator.use_light_tree && !sample_all_lights;
+        light_sample(kg,
+                     lamp,
+                     light_u,
+                     light_v,
+                     sd->time,
+                     ray->P,
+                     state->bounce,
+                     use_light_tree,
+                     &ls);
 
         /* sample position on volume segment */
         float rphase = path_branched_rng_1D(
@@ -225,7 +256,15 @@ ccl_device void kernel_branched_path_volume_connect_light(KernelGlobals *kg,
 
         if (result == VOLUME_PATH_SCATTERED) {
           /* todo: split up light_sample so we don't have to call it again with new position */
-          if (light_sample(kg, lamp, light_u, light_v, sd->time, sd->P, state->bounce, &ls)) {
+          if (light_sample(kg,
+                           lamp,
+                           light_u,
+                           light_v,
+                           sd->time,
+                           sd->P,
+                           state->bounce,
+                           use_light_tree,
+                           &ls)) {
             if (double_pdf) {
               ls.pdf *= 2.0f;
             }
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KERNEL_TEXTURE_CACHE_H__
+#define __KERNEL_TEXTURE_CACHE_H__
+
+#include <OpenImageIO/texture.h>
+
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Texture Cache Globals
+ *
+ * Images rendered through the texture cache are not loaded into device memory. Tiles of their
+ * mipmap levels are instead read on demand by the OpenImageIO texture system, which evicts them
+ * again to stay below a fixed memory ceiling. Only used by the CPU device.
+ */
+
+struct TextureCacheImage {
+  TextureCacheImage() : handle(NULL), num_channels(0)
+  {
+  }
+
+  /* File the tiles are read from, the image itself or its .tx file. */
+  OIIO::ustring filename;
+  OIIO::TextureSystem::TextureHandle *handle;
+  /* Interpolation and extension of the image node. */
+  OIIO::TextureOpt options;
+  /* Number of channels to look up, 1 for single channel images and 4 otherwise. */
+  int num_channels;
+};
+
+struct TextureCacheGlobals {
+  TextureCacheGlobals() : texture_system(NULL)
+  {
+  }
+
+  /* Owned by the image manager, NULL when the texture cache is not used. */
+  OIIO::TextureSystem *texture_system;
+
+  /* Indexed by flat image slot. Images without handle are stored in device memory. */
+  vector<TextureCacheImage> images;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __KERNEL_TEXTURE_CACHE_H__ */
@@ -65,6 +65,11 @@ KERNEL_TEX(KernelLightDistribution, __light_distribution)
 KERNEL_TEX(KernelLight, __lights)
 KERNEL_TEX(float2, __light_background_marginal_cdf)
 KERNEL_TEX(float2, __light_background_conditional_cdf)
+KERNEL_TEX(KernelLightTreeNode, __light_tree_nodes)
+KERNEL_TEX(uint, __light_tree_emitter_to_leaf)
+KERNEL_TEX(uint, __light_tree_infinite_lights)
+KERNEL_TEX(uint, __light_tree_object_to_triangle)
+KERNEL_TEX(uint, __light_tree_triangle_to_emitter)
 
 /* particles */
 KERNEL_TEX(KernelParticle, __particles)
@@ -327,7 +327,10 @@ enum PathRayFlag {
   /* Ray is to be terminated. */
   PATH_RAY_TERMINATE = (PATH_RAY_TERMINATE_IMMEDIATE | PATH_RAY_TERMINATE_AFTER_TRANSPARENT),
   /* Path and shader is being evaluated for direct lighting emission. */
-  PATH_RAY_EMISSION = (1 << 22)
+  PATH_RAY_EMISSION = (1 << 22),
+  /* Direct light was sampled from all lights without the light tree, so multiple importance
+   * sampling of emission hit by this ray uses the light distribution pdfs. */
+  PATH_RAY_ALL_LIGHTS = (1 << 23)
 };
 
 /* Closure Label */
@@ -375,6 +378,8 @@ typedef enum PassType {
   PASS_CRYPTOMATTE,
   PASS_AOV_COLOR,
   PASS_AOV_VALUE,
+  PASS_ADAPTIVE_AUX_BUFFER,
+  PASS_SAMPLE_COUNT,
   PASS_CATEGORY_MAIN_END = 31,
 
   PASS_MIST = 32,
@@ -1251,8 +1256,8 @@ typedef struct KernelFilm {
 
   int pass_aov_color;
   int pass_aov_value;
-  int pad1;
-  int pad2;
+  int pass_adaptive_aux_buffer;
+  int pass_sample_count;
 
   /* XYZ to rendering color space transform. float4 instead of float3 to
    * ensure consistent padding/alignment across devices. */
@@ -1366,7 +1371,18 @@ typedef struct KernelIntegrator {
 
   int max_closures;
 
-  int pad1;
+  /* adaptive sampling */
+  float adaptive_threshold;
+  int adaptive_min_samples;
+  int adaptive_step;
+
+  /* light tree */
+  int use_light_tree;
+  float pdf_light_tree;
+  int num_infinite_lights;
+  float pdf_infinite_lights;
+
+  int pad1, pad2;
 } KernelIntegrator;
 static_assert_align(KernelIntegrator, 16);
 
@@ -1535,6 +1551,25 @@ typedef struct KernelLightDistribution {
 } KernelLightDistribution;
 static_assert_align(KernelLightDistribution, 16);
 
+typedef struct KernelLightTreeNode {
+  /* Bounds and total energy of the emitters in the subtree. */
+  float bbox_min[3];
+  float energy;
+  float bbox_max[3];
+  /* Emitter normals are within theta_o of the axis, and emit light within
+   * theta_e of their normal. */
+  float theta_o;
+  float axis[3];
+  float theta_e;
+  /* The first child of an inner node directly follows it. Leaves store the
+   * index of their emitter in the light distribution, inner nodes -1. */
+  int right_child;
+  int emitter;
+  int parent;
+  int pad;
+} KernelLightTreeNode;
+static_assert_align(KernelLightTreeNode, 16);
+
 typedef struct KernelParticle {
   int index;
   float age;
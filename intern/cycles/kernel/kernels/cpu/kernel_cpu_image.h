@@ -19,6 +19,16 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Look up an image paged in on demand by the texture cache, using the UV footprint to select the
+ * mipmap level. Returns false if the image is stored in device memory instead. */
+bool kernel_tex_image_cache_lookup(TextureCacheGlobals *texture_cache,
+                                   int id,
+                                   float x,
+                                   float y,
+                                   float2 duv_dx,
+                                   float2 duv_dy,
+                                   float4 *result);
+
 /* Make template functions private so symbols don't conflict between kernels with different
  * instruction sets. */
 namespace {
@@ -470,8 +480,16 @@ template<typename T> struct TextureInterpolator {
 #undef SET_CUBIC_SPLINE_WEIGHTS
 };
 
-ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, float y)
+ccl_device float4 kernel_tex_image_interp(
+    KernelGlobals *kg, int id, float x, float y, float2 duv_dx, float2 duv_dy)
 {
+  if (kg->texture_cache) {
+    float4 r;
+    if (kernel_tex_image_cache_lookup(kg->texture_cache, id, x, y, duv_dx, duv_dy, &r)) {
+      return r;
+    }
+  }
+
   const TextureInfo &info = kernel_tex_fetch(__texture_info, id);
 
   switch (kernel_tex_type(id)) {
@@ -498,6 +516,11 @@ ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, fl
   }
 }
 
+ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, float y)
+{
+  return kernel_tex_image_interp(kg, id, x, y, make_float2(0.0f, 0.0f), make_float2(0.0f, 0.0f));
+}
+
 ccl_device float4 kernel_tex_image_interp_3d(
     KernelGlobals *kg, int id, float x, float y, float z, InterpolationType interp)
 {
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Texture cache lookups, shared by the CPU kernels of all instruction sets. Kept in a separate
+ * file so that the OpenImageIO headers are not pulled into the kernels. */
+
+#include "kernel/kernel_texture_cache.h"
+
+#include "util/util_texture.h"
+
+CCL_NAMESPACE_BEGIN
+
+bool kernel_tex_image_cache_lookup(TextureCacheGlobals *texture_cache,
+                                   int id,
+                                   float x,
+                                   float y,
+                                   float2 duv_dx,
+                                   float2 duv_dy,
+                                   float4 *result)
+{
+  if (id < 0 || id >= (int)texture_cache->images.size()) {
+    return false;
+  }
+
+  const TextureCacheImage &image = texture_cache->images[id];
+  if (image.handle == NULL) {
+    return false;
+  }
+
+  OIIO::TextureSystem *ts = texture_cache->texture_system;
+  OIIO::TextureOpt options = image.options;
+  float rgba[4];
+
+  /* Images in device memory are stored bottom to top, flip to match the OpenImageIO texture
+   * coordinates. A zero footprint selects the highest resolution mipmap level. */
+  if (!ts->texture(image.handle,
+                   ts->get_perthread_info(),
+                   options,
+                   x,
+                   1.0f - y,
+                   duv_dx.x,
+                   -duv_dx.y,
+                   duv_dy.x,
+                   -duv_dy.y,
+                   image.num_channels,
+                   rgba)) {
+    *result = make_float4(
+        TEX_IMAGE_MISSING_R, TEX_IMAGE_MISSING_G, TEX_IMAGE_MISSING_B, TEX_IMAGE_MISSING_A);
+    return true;
+  }
+
+  if (image.num_channels == 1) {
+    *result = make_float4(rgba[0], rgba[0], rgba[0], 1.0f);
+  }
+  else {
+    *result = make_float4(rgba[0], rgba[1], rgba[2], rgba[3]);
+  }
+
+  return true;
+}
+
+CCL_NAMESPACE_END
@@ -86,7 +86,15 @@ ccl_device void kernel_direct_lighting(KernelGlobals *kg,
       float terminate = path_state_rng_light_termination(kg, state);
 
       LightSample ls;
-      if (light_sample(kg, -1, light_u, light_v, sd->time, sd->P, state->bounce, &ls)) {
+      if (light_sample(kg,
+                       -1,
+                       light_u,
+                       light_v,
+                       sd->time,
+                       sd->P,
+                       state->bounce,
+                       kernel_data.integrator.use_light_tree,
+                       &ls)) {
         Ray light_ray;
         light_ray.time = sd->time;
 
@@ -265,6 +265,7 @@ GeometryManager::GeometryManager()
 {
   need_update = true;
   need_flags_update = true;
+  need_update_scene_bvh = true;
 }
 
 GeometryManager::~GeometryManager()
@@ -498,7 +499,7 @@ static void update_attribute_element_size(Geometry *geom,
       *attr_float2_size += size;
     }
     else if (mattr->type == TypeDesc::TypeMatrix) {
-      *attr_float3_size += size * 4;
+      *attr_float3_size += size * 3;
     }
     else {
       *attr_float3_size += size;
@@ -631,125 +632,170 @@ static void update_attribute_element_offset(Geometry *geom,
   }
 }
 
-void GeometryManager::device_update_attributes(Device *device,
-                                               DeviceScene *dscene,
-                                               Scene *scene,
-                                               Progress &progress)
+/* Number of elements in each of the attribute arrays, or offsets into them. */
+struct AttributeArrayOffsets {
+  AttributeArrayOffsets() : attr_float(0), attr_float2(0), attr_float3(0), attr_uchar4(0)
+  {
+  }
+
+  size_t attr_float;
+  size_t attr_float2;
+  size_t attr_float3;
+  size_t attr_uchar4;
+};
+
+static void geometry_gather_attributes(Scene *scene,
+                                       Geometry *geom,
+                                       AttributeRequestSet *attributes,
+                                       AttributeArrayOffsets *sizes)
 {
-  progress.set_status("Updating Mesh", "Computing attributes");
+  /* as meshes may have multiple shaders assigned, this merges the requested
+   * attributes that have been set per shader by the shader manager */
+  scene->need_global_attributes(*attributes);
 
-  /* gather per mesh requested attributes. as meshes may have multiple
-   * shaders assigned, this merges the requested attributes that have
-   * been set per shader by the shader manager */
-  vector<AttributeRequestSet> geom_attributes(scene->geometry.size());
+  foreach (Shader *shader, geom->used_shaders) {
+    attributes->add(shader->attributes);
+  }
 
-  for (size_t i = 0; i < scene->geometry.size(); i++) {
-    Geometry *geom = scene->geometry[i];
+  foreach (AttributeRequest &req, attributes->requests) {
+    Attribute *attr = geom->attributes.find(req);
 
-    scene->need_global_attributes(geom_attributes[i]);
+    update_attribute_element_size(geom,
+                                  attr,
+                                  ATTR_PRIM_GEOMETRY,
+                                  &sizes->attr_float,
+                                  &sizes->attr_float2,
+                                  &sizes->attr_float3,
+                                  &sizes->attr_uchar4);
 
-    foreach (Shader *shader, geom->used_shaders) {
-      geom_attributes[i].add(shader->attributes);
+    if (geom->type == Geometry::MESH) {
+      Mesh *mesh = static_cast<Mesh *>(geom);
+      Attribute *subd_attr = mesh->subd_attributes.find(req);
+
+      update_attribute_element_size(mesh,
+                                    subd_attr,
+                                    ATTR_PRIM_SUBD,
+                                    &sizes->attr_float,
+                                    &sizes->attr_float2,
+                                    &sizes->attr_float3,
+                                    &sizes->attr_uchar4);
     }
   }
+}
 
-  /* mesh attribute are stored in a single array per data type. here we fill
-   * those arrays, and set the offset and element type to create attribute
-   * maps next */
-
-  /* Pre-allocate attributes to avoid arrays re-allocation which would
-   * take 2x of overall attribute memory usage.
-   */
-  size_t attr_float_size = 0;
-  size_t attr_float2_size = 0;
-  size_t attr_float3_size = 0;
-  size_t attr_uchar4_size = 0;
-  for (size_t i = 0; i < scene->geometry.size(); i++) {
-    Geometry *geom = scene->geometry[i];
-    AttributeRequestSet &attributes = geom_attributes[i];
-    foreach (AttributeRequest &req, attributes.requests) {
-      Attribute *attr = geom->attributes.find(req);
-
-      update_attribute_element_size(geom,
+static void geometry_fill_attributes(DeviceScene *dscene,
+                                     Geometry *geom,
+                                     AttributeRequestSet *attributes,
+                                     AttributeArrayOffsets offsets,
+                                     Progress *progress)
+{
+  /* todo: we now store std and name attributes from requests even if
+   * they actually refer to the same mesh attributes, optimize */
+  foreach (AttributeRequest &req, attributes->requests) {
+    Attribute *attr = geom->attributes.find(req);
+    update_attribute_element_offset(geom,
+                                    dscene->attributes_float,
+                                    offsets.attr_float,
+                                    dscene->attributes_float2,
+                                    offsets.attr_float2,
+                                    dscene->attributes_float3,
+                                    offsets.attr_float3,
+                                    dscene->attributes_uchar4,
+                                    offsets.attr_uchar4,
                                     attr,
                                     ATTR_PRIM_GEOMETRY,
-                                    &attr_float_size,
-                                    &attr_float2_size,
-                                    &attr_float3_size,
-                                    &attr_uchar4_size);
+                                    req.type,
+                                    req.desc);
 
-      if (geom->type == Geometry::MESH) {
-        Mesh *mesh = static_cast<Mesh *>(geom);
-        Attribute *subd_attr = mesh->subd_attributes.find(req);
+    if (geom->type == Geometry::MESH) {
+      Mesh *mesh = static_cast<Mesh *>(geom);
+      Attribute *subd_attr = mesh->subd_attributes.find(req);
 
-        update_attribute_element_size(mesh,
+      update_attribute_element_offset(mesh,
+                                      dscene->attributes_float,
+                                      offsets.attr_float,
+                                      dscene->attributes_float2,
+                                      offsets.attr_float2,
+                                      dscene->attributes_float3,
+                                      offsets.attr_float3,
+                                      dscene->attributes_uchar4,
+                                      offsets.attr_uchar4,
                                       subd_attr,
                                       ATTR_PRIM_SUBD,
-                                      &attr_float_size,
-                                      &attr_float2_size,
-                                      &attr_float3_size,
-                                      &attr_uchar4_size);
-      }
+                                      req.subd_type,
+                                      req.subd_desc);
     }
-  }
 
-  dscene->attributes_float.alloc(attr_float_size);
-  dscene->attributes_float2.alloc(attr_float2_size);
-  dscene->attributes_float3.alloc(attr_float3_size);
-  dscene->attributes_uchar4.alloc(attr_uchar4_size);
-
-  size_t attr_float_offset = 0;
-  size_t attr_float2_offset = 0;
-  size_t attr_float3_offset = 0;
-  size_t attr_uchar4_offset = 0;
+    if (progress->get_cancel())
+      return;
+  }
+}
 
-  /* Fill in attributes. */
-  for (size_t i = 0; i < scene->geometry.size(); i++) {
-    Geometry *geom = scene->geometry[i];
-    AttributeRequestSet &attributes = geom_attributes[i];
+void GeometryManager::device_update_attributes(Device *device,
+                                               DeviceScene *dscene,
+                                               Scene *scene,
+                                               Progress &progress)
+{
+  progress.set_status("Updating Mesh", "Computing attributes");
 
-    /* todo: we now store std and name attributes from requests even if
-     * they actually refer to the same mesh attributes, optimize */
-    foreach (AttributeRequest &req, attributes.requests) {
-      Attribute *attr = geom->attributes.find(req);
-      update_attribute_element_offset(geom,
-                                      dscene->attributes_float,
-                                      attr_float_offset,
-                                      dscene->attributes_float2,
-                                      attr_float2_offset,
-                                      dscene->attributes_float3,
-                                      attr_float3_offset,
-                                      dscene->attributes_uchar4,
-                                      attr_uchar4_offset,
-                                      attr,
-                                      ATTR_PRIM_GEOMETRY,
-                                      req.type,
-                                      req.desc);
+  /* gather per mesh requested attributes and the number of elements
+   * they take in each of the attribute arrays */
+  const size_t num_geometry = scene->geometry.size();
+  vector<AttributeRequestSet> geom_attributes(num_geometry);
+  vector<AttributeArrayOffsets> geom_offsets(num_geometry);
+
+  {
+    TaskPool pool;
+    for (size_t i = 0; i < num_geometry; i++) {
+      pool.push(function_bind(&geometry_gather_attributes,
+                              scene,
+                              scene->geometry[i],
+                              &geom_attributes[i],
+                              &geom_offsets[i]));
+    }
+    pool.wait_work();
+  }
 
-      if (geom->type == Geometry::MESH) {
-        Mesh *mesh = static_cast<Mesh *>(geom);
-        Attribute *subd_attr = mesh->subd_attributes.find(req);
-
-        update_attribute_element_offset(mesh,
-                                        dscene->attributes_float,
-                                        attr_float_offset,
-                                        dscene->attributes_float2,
-                                        attr_float2_offset,
-                                        dscene->attributes_float3,
-                                        attr_float3_offset,
-                                        dscene->attributes_uchar4,
-                                        attr_uchar4_offset,
-                                        subd_attr,
-                                        ATTR_PRIM_SUBD,
-                                        req.subd_type,
-                                        req.subd_desc);
-      }
+  /* mesh attribute are stored in a single array per data type. the start
+   * of every mesh in those arrays is the sum of the sizes of all meshes
+   * before it, so the arrays can be filled in parallel.
+   *
+   * Pre-allocate attributes to avoid arrays re-allocation which would
+   * take 2x of overall attribute memory usage.
+   */
+  AttributeArrayOffsets total_size;
+  for (size_t i = 0; i < num_geometry; i++) {
+    const AttributeArrayOffsets size = geom_offsets[i];
+    geom_offsets[i] = total_size;
+
+    total_size.attr_float += size.attr_float;
+    total_size.attr_float2 += size.attr_float2;
+    total_size.attr_float3 += size.attr_float3;
+    total_size.attr_uchar4 += size.attr_uchar4;
+  }
 
-      if (progress.get_cancel())
-        return;
+  dscene->attributes_float.alloc(total_size.attr_float);
+  dscene->attributes_float2.alloc(total_size.attr_float2);
+  dscene->attributes_float3.alloc(total_size.attr_float3);
+  dscene->attributes_uchar4.alloc(total_size.attr_uchar4);
+
+  /* Fill in attributes, every mesh writes to its own range of the arrays. */
+  {
+    TaskPool pool;
+    for (size_t i = 0; i < num_geometry; i++) {
+      pool.push(function_bind(&geometry_fill_attributes,
+                              dscene,
+                              scene->geometry[i],
+                              &geom_attributes[i],
+                              geom_offsets[i],
+                              &progress));
     }
+    pool.wait_work();
   }
 
+  if (progress.get_cancel())
+    return;
+
   /* create attribute lookup maps */
   if (scene->shader_manager->use_osl())
     update_osl_attributes(device, scene, geom_attributes);
@@ -843,6 +889,36 @@ void GeometryManager::mesh_calc_offset(Scene *scene)
   }
 }
 
+static void mesh_pack_triangles(Scene *scene,
+                                Mesh *mesh,
+                                const vector<uint> *tri_prim_index,
+                                uint *tri_shader,
+                                float4 *vnormal,
+                                uint4 *tri_vindex,
+                                uint *tri_patch,
+                                float2 *tri_patch_uv)
+{
+  mesh->pack_shaders(scene, &tri_shader[mesh->prim_offset]);
+  mesh->pack_normals(&vnormal[mesh->vert_offset]);
+  mesh->pack_verts(*tri_prim_index,
+                   &tri_vindex[mesh->prim_offset],
+                   &tri_patch[mesh->prim_offset],
+                   &tri_patch_uv[mesh->vert_offset],
+                   mesh->vert_offset,
+                   mesh->prim_offset);
+}
+
+static void mesh_pack_patches(Mesh *mesh, uint *patch_data)
+{
+  mesh->pack_patches(
+      &patch_data[mesh->patch_offset], mesh->vert_offset, mesh->face_offset, mesh->corner_offset);
+
+  if (mesh->patch_table) {
+    mesh->patch_table->copy_adjusting_offsets(&patch_data[mesh->patch_table_offset],
+                                              mesh->patch_table_offset);
+  }
+}
+
 void GeometryManager::device_update_mesh(
     Device *, DeviceScene *dscene, Scene *scene, bool for_displacement, Progress &progress)
 {
@@ -917,21 +993,25 @@ void GeometryManager::device_update_mesh(
     uint *tri_patch = dscene->tri_patch.alloc(tri_size);
     float2 *tri_patch_uv = dscene->tri_patch_uv.alloc(vert_size);
 
+    /* Meshes write to disjoint ranges of the arrays, so they are packed in parallel. */
+    TaskPool pool;
     foreach (Geometry *geom, scene->geometry) {
       if (geom->type == Geometry::MESH) {
-        Mesh *mesh = static_cast<Mesh *>(geom);
-        mesh->pack_shaders(scene, &tri_shader[mesh->prim_offset]);
-        mesh->pack_normals(&vnormal[mesh->vert_offset]);
-        mesh->pack_verts(tri_prim_index,
-                         &tri_vindex[mesh->prim_offset],
-                         &tri_patch[mesh->prim_offset],
-                         &tri_patch_uv[mesh->vert_offset],
-                         mesh->vert_offset,
-                         mesh->prim_offset);
-        if (progress.get_cancel())
-          return;
+        pool.push(function_bind(&mesh_pack_triangles,
+                                scene,
+                                static_cast<Mesh *>(geom),
+                                &tri_prim_index,
+                                tri_shader,
+                                vnormal,
+                                tri_vindex,
+                                tri_patch,
+                                tri_patch_uv));
       }
     }
+    pool.wait_work();
+
+    if (progress.get_cancel())
+      return;
 
     /* vertex coordinates */
     progress.set_status("Updating Mesh", "Copying Mesh to device");
@@ -949,17 +1029,22 @@ void GeometryManager::device_update_mesh(
     float4 *curve_keys = dscene->curve_keys.alloc(curve_key_size);
     float4 *curves = dscene->curves.alloc(curve_size);
 
+    TaskPool pool;
     foreach (Geometry *geom, scene->geometry) {
       if (geom->type == Geometry::HAIR) {
         Hair *hair = static_cast<Hair *>(geom);
-        hair->pack_curves(scene,
-                          &curve_keys[hair->curvekey_offset],
-                          &curves[hair->prim_offset],
-                          hair->curvekey_offset);
-        if (progress.get_cancel())
-          return;
+        pool.push(function_bind(&Hair::pack_curves,
+                                hair,
+                                scene,
+                                &curve_keys[hair->curvekey_offset],
+                                &curves[hair->prim_offset],
+                                hair->curvekey_offset));
       }
     }
+    pool.wait_work();
+
+    if (progress.get_cancel())
+      return;
 
     dscene->curve_keys.copy_to_device();
     dscene->curves.copy_to_device();
@@ -970,23 +1055,16 @@ void GeometryManager::device_update_mesh(
 
     uint *patch_data = dscene->patches.alloc(patch_size);
 
+    TaskPool pool;
     foreach (Geometry *geom, scene->geometry) {
       if (geom->type == Geometry::MESH) {
-        Mesh *mesh = static_cast<Mesh *>(geom);
-        mesh->pack_patches(&patch_data[mesh->patch_offset],
-                           mesh->vert_offset,
-                           mesh->face_offset,
-                           mesh->corner_offset);
-
-        if (mesh->patch_table) {
-          mesh->patch_table->copy_adjusting_offsets(&patch_data[mesh->patch_table_offset],
-                                                    mesh->patch_table_offset);
-        }
-
-        if (progress.get_cancel())
-          return;
+        pool.push(function_bind(&mesh_pack_patches, static_cast<Mesh *>(geom), patch_data));
       }
     }
+    pool.wait_work();
+
+    if (progress.get_cancel())
+      return;
 
     dscene->patches.copy_to_device();
   }
@@ -1009,14 +1087,8 @@ void GeometryManager::device_update_mesh(
   }
 }
 
-void GeometryManager::device_update_bvh(Device *device,
-                                        DeviceScene *dscene,
-                                        Scene *scene,
-                                        Progress &progress)
+static BVHParams scene_bvh_params(Device *device, DeviceScene *dscene, Scene *scene)
 {
-  /* bvh build */
-  progress.set_status("Updating Scene BVH", "Building");
-
   BVHParams bparams;
   bparams.top_level = true;
   bparams.bvh_layout = BVHParams::best_bvh_layout(scene->params.bvh_layout,
@@ -1029,6 +1101,18 @@ void GeometryManager::device_update_bvh(Device *device,
   bparams.bvh_type = scene->params.bvh_type;
   bparams.curve_flags = dscene->data.curve.curveflags;
   bparams.curve_subdivisions = dscene->data.curve.subdivisions;
+  return bparams;
+}
+
+void GeometryManager::device_update_bvh(Device *device,
+                                        DeviceScene *dscene,
+                                        Scene *scene,
+                                        Progress &progress)
+{
+  /* bvh build */
+  progress.set_status("Updating Scene BVH", "Building");
+
+  BVHParams bparams = scene_bvh_params(device, dscene, scene);
 
   VLOG(1) << "Using " << bvh_layout_name(bparams.bvh_layout) << " layout.";
 
@@ -1108,6 +1192,132 @@ void GeometryManager::device_update_bvh(Device *device,
   bvh->copy_to_device(progress, dscene);
 
   delete bvh;
+
+  scene_bvh_geometry.clear();
+  scene_bvh_traceable.clear();
+  foreach (Object *object, scene->objects) {
+    scene_bvh_geometry.push_back(object->geometry);
+    scene_bvh_traceable.push_back(object->is_traceable());
+  }
+}
+
+bool GeometryManager::scene_bvh_can_refit(Device *device, DeviceScene *dscene, Scene *scene)
+{
+  /* Refitting lowers the quality of the BVH, so only do it for interactive updates. Motion
+   * changes the time ranges of the instances, which are not refit. */
+  if (scene->params.bvh_type != SceneParams::BVH_DYNAMIC ||
+      scene->need_motion() != Scene::MOTION_NONE) {
+    return false;
+  }
+
+  /* Embree and OptiX keep their own scene BVH. */
+  const BVHLayout bvh_layout = BVHParams::best_bvh_layout(scene->params.bvh_layout,
+                                                          device->get_bvh_layout_mask());
+  if (!(bvh_layout == BVH_LAYOUT_BVH2 || bvh_layout == BVH_LAYOUT_BVH4 ||
+        bvh_layout == BVH_LAYOUT_BVH8) ||
+      bvh_layout != dscene->data.bvh.bvh_layout) {
+    return false;
+  }
+
+  /* Leaves reference objects by index, and the instanced BVH nodes of their geometry. */
+  if (scene->objects.empty() || scene->objects.size() != scene_bvh_geometry.size()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < scene->objects.size(); i++) {
+    if (scene->objects[i]->geometry != scene_bvh_geometry[i]) {
+      return false;
+    }
+  }
+
+  foreach (Geometry *geom, scene->geometry) {
+    if (geom->need_update) {
+      return false;
+    }
+
+    foreach (Shader *shader, geom->used_shaders) {
+      if (shader->need_update_geometry) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+/* Needs up to date object bounds. */
+bool GeometryManager::scene_bvh_traceable_changed(Scene *scene)
+{
+  for (size_t i = 0; i < scene->objects.size(); i++) {
+    if (scene->objects[i]->is_traceable() != scene_bvh_traceable[i]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Returns false when the refit BVH does not match a rebuilt one, the arrays on the device are
+ * not updated then. */
+bool GeometryManager::device_refit_bvh(Device *device,
+                                       DeviceScene *dscene,
+                                       Scene *scene,
+                                       Progress &progress)
+{
+  progress.set_status("Updating Scene BVH", "Refitting");
+
+  BVH *bvh = BVH::create(scene_bvh_params(device, dscene, scene), scene->geometry, scene->objects);
+  PackedBVH &pack = bvh->pack;
+
+  /* Refit the packed arrays in place, without copying them. */
+  pack.root_index = dscene->data.bvh.root;
+  dscene->bvh_nodes.give_data(pack.nodes);
+  dscene->bvh_leaf_nodes.give_data(pack.leaf_nodes);
+  dscene->prim_index.give_data(pack.prim_index);
+  dscene->prim_type.give_data(pack.prim_type);
+  dscene->prim_object.give_data(pack.prim_object);
+
+  bvh->refit(progress);
+
+  progress.set_status("Updating Scene BVH", "Copying BVH to device");
+
+  dscene->bvh_nodes.steal_data(pack.nodes);
+  dscene->bvh_leaf_nodes.steal_data(pack.leaf_nodes);
+  dscene->prim_index.steal_data(pack.prim_index);
+  dscene->prim_type.steal_data(pack.prim_type);
+  dscene->prim_object.steal_data(pack.prim_object);
+
+  /* A rebuilt BVH bounds exactly the traceable objects. */
+  BoundBox bounds = BoundBox::empty;
+  foreach (Object *object, scene->objects) {
+    if (object->is_traceable()) {
+      bounds.grow(object->bounds);
+    }
+  }
+
+  const bool bounds_match = (bvh->bounds.min == bounds.min && bvh->bounds.max == bounds.max);
+  if (progress.get_cancel() || !bounds_match) {
+    delete bvh;
+    return false;
+  }
+
+  if (dscene->bvh_nodes.size()) {
+    dscene->bvh_nodes.copy_to_device();
+  }
+  if (dscene->bvh_leaf_nodes.size()) {
+    dscene->bvh_leaf_nodes.copy_to_device();
+  }
+  if (dscene->prim_index.size()) {
+    dscene->prim_index.copy_to_device();
+  }
+  if (dscene->prim_type.size()) {
+    dscene->prim_type.copy_to_device();
+  }
+  if (dscene->prim_object.size()) {
+    dscene->prim_object.copy_to_device();
+  }
+
+  delete bvh;
+  return true;
 }
 
 void GeometryManager::device_update_preprocess(Device *device, Scene *scene, Progress &progress)
@@ -1219,54 +1429,104 @@ void GeometryManager::device_update_volume_images(Device *device, Scene *scene,
   pool.wait_work();
 }
 
+static void mesh_update_normals(Scene *scene, Mesh *mesh)
+{
+  mesh->add_face_normals();
+  mesh->add_vertex_normals();
+
+  if (mesh->need_attribute(scene, ATTR_STD_POSITION_UNDISPLACED)) {
+    mesh->add_undisplaced();
+  }
+}
+
 void GeometryManager::device_update(Device *device,
                                     DeviceScene *dscene,
                                     Scene *scene,
                                     Progress &progress)
 {
-  if (!need_update)
+  if (!need_update && !need_update_scene_bvh)
     return;
 
   VLOG(1) << "Total " << scene->geometry.size() << " meshes.";
 
-  bool true_displacement_used = false;
-  size_t total_tess_needed = 0;
+  UpdateTimeStats *update_stats = &scene->update_stats->geometry;
+  update_stats->clear();
 
-  foreach (Geometry *geom, scene->geometry) {
-    foreach (Shader *shader, geom->used_shaders) {
-      if (shader->need_update_geometry)
-        geom->need_update = true;
+  /* Only objects changed, keep the packed geometry and attributes and refit the scene BVH. */
+  if (!need_update && scene_bvh_can_refit(device, dscene, scene)) {
+    VLOG(1) << "Refitting scene BVH of " << scene->objects.size() << " objects.";
+
+    {
+      ScopedUpdateTimer timer(update_stats, "Object bounds");
+
+      foreach (Object *object, scene->objects) {
+        object->compute_bounds(false);
+      }
     }
 
-    if (geom->need_update && geom->type == Geometry::MESH) {
-      Mesh *mesh = static_cast<Mesh *>(geom);
+    /* Objects which became empty or non-empty add or remove leaves. */
+    bool refit = false;
+    if (!scene_bvh_traceable_changed(scene)) {
+      ScopedUpdateTimer timer(update_stats, "Scene BVH refit");
 
-      /* Update normals. */
-      mesh->add_face_normals();
-      mesh->add_vertex_normals();
+      refit = device_refit_bvh(device, dscene, scene, progress);
+      if (progress.get_cancel())
+        return;
+    }
 
-      if (mesh->need_attribute(scene, ATTR_STD_POSITION_UNDISPLACED)) {
-        mesh->add_undisplaced();
-      }
+    if (refit) {
+      /* Objects were packed again, restore their offsets into the attribute and patch arrays. */
+      scene->object_manager->device_update_mesh_offsets(device, dscene, scene);
 
-      /* Test if we need tessellation. */
-      if (mesh->subdivision_type != Mesh::SUBDIVISION_NONE && mesh->num_subd_verts == 0 &&
-          mesh->subd_params) {
-        total_tess_needed++;
-      }
+      VLOG(2) << "Geometry update statistics:\n" << update_stats->full_report();
+
+      need_update_scene_bvh = false;
+      return;
+    }
+
+    VLOG(1) << "Scene BVH can not be refit, rebuilding it.";
+  }
+
+  bool true_displacement_used = false;
+  size_t total_tess_needed = 0;
+
+  {
+    ScopedUpdateTimer timer(update_stats, "Normals");
 
-      /* Test if we need displacement. */
-      if (mesh->has_true_displacement()) {
-        true_displacement_used = true;
+    /* Update normals, every mesh only touches its own attributes. */
+    TaskPool pool;
+    foreach (Geometry *geom, scene->geometry) {
+      foreach (Shader *shader, geom->used_shaders) {
+        if (shader->need_update_geometry)
+          geom->need_update = true;
       }
 
-      if (progress.get_cancel())
-        return;
+      if (geom->need_update && geom->type == Geometry::MESH) {
+        Mesh *mesh = static_cast<Mesh *>(geom);
+
+        pool.push(function_bind(&mesh_update_normals, scene, mesh));
+
+        /* Test if we need tessellation. */
+        if (mesh->subdivision_type != Mesh::SUBDIVISION_NONE && mesh->num_subd_verts == 0 &&
+            mesh->subd_params) {
+          total_tess_needed++;
+        }
+
+        /* Test if we need displacement. */
+        if (mesh->has_true_displacement()) {
+          true_displacement_used = true;
+        }
+      }
     }
+    pool.wait_work();
+
+    if (progress.get_cancel())
+      return;
   }
 
   /* Tessellate meshes that are using subdivision */
   if (total_tess_needed) {
+    ScopedUpdateTimer timer(update_stats, "Tessellation");
     Camera *dicing_camera = scene->dicing_camera;
     dicing_camera->update(scene);
 
@@ -1303,6 +1563,7 @@ void GeometryManager::device_update(Device *device,
   /* Update images needed for true displacement. */
   bool old_need_object_flags_update = false;
   if (true_displacement_used) {
+    ScopedUpdateTimer timer(update_stats, "Displacement images");
     VLOG(1) << "Updating images used for true displacement.";
     device_update_displacement_images(device, scene, progress);
     old_need_object_flags_update = scene->object_manager->need_flags_update;
@@ -1312,16 +1573,24 @@ void GeometryManager::device_update(Device *device,
   /* Device update. */
   device_free(device, dscene);
 
-  mesh_calc_offset(scene);
+  {
+    ScopedUpdateTimer timer(update_stats, "Mesh offsets");
+    mesh_calc_offset(scene);
+  }
+
   if (true_displacement_used) {
+    ScopedUpdateTimer timer(update_stats, "Displacement mesh packing");
     device_update_mesh(device, dscene, scene, true, progress);
   }
   if (progress.get_cancel())
     return;
 
-  device_update_attributes(device, dscene, scene, progress);
-  if (progress.get_cancel())
-    return;
+  {
+    ScopedUpdateTimer timer(update_stats, "Attributes");
+    device_update_attributes(device, dscene, scene, progress);
+    if (progress.get_cancel())
+      return;
+  }
 
   /* Update displacement. */
   bool displacement_done = false;
@@ -1329,26 +1598,31 @@ void GeometryManager::device_update(Device *device,
   BVHLayout bvh_layout = BVHParams::best_bvh_layout(scene->params.bvh_layout,
                                                     device->get_bvh_layout_mask());
 
-  foreach (Geometry *geom, scene->geometry) {
-    if (geom->need_update) {
-      if (geom->type == Geometry::MESH) {
-        Mesh *mesh = static_cast<Mesh *>(geom);
-        if (displace(device, dscene, scene, mesh, progress)) {
-          displacement_done = true;
+  {
+    ScopedUpdateTimer timer(update_stats, "Displacement");
+
+    foreach (Geometry *geom, scene->geometry) {
+      if (geom->need_update) {
+        if (geom->type == Geometry::MESH) {
+          Mesh *mesh = static_cast<Mesh *>(geom);
+          if (displace(device, dscene, scene, mesh, progress)) {
+            displacement_done = true;
+          }
         }
-      }
 
-      if (geom->need_build_bvh(bvh_layout)) {
-        num_bvh++;
+        if (geom->need_build_bvh(bvh_layout)) {
+          num_bvh++;
+        }
       }
-    }
 
-    if (progress.get_cancel())
-      return;
+      if (progress.get_cancel())
+        return;
+    }
   }
 
   /* Device re-update after displacement. */
   if (displacement_done) {
+    ScopedUpdateTimer timer(update_stats, "Attributes after displacement");
     device_free(device, dscene);
 
     device_update_attributes(device, dscene, scene, progress);
@@ -1356,22 +1630,26 @@ void GeometryManager::device_update(Device *device,
       return;
   }
 
-  TaskPool pool;
+  {
+    ScopedUpdateTimer timer(update_stats, "Object BVH");
 
-  size_t i = 0;
-  foreach (Geometry *geom, scene->geometry) {
-    if (geom->need_update) {
-      pool.push(function_bind(
-          &Geometry::compute_bvh, geom, device, dscene, &scene->params, &progress, i, num_bvh));
-      if (geom->need_build_bvh(bvh_layout)) {
-        i++;
+    TaskPool pool;
+
+    size_t i = 0;
+    foreach (Geometry *geom, scene->geometry) {
+      if (geom->need_update) {
+        pool.push(function_bind(
+            &Geometry::compute_bvh, geom, device, dscene, &scene->params, &progress, i, num_bvh));
+        if (geom->need_build_bvh(bvh_layout)) {
+          i++;
+        }
       }
     }
-  }
 
-  TaskPool::Summary summary;
-  pool.wait_work(&summary);
-  VLOG(2) << "Objects BVH build pool statistics:\n" << summary.full_report();
+    TaskPool::Summary summary;
+    pool.wait_work(&summary);
+    VLOG(2) << "Objects BVH build pool statistics:\n" << summary.full_report();
+  }
 
   foreach (Shader *shader, scene->shaders) {
     shader->need_update_geometry = false;
@@ -1381,23 +1659,37 @@ void GeometryManager::device_update(Device *device,
   bool motion_blur = need_motion == Scene::MOTION_BLUR;
 
   /* Update objects. */
-  vector<Object *> volume_objects;
-  foreach (Object *object, scene->objects) {
-    object->compute_bounds(motion_blur);
+  {
+    ScopedUpdateTimer timer(update_stats, "Object bounds");
+
+    foreach (Object *object, scene->objects) {
+      object->compute_bounds(motion_blur);
+    }
   }
 
   if (progress.get_cancel())
     return;
 
-  device_update_bvh(device, dscene, scene, progress);
-  if (progress.get_cancel())
-    return;
+  {
+    ScopedUpdateTimer timer(update_stats, "Scene BVH");
 
-  device_update_mesh(device, dscene, scene, false, progress);
-  if (progress.get_cancel())
-    return;
+    device_update_bvh(device, dscene, scene, progress);
+    if (progress.get_cancel())
+      return;
+  }
+
+  {
+    ScopedUpdateTimer timer(update_stats, "Mesh packing");
+
+    device_update_mesh(device, dscene, scene, false, progress);
+    if (progress.get_cancel())
+      return;
+  }
+
+  VLOG(2) << "Geometry update statistics:\n" << update_stats->full_report();
 
   need_update = false;
+  need_update_scene_bvh = false;
 
   if (true_displacement_used) {
     /* Re-tag flags for update, so they're re-evaluated
@@ -1438,6 +1730,8 @@ void GeometryManager::device_free(Device *device, DeviceScene *dscene)
 
   /* Signal for shaders like displacement not to do ray tracing. */
   dscene->data.bvh.bvh_layout = BVH_LAYOUT_NONE;
+  scene_bvh_geometry.clear();
+  scene_bvh_traceable.clear();
 
 #ifdef WITH_OSL
   OSLGlobals *og = (OSLGlobals *)device->osl_memory();
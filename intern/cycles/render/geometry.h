@@ -147,6 +147,9 @@ class GeometryManager {
   /* Update Flags */
   bool need_update;
   bool need_flags_update;
+  /* Objects moved or changed visibility. The scene BVH needs an update, the packed geometry
+   * stays valid unless need_update is set too. */
+  bool need_update_scene_bvh;
 
   /* Constructor/Destructor */
   GeometryManager();
@@ -195,9 +198,18 @@ class GeometryManager {
 
   void device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress &progress);
 
+  bool scene_bvh_can_refit(Device *device, DeviceScene *dscene, Scene *scene);
+  bool scene_bvh_traceable_changed(Scene *scene);
+  bool device_refit_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress &progress);
+
   void device_update_displacement_images(Device *device, Scene *scene, Progress &progress);
 
   void device_update_volume_images(Device *device, Scene *scene, Progress &progress);
+
+  /* Geometry of every object the scene BVH was built for, to detect when it can be refit. */
+  vector<Geometry *> scene_bvh_geometry;
+  /* Objects which had leaves in the scene BVH, empty objects are left out of it. */
+  vector<bool> scene_bvh_traceable;
 };
 
 CCL_NAMESPACE_END
@@ -20,6 +20,8 @@
 #include "render/scene.h"
 #include "render/stats.h"
 
+#include "kernel/kernel_texture_cache.h"
+
 #include "util/util_foreach.h"
 #include "util/util_image_impl.h"
 #include "util/util_logging.h"
@@ -98,6 +100,7 @@ ImageManager::ImageManager(const DeviceInfo &info)
 {
   need_update = true;
   osl_texture_system = NULL;
+  texture_cache = NULL;
   animation_frame = 0;
 
   /* Set image limits */
@@ -403,6 +406,7 @@ int ImageManager::add_image(const string &filename,
   img->alpha_type = alpha_type;
   img->colorspace = colorspace;
   img->mem = NULL;
+  img->use_texture_cache = false;
 
   images[type][slot] = img;
 
@@ -553,6 +557,15 @@ bool ImageManager::file_load_image(Image *img,
                                    int texture_limit,
                                    device_vector<DeviceType> &tex_img)
 {
+  if (img->use_texture_cache) {
+    /* Pixels are read by the kernel through the texture cache, only allocate a placeholder so
+     * the slot has valid texture info. */
+    thread_scoped_lock device_lock(device_mutex);
+    DeviceType *pixels = tex_img.alloc(1, 1);
+    memset(pixels, 0, sizeof(DeviceType));
+    return true;
+  }
+
   unique_ptr<ImageInput> in = NULL;
   if (!file_load_image_generic(img, &in)) {
     return false;
@@ -801,6 +814,8 @@ void ImageManager::device_load_image(
     img->mem = NULL;
   }
 
+  img->use_texture_cache = texture_cache_add_image(scene, img, flat_slot);
+
   /* Create new texture. */
   if (type == IMAGE_DATA_TYPE_FLOAT4) {
     device_vector<float4> *tex_img = new device_vector<float4>(
@@ -981,6 +996,10 @@ void ImageManager::device_free_image(Device *, ImageDataType type, int slot)
 #endif
     }
 
+    if (img->use_texture_cache) {
+      texture_cache_remove_image(type_index_to_flattened_slot(slot, type));
+    }
+
     if (img->mem) {
       thread_scoped_lock device_lock(device_mutex);
       delete img->mem;
@@ -994,6 +1013,9 @@ void ImageManager::device_free_image(Device *, ImageDataType type, int slot)
 
 void ImageManager::device_update(Device *device, Scene *scene, Progress &progress)
 {
+  /* Also when no image changed, to follow changes of the memory limit. */
+  device_update_texture_cache(device, scene);
+
   if (!need_update) {
     return;
   }
@@ -1094,16 +1116,202 @@ void ImageManager::device_free(Device *device)
     }
     images[type].clear();
   }
+
+  device_free_texture_cache();
+}
+
+static string image_tx_filename(const string &filename)
+{
+  string name = path_filename(filename);
+  size_t dot = name.rfind('.');
+  if (dot != string::npos) {
+    name = name.substr(0, dot);
+  }
+  return path_join(path_dirname(filename), name + ".tx");
+}
+
+void ImageManager::device_update_texture_cache(Device *device, Scene *scene)
+{
+  /* Only the CPU device can page in tiles while rendering. With OSL, images are already looked up
+   * through the OSL texture system. */
+  TextureCacheGlobals *device_texture_cache = (TextureCacheGlobals *)
+                                                  device->texture_cache_memory();
+  if (!scene->params.texture_cache || osl_texture_system || device_texture_cache == NULL) {
+    device_free_texture_cache();
+    return;
+  }
+
+  texture_cache = device_texture_cache;
+
+  if (texture_cache->texture_system == NULL) {
+    /* Use a private texture system, so the memory ceiling is not shared with OSL. Images which
+     * are not tiled or mipmapped are tiled and mipmapped on the fly. */
+    OIIO::TextureSystem *ts = OIIO::TextureSystem::create(false);
+    ts->attribute("autotile", 64);
+    ts->attribute("automip", 1);
+    ts->attribute("accept_untiled", 1);
+    ts->attribute("accept_unmipped", 1);
+    texture_cache->texture_system = ts;
+
+    VLOG(1) << "Texture cache created.";
+  }
+
+  /* The memory limit can change between updates of the same device, the cache evicts tiles
+   * down to the new limit as it loads more of them. */
+  OIIO::TextureSystem *ts = texture_cache->texture_system;
+  const float max_memory_MB = (float)scene->params.texture_cache_size;
+  float current_max_memory_MB = 0.0f;
+  if (!ts->getattribute("max_memory_MB", current_max_memory_MB) ||
+      current_max_memory_MB != max_memory_MB) {
+    ts->attribute("max_memory_MB", max_memory_MB);
+    VLOG(1) << "Texture cache memory limit set to " << scene->params.texture_cache_size
+            << " MB.";
+  }
+
+  /* Sized up front, so slots can be added while loading images in parallel. */
+  size_t num_slots = 0;
+  for (int type = 0; type < IMAGE_DATA_NUM_TYPES; type++) {
+    num_slots = max(num_slots, images[type].size() << IMAGE_DATA_TYPE_SHIFT);
+  }
+  if (texture_cache->images.size() < num_slots) {
+    texture_cache->images.resize(num_slots);
+  }
+}
+
+void ImageManager::device_free_texture_cache()
+{
+  if (texture_cache == NULL) {
+    return;
+  }
+
+  if (texture_cache->texture_system) {
+    OIIO::TextureSystem::destroy(texture_cache->texture_system);
+    texture_cache->texture_system = NULL;
+  }
+  texture_cache->images.clear();
+  texture_cache = NULL;
+}
+
+bool ImageManager::texture_cache_add_image(Scene *scene, Image *img, int flat_slot)
+{
+  if (texture_cache == NULL || (size_t)flat_slot >= texture_cache->images.size()) {
+    return false;
+  }
+
+  /* Builtin images, volumes and images that need their pixels converted on load are stored in
+   * device memory. */
+  const ImageMetaData &metadata = img->metadata;
+  if (img->builtin_data || metadata.depth > 1) {
+    return false;
+  }
+  if (metadata.colorspace != u_colorspace_raw && metadata.colorspace != u_colorspace_srgb) {
+    return false;
+  }
+  if (!(metadata.channels == 1 || metadata.channels == 3 ||
+        (metadata.channels == 4 && image_associate_alpha(img)))) {
+    return false;
+  }
+
+  texture_cache_remove_image(flat_slot);
+
+  string filename = img->filename;
+  if (scene->params.texture_cache_use_tx) {
+    const string tx_filename = image_tx_filename(filename);
+    if (path_exists(tx_filename)) {
+      filename = tx_filename;
+    }
+  }
+
+  OIIO::TextureSystem *ts = texture_cache->texture_system;
+  TextureCacheImage &cache_image = texture_cache->images[flat_slot];
+  cache_image.filename = ustring(filename);
+  cache_image.handle = ts->get_texture_handle(cache_image.filename);
+
+  if (cache_image.handle == NULL || !ts->good(cache_image.handle)) {
+    cache_image = TextureCacheImage();
+    return false;
+  }
+
+  OIIO::TextureOpt &options = cache_image.options;
+  switch (img->interpolation) {
+    case INTERPOLATION_CLOSEST:
+      options.interpmode = OIIO::TextureOpt::InterpClosest;
+      break;
+    case INTERPOLATION_LINEAR:
+      options.interpmode = OIIO::TextureOpt::InterpBilinear;
+      break;
+    case INTERPOLATION_CUBIC:
+      options.interpmode = OIIO::TextureOpt::InterpBicubic;
+      break;
+    default:
+      options.interpmode = OIIO::TextureOpt::InterpSmartBicubic;
+      break;
+  }
+  switch (img->extension) {
+    case EXTENSION_EXTEND:
+      options.swrap = options.twrap = OIIO::TextureOpt::WrapClamp;
+      break;
+    case EXTENSION_CLIP:
+      options.swrap = options.twrap = OIIO::TextureOpt::WrapBlack;
+      break;
+    default:
+      options.swrap = options.twrap = OIIO::TextureOpt::WrapPeriodic;
+      break;
+  }
+  /* Alpha of RGB images. */
+  options.fill = 1.0f;
+  cache_image.num_channels = (metadata.channels == 1) ? 1 : 4;
+
+  return true;
+}
+
+void ImageManager::texture_cache_remove_image(int flat_slot)
+{
+  if (texture_cache == NULL || (size_t)flat_slot >= texture_cache->images.size()) {
+    return;
+  }
+
+  TextureCacheImage &cache_image = texture_cache->images[flat_slot];
+  if (cache_image.handle) {
+    texture_cache->texture_system->invalidate(cache_image.filename);
+  }
+  cache_image = TextureCacheImage();
 }
 
 void ImageManager::collect_statistics(RenderStats *stats)
 {
+  TextureCacheStats &cache_stats = stats->image.texture_cache;
+
   for (int type = 0; type < IMAGE_DATA_NUM_TYPES; type++) {
     foreach (const Image *image, images[type]) {
+      if (image->use_texture_cache) {
+        cache_stats.num_images++;
+        continue;
+      }
       stats->image.textures.add_entry(
           NamedSizeEntry(path_filename(image->filename), image->mem->memory_size()));
     }
   }
+
+  if (texture_cache && texture_cache->texture_system) {
+    OIIO::TextureSystem *ts = texture_cache->texture_system;
+    float memory_limit_mb = 0.0f;
+    int64_t memory_used = 0, bytes_read = 0, queries = 0;
+    int tiles_read = 0;
+
+    ts->getattribute("max_memory_MB", TypeDesc::FLOAT, &memory_limit_mb);
+    ts->getattribute("stat:cache_memory_used", TypeDesc::INT64, &memory_used);
+    ts->getattribute("stat:bytes_read", TypeDesc::INT64, &bytes_read);
+    ts->getattribute("stat:texture_queries", TypeDesc::INT64, &queries);
+    ts->getattribute("stat:tiles_created", TypeDesc::INT, &tiles_read);
+
+    cache_stats.use = true;
+    cache_stats.memory_limit = (size_t)(memory_limit_mb * 1024.0f * 1024.0f);
+    cache_stats.memory_used = memory_used;
+    cache_stats.tiles_read = tiles_read;
+    cache_stats.bytes_read = bytes_read;
+    cache_stats.queries = queries;
+  }
 }
 
 CCL_NAMESPACE_END
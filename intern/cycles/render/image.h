@@ -35,6 +35,7 @@ class Progress;
 class RenderStats;
 class Scene;
 class ColorSpaceProcessor;
+struct TextureCacheGlobals;
 
 class ImageMetaData {
  public:
@@ -161,6 +162,9 @@ class ImageManager {
     string mem_name;
     device_memory *mem;
 
+    /* Pixels are paged in on demand by the texture cache, only a placeholder is in mem. */
+    bool use_texture_cache;
+
     int users;
   };
 
@@ -174,6 +178,7 @@ class ImageManager {
 
   vector<Image *> images[IMAGE_DATA_NUM_TYPES];
   void *osl_texture_system;
+  TextureCacheGlobals *texture_cache;
 
   bool file_load_image_generic(Image *img, unique_ptr<ImageInput> *in);
 
@@ -188,6 +193,11 @@ class ImageManager {
   void device_load_image(
       Device *device, Scene *scene, ImageDataType type, int slot, Progress *progress);
   void device_free_image(Device *device, ImageDataType type, int slot);
+
+  void device_update_texture_cache(Device *device, Scene *scene);
+  void device_free_texture_cache();
+  bool texture_cache_add_image(Scene *scene, Image *img, int flat_slot);
+  void texture_cache_remove_image(int flat_slot);
 };
 
 CCL_NAMESPACE_END
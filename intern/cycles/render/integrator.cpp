@@ -70,6 +70,11 @@ NODE_DEFINE(Integrator)
   SOCKET_BOOLEAN(sample_all_lights_indirect, "Sample All Lights Indirect", true);
   SOCKET_FLOAT(light_sampling_threshold, "Light Sampling Threshold", 0.05f);
 
+  SOCKET_FLOAT(adaptive_threshold, "Adaptive Threshold", 0.0f);
+  SOCKET_INT(adaptive_min_samples, "Adaptive Min Samples", 0);
+
+  SOCKET_BOOLEAN(use_light_tree, "Use Light Tree", false);
+
   static NodeEnum method_enum;
   method_enum.insert("path", PATH);
   method_enum.insert("branched_path", BRANCHED_PATH);
@@ -175,6 +180,18 @@ void Integrator::device_update(Device *device, DeviceScene *dscene, Scene *scene
   kintegrator->sampling_pattern = sampling_pattern;
   kintegrator->aa_samples = aa_samples;
 
+  /* Pixels are checked for convergence every adaptive_step samples, must be a power of two. */
+  kintegrator->adaptive_step = 4;
+  kintegrator->adaptive_threshold = adaptive_threshold;
+  if (adaptive_min_samples == 0) {
+    kintegrator->adaptive_min_samples = max(4, (int)sqrtf((float)aa_samples));
+  }
+  else {
+    kintegrator->adaptive_min_samples = adaptive_min_samples;
+  }
+  kintegrator->adaptive_min_samples = (int)align_up(kintegrator->adaptive_min_samples,
+                                                    kintegrator->adaptive_step);
+
   if (light_sampling_threshold > 0.0f) {
     kintegrator->light_inv_rr_threshold = 1.0f / light_sampling_threshold;
   }
@@ -222,6 +239,15 @@ bool Integrator::modified(const Integrator &integrator)
   return !Node::equals(integrator);
 }
 
+bool Integrator::light_tree_enabled() const
+{
+  /* Sampling all lights walks over the lamps and the triangle distribution separately. */
+  if (method == BRANCHED_PATH && (sample_all_lights_direct || sample_all_lights_indirect)) {
+    return false;
+  }
+  return use_light_tree;
+}
+
 void Integrator::tag_update(Scene *scene)
 {
   foreach (Shader *shader, scene->shaders) {
@@ -75,6 +75,15 @@ class Integrator : public Node {
   bool sample_all_lights_indirect;
   float light_sampling_threshold;
 
+  /* Adaptive sampling: pixels stop being sampled once their error estimate is below the
+   * threshold, after at least adaptive_min_samples (0 picks a number based on aa_samples). */
+  float adaptive_threshold;
+  int adaptive_min_samples;
+
+  /* Pick lights and emissive triangles with a light tree, based on their estimated contribution
+   * to the shading point. Not used when branched path tracing samples all lights. */
+  bool use_light_tree;
+
   enum Method {
     BRANCHED_PATH = 0,
     PATH = 1,
@@ -95,6 +104,7 @@ class Integrator : public Node {
   void device_free(Device *device, DeviceScene *dscene);
 
   bool modified(const Integrator &integrator);
+  bool light_tree_enabled() const;
   void tag_update(Scene *scene);
 };
 
@@ -20,17 +20,20 @@
 #include "render/film.h"
 #include "render/graph.h"
 #include "render/light.h"
+#include "render/light_tree.h"
 #include "render/mesh.h"
 #include "render/nodes.h"
 #include "render/object.h"
 #include "render/scene.h"
 #include "render/shader.h"
 
+#include "util/util_algorithm.h"
 #include "util/util_foreach.h"
 #include "util/util_hash.h"
 #include "util/util_path.h"
 #include "util/util_progress.h"
 #include "util/util_logging.h"
+#include "util/util_map.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -120,6 +123,7 @@ NODE_DEFINE(Light)
 
   SOCKET_VECTOR(dir, "Dir", make_float3(0.0f, 0.0f, 0.0f));
   SOCKET_FLOAT(size, "Size", 0.0f);
+  SOCKET_FLOAT(angle, "Angle", 0.0f);
 
   SOCKET_VECTOR(axisu, "Axis U", make_float3(0.0f, 0.0f, 0.0f));
   SOCKET_FLOAT(sizeu, "Size U", 1.0f);
@@ -160,6 +164,15 @@ Light::Light() : Node(node_type)
 void Light::tag_update(Scene *scene)
 {
   scene->light_manager->need_update = true;
+
+  if (type == LIGHT_BACKGROUND) {
+    scene->light_manager->need_update_background = true;
+  }
+}
+
+bool Light::modified(const Light &light)
+{
+  return !Node::equals(light);
 }
 
 bool Light::has_contribution(Scene *scene)
@@ -181,6 +194,7 @@ bool Light::has_contribution(Scene *scene)
 LightManager::LightManager()
 {
   need_update = true;
+  need_update_background = true;
   use_light_visibility = false;
 }
 
@@ -257,6 +271,65 @@ bool LightManager::object_usable_as_light(Object *object)
   return false;
 }
 
+/* Rough estimate of the emitted radiance of a shader, used to weight emitters in the light tree.
+ * Only exact for constant emission, other shaders are assumed to emit unit radiance. */
+static float light_tree_shader_emission(Shader *shader, map<Shader *, float> &shader_emission)
+{
+  map<Shader *, float>::iterator it = shader_emission.find(shader);
+  if (it != shader_emission.end()) {
+    return it->second;
+  }
+
+  float3 constant_emission;
+  const float emission = shader->is_constant_emission(&constant_emission) ?
+                             average(fabs(constant_emission)) :
+                             1.0f;
+  shader_emission[shader] = emission;
+  return emission;
+}
+
+static void light_tree_lamp_emitter(Light *light,
+                                    Shader *shader,
+                                    int emitter,
+                                    map<Shader *, float> &shader_emission,
+                                    LightTreeEmitter *tree_emitter)
+{
+  const float3 co = light->co;
+  const float emission = average(fabs(light->strength)) *
+                         light_tree_shader_emission(shader, shader_emission);
+
+  tree_emitter->emitter = emitter;
+
+  if (light->type == LIGHT_AREA) {
+    const float3 axisu = light->axisu * (light->sizeu * light->size);
+    const float3 axisv = light->axisv * (light->sizev * light->size);
+
+    tree_emitter->bbox = BoundBox::empty;
+    tree_emitter->bbox.grow(co - 0.5f * axisu - 0.5f * axisv);
+    tree_emitter->bbox.grow(co + 0.5f * axisu - 0.5f * axisv);
+    tree_emitter->bbox.grow(co - 0.5f * axisu + 0.5f * axisv);
+    tree_emitter->bbox.grow(co + 0.5f * axisu + 0.5f * axisv);
+    /* One sided, the intensity along the normal is a quarter of the strength. */
+    tree_emitter->orientation = LightTreeOrientation(
+        safe_normalize(light->dir), 0.0f, M_PI_2_F);
+    tree_emitter->energy = 0.25f * emission;
+  }
+  else {
+    const float3 radius = make_float3(light->size, light->size, light->size);
+
+    tree_emitter->bbox = BoundBox(co - radius, co + radius);
+    if (light->type == LIGHT_SPOT) {
+      tree_emitter->orientation = LightTreeOrientation(
+          safe_normalize(light->dir), 0.0f, 0.5f * light->spot_angle);
+    }
+    else {
+      tree_emitter->orientation = LightTreeOrientation(
+          make_float3(0.0f, 0.0f, 1.0f), M_PI_F, M_PI_2_F);
+    }
+    tree_emitter->energy = emission * M_1_PI_F * 0.25f;
+  }
+}
+
 void LightManager::device_update_distribution(Device *,
                                               DeviceScene *dscene,
                                               Scene *scene,
@@ -269,6 +342,7 @@ void LightManager::device_update_distribution(Device *,
   size_t num_portals = 0;
   size_t num_background_lights = 0;
   size_t num_triangles = 0;
+  size_t num_object_triangles = 0;
 
   bool background_mis = false;
 
@@ -292,6 +366,7 @@ void LightManager::device_update_distribution(Device *,
     /* Count triangles. */
     Mesh *mesh = static_cast<Mesh *>(object->geometry);
     size_t mesh_num_triangles = mesh->num_triangles();
+    num_object_triangles += mesh_num_triangles;
     for (size_t i = 0; i < mesh_num_triangles; i++) {
       int shader_index = mesh->shader[i];
       Shader *shader = (shader_index < mesh->used_shaders.size()) ?
@@ -311,6 +386,23 @@ void LightManager::device_update_distribution(Device *,
   KernelLightDistribution *distribution = dscene->light_distribution.alloc(num_distribution + 1);
   float totarea = 0.0f;
 
+  /* light tree, lamps and emissive triangles with their bounds and estimated power */
+  const bool use_light_tree = scene->integrator->light_tree_enabled() && num_distribution > 0;
+  vector<LightTreeEmitter> light_tree_emitters;
+  vector<uint> light_tree_infinite_lights;
+  map<Shader *, float> shader_emission;
+  uint *object_to_triangle = NULL;
+  uint *triangle_to_emitter = NULL;
+  size_t triangle_offset = 0;
+
+  if (use_light_tree) {
+    light_tree_emitters.reserve(num_distribution);
+    object_to_triangle = dscene->light_tree_object_to_triangle.alloc(scene->objects.size());
+    const size_t num_triangle_to_emitter = max(num_object_triangles, (size_t)1);
+    triangle_to_emitter = dscene->light_tree_triangle_to_emitter.alloc(num_triangle_to_emitter);
+    std::fill(triangle_to_emitter, triangle_to_emitter + num_triangle_to_emitter, ~0u);
+  }
+
   /* triangles */
   size_t offset = 0;
   int j = 0;
@@ -320,6 +412,9 @@ void LightManager::device_update_distribution(Device *,
       return;
 
     if (!object_usable_as_light(object)) {
+      if (use_light_tree) {
+        object_to_triangle[j] = (uint)INT_MIN;
+      }
       j++;
       continue;
     }
@@ -348,6 +443,11 @@ void LightManager::device_update_distribution(Device *,
     }
 
     size_t mesh_num_triangles = mesh->num_triangles();
+    if (use_light_tree) {
+      /* Triangles are looked up by their primitive index, which starts at prim_offset. */
+      object_to_triangle[j] = (uint)((int)triangle_offset - (int)mesh->prim_offset);
+    }
+
     for (size_t i = 0; i < mesh_num_triangles; i++) {
       int shader_index = mesh->shader[i];
       Shader *shader = (shader_index < mesh->used_shaders.size()) ?
@@ -355,6 +455,7 @@ void LightManager::device_update_distribution(Device *,
                            scene->default_surface;
 
       if (shader->use_mis && shader->has_surface_emission) {
+        const size_t emitter = offset;
         distribution[offset].totarea = totarea;
         distribution[offset].prim = i + mesh->prim_offset;
         distribution[offset].mesh_light.shader_flag = shader_flag;
@@ -375,10 +476,29 @@ void LightManager::device_update_distribution(Device *,
           p3 = transform_point(&tfm, p3);
         }
 
-        totarea += triangle_area(p1, p2, p3);
+        const float area = triangle_area(p1, p2, p3);
+        totarea += area;
+
+        if (use_light_tree) {
+          /* Emission is two sided, so the normals do not bound the orientation. */
+          LightTreeEmitter tree_emitter;
+          tree_emitter.bbox = BoundBox::empty;
+          tree_emitter.bbox.grow(p1);
+          tree_emitter.bbox.grow(p2);
+          tree_emitter.bbox.grow(p3);
+          tree_emitter.orientation = LightTreeOrientation(
+              make_float3(0.0f, 0.0f, 1.0f), M_PI_F, M_PI_2_F);
+          tree_emitter.energy = area * M_1_PI_F *
+                                light_tree_shader_emission(shader, shader_emission);
+          tree_emitter.emitter = emitter;
+          light_tree_emitters.push_back(tree_emitter);
+
+          triangle_to_emitter[triangle_offset + i] = emitter;
+        }
       }
     }
 
+    triangle_offset += mesh_num_triangles;
     j++;
   }
 
@@ -413,6 +533,18 @@ void LightManager::device_update_distribution(Device *,
       background_mis |= light->use_mis;
     }
 
+    if (use_light_tree) {
+      if (light->type == LIGHT_DISTANT || light->type == LIGHT_BACKGROUND) {
+        light_tree_infinite_lights.push_back(offset);
+      }
+      else {
+        LightTreeEmitter tree_emitter;
+        Shader *shader = (light->shader) ? light->shader : scene->default_light;
+        light_tree_lamp_emitter(light, shader, offset, shader_emission, &tree_emitter);
+        light_tree_emitters.push_back(tree_emitter);
+      }
+    }
+
     light_index++;
     offset++;
   }
@@ -462,6 +594,62 @@ void LightManager::device_update_distribution(Device *,
 
     kintegrator->use_lamp_mis = use_lamp_mis;
 
+    /* Light tree, with the distant and background lights picked uniformly outside of it. */
+    kintegrator->use_light_tree = use_light_tree;
+    kintegrator->pdf_light_tree = 0.0f;
+    kintegrator->num_infinite_lights = 0;
+    kintegrator->pdf_infinite_lights = 0.0f;
+
+    if (use_light_tree) {
+      LightTree light_tree(light_tree_emitters, num_distribution);
+      const size_t num_infinite_lights = light_tree_infinite_lights.size();
+
+      VLOG(1) << "Light tree with " << light_tree.nodes.size() << " nodes, "
+              << num_infinite_lights << " lights outside of the tree.";
+
+      if (!light_tree.nodes.empty()) {
+        KernelLightTreeNode *nodes = dscene->light_tree_nodes.alloc(light_tree.nodes.size());
+        std::copy(light_tree.nodes.begin(), light_tree.nodes.end(), nodes);
+        dscene->light_tree_nodes.copy_to_device();
+
+        kintegrator->pdf_light_tree = (num_infinite_lights > 0) ? 0.5f : 1.0f;
+      }
+      else {
+        dscene->light_tree_nodes.free();
+      }
+
+      uint *emitter_to_leaf = dscene->light_tree_emitter_to_leaf.alloc(num_distribution);
+      std::copy(light_tree.emitter_to_leaf.begin(),
+                light_tree.emitter_to_leaf.end(),
+                emitter_to_leaf);
+      dscene->light_tree_emitter_to_leaf.copy_to_device();
+
+      if (num_infinite_lights > 0) {
+        uint *infinite_lights = dscene->light_tree_infinite_lights.alloc(num_infinite_lights);
+        std::copy(light_tree_infinite_lights.begin(),
+                  light_tree_infinite_lights.end(),
+                  infinite_lights);
+        dscene->light_tree_infinite_lights.copy_to_device();
+
+        kintegrator->num_infinite_lights = num_infinite_lights;
+        kintegrator->pdf_infinite_lights = (1.0f - kintegrator->pdf_light_tree) /
+                                           num_infinite_lights;
+      }
+      else {
+        dscene->light_tree_infinite_lights.free();
+      }
+
+      dscene->light_tree_object_to_triangle.copy_to_device();
+      dscene->light_tree_triangle_to_emitter.copy_to_device();
+    }
+    else {
+      dscene->light_tree_nodes.free();
+      dscene->light_tree_emitter_to_leaf.free();
+      dscene->light_tree_infinite_lights.free();
+      dscene->light_tree_object_to_triangle.free();
+      dscene->light_tree_triangle_to_emitter.free();
+    }
+
     /* bit of an ugly hack to compensate for emitting triangles influencing
      * amount of samples we get for this pass */
     kfilm->pass_shadow_scale = 1.0f;
@@ -489,12 +677,21 @@ void LightManager::device_update_distribution(Device *,
   }
   else {
     dscene->light_distribution.free();
+    dscene->light_tree_nodes.free();
+    dscene->light_tree_emitter_to_leaf.free();
+    dscene->light_tree_infinite_lights.free();
+    dscene->light_tree_object_to_triangle.free();
+    dscene->light_tree_triangle_to_emitter.free();
 
     kintegrator->num_distribution = 0;
     kintegrator->num_all_lights = 0;
     kintegrator->pdf_triangles = 0.0f;
     kintegrator->pdf_lights = 0.0f;
     kintegrator->use_lamp_mis = false;
+    kintegrator->use_light_tree = false;
+    kintegrator->pdf_light_tree = 0.0f;
+    kintegrator->num_infinite_lights = 0;
+    kintegrator->pdf_infinite_lights = 0.0f;
     kintegrator->num_portals = 0;
     kintegrator->portal_offset = 0;
     kintegrator->portal_pdf = 0.0f;
@@ -561,6 +758,13 @@ void LightManager::device_update_background(Device *device,
   if (!background_light || !background_light->is_enabled) {
     kintegrator->pdf_background_res_x = 0;
     kintegrator->pdf_background_res_y = 0;
+    dscene->light_background_marginal_cdf.free();
+    dscene->light_background_conditional_cdf.free();
+    return;
+  }
+
+  /* The importance map only depends on the background, keep it when other lights changed. */
+  if (!need_update_background && dscene->light_background_marginal_cdf.size() != 0) {
     return;
   }
 
@@ -901,7 +1105,7 @@ void LightManager::device_update(Device *device,
 
   VLOG(1) << "Total " << scene->lights.size() << " lights.";
 
-  device_free(device, dscene);
+  device_free(device, dscene, need_update_background);
 
   use_light_visibility = false;
 
@@ -929,20 +1133,29 @@ void LightManager::device_update(Device *device,
   }
 
   need_update = false;
+  need_update_background = false;
 }
 
-void LightManager::device_free(Device *, DeviceScene *dscene)
+void LightManager::device_free(Device *, DeviceScene *dscene, const bool free_background)
 {
   dscene->light_distribution.free();
   dscene->lights.free();
-  dscene->light_background_marginal_cdf.free();
-  dscene->light_background_conditional_cdf.free();
+  if (free_background) {
+    dscene->light_background_marginal_cdf.free();
+    dscene->light_background_conditional_cdf.free();
+  }
+  dscene->light_tree_nodes.free();
+  dscene->light_tree_emitter_to_leaf.free();
+  dscene->light_tree_infinite_lights.free();
+  dscene->light_tree_object_to_triangle.free();
+  dscene->light_tree_triangle_to_emitter.free();
   dscene->ies_lights.free();
 }
 
 void LightManager::tag_update(Scene * /*scene*/)
 {
   need_update = true;
+  need_update_background = true;
 }
 
 int LightManager::add_ies_from_file(const string &filename)
@@ -78,6 +78,7 @@ class Light : public Node {
   uint random_id;
 
   void tag_update(Scene *scene);
+  bool modified(const Light &light);
 
   /* Check whether the light has contribution the scene. */
   bool has_contribution(Scene *scene);
@@ -87,6 +88,9 @@ class LightManager {
  public:
   bool use_light_visibility;
   bool need_update;
+  /* The background importance map is only computed again when this is set, changes to other
+   * lights keep it. */
+  bool need_update_background;
 
   LightManager();
   ~LightManager();
@@ -97,7 +101,7 @@ class LightManager {
   void remove_ies(int slot);
 
   void device_update(Device *device, DeviceScene *dscene, Scene *scene, Progress &progress);
-  void device_free(Device *device, DeviceScene *dscene);
+  void device_free(Device *device, DeviceScene *dscene, const bool free_background = true);
 
   void tag_update(Scene *scene);
 
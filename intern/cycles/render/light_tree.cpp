@@ -0,0 +1,259 @@
+/*
+ * Copyright 2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/light_tree.h"
+
+#include "util/util_algorithm.h"
+#include "util/util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Orientation Bounds
+ *
+ * See "Importance Sampling of Many Lights with Adaptive Tree Splitting" by Conty Estevez and
+ * Kulla, section 4.1. */
+
+float LightTreeOrientation::measure() const
+{
+  const float theta_w = min(theta_o + theta_e, M_PI_F);
+  const float sin_theta_o = sinf(theta_o);
+  const float cos_theta_o = cosf(theta_o);
+
+  return M_2PI_F * (1.0f - cos_theta_o) +
+         M_PI_2_F * (2.0f * theta_w * sin_theta_o - cosf(theta_o - 2.0f * theta_w) -
+                     2.0f * theta_o * sin_theta_o + cos_theta_o);
+}
+
+LightTreeOrientation merge(const LightTreeOrientation &a, const LightTreeOrientation &b)
+{
+  if (b.theta_o > a.theta_o) {
+    return merge(b, a);
+  }
+
+  const float theta_d = acosf(clamp(dot(a.axis, b.axis), -1.0f, 1.0f));
+  const float theta_e = max(a.theta_e, b.theta_e);
+
+  /* The cone of a already contains the cone of b. */
+  if (min(theta_d + b.theta_o, M_PI_F) <= a.theta_o) {
+    return LightTreeOrientation(a.axis, a.theta_o, theta_e);
+  }
+
+  const float theta_o = 0.5f * (a.theta_o + theta_d + b.theta_o);
+  if (theta_o >= M_PI_F) {
+    return LightTreeOrientation(a.axis, M_PI_F, theta_e);
+  }
+
+  /* Nearly parallel axes have no stable rotation axis, widen the cone of a instead. */
+  const float3 rotation_axis = cross(a.axis, b.axis);
+  if (len_squared(rotation_axis) < 1e-8f) {
+    return LightTreeOrientation(a.axis, min(theta_d + b.theta_o, M_PI_F), theta_e);
+  }
+
+  /* Rotate the axis of a towards b, to the middle of the merged cone. */
+  const float3 axis = rotate_around_axis(
+      a.axis, normalize(rotation_axis), theta_o - a.theta_o);
+  return LightTreeOrientation(normalize(axis), theta_o, theta_e);
+}
+
+/* Light Tree */
+
+static const int LIGHT_TREE_NUM_BINS = 12;
+/* Past this depth the emitters are split in the middle, to bound the traversal cost. */
+static const int LIGHT_TREE_MAX_DEPTH = 64;
+
+LightTree::LightTree(const vector<LightTreeEmitter> &emitters, size_t num_distribution)
+    : emitters(emitters)
+{
+  emitter_to_leaf.resize(num_distribution, ~0u);
+
+  if (emitters.empty()) {
+    return;
+  }
+
+  nodes.reserve(2 * emitters.size() - 1);
+  recursive_build(0, emitters.size(), -1, 0);
+}
+
+int LightTree::recursive_build(int start, int end, int parent, int depth)
+{
+  BoundBox bbox = BoundBox::empty;
+  BoundBox centroid_bbox = BoundBox::empty;
+  LightTreeOrientation orientation = emitters[start].orientation;
+  float energy = 0.0f;
+
+  for (int i = start; i < end; i++) {
+    const LightTreeEmitter &emitter = emitters[i];
+    bbox.grow(emitter.bbox);
+    centroid_bbox.grow(emitter.bbox.center());
+    if (i != start) {
+      orientation = merge(orientation, emitter.orientation);
+    }
+    energy += emitter.energy;
+  }
+
+  const int index = nodes.size();
+  nodes.push_back(KernelLightTreeNode());
+
+  KernelLightTreeNode &knode = nodes[index];
+  knode.bbox_min[0] = bbox.min.x;
+  knode.bbox_min[1] = bbox.min.y;
+  knode.bbox_min[2] = bbox.min.z;
+  knode.energy = energy;
+  knode.bbox_max[0] = bbox.max.x;
+  knode.bbox_max[1] = bbox.max.y;
+  knode.bbox_max[2] = bbox.max.z;
+  knode.theta_o = orientation.theta_o;
+  knode.axis[0] = orientation.axis.x;
+  knode.axis[1] = orientation.axis.y;
+  knode.axis[2] = orientation.axis.z;
+  knode.theta_e = orientation.theta_e;
+  knode.right_child = -1;
+  knode.emitter = -1;
+  knode.parent = parent;
+  knode.pad = 0;
+
+  if (end - start == 1) {
+    knode.emitter = emitters[start].emitter;
+    emitter_to_leaf[emitters[start].emitter] = index;
+    return index;
+  }
+
+  int middle = (depth < LIGHT_TREE_MAX_DEPTH) ? split(start, end, centroid_bbox) : -1;
+  if (middle <= start || middle >= end) {
+    middle = (start + end) / 2;
+  }
+
+  recursive_build(start, middle, index, depth + 1);
+  const int right_child = recursive_build(middle, end, index, depth + 1);
+  nodes[index].right_child = right_child;
+
+  return index;
+}
+
+static int light_tree_bin(const LightTreeEmitter &emitter,
+                          const BoundBox &centroid_bbox,
+                          int axis,
+                          float inv_extent)
+{
+  const float centroid = emitter.bbox.center()[axis];
+  return min((int)((centroid - centroid_bbox.min[axis]) * inv_extent), LIGHT_TREE_NUM_BINS - 1);
+}
+
+/* Binned split minimizing the energy, surface area and orientation cost of both sides. Returns
+ * the start of the second half after partitioning, or -1 when no split was found. */
+int LightTree::split(int start, int end, const BoundBox &centroid_bbox)
+{
+  const float3 extent = centroid_bbox.size();
+  const float max_extent = max(extent.x, max(extent.y, extent.z));
+
+  float min_cost = FLT_MAX;
+  int min_axis = -1;
+  int min_bin = -1;
+
+  for (int axis = 0; axis < 3; axis++) {
+    if (extent[axis] <= 0.0f) {
+      continue;
+    }
+
+    BoundBox bin_bbox[LIGHT_TREE_NUM_BINS];
+    LightTreeOrientation bin_orientation[LIGHT_TREE_NUM_BINS];
+    float bin_energy[LIGHT_TREE_NUM_BINS];
+    int bin_count[LIGHT_TREE_NUM_BINS];
+
+    for (int b = 0; b < LIGHT_TREE_NUM_BINS; b++) {
+      bin_bbox[b] = BoundBox::empty;
+      bin_energy[b] = 0.0f;
+      bin_count[b] = 0;
+    }
+
+    const float inv_extent = LIGHT_TREE_NUM_BINS / extent[axis];
+    for (int i = start; i < end; i++) {
+      const LightTreeEmitter &emitter = emitters[i];
+      const int b = light_tree_bin(emitter, centroid_bbox, axis, inv_extent);
+
+      bin_bbox[b].grow(emitter.bbox);
+      bin_orientation[b] = (bin_count[b] == 0) ? emitter.orientation :
+                                                 merge(bin_orientation[b], emitter.orientation);
+      bin_energy[b] += emitter.energy;
+      bin_count[b]++;
+    }
+
+    /* Cost of everything right of each split, accumulated from the right. */
+    float right_cost[LIGHT_TREE_NUM_BINS];
+    int right_count[LIGHT_TREE_NUM_BINS];
+    {
+      BoundBox bbox = BoundBox::empty;
+      LightTreeOrientation orientation;
+      float energy = 0.0f;
+      int count = 0;
+      for (int b = LIGHT_TREE_NUM_BINS - 1; b > 0; b--) {
+        if (bin_count[b] > 0) {
+          bbox.grow(bin_bbox[b]);
+          orientation = (count == 0) ? bin_orientation[b] : merge(orientation, bin_orientation[b]);
+          energy += bin_energy[b];
+          count += bin_count[b];
+        }
+        right_cost[b] = (count > 0) ? energy * bbox.safe_area() * orientation.measure() : 0.0f;
+        right_count[b] = count;
+      }
+    }
+
+    /* Sweep from the left. Splitting along a short axis is penalized, since the bounds of both
+     * sides overlap more. */
+    const float axis_factor = max_extent / extent[axis];
+    BoundBox bbox = BoundBox::empty;
+    LightTreeOrientation orientation;
+    float energy = 0.0f;
+    int count = 0;
+    for (int b = 1; b < LIGHT_TREE_NUM_BINS; b++) {
+      if (bin_count[b - 1] > 0) {
+        bbox.grow(bin_bbox[b - 1]);
+        orientation = (count == 0) ? bin_orientation[b - 1] :
+                                     merge(orientation, bin_orientation[b - 1]);
+        energy += bin_energy[b - 1];
+        count += bin_count[b - 1];
+      }
+      if (count == 0 || right_count[b] == 0) {
+        continue;
+      }
+
+      const float left_cost = energy * bbox.safe_area() * orientation.measure();
+      const float cost = axis_factor * (left_cost + right_cost[b]);
+      if (cost < min_cost) {
+        min_cost = cost;
+        min_axis = axis;
+        min_bin = b;
+      }
+    }
+  }
+
+  if (min_axis == -1) {
+    return -1;
+  }
+
+  const float inv_extent = LIGHT_TREE_NUM_BINS / extent[min_axis];
+  int middle = start;
+  for (int i = start; i < end; i++) {
+    if (light_tree_bin(emitters[i], centroid_bbox, min_axis, inv_extent) < min_bin) {
+      swap(emitters[i], emitters[middle]);
+      middle++;
+    }
+  }
+
+  return middle;
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LIGHT_TREE_H__
+#define __LIGHT_TREE_H__
+
+#include "kernel/kernel_types.h"
+
+#include "util/util_boundbox.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Bounds of the normals of a set of emitters: all normals are within theta_o of the axis, and
+ * light is emitted within theta_e of the normal. */
+struct LightTreeOrientation {
+  LightTreeOrientation() : axis(make_float3(0.0f, 0.0f, 1.0f)), theta_o(0.0f), theta_e(0.0f)
+  {
+  }
+
+  LightTreeOrientation(const float3 &axis, float theta_o, float theta_e)
+      : axis(axis), theta_o(theta_o), theta_e(theta_e)
+  {
+  }
+
+  float3 axis;
+  float theta_o;
+  float theta_e;
+
+  /* Solid angle measure used by the split heuristic. */
+  float measure() const;
+};
+
+LightTreeOrientation merge(const LightTreeOrientation &a, const LightTreeOrientation &b);
+
+/* Lamp or emissive triangle, an entry of the light distribution. */
+struct LightTreeEmitter {
+  BoundBox bbox;
+  LightTreeOrientation orientation;
+  /* Estimate of the emitted power, only affects noise. */
+  float energy;
+  /* Index in the light distribution. */
+  int emitter;
+};
+
+/* Bounding volume hierarchy over the emitters, with one emitter per leaf. Nodes are stored in
+ * depth first order, so the first child of an inner node directly follows it. */
+class LightTree {
+ public:
+  LightTree(const vector<LightTreeEmitter> &emitters, size_t num_distribution);
+
+  vector<KernelLightTreeNode> nodes;
+  /* Leaf node of every light distribution entry, ~0 for entries outside of the tree. */
+  vector<uint> emitter_to_leaf;
+
+ protected:
+  int recursive_build(int start, int end, int parent, int depth);
+  int split(int start, int end, const BoundBox &centroid_bbox);
+
+  vector<LightTreeEmitter> emitters;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __LIGHT_TREE_H__ */
@@ -206,8 +206,11 @@ void Object::apply_transform(bool apply_to_motion)
 void Object::tag_update(Scene *scene)
 {
   if (geometry) {
-    if (geometry->transform_applied)
+    /* Transform is baked into the geometry, otherwise only the scene BVH changes. */
+    if (geometry->transform_applied) {
       geometry->need_update = true;
+      scene->geometry_manager->need_update = true;
+    }
 
     foreach (Shader *shader, geometry->used_shaders) {
       if (shader->use_mis && shader->has_surface_emission)
@@ -217,7 +220,7 @@ void Object::tag_update(Scene *scene)
 
   scene->camera->need_flags_update = true;
   scene->curve_system_manager->need_update = true;
-  scene->geometry_manager->need_update = true;
+  scene->geometry_manager->need_update_scene_bvh = true;
   scene->object_manager->need_update = true;
 }
 
@@ -30,6 +30,7 @@
 #include "render/particles.h"
 #include "render/scene.h"
 #include "render/shader.h"
+#include "render/stats.h"
 #include "render/svm.h"
 #include "render/tables.h"
 
@@ -73,6 +74,11 @@ DeviceScene::DeviceScene(Device *device)
       lights(device, "__lights", MEM_TEXTURE),
       light_background_marginal_cdf(device, "__light_background_marginal_cdf", MEM_TEXTURE),
       light_background_conditional_cdf(device, "__light_background_conditional_cdf", MEM_TEXTURE),
+      light_tree_nodes(device, "__light_tree_nodes", MEM_TEXTURE),
+      light_tree_emitter_to_leaf(device, "__light_tree_emitter_to_leaf", MEM_TEXTURE),
+      light_tree_infinite_lights(device, "__light_tree_infinite_lights", MEM_TEXTURE),
+      light_tree_object_to_triangle(device, "__light_tree_object_to_triangle", MEM_TEXTURE),
+      light_tree_triangle_to_emitter(device, "__light_tree_triangle_to_emitter", MEM_TEXTURE),
       particles(device, "__particles", MEM_TEXTURE),
       svm_nodes(device, "__svm_nodes", MEM_TEXTURE),
       shaders(device, "__shaders", MEM_TEXTURE),
@@ -101,6 +107,7 @@ Scene::Scene(const SceneParams &params_, Device *device)
   particle_system_manager = new ParticleSystemManager();
   curve_system_manager = new CurveSystemManager();
   bake_manager = new BakeManager();
+  update_stats = new SceneUpdateStats();
 
   /* OSL only works on the CPU */
   if (device->info.has_osl)
@@ -172,6 +179,7 @@ void Scene::free_memory(bool final)
     delete curve_system_manager;
     delete image_manager;
     delete bake_manager;
+    delete update_stats;
   }
 }
 
@@ -356,10 +364,10 @@ bool Scene::need_update()
 bool Scene::need_data_update()
 {
   return (background->need_update || image_manager->need_update || object_manager->need_update ||
-          geometry_manager->need_update || light_manager->need_update ||
-          lookup_tables->need_update || integrator->need_update || shader_manager->need_update ||
-          particle_system_manager->need_update || curve_system_manager->need_update ||
-          bake_manager->need_update || film->need_update);
+          geometry_manager->need_update || geometry_manager->need_update_scene_bvh ||
+          light_manager->need_update || lookup_tables->need_update || integrator->need_update ||
+          shader_manager->need_update || particle_system_manager->need_update ||
+          curve_system_manager->need_update || bake_manager->need_update || film->need_update);
 }
 
 bool Scene::need_reset()
@@ -394,6 +402,7 @@ void Scene::collect_statistics(RenderStats *stats)
 {
   geometry_manager->collect_statistics(this, stats);
   image_manager->collect_statistics(stats);
+  stats->scene_update = *update_stats;
 }
 
 CCL_NAMESPACE_END
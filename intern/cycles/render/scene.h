@@ -57,6 +57,7 @@ class Progress;
 class BakeManager;
 class BakeData;
 class RenderStats;
+class SceneUpdateStats;
 
 /* Scene Device Data */
 
@@ -107,6 +108,11 @@ class DeviceScene {
   device_vector<KernelLight> lights;
   device_vector<float2> light_background_marginal_cdf;
   device_vector<float2> light_background_conditional_cdf;
+  device_vector<KernelLightTreeNode> light_tree_nodes;
+  device_vector<uint> light_tree_emitter_to_leaf;
+  device_vector<uint> light_tree_infinite_lights;
+  device_vector<uint> light_tree_object_to_triangle;
+  device_vector<uint> light_tree_triangle_to_emitter;
 
   /* particles */
   device_vector<KernelParticle> particles;
@@ -170,6 +176,13 @@ class SceneParams {
   bool persistent_data;
   int texture_limit;
 
+  /* Page image tiles in on demand instead of loading full images, CPU only. */
+  bool texture_cache;
+  /* Memory ceiling of the texture cache in megabytes. */
+  int texture_cache_size;
+  /* Prefer tiled and mipmapped .tx files next to the images. */
+  bool texture_cache_use_tx;
+
   bool background;
 
   SceneParams()
@@ -182,6 +195,9 @@ class SceneParams {
     num_bvh_time_steps = 0;
     persistent_data = false;
     texture_limit = 0;
+    texture_cache = false;
+    texture_cache_size = 1024;
+    texture_cache_use_tx = true;
     background = true;
   }
 
@@ -192,7 +208,10 @@ class SceneParams {
              use_bvh_spatial_split == params.use_bvh_spatial_split &&
              use_bvh_unaligned_nodes == params.use_bvh_unaligned_nodes &&
              num_bvh_time_steps == params.num_bvh_time_steps &&
-             persistent_data == params.persistent_data && texture_limit == params.texture_limit);
+             persistent_data == params.persistent_data && texture_limit == params.texture_limit &&
+             texture_cache == params.texture_cache &&
+             texture_cache_size == params.texture_cache_size &&
+             texture_cache_use_tx == params.texture_cache_use_tx);
   }
 };
 
@@ -228,6 +247,9 @@ class Scene {
   CurveSystemManager *curve_system_manager;
   BakeManager *bake_manager;
 
+  /* time spent in the phases of the last device update */
+  SceneUpdateStats *update_stats;
+
   /* default shaders */
   Shader *default_surface;
   Shader *default_light;
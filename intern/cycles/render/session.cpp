@@ -1101,6 +1101,13 @@ void Session::render()
   task.need_finish_queue = params.progressive_refine;
   task.integrator_branched = scene->integrator->method == Integrator::BRANCHED_PATH;
 
+  const KernelFilm &kfilm = scene->dscene.data.film;
+  const KernelIntegrator &kintegrator = scene->dscene.data.integrator;
+  task.adaptive_sampling.use = (kintegrator.adaptive_threshold > 0.0f) &&
+                               kfilm.pass_adaptive_aux_buffer && kfilm.pass_sample_count;
+  task.adaptive_sampling.min_samples = kintegrator.adaptive_min_samples;
+  task.adaptive_sampling.adaptive_step = kintegrator.adaptive_step;
+
   device->task_add(task);
 }
 
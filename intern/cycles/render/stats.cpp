@@ -210,6 +210,42 @@ string MeshStats::full_report(int indent_level)
   return result;
 }
 
+/* Texture cache statistics. */
+
+TextureCacheStats::TextureCacheStats()
+    : use(false),
+      num_images(0),
+      memory_limit(0),
+      memory_used(0),
+      tiles_read(0),
+      bytes_read(0),
+      queries(0)
+{
+}
+
+string TextureCacheStats::full_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  string result = "";
+  result += string_printf("%sImages:       %d\n", indent.c_str(), num_images);
+  result += string_printf("%sMemory limit: %s\n",
+                          indent.c_str(),
+                          string_human_readable_size(memory_limit).c_str());
+  result += string_printf("%sMemory used:  %s\n",
+                          indent.c_str(),
+                          string_human_readable_size(memory_used).c_str());
+  result += string_printf("%sTiles read:   %s\n",
+                          indent.c_str(),
+                          string_human_readable_number(tiles_read).c_str());
+  result += string_printf("%sBytes read:   %s\n",
+                          indent.c_str(),
+                          string_human_readable_size(bytes_read).c_str());
+  result += string_printf("%sLookups:      %s\n",
+                          indent.c_str(),
+                          string_human_readable_number(queries).c_str());
+  return result;
+}
+
 /* Image statistics. */
 
 ImageStats::ImageStats()
@@ -221,6 +257,68 @@ string ImageStats::full_report(int indent_level)
   const string indent(indent_level * kIndentNumSpaces, ' ');
   string result = "";
   result += indent + "Textures:\n" + textures.full_report(indent_level + 1);
+  if (texture_cache.use) {
+    result += indent + "Texture Cache:\n" + texture_cache.full_report(indent_level + 1);
+  }
+  return result;
+}
+
+/* Update time statistics. */
+
+NamedTimeEntry::NamedTimeEntry(const string &name, double time) : name(name), time(time)
+{
+}
+
+UpdateTimeStats::UpdateTimeStats() : total_time(0.0)
+{
+}
+
+void UpdateTimeStats::add_entry(const NamedTimeEntry &entry)
+{
+  total_time += entry.time;
+  entries.push_back(entry);
+}
+
+void UpdateTimeStats::clear()
+{
+  total_time = 0.0;
+  entries.clear();
+}
+
+string UpdateTimeStats::full_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  const string double_indent = indent + indent;
+  string result = "";
+  result += string_printf("%sTotal time: %.3fs\n", indent.c_str(), total_time);
+  foreach (const NamedTimeEntry &entry, entries) {
+    result += string_printf(
+        "%s%-32s %.3fs\n", double_indent.c_str(), entry.name.c_str(), entry.time);
+  }
+  return result;
+}
+
+ScopedUpdateTimer::ScopedUpdateTimer(UpdateTimeStats *stats, const string &name)
+    : stats(stats), name(name)
+{
+}
+
+ScopedUpdateTimer::~ScopedUpdateTimer()
+{
+  if (stats != NULL) {
+    stats->add_entry(NamedTimeEntry(name, timer.get_time()));
+  }
+}
+
+SceneUpdateStats::SceneUpdateStats()
+{
+}
+
+string SceneUpdateStats::full_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  string result = "";
+  result += indent + "Geometry:\n" + geometry.full_report(indent_level + 1);
   return result;
 }
 
@@ -306,6 +404,7 @@ string RenderStats::full_report()
   string result = "";
   result += "Mesh statistics:\n" + mesh.full_report(1);
   result += "Image statistics:\n" + image.full_report(1);
+  result += "Scene update statistics:\n" + scene_update.full_report(1);
   if (has_profiling) {
     result += "Kernel statistics:\n" + kernel.full_report(1);
     result += "Shader statistics:\n" + shaders.full_report(1);
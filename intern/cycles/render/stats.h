@@ -21,6 +21,7 @@
 
 #include "util/util_stats.h"
 #include "util/util_string.h"
+#include "util/util_time.h"
 #include "util/util_vector.h"
 
 CCL_NAMESPACE_BEGIN
@@ -124,6 +125,28 @@ class MeshStats {
   NamedSizeStats geometry;
 };
 
+/* Statistics about images paged in on demand by the texture cache. */
+class TextureCacheStats {
+ public:
+  TextureCacheStats();
+
+  /* Generate full human-readable report. */
+  string full_report(int indent_level = 0);
+
+  bool use;
+
+  /* Number of images rendered through the cache. */
+  int num_images;
+  /* Memory ceiling and memory currently used by tiles. */
+  size_t memory_limit;
+  size_t memory_used;
+  /* Tiles and bytes read from image files. */
+  uint64_t tiles_read;
+  uint64_t bytes_read;
+  /* Number of texture lookups. */
+  uint64_t queries;
+};
+
 /* Statistics about images held in memory. */
 class ImageStats {
  public:
@@ -133,6 +156,59 @@ class ImageStats {
   string full_report(int indent_level = 0);
 
   NamedSizeStats textures;
+  TextureCacheStats texture_cache;
+};
+
+/* Named entry of the time spent in one phase of a scene update, in seconds. */
+class NamedTimeEntry {
+ public:
+  NamedTimeEntry(const string &name, double time);
+
+  string name;
+  double time;
+};
+
+/* Time spent in the phases of updating one part of the scene, in the order they ran. */
+class UpdateTimeStats {
+ public:
+  UpdateTimeStats();
+
+  /* Add entry to the statistics. */
+  void add_entry(const NamedTimeEntry &entry);
+
+  /* Remove all entries, done at the start of each update. */
+  void clear();
+
+  /* Generate full human-readable report. */
+  string full_report(int indent_level = 0);
+
+  /* Total time of all entries. */
+  double total_time;
+
+  vector<NamedTimeEntry> entries;
+};
+
+/* Adds the time spent until it goes out of scope as an entry of the update statistics. */
+class ScopedUpdateTimer {
+ public:
+  ScopedUpdateTimer(UpdateTimeStats *stats, const string &name);
+  ~ScopedUpdateTimer();
+
+ protected:
+  UpdateTimeStats *stats;
+  string name;
+  scoped_timer timer;
+};
+
+/* Statistics about the last device update of the scene. */
+class SceneUpdateStats {
+ public:
+  SceneUpdateStats();
+
+  /* Generate full human-readable report. */
+  string full_report(int indent_level = 0);
+
+  UpdateTimeStats geometry;
 };
 
 /* Render process statistics. */
@@ -150,6 +226,7 @@ class RenderStats {
 
   MeshStats mesh;
   ImageStats image;
+  SceneUpdateStats scene_update;
   NamedNestedSampleStats kernel;
   NamedSampleCountStats shaders;
   NamedSampleCountStats objects;
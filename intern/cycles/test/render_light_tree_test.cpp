@@ -0,0 +1,310 @@
+/*
+ * Copyright 2011-2019 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "render/light_tree.h"
+
+#include "util/util_hash.h"
+#include "util/util_math.h"
+
+#include "kernel/kernel_compat_cpu.h"
+#include "kernel/split/kernel_split_data.h"
+#include "kernel/kernel_globals.h"
+#include "kernel/kernel_light_tree.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Small emitters scattered in a unit cube, facing in random directions. */
+vector<LightTreeEmitter> light_tree_emitters(int num_emitters)
+{
+  vector<LightTreeEmitter> emitters(num_emitters);
+  for (int i = 0; i < num_emitters; i++) {
+    const float3 P = make_float3(hash_uint2_to_float(i, 0),
+                                 hash_uint2_to_float(i, 1),
+                                 hash_uint2_to_float(i, 2));
+    const float3 N = make_float3(hash_uint2_to_float(i, 3) - 0.5f,
+                                 hash_uint2_to_float(i, 4) - 0.5f,
+                                 hash_uint2_to_float(i, 5) - 0.5f);
+
+    LightTreeEmitter &emitter = emitters[i];
+    emitter.bbox = BoundBox(P - make_float3(0.01f, 0.01f, 0.01f),
+                            P + make_float3(0.01f, 0.01f, 0.01f));
+    emitter.orientation = LightTreeOrientation(normalize(N), 0.0f, M_PI_2_F);
+    emitter.energy = 1.0f + hash_uint2_to_float(i, 6);
+    /* Leave a gap in the light distribution, like lamps outside of the tree. */
+    emitter.emitter = 2 * i;
+  }
+  return emitters;
+}
+
+bool light_tree_bbox_contains(const KernelLightTreeNode &parent, const KernelLightTreeNode &child)
+{
+  for (int i = 0; i < 3; i++) {
+    if (child.bbox_min[i] < parent.bbox_min[i] || child.bbox_max[i] > parent.bbox_max[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+float light_tree_axis_angle(const float3 &a, const KernelLightTreeNode &node)
+{
+  const float3 axis = make_float3(node.axis[0], node.axis[1], node.axis[2]);
+  return acosf(clamp(dot(a, axis), -1.0f, 1.0f));
+}
+
+/* Kernel globals pointing to the light tree, with no lights outside of it. */
+void light_tree_kernel_globals(KernelGlobals *kg, LightTree &light_tree)
+{
+  kg->__light_tree_nodes.data = light_tree.nodes.data();
+  kg->__light_tree_nodes.width = light_tree.nodes.size();
+  kg->__light_tree_emitter_to_leaf.data = light_tree.emitter_to_leaf.data();
+  kg->__light_tree_emitter_to_leaf.width = light_tree.emitter_to_leaf.size();
+
+  kernel_data.integrator.use_light_tree = true;
+  kernel_data.integrator.pdf_light_tree = 1.0f;
+  kernel_data.integrator.num_infinite_lights = 0;
+  kernel_data.integrator.pdf_infinite_lights = 0.0f;
+}
+
+float3 light_tree_shading_point(int i)
+{
+  return make_float3(4.0f * hash_uint2_to_float(i, 7) - 1.5f,
+                     4.0f * hash_uint2_to_float(i, 8) - 1.5f,
+                     4.0f * hash_uint2_to_float(i, 9) - 1.5f);
+}
+
+}  // namespace
+
+TEST(render_light_tree, empty)
+{
+  vector<LightTreeEmitter> emitters;
+  LightTree light_tree(emitters, 4);
+
+  EXPECT_TRUE(light_tree.nodes.empty());
+  ASSERT_EQ(light_tree.emitter_to_leaf.size(), 4);
+  for (uint leaf : light_tree.emitter_to_leaf) {
+    EXPECT_EQ(leaf, ~0u);
+  }
+}
+
+TEST(render_light_tree, single)
+{
+  vector<LightTreeEmitter> emitters = light_tree_emitters(1);
+  LightTree light_tree(emitters, 2);
+
+  ASSERT_EQ(light_tree.nodes.size(), 1);
+  EXPECT_EQ(light_tree.nodes[0].emitter, 0);
+  EXPECT_EQ(light_tree.nodes[0].parent, -1);
+  EXPECT_EQ(light_tree.emitter_to_leaf[0], 0);
+  EXPECT_EQ(light_tree.emitter_to_leaf[1], ~0u);
+}
+
+TEST(render_light_tree, structure)
+{
+  const int num_emitters = 1000;
+  vector<LightTreeEmitter> emitters = light_tree_emitters(num_emitters);
+  LightTree light_tree(emitters, 2 * num_emitters);
+  const vector<KernelLightTreeNode> &nodes = light_tree.nodes;
+
+  /* One emitter per leaf. */
+  ASSERT_EQ(nodes.size(), 2 * num_emitters - 1);
+  EXPECT_EQ(nodes[0].parent, -1);
+
+  for (int i = 0; i < num_emitters; i++) {
+    EXPECT_EQ(light_tree.emitter_to_leaf[2 * i + 1], ~0u);
+
+    const uint leaf = light_tree.emitter_to_leaf[2 * i];
+    ASSERT_LT(leaf, nodes.size());
+    EXPECT_EQ(nodes[leaf].emitter, 2 * i);
+    EXPECT_EQ(nodes[leaf].right_child, -1);
+    EXPECT_FLOAT_EQ(nodes[leaf].energy, emitters[i].energy);
+  }
+
+  for (int index = 0; index < nodes.size(); index++) {
+    const KernelLightTreeNode &node = nodes[index];
+    if (node.emitter != -1) {
+      continue;
+    }
+
+    /* First child directly follows its parent. */
+    const int left_child = index + 1;
+    const int right_child = node.right_child;
+    ASSERT_GT(right_child, left_child);
+    ASSERT_LT(right_child, nodes.size());
+    EXPECT_EQ(nodes[left_child].parent, index);
+    EXPECT_EQ(nodes[right_child].parent, index);
+
+    /* Children are bounded by their parent. */
+    EXPECT_NEAR(node.energy, nodes[left_child].energy + nodes[right_child].energy, 1e-3f);
+    EXPECT_TRUE(light_tree_bbox_contains(node, nodes[left_child]));
+    EXPECT_TRUE(light_tree_bbox_contains(node, nodes[right_child]));
+    EXPECT_GE(node.theta_e, max(nodes[left_child].theta_e, nodes[right_child].theta_e));
+  }
+
+  /* All emitter normals are within the cone of their ancestors. */
+  for (int i = 0; i < num_emitters; i++) {
+    const float3 N = emitters[i].orientation.axis;
+    for (int index = light_tree.emitter_to_leaf[2 * i]; index != -1;
+         index = nodes[index].parent) {
+      EXPECT_LE(light_tree_axis_angle(N, nodes[index]), nodes[index].theta_o + 1e-3f);
+    }
+  }
+}
+
+TEST(render_light_tree, merge_orientation)
+{
+  const LightTreeOrientation a(make_float3(0.0f, 0.0f, 1.0f), 0.1f, 0.5f);
+  const LightTreeOrientation b(make_float3(1.0f, 0.0f, 0.0f), 0.2f, M_PI_2_F);
+  const LightTreeOrientation merged = merge(a, b);
+
+  EXPECT_FLOAT_EQ(merged.theta_e, M_PI_2_F);
+  EXPECT_NEAR(len(merged.axis), 1.0f, 1e-5f);
+  /* Both cones are inside of the merged one. */
+  EXPECT_LE(acosf(dot(merged.axis, a.axis)) + a.theta_o, merged.theta_o + 1e-4f);
+  EXPECT_LE(acosf(dot(merged.axis, b.axis)) + b.theta_o, merged.theta_o + 1e-4f);
+
+  /* A cone containing the other one is kept. */
+  const LightTreeOrientation wide(make_float3(0.0f, 0.0f, 1.0f), M_PI_2_F, 0.0f);
+  const LightTreeOrientation contained = merge(a, wide);
+  EXPECT_FLOAT_EQ(contained.theta_o, M_PI_2_F);
+  EXPECT_NEAR(contained.axis.z, 1.0f, 1e-5f);
+}
+
+/* Emitters at the same position which light every direction with the same energy can't be told
+ * apart by the tree, so it must pick them with the probability of the flat light distribution. */
+TEST(render_light_tree, flat_equivalence)
+{
+  const int num_emitters = 7;
+  vector<LightTreeEmitter> emitters = light_tree_emitters(num_emitters);
+  for (LightTreeEmitter &emitter : emitters) {
+    emitter.bbox = BoundBox(make_float3(0.4f, 0.5f, 0.6f), make_float3(0.6f, 0.5f, 0.7f));
+    emitter.orientation = LightTreeOrientation(make_float3(0.0f, 0.0f, 1.0f), M_PI_F, M_PI_2_F);
+    emitter.energy = 1.0f;
+  }
+  LightTree light_tree(emitters, 2 * num_emitters);
+
+  KernelGlobals kernel_globals = KernelGlobals();
+  KernelGlobals *kg = &kernel_globals;
+  light_tree_kernel_globals(kg, light_tree);
+
+  const float pdf_flat = 1.0f / num_emitters;
+  for (int p = 0; p < 16; p++) {
+    const float3 P = light_tree_shading_point(p);
+
+    for (int i = 0; i < num_emitters; i++) {
+      const int leaf = light_tree.emitter_to_leaf[2 * i];
+      EXPECT_NEAR(light_tree_leaf_pdf(kg, P, leaf), pdf_flat, 1e-5f);
+    }
+
+    /* Stratified random numbers pick every emitter once, like the flat distribution. */
+    vector<int> num_picked(2 * num_emitters, 0);
+    for (int i = 0; i < num_emitters; i++) {
+      float randu = (i + 0.5f) * pdf_flat;
+      float pdf;
+      const int emitter = light_tree_select(kg, P, &randu, &pdf);
+      ASSERT_GE(emitter, 0);
+      ASSERT_LT(emitter, 2 * num_emitters);
+      num_picked[emitter]++;
+      EXPECT_NEAR(pdf, pdf_flat, 1e-5f);
+      EXPECT_NEAR(randu, 0.5f, 1e-3f);
+    }
+    for (int i = 0; i < num_emitters; i++) {
+      EXPECT_EQ(num_picked[2 * i], 1);
+    }
+  }
+}
+
+/* The pdf of a sampled emitter must match the one used for multiple importance sampling of
+ * emission hit by a ray. */
+TEST(render_light_tree, sample_pdf)
+{
+  const int num_emitters = 100;
+  vector<LightTreeEmitter> emitters = light_tree_emitters(num_emitters);
+  LightTree light_tree(emitters, 2 * num_emitters);
+
+  KernelGlobals kernel_globals = KernelGlobals();
+  KernelGlobals *kg = &kernel_globals;
+  light_tree_kernel_globals(kg, light_tree);
+
+  for (int p = 0; p < 16; p++) {
+    const float3 P = light_tree_shading_point(p);
+
+    float pdf_sum = 0.0f;
+    for (int i = 0; i < num_emitters; i++) {
+      pdf_sum += light_tree_leaf_pdf(kg, P, light_tree.emitter_to_leaf[2 * i]);
+    }
+    /* Less than one when some subtree can't light P, sampling then fails. */
+    EXPECT_GT(pdf_sum, 0.0f);
+    EXPECT_LE(pdf_sum, 1.0f + 1e-4f);
+
+    for (int i = 0; i < 64; i++) {
+      float randu = hash_uint2_to_float(p, i);
+      float pdf;
+      const int emitter = light_tree_sample(kg, P, &randu, &pdf);
+      if (emitter < 0) {
+        continue;
+      }
+      const int leaf = light_tree.emitter_to_leaf[emitter];
+      EXPECT_NEAR(pdf, light_tree_leaf_pdf(kg, P, leaf), 1e-5f);
+      EXPECT_GE(randu, 0.0f);
+      EXPECT_LE(randu, 1.0f);
+    }
+  }
+}
+
+/* Lights outside of the tree are picked with their own probability, leaving the one of the flat
+ * light distribution alone. */
+TEST(render_light_tree, infinite_lights)
+{
+  vector<LightTreeEmitter> emitters = light_tree_emitters(4);
+  LightTree light_tree(emitters, 8);
+  vector<uint> infinite_lights = {1, 3};
+
+  KernelGlobals kernel_globals = KernelGlobals();
+  KernelGlobals *kg = &kernel_globals;
+  light_tree_kernel_globals(kg, light_tree);
+  kg->__light_tree_infinite_lights.data = infinite_lights.data();
+  kg->__light_tree_infinite_lights.width = infinite_lights.size();
+  kernel_data.integrator.pdf_lights = 0.125f;
+  kernel_data.integrator.pdf_light_tree = 0.5f;
+  kernel_data.integrator.num_infinite_lights = infinite_lights.size();
+  kernel_data.integrator.pdf_infinite_lights = 0.25f;
+
+  const float3 P = light_tree_shading_point(0);
+  for (int i = 0; i < 2; i++) {
+    float randu = 0.5f + 0.25f * (i + 0.5f);
+    float pdf;
+    EXPECT_EQ(light_tree_select(kg, P, &randu, &pdf), infinite_lights[i]);
+    EXPECT_FLOAT_EQ(pdf, 0.25f);
+    EXPECT_NEAR(randu, 0.5f, 1e-5f);
+  }
+
+  float randu = 0.25f;
+  float pdf;
+  const int emitter = light_tree_select(kg, P, &randu, &pdf);
+  ASSERT_GE(emitter, 0);
+  EXPECT_NEAR(pdf, 0.5f * light_tree_leaf_pdf(kg, P, light_tree.emitter_to_leaf[emitter]), 1e-5f);
+
+  /* Multiple importance sampling only uses the light tree pdfs when it picked the light. */
+  EXPECT_TRUE(light_tree_use_for_mis(kg, PATH_RAY_DIFFUSE));
+  EXPECT_FALSE(light_tree_use_for_mis(kg, PATH_RAY_DIFFUSE | PATH_RAY_ALL_LIGHTS));
+}
+
+CCL_NAMESPACE_END
@@ -632,6 +632,10 @@ class NODE_PT_quality(bpy.types.Panel):
         tree = snode.node_tree
 
         col = layout.column()
+        col.prop(tree, "execution_mode")
+        sub = col.column()
+        sub.active = tree.execution_mode == 'FULL_FRAME'
+        sub.prop(tree, "cache_size")
         col.prop(tree, "render_quality", text="Render")
         col.prop(tree, "edit_quality", text="Edit")
         col.prop(tree, "chunk_size")
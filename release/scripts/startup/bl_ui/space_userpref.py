@@ -2088,6 +2088,22 @@ class ExperimentalPanel:
 
     url_prefix = "https://developer.blender.org/"
 
+
+class USERPREF_PT_experimental_system(ExperimentalPanel, Panel):
+    bl_label = "System"
+
+    def draw(self, context):
+        prefs = context.preferences
+        experimental = prefs.experimental
+
+        layout = self.layout
+        layout.use_property_split = True
+        layout.use_property_decorate = False
+
+        col = layout.column()
+        col.prop(experimental, "use_undo_speedup")
+
+
 """
 # Example panel, leave it here so we always have a template to follow even
 # after the features are gone from the experimental panel.
@@ -2203,6 +2219,8 @@ classes = (
     USERPREF_PT_studiolight_matcaps,
     USERPREF_PT_studiolight_world,
 
+    USERPREF_PT_experimental_system,
+
     # Popovers.
     USERPREF_PT_ndof_settings,
 
@@ -242,6 +242,7 @@ enum {
 bool bvhcache_find(const BVHCache *cache, int type, BVHTree **r_tree);
 bool bvhcache_has_tree(const BVHCache *cache, const BVHTree *tree);
 void bvhcache_insert(BVHCache **cache_p, BVHTree *tree, int type);
+void bvhcache_tag_deformed(BVHCache *cache);
 void bvhcache_free(BVHCache **cache_p);
 
 #endif
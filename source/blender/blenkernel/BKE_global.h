@@ -153,13 +153,14 @@ enum {
   G_DEBUG_GPU_SHADERS = (1 << 18),           /* GLSL shaders */
   G_DEBUG_GPU_FORCE_WORKAROUNDS = (1 << 19), /* force gpu workarounds bypassing detections. */
 
-  G_DEBUG_GHOST = (1 << 20), /* Debug GHOST module. */
+  G_DEBUG_GHOST = (1 << 20),      /* Debug GHOST module. */
+  G_DEBUG_COMPOSITOR = (1 << 21), /* compositor execution trace */
 };
 
 #define G_DEBUG_ALL \
   (G_DEBUG | G_DEBUG_FFMPEG | G_DEBUG_PYTHON | G_DEBUG_EVENTS | G_DEBUG_WM | G_DEBUG_JOBS | \
    G_DEBUG_FREESTYLE | G_DEBUG_DEPSGRAPH | G_DEBUG_GPU_MEM | G_DEBUG_IO | G_DEBUG_GPU_SHADERS | \
-   G_DEBUG_GHOST)
+   G_DEBUG_GHOST | G_DEBUG_COMPOSITOR)
 
 /** #Global.fileflags */
 enum {
@@ -183,6 +184,8 @@ enum {
   /** On write, restore paths after editing them (G_FILE_RELATIVE_REMAP) */
   G_FILE_SAVE_COPY = (1 << 27),
   /* #define G_FILE_GLSL_NO_ENV_LIGHTING (1 << 28) */ /* deprecated */
+  /** On write, use multi-threaded Zstandard instead of gzip when #G_FILE_COMPRESS is set. */
+  G_FILE_COMPRESS_ZSTD = (1 << 29),
 };
 
 /** Don't overwrite these flags when reading a file. */
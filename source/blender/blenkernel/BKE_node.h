@@ -1195,6 +1195,16 @@ void ntreeCompositRegisterPass(struct bNodeTree *ntree,
                                int type);
 void ntreeCompositClearTags(struct bNodeTree *ntree);
 
+/* Profiling of compositor nodes, runtime only. */
+typedef struct bNodeExecutionStats {
+  /** Time in seconds of the last execution. */
+  float time;
+  /** Memory in MB of the results of the last execution. */
+  float memory;
+} bNodeExecutionStats;
+
+void ntreeCompositMergeExecutionStats(struct bNodeTree *ntree, struct bNodeTree *exec_ntree);
+
 struct bNodeSocket *ntreeCompositOutputFileAddSocket(struct bNodeTree *ntree,
                                                      struct bNode *node,
                                                      const char *name,
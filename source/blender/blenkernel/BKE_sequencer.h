@@ -298,6 +298,10 @@ void BKE_sequencer_proxy_rebuild(struct SeqIndexBuildContext *context,
                                  short *stop,
                                  short *do_update,
                                  float *num_frames_prefetched);
+void BKE_sequencer_proxy_rebuild_queue(ListBase *queue,
+                                       short *stop,
+                                       short *do_update,
+                                       float *progress);
 void BKE_sequencer_proxy_rebuild_finish(struct SeqIndexBuildContext *context, bool stop);
 
 void BKE_sequencer_proxy_set(struct Sequence *seq, bool value);
@@ -309,6 +313,13 @@ void BKE_sequencer_proxy_set(struct Sequence *seq, bool value);
 
 #define SEQ_CACHE_COST_MAX 10.0f
 
+typedef struct SeqCacheStats {
+  /** Lookups of cached images, see #BKE_sequencer_cache_get. */
+  size_t hits, misses;
+  /** Number of images freed by recycling. */
+  size_t evictions;
+} SeqCacheStats;
+
 struct ImBuf *BKE_sequencer_cache_get(const SeqRenderData *context,
                                       struct Sequence *seq,
                                       float cfra,
@@ -340,6 +351,7 @@ void BKE_sequencer_cache_iterate(
     bool callback(void *userdata, struct Sequence *seq, int cfra, int cache_type, float cost));
 size_t BKE_sequencer_cache_get_num_items(struct Scene *scene);
 bool BKE_sequencer_cache_is_full(struct Scene *scene);
+void BKE_sequencer_cache_stats_get(struct Scene *scene, SeqCacheStats *r_stats);
 
 /* **********************************************************************
  * seqprefetch.c
@@ -61,7 +61,11 @@
 
 #define UNDO_DISK 0
 
-bool BKE_memfile_undo_decode(MemFileUndoData *mfu, bContext *C)
+/**
+ * \param mfu_reference: The undo data matching the current state (optional),
+ * data-blocks unchanged since are reused instead of being read.
+ */
+bool BKE_memfile_undo_decode(MemFileUndoData *mfu, MemFileUndoData *mfu_reference, bContext *C)
 {
   Main *bmain = CTX_data_main(C);
   char mainstr[sizeof(bmain->name)];
@@ -76,8 +80,11 @@ bool BKE_memfile_undo_decode(MemFileUndoData *mfu, bContext *C)
     success = BKE_blendfile_read(C, mfu->filename, &(const struct BlendFileReadParams){0}, NULL);
   }
   else {
-    success = BKE_blendfile_read_from_memfile(
-        C, &mfu->memfile, &(const struct BlendFileReadParams){0}, NULL);
+    success = BKE_blendfile_read_from_memfile(C,
+                                              &mfu->memfile,
+                                              mfu_reference ? &mfu_reference->memfile : NULL,
+                                              &(const struct BlendFileReadParams){0},
+                                              NULL);
   }
 
   /* Restore, bmain has been re-allocated. */
@@ -464,17 +464,26 @@ bool BKE_blendfile_read_from_memory(bContext *C,
   return (bfd != NULL);
 }
 
-/* memfile is the undo buffer */
+/**
+ * \param memfile: The undo buffer.
+ * \param memfile_reference: The undo buffer matching the current data (optional),
+ * see: #BLO_read_from_memfile.
+ */
 bool BKE_blendfile_read_from_memfile(bContext *C,
                                      struct MemFile *memfile,
+                                     struct MemFile *memfile_reference,
                                      const struct BlendFileReadParams *params,
                                      ReportList *reports)
 {
   Main *bmain = CTX_data_main(C);
   BlendFileData *bfd;
 
-  bfd = BLO_read_from_memfile(
-      bmain, BKE_main_blendfile_path(bmain), memfile, params->skip_flags, reports);
+  bfd = BLO_read_from_memfile(bmain,
+                              BKE_main_blendfile_path(bmain),
+                              memfile,
+                              memfile_reference,
+                              params->skip_flags,
+                              reports);
   if (bfd) {
     /* remove the unused screens and wm */
     while (bfd->main->wm.first) {
@@ -43,6 +43,27 @@
 
 static ThreadRWMutex cache_rwlock = BLI_RWLOCK_INITIALIZER;
 
+typedef struct BVHCacheItem {
+  int type;
+  BVHTree *tree;
+  /** The vertices moved since the tree was built, see: #bvhcache_tag_deformed. */
+  bool is_deformed;
+  /** Protects #is_deformed and the tree while it's refitted, without locking the whole cache. */
+  ThreadMutex refit_mutex;
+} BVHCacheItem;
+
+static BVHCacheItem *bvhcache_find_item(const BVHCache *cache, int type)
+{
+  while (cache) {
+    BVHCacheItem *item = cache->link;
+    if (item->type == type) {
+      return item;
+    }
+    cache = cache->next;
+  }
+  return NULL;
+}
+
 /* -------------------------------------------------------------------- */
 /** \name Local Callbacks
  * \{ */
@@ -1306,6 +1327,117 @@ static BLI_bitmap *looptri_no_hidden_map_get(const MPoly *mpoly,
   return looptri_mask;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Refit
+ *
+ * Update the bounds of a cached tree from the current vertex coordinates of its mesh.
+ * \{ */
+
+typedef struct BVHRefitMeshData {
+  const MVert *vert;
+  const MEdge *edge;
+  const MFace *face;
+  const MLoop *loop;
+  const MLoopTri *looptri;
+} BVHRefitMeshData;
+
+static int mesh_verts_refit_cb(void *userdata, int index, float r_co[BVH_REFIT_POINTS_MAX][3])
+{
+  const BVHRefitMeshData *data = userdata;
+  copy_v3_v3(r_co[0], data->vert[index].co);
+  return 1;
+}
+
+static int mesh_edges_refit_cb(void *userdata, int index, float r_co[BVH_REFIT_POINTS_MAX][3])
+{
+  const BVHRefitMeshData *data = userdata;
+  const MEdge *edge = &data->edge[index];
+  copy_v3_v3(r_co[0], data->vert[edge->v1].co);
+  copy_v3_v3(r_co[1], data->vert[edge->v2].co);
+  return 2;
+}
+
+static int mesh_faces_refit_cb(void *userdata, int index, float r_co[BVH_REFIT_POINTS_MAX][3])
+{
+  const BVHRefitMeshData *data = userdata;
+  const MFace *face = &data->face[index];
+  copy_v3_v3(r_co[0], data->vert[face->v1].co);
+  copy_v3_v3(r_co[1], data->vert[face->v2].co);
+  copy_v3_v3(r_co[2], data->vert[face->v3].co);
+  if (face->v4) {
+    copy_v3_v3(r_co[3], data->vert[face->v4].co);
+    return 4;
+  }
+  return 3;
+}
+
+static int mesh_looptri_refit_cb(void *userdata, int index, float r_co[BVH_REFIT_POINTS_MAX][3])
+{
+  const BVHRefitMeshData *data = userdata;
+  const MLoopTri *lt = &data->looptri[index];
+  copy_v3_v3(r_co[0], data->vert[data->loop[lt->tri[0]].v].co);
+  copy_v3_v3(r_co[1], data->vert[data->loop[lt->tri[1]].v].co);
+  copy_v3_v3(r_co[2], data->vert[data->loop[lt->tri[2]].v].co);
+  return 3;
+}
+
+static void bvhtree_from_mesh_refit(BVHTree *tree, Mesh *mesh, const int bvh_cache_type)
+{
+  BVHRefitMeshData data = {
+      .vert = mesh->mvert,
+      .edge = mesh->medge,
+      .face = mesh->mface,
+      .loop = mesh->mloop,
+  };
+  BVHTree_RefitCallback callback = NULL;
+
+  switch (bvh_cache_type) {
+    case BVHTREE_FROM_VERTS:
+    case BVHTREE_FROM_LOOSEVERTS:
+      callback = mesh_verts_refit_cb;
+      break;
+    case BVHTREE_FROM_EDGES:
+    case BVHTREE_FROM_LOOSEEDGES:
+      callback = mesh_edges_refit_cb;
+      break;
+    case BVHTREE_FROM_FACES:
+      callback = mesh_faces_refit_cb;
+      break;
+    case BVHTREE_FROM_LOOPTRI:
+    case BVHTREE_FROM_LOOPTRI_NO_HIDDEN:
+      data.looptri = BKE_mesh_runtime_looptri_ensure(mesh);
+      callback = mesh_looptri_refit_cb;
+      break;
+    case BVHTREE_FROM_EM_VERTS:
+    case BVHTREE_FROM_EM_EDGES:
+    case BVHTREE_FROM_EM_LOOPTRI:
+      BLI_assert(false);
+      return;
+  }
+
+  BLI_bvhtree_refit(tree, callback, &data);
+}
+
+/**
+ * Refit the cached tree of \a bvh_cache_type when it's tagged as deformed.
+ */
+static void bvhcache_deformed_refit(BVHCache *cache, Mesh *mesh, const int bvh_cache_type)
+{
+  BLI_rw_mutex_lock(&cache_rwlock, THREAD_LOCK_READ);
+  BVHCacheItem *item = bvhcache_find_item(cache, bvh_cache_type);
+  BLI_rw_mutex_unlock(&cache_rwlock);
+
+  /* Items are only freed with the whole cache, the item lock is enough while refitting. */
+  BLI_mutex_lock(&item->refit_mutex);
+  if (item->is_deformed) {
+    bvhtree_from_mesh_refit(item->tree, mesh, bvh_cache_type);
+    item->is_deformed = false;
+  }
+  BLI_mutex_unlock(&item->refit_mutex);
+}
+
+/** \} */
+
 /**
  * Builds or queries a bvhcache for the cache bvhtree of the request type.
  */
@@ -1326,6 +1458,10 @@ BVHTree *BKE_bvhtree_from_mesh_get(struct BVHTreeFromMesh *data,
     return tree;
   }
 
+  if (is_cached) {
+    bvhcache_deformed_refit(*bvh_cache, mesh, bvh_cache_type);
+  }
+
   switch (bvh_cache_type) {
     case BVHTREE_FROM_VERTS:
     case BVHTREE_FROM_LOOSEVERTS:
@@ -1620,24 +1756,15 @@ void free_bvhtree_from_mesh(struct BVHTreeFromMesh *data)
 /** \name BVHCache
  * \{ */
 
-typedef struct BVHCacheItem {
-  int type;
-  BVHTree *tree;
-
-} BVHCacheItem;
-
 /**
  * Queries a bvhcache for the cache bvhtree of the request type
  */
 bool bvhcache_find(const BVHCache *cache, int type, BVHTree **r_tree)
 {
-  while (cache) {
-    const BVHCacheItem *item = cache->link;
-    if (item->type == type) {
-      *r_tree = item->tree;
-      return true;
-    }
-    cache = cache->next;
+  const BVHCacheItem *item = bvhcache_find_item(cache, type);
+  if (item) {
+    *r_tree = item->tree;
+    return true;
   }
   return false;
 }
@@ -1672,10 +1799,34 @@ void bvhcache_insert(BVHCache **cache_p, BVHTree *tree, int type)
 
   item->type = type;
   item->tree = tree;
+  item->is_deformed = false;
+  BLI_mutex_init(&item->refit_mutex);
 
   BLI_linklist_prepend(cache_p, item);
 }
 
+/**
+ * Tag the trees of a mesh whose vertices moved without changing its topology,
+ * #BKE_bvhtree_from_mesh_get refits them the next time they're used instead of building them
+ * again (which is much faster for large meshes).
+ */
+void bvhcache_tag_deformed(BVHCache *cache)
+{
+  if (cache == NULL) {
+    return;
+  }
+
+  /* The list itself isn't modified, the flag is protected by the item lock. */
+  BLI_rw_mutex_lock(&cache_rwlock, THREAD_LOCK_READ);
+  for (; cache; cache = cache->next) {
+    BVHCacheItem *item = cache->link;
+    BLI_mutex_lock(&item->refit_mutex);
+    item->is_deformed = true;
+    BLI_mutex_unlock(&item->refit_mutex);
+  }
+  BLI_rw_mutex_unlock(&cache_rwlock);
+}
+
 /**
  * frees a bvhcache
  */
@@ -1684,6 +1835,7 @@ static void bvhcacheitem_free(void *_item)
   BVHCacheItem *item = (BVHCacheItem *)_item;
 
   BLI_bvhtree_free(item->tree);
+  BLI_mutex_end(&item->refit_mutex);
   MEM_freeN(item);
 }
 
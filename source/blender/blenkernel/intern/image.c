@@ -153,11 +153,11 @@ static void imagecache_put(Image *image, int index, ImBuf *ibuf)
   ImageCacheKey key;
 
   if (image->cache == NULL) {
-    // char cache_name[64];
-    // SNPRINTF(cache_name, "Image Datablock %s", image->id.name);
+    char cache_name[64];
+    SNPRINTF(cache_name, "Image Datablock %s", image->id.name + 2);
 
     image->cache = IMB_moviecache_create(
-        "Image Datablock Cache", sizeof(ImageCacheKey), imagecache_hashhash, imagecache_hashcmp);
+        cache_name, sizeof(ImageCacheKey), imagecache_hashhash, imagecache_hashcmp);
     IMB_moviecache_set_getdata_callback(image->cache, imagecache_keydata);
   }
 
@@ -3651,6 +3651,10 @@ RenderPass *BKE_image_multilayer_index(RenderResult *rr, ImageUser *iuser)
         int rp_index;
         rpass = image_render_pass_get(rl, iuser->pass, rv_index, &rp_index);
         iuser->multi_index = index + rp_index;
+        /* Passes of multilayer files are read once they are used. */
+        if (rpass) {
+          RE_RenderResult_load_pass(rr, rl, rpass);
+        }
         break;
       }
       else {
@@ -3863,12 +3867,13 @@ static void image_create_multilayer(Image *ima, ImBuf *ibuf, int framenr)
   const char *colorspace = ima->colorspace_settings.name;
   bool predivide = (ima->alpha_mode == IMA_ALPHA_PREMUL);
 
-  /* only load rr once for multiview */
+  /* only load rr once for multiview, the render result takes over the handle */
   if (!ima->rr) {
     ima->rr = RE_MultilayerConvert(ibuf->userdata, colorspace, predivide, ibuf->x, ibuf->y);
   }
-
-  IMB_exr_close(ibuf->userdata);
+  else {
+    IMB_exr_close(ibuf->userdata);
+  }
 
   ibuf->userdata = NULL;
   if (ima->rr != NULL) {
@@ -3955,7 +3960,7 @@ static ImBuf *load_sequence_single(
   iuser_t.view = view_id;
   BKE_image_user_file_path(&iuser_t, ima, name);
 
-  flag = IB_rect | IB_multilayer | IB_metadata;
+  flag = IB_rect | IB_multilayer | IB_multilayer_lazy | IB_metadata;
   flag |= imbuf_alpha_flags_for_image(ima);
 
   /* read ibuf */
@@ -4250,7 +4255,7 @@ static ImBuf *load_image_single(Image *ima,
   if (has_packed) {
     ImagePackedFile *imapf;
 
-    flag = IB_rect | IB_multilayer;
+    flag = IB_rect | IB_multilayer | IB_multilayer_lazy;
     flag |= imbuf_alpha_flags_for_image(ima);
 
     imapf = BLI_findlink(&ima->packedfiles, view_id);
@@ -4265,7 +4270,7 @@ static ImBuf *load_image_single(Image *ima,
   else {
     ImageUser iuser_t;
 
-    flag = IB_rect | IB_multilayer | IB_metadata;
+    flag = IB_rect | IB_multilayer | IB_multilayer_lazy | IB_metadata;
     flag |= imbuf_alpha_flags_for_image(ima);
 
     /* get the correct filepath */
@@ -5492,6 +5497,7 @@ bool BKE_image_is_dirty(Image *image)
 void BKE_image_mark_dirty(Image *UNUSED(image), ImBuf *ibuf)
 {
   ibuf->userflags |= IB_BITMAPDIRTY;
+  IMB_tag_update(ibuf);
 }
 
 bool BKE_image_buffer_format_writable(ImBuf *ibuf)
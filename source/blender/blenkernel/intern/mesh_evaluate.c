@@ -44,6 +44,7 @@
 #include "BLI_alloca.h"
 #include "BLI_stack.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_customdata.h"
 #include "BKE_global.h"
@@ -216,6 +217,12 @@ typedef struct MeshCalcNormalsData {
   float (*pnors)[3];
   float (*lnors_weighted)[3];
   float (*vnors)[3];
+  /**
+   * Loops using each vertex: the loops of vertex `v` are
+   * `vert_loops[vert_loops_offset[v]]` to `vert_loops[vert_loops_offset[v + 1] - 1]`.
+   */
+  int *vert_loops_offset;
+  int *vert_loops;
 } MeshCalcNormalsData;
 
 static void mesh_calc_normals_poly_cb(void *__restrict userdata,
@@ -272,7 +279,7 @@ static void mesh_calc_normals_poly_prepare_cb(void *__restrict userdata,
 
   /* accumulate angle weighted face normal */
   /* inline version of #accumulate_vertex_normals_poly_v3,
-   * split between this threaded callback and #mesh_calc_normals_poly_accum_cb. */
+   * split between this threaded callback and #mesh_calc_normals_poly_accum. */
   {
     const float *prev_edge = edgevecbuf[nverts - 1];
 
@@ -292,6 +299,44 @@ static void mesh_calc_normals_poly_prepare_cb(void *__restrict userdata,
   }
 }
 
+static void mesh_calc_normals_poly_vert_loops_count_cb(
+    void *__restrict userdata, const int lidx, const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshCalcNormalsData *data = userdata;
+  atomic_add_and_fetch_int32(&data->vert_loops_offset[data->mloop[lidx].v], 1);
+}
+
+static void mesh_calc_normals_poly_vert_loops_fill_cb(
+    void *__restrict userdata, const int lidx, const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshCalcNormalsData *data = userdata;
+  /* Offsets point to the end of each vertex range, fill it backwards so they end at its start. */
+  const int index = atomic_sub_and_fetch_int32(&data->vert_loops_offset[data->mloop[lidx].v], 1);
+  data->vert_loops[index] = lidx;
+}
+
+static void mesh_calc_normals_poly_accum(MeshCalcNormalsData *data, const int vidx)
+{
+  int *vert_loops = &data->vert_loops[data->vert_loops_offset[vidx]];
+  const int vert_loops_len = data->vert_loops_offset[vidx + 1] - data->vert_loops_offset[vidx];
+  float *no = data->vnors[vidx];
+
+  /* The map is filled in any order by threads, sort loops so the sum is deterministic.
+   * Vertices only have a few loops, insertion sort is fine. */
+  for (int i = 1; i < vert_loops_len; i++) {
+    const int lidx = vert_loops[i];
+    int j = i;
+    for (; (j > 0) && (vert_loops[j - 1] > lidx); j--) {
+      vert_loops[j] = vert_loops[j - 1];
+    }
+    vert_loops[j] = lidx;
+  }
+
+  for (int i = 0; i < vert_loops_len; i++) {
+    add_v3_v3(no, data->lnors_weighted[vert_loops[i]]);
+  }
+}
+
 static void mesh_calc_normals_poly_finalize_cb(void *__restrict userdata,
                                                const int vidx,
                                                const TaskParallelTLS *__restrict UNUSED(tls))
@@ -301,6 +346,10 @@ static void mesh_calc_normals_poly_finalize_cb(void *__restrict userdata,
   MVert *mv = &data->mverts[vidx];
   float *no = data->vnors[vidx];
 
+  if (data->vert_loops != NULL) {
+    mesh_calc_normals_poly_accum(data, vidx);
+  }
+
   if (UNLIKELY(normalize_v3(no) == 0.0f)) {
     /* following Mesh convention; we use vertex coordinate itself for normal in this case */
     normalize_v3_v3(no, mv->co);
@@ -366,20 +415,41 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
   /* Compute poly normals, and prepare weighted loop normals. */
   BLI_task_parallel_range(0, numPolys, &data, mesh_calc_normals_poly_prepare_cb, &settings);
 
-  /* Actually accumulate weighted loop normals into vertex ones. */
-  /* Unfortunately, not possible to thread that
-   * (not in a reasonable, totally lock- and barrier-free fashion),
-   * since several loops will point to the same vertex... */
-  for (int lidx = 0; lidx < numLoops; lidx++) {
-    add_v3_v3(vnors[mloop[lidx].v], data.lnors_weighted[lidx]);
+  /* Actually accumulate weighted loop normals into vertex ones.
+   * Several loops use the same vertex, so instead of adding loop normals to vertices
+   * (which can't be threaded without atomic float operations), gather the loop normals
+   * of each vertex from a vertex to loops map, built in parallel with integer atomics.
+   * Building the map is more work than the serial sum, only do it when threads can share it. */
+  if ((numLoops > settings.min_iter_per_thread) && (BLI_system_thread_count() > 1)) {
+    data.vert_loops_offset = MEM_calloc_arrayN(
+        (size_t)numVerts + 1, sizeof(*data.vert_loops_offset), __func__);
+    data.vert_loops = MEM_malloc_arrayN((size_t)numLoops, sizeof(*data.vert_loops), __func__);
+
+    BLI_task_parallel_range(
+        0, numLoops, &data, mesh_calc_normals_poly_vert_loops_count_cb, &settings);
+    /* Accumulate counts, so each offset is the end of its vertex range,
+     * the fill moves it back to the start. */
+    for (int vidx = 1; vidx < numVerts; vidx++) {
+      data.vert_loops_offset[vidx] += data.vert_loops_offset[vidx - 1];
+    }
+    data.vert_loops_offset[numVerts] = numLoops;
+    BLI_task_parallel_range(
+        0, numLoops, &data, mesh_calc_normals_poly_vert_loops_fill_cb, &settings);
+  }
+  else {
+    for (int lidx = 0; lidx < numLoops; lidx++) {
+      add_v3_v3(vnors[mloop[lidx].v], data.lnors_weighted[lidx]);
+    }
   }
 
-  /* Normalize and validate computed vertex normals. */
+  /* Accumulate, normalize and validate computed vertex normals. */
   BLI_task_parallel_range(0, numVerts, &data, mesh_calc_normals_poly_finalize_cb, &settings);
 
   if (free_vnors) {
     MEM_freeN(vnors);
   }
+  MEM_SAFE_FREE(data.vert_loops_offset);
+  MEM_SAFE_FREE(data.vert_loops);
   MEM_freeN(lnors_weighted);
 }
 
@@ -803,6 +873,16 @@ typedef struct LoopSplitTaskDataCommon {
   int numPolys;
 } LoopSplitTaskDataCommon;
 
+/** The loop a smooth fan is walked from (see #LoopSplitTaskData), found once for all evaluations
+ * of a topology in #MeshLoopSplitCache. */
+typedef struct LoopSplitFan {
+  int ml_curr_index;
+  int ml_prev_index;
+  int mp_index;
+  /** Both edges of the loop are sharp, see #split_loop_nor_single_do. */
+  bool is_single;
+} LoopSplitFan;
+
 #define INDEX_UNSET INT_MIN
 #define INDEX_INVALID -1
 /* See comment about edge_to_loops below. */
@@ -1408,7 +1488,13 @@ static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
   }
 }
 
-static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common_data)
+/**
+ * \param r_fans: When set, only find the smooth fans and add their #LoopSplitFan to this stack,
+ * without computing their normals.
+ */
+static void loop_split_generator(TaskPool *pool,
+                                 LoopSplitTaskDataCommon *common_data,
+                                 BLI_Stack *r_fans)
 {
   MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
   float(*loopnors)[3] = common_data->loopnors;
@@ -1441,7 +1527,7 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
   TIMEIT_START_AVERAGED(loop_split_generator);
 #endif
 
-  if (!pool) {
+  if (!pool && !r_fans) {
     if (lnors_spacearr) {
       edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
     }
@@ -1497,6 +1583,13 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
                                                                                      mp_index))) {
         //              printf("SKIPPING!\n");
       }
+      else if (r_fans) {
+        LoopSplitFan *fan = BLI_stack_push_r(r_fans);
+        fan->ml_curr_index = ml_curr_index;
+        fan->ml_prev_index = ml_prev_index;
+        fan->mp_index = mp_index;
+        fan->is_single = IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev);
+      }
       else {
         LoopSplitTaskData *data, data_local;
 
@@ -1585,13 +1678,244 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
 #endif
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Loop Split Cache
+ *
+ * Smooth fans only depend on the topology and the sharpness of edges, when only vertex positions
+ * change (e.g. for an armature deformed mesh with auto-smooth), the fans found by
+ * #loop_split_generator are kept so only their normals have to be computed again.
+ * \{ */
+
+/** Fans of a given topology, not modified once created, so they can be used by any thread. */
+typedef struct LoopSplitFans {
+  int users;
+
+  /* The fans are only valid for the topology they were found in. */
+  const MEdge *medges;
+  const MLoop *mloops;
+  const MPoly *mpolys;
+  int numEdges;
+  int numLoops;
+  int numPolys;
+  /** Copy of #LoopSplitTaskDataCommon.edge_to_loops, which also defines sharp edges. */
+  int (*edge_to_loops)[2];
+
+  LoopSplitFan *fans;
+  int fans_len;
+} LoopSplitFans;
+
+/** Stored in #Mesh_Runtime.loop_split_cache, shared between a mesh and its copies. */
+typedef struct MeshLoopSplitCache {
+  int users;
+  ThreadMutex mutex;
+  /** Fans last found by any mesh using this cache, may be NULL. */
+  LoopSplitFans *fans;
+} MeshLoopSplitCache;
+
+static void loop_split_fans_free(LoopSplitFans *fans)
+{
+  if (atomic_sub_and_fetch_int32(&fans->users, 1) != 0) {
+    return;
+  }
+  MEM_freeN(fans->edge_to_loops);
+  MEM_SAFE_FREE(fans->fans);
+  MEM_freeN(fans);
+}
+
+static bool loop_split_fans_match(const LoopSplitFans *fans,
+                                  const LoopSplitTaskDataCommon *common_data)
+{
+  return (fans->medges == common_data->medges) && (fans->mloops == common_data->mloops) &&
+         (fans->mpolys == common_data->mpolys) && (fans->numEdges == common_data->numEdges) &&
+         (fans->numLoops == common_data->numLoops) && (fans->numPolys == common_data->numPolys) &&
+         (memcmp(fans->edge_to_loops,
+                 common_data->edge_to_loops,
+                 sizeof(*fans->edge_to_loops) * (size_t)fans->numEdges) == 0);
+}
+
+static LoopSplitFans *loop_split_fans_create(LoopSplitTaskDataCommon *common_data)
+{
+  LoopSplitFans *fans = MEM_callocN(sizeof(*fans), __func__);
+  fans->users = 1;
+  fans->medges = common_data->medges;
+  fans->mloops = common_data->mloops;
+  fans->mpolys = common_data->mpolys;
+  fans->numEdges = common_data->numEdges;
+  fans->numLoops = common_data->numLoops;
+  fans->numPolys = common_data->numPolys;
+  fans->edge_to_loops = MEM_dupallocN(common_data->edge_to_loops);
+
+  BLI_Stack *fans_stack = BLI_stack_new(sizeof(LoopSplitFan), __func__);
+  loop_split_generator(NULL, common_data, fans_stack);
+
+  fans->fans_len = (int)BLI_stack_count(fans_stack);
+  if (fans->fans_len != 0) {
+    fans->fans = MEM_malloc_arrayN((size_t)fans->fans_len, sizeof(*fans->fans), __func__);
+    BLI_stack_pop_n_reverse(fans_stack, fans->fans, (uint)fans->fans_len);
+  }
+  BLI_stack_free(fans_stack);
+
+  return fans;
+}
+
+/**
+ * Get the fans of the topology in \a common_data, reusing the cached ones when they still match,
+ * \a common_data must already contain the edge to loops mapping (see #mesh_edges_sharp_tag).
+ * The result must be released with #loop_split_fans_free.
+ */
+static LoopSplitFans *loop_split_cache_fans_ensure(MeshLoopSplitCache *loop_split_cache,
+                                                   LoopSplitTaskDataCommon *common_data)
+{
+  BLI_mutex_lock(&loop_split_cache->mutex);
+  LoopSplitFans *fans = loop_split_cache->fans;
+  if (fans != NULL) {
+    atomic_add_and_fetch_int32(&fans->users, 1);
+  }
+  BLI_mutex_unlock(&loop_split_cache->mutex);
+
+  /* Comparing is as expensive as reading the whole mapping, don't lock other users meanwhile. */
+  if (fans != NULL) {
+    if (loop_split_fans_match(fans, common_data)) {
+      return fans;
+    }
+    loop_split_fans_free(fans);
+  }
+
+  fans = loop_split_fans_create(common_data);
+
+  BLI_mutex_lock(&loop_split_cache->mutex);
+  if (loop_split_cache->fans != NULL) {
+    loop_split_fans_free(loop_split_cache->fans);
+  }
+  atomic_add_and_fetch_int32(&fans->users, 1);
+  loop_split_cache->fans = fans;
+  BLI_mutex_unlock(&loop_split_cache->mutex);
+
+  return fans;
+}
+
+typedef struct LoopSplitFansData {
+  LoopSplitTaskDataCommon *common_data;
+  const LoopSplitFan *fans;
+  /** Only when computing the lnor spacearr, one space for each fan. */
+  MLoopNorSpace **lnor_spaces;
+} LoopSplitFansData;
+
+static void loop_split_fans_compute_cb(void *__restrict userdata,
+                                       const int fan_index,
+                                       const TaskParallelTLS *__restrict tls)
+{
+  LoopSplitFansData *data = userdata;
+  LoopSplitTaskDataCommon *common_data = data->common_data;
+  const LoopSplitFan *fan = &data->fans[fan_index];
+  const MLoop *mloops = common_data->mloops;
+
+  /* Temp edge vectors stack, only used when computing lnor spacearr. */
+  BLI_Stack **edge_vectors = tls->userdata_chunk;
+  if (common_data->lnors_spacearr && (*edge_vectors == NULL)) {
+    *edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
+  }
+
+  LoopSplitTaskData task_data = {
+      .lnor_space = data->lnor_spaces ? data->lnor_spaces[fan_index] : NULL,
+      .lnor = &common_data->loopnors[fan->ml_curr_index],
+      .ml_curr = &mloops[fan->ml_curr_index],
+      .ml_prev = &mloops[fan->ml_prev_index],
+      .ml_curr_index = fan->ml_curr_index,
+      .ml_prev_index = fan->ml_prev_index,
+      .e2l_prev = fan->is_single ? NULL :
+                                   common_data->edge_to_loops[mloops[fan->ml_prev_index].e],
+      .mp_index = fan->mp_index,
+  };
+  loop_split_worker_do(common_data, &task_data, *edge_vectors);
+}
+
+static void loop_split_fans_compute_finalize(void *__restrict UNUSED(userdata),
+                                             void *__restrict userdata_chunk)
+{
+  BLI_Stack **edge_vectors = userdata_chunk;
+  if (*edge_vectors != NULL) {
+    BLI_stack_free(*edge_vectors);
+  }
+}
+
+/** Unlike #loop_split_generator, all fans are known so they can be computed in parallel. */
+static void loop_split_fans_compute(LoopSplitTaskDataCommon *common_data,
+                                    const LoopSplitFans *fans)
+{
+  MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
+
+  LoopSplitFansData data = {
+      .common_data = common_data,
+      .fans = fans->fans,
+  };
+
+  /* Spaces are allocated from a memarena, which is not thread-safe. */
+  if (lnors_spacearr) {
+    data.lnor_spaces = MEM_malloc_arrayN(
+        (size_t)fans->fans_len, sizeof(*data.lnor_spaces), __func__);
+    for (int i = 0; i < fans->fans_len; i++) {
+      data.lnor_spaces[i] = BKE_lnor_space_create(lnors_spacearr);
+    }
+  }
+
+  BLI_Stack *edge_vectors = NULL;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = LOOP_SPLIT_TASK_BLOCK_SIZE;
+  settings.userdata_chunk = &edge_vectors;
+  settings.userdata_chunk_size = sizeof(edge_vectors);
+  settings.func_finalize = loop_split_fans_compute_finalize;
+  BLI_task_parallel_range(0, fans->fans_len, &data, loop_split_fans_compute_cb, &settings);
+
+  MEM_SAFE_FREE(data.lnor_spaces);
+}
+
+MeshLoopSplitCache *BKE_mesh_loop_split_cache_create(void)
+{
+  MeshLoopSplitCache *loop_split_cache = MEM_callocN(sizeof(*loop_split_cache), __func__);
+  loop_split_cache->users = 1;
+  BLI_mutex_init(&loop_split_cache->mutex);
+  return loop_split_cache;
+}
+
+void BKE_mesh_loop_split_cache_user_add(MeshLoopSplitCache *loop_split_cache)
+{
+  atomic_add_and_fetch_int32(&loop_split_cache->users, 1);
+}
+
+/** Remove a user, freeing the cache when it was the last one. */
+void BKE_mesh_loop_split_cache_free(MeshLoopSplitCache *loop_split_cache)
+{
+  if (atomic_sub_and_fetch_int32(&loop_split_cache->users, 1) != 0) {
+    return;
+  }
+  BKE_mesh_loop_split_cache_clear(loop_split_cache);
+  BLI_mutex_end(&loop_split_cache->mutex);
+  MEM_freeN(loop_split_cache);
+}
+
+/** Discard the cached fans, needed when the topology changes. */
+void BKE_mesh_loop_split_cache_clear(MeshLoopSplitCache *loop_split_cache)
+{
+  BLI_mutex_lock(&loop_split_cache->mutex);
+  if (loop_split_cache->fans != NULL) {
+    loop_split_fans_free(loop_split_cache->fans);
+    loop_split_cache->fans = NULL;
+  }
+  BLI_mutex_unlock(&loop_split_cache->mutex);
+}
+
+/** \} */
+
 /**
  * Compute split normals, i.e. vertex normals associated with each poly (hence 'loop normals').
  * Useful to materialize sharp edges (or non-smooth faces) without actually modifying the geometry
  * (splitting edges).
  */
 void BKE_mesh_normals_loop_split(const MVert *mverts,
-                                 const int UNUSED(numVerts),
+                                 const int numVerts,
                                  MEdge *medges,
                                  const int numEdges,
                                  MLoop *mloops,
@@ -1605,6 +1929,45 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
                                  MLoopNorSpaceArray *r_lnors_spacearr,
                                  short (*clnors_data)[2],
                                  int *r_loop_to_poly)
+{
+  BKE_mesh_normals_loop_split_ex(mverts,
+                                 numVerts,
+                                 medges,
+                                 numEdges,
+                                 mloops,
+                                 r_loopnors,
+                                 numLoops,
+                                 mpolys,
+                                 polynors,
+                                 numPolys,
+                                 use_split_normals,
+                                 split_angle,
+                                 r_lnors_spacearr,
+                                 clnors_data,
+                                 r_loop_to_poly,
+                                 NULL);
+}
+
+/**
+ * \param loop_split_cache: Optional storage of the smooth fans (see #Mesh_Runtime),
+ * reused when the topology and sharp edges are unchanged.
+ */
+void BKE_mesh_normals_loop_split_ex(const MVert *mverts,
+                                    const int UNUSED(numVerts),
+                                    MEdge *medges,
+                                    const int numEdges,
+                                    MLoop *mloops,
+                                    float (*r_loopnors)[3],
+                                    const int numLoops,
+                                    MPoly *mpolys,
+                                    const float (*polynors)[3],
+                                    const int numPolys,
+                                    const bool use_split_normals,
+                                    const float split_angle,
+                                    MLoopNorSpaceArray *r_lnors_spacearr,
+                                    short (*clnors_data)[2],
+                                    int *r_loop_to_poly,
+                                    MeshLoopSplitCache *loop_split_cache)
 {
   /* For now this is not supported.
    * If we do not use split normals, we do not generate anything fancy! */
@@ -1699,9 +2062,14 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
   /* This first loop check which edges are actually smooth, and compute edge vectors. */
   mesh_edges_sharp_tag(&common_data, check_angle, split_angle, false);
 
-  if (numLoops < LOOP_SPLIT_TASK_BLOCK_SIZE * 8) {
+  if (loop_split_cache) {
+    LoopSplitFans *fans = loop_split_cache_fans_ensure(loop_split_cache, &common_data);
+    loop_split_fans_compute(&common_data, fans);
+    loop_split_fans_free(fans);
+  }
+  else if (numLoops < LOOP_SPLIT_TASK_BLOCK_SIZE * 8) {
     /* Not enough loops to be worth the whole threading overhead... */
-    loop_split_generator(NULL, &common_data);
+    loop_split_generator(NULL, &common_data, NULL);
   }
   else {
     TaskScheduler *task_scheduler;
@@ -1710,7 +2078,7 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
     task_scheduler = BLI_task_scheduler_get();
     task_pool = BLI_task_pool_create(task_scheduler, &common_data);
 
-    loop_split_generator(task_pool, &common_data);
+    loop_split_generator(task_pool, &common_data, NULL);
 
     BLI_task_pool_work_and_wait(task_pool);
 
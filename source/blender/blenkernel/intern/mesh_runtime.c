@@ -53,6 +53,7 @@ void BKE_mesh_runtime_reset(Mesh *mesh)
   memset(&mesh->runtime, 0, sizeof(mesh->runtime));
   mesh->runtime.eval_mutex = MEM_mallocN(sizeof(ThreadMutex), "mesh runtime eval_mutex");
   BLI_mutex_init(mesh->runtime.eval_mutex);
+  mesh->runtime.loop_split_cache = BKE_mesh_loop_split_cache_create();
 }
 
 /* Clear all pointers which we don't want to be shared on copying the datablock.
@@ -72,6 +73,11 @@ void BKE_mesh_runtime_reset_on_copy(Mesh *mesh, const int UNUSED(flag))
 
   mesh->runtime.eval_mutex = MEM_mallocN(sizeof(ThreadMutex), "mesh runtime eval_mutex");
   BLI_mutex_init(mesh->runtime.eval_mutex);
+
+  /* Shared, copies for evaluation reference the topology of the original. */
+  if (runtime->loop_split_cache != NULL) {
+    BKE_mesh_loop_split_cache_user_add(runtime->loop_split_cache);
+  }
 }
 
 void BKE_mesh_runtime_clear_cache(Mesh *mesh)
@@ -86,6 +92,11 @@ void BKE_mesh_runtime_clear_cache(Mesh *mesh)
     BKE_id_free(NULL, mesh->runtime.mesh_eval);
     mesh->runtime.mesh_eval = NULL;
   }
+  /* Release before clearing geometry, which would discard the fans for all users. */
+  if (mesh->runtime.loop_split_cache != NULL) {
+    BKE_mesh_loop_split_cache_free(mesh->runtime.loop_split_cache);
+    mesh->runtime.loop_split_cache = NULL;
+  }
   BKE_mesh_runtime_clear_geometry(mesh);
   BKE_mesh_batch_cache_free(mesh);
   BKE_mesh_runtime_clear_edit_data(mesh);
@@ -235,6 +246,9 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
     mesh->runtime.subdiv_ccg = NULL;
   }
   BKE_shrinkwrap_discard_boundary_data(mesh);
+  if (mesh->runtime.loop_split_cache != NULL) {
+    BKE_mesh_loop_split_cache_clear(mesh->runtime.loop_split_cache);
+  }
 }
 
 /** \} */
@@ -70,6 +70,8 @@
 
 #include "GPU_texture.h"
 
+#include "PIL_time.h"
+
 #ifdef WITH_OPENEXR
 #  include "intern/openexr/openexr_multi.h"
 #endif
@@ -574,27 +576,34 @@ static bool has_imbuf_cache(MovieClip *clip, MovieClipUser *user, int flag)
   return false;
 }
 
-static bool put_imbuf_cache(
-    MovieClip *clip, const MovieClipUser *user, ImBuf *ibuf, int flag, bool destructive)
+/* \a cost is the time in seconds it took to read the frame. */
+static bool put_imbuf_cache(MovieClip *clip,
+                            const MovieClipUser *user,
+                            ImBuf *ibuf,
+                            int flag,
+                            float cost,
+                            bool destructive)
 {
   MovieClipImBufCacheKey key;
 
   if (clip->cache == NULL) {
     struct MovieCache *moviecache;
+    char cache_name[64];
 
-    // char cache_name[64];
-    // BLI_snprintf(cache_name, sizeof(cache_name), "movie %s", clip->id.name);
+    BLI_snprintf(cache_name, sizeof(cache_name), "movieclip %s", clip->id.name + 2);
 
     clip->cache = MEM_callocN(sizeof(MovieClipCache), "movieClipCache");
 
     moviecache = IMB_moviecache_create(
-        "movieclip", sizeof(MovieClipImBufCacheKey), moviecache_hashhash, moviecache_hashcmp);
+        cache_name, sizeof(MovieClipImBufCacheKey), moviecache_hashhash, moviecache_hashcmp);
 
     IMB_moviecache_set_getdata_callback(moviecache, moviecache_keydata);
     IMB_moviecache_set_priority_callback(moviecache,
                                          moviecache_getprioritydata,
                                          moviecache_getitempriority,
                                          moviecache_prioritydeleter);
+    /* Decoding frames again is slow, keep cold frames compressed instead. */
+    IMB_moviecache_set_compression(moviecache, true);
 
     clip->cache->moviecache = moviecache;
     clip->cache->sequence_offset = -1;
@@ -622,7 +631,7 @@ static bool put_imbuf_cache(
   }
 
   if (destructive) {
-    IMB_moviecache_put(clip->cache->moviecache, &key, ibuf);
+    IMB_moviecache_put_ex(clip->cache->moviecache, &key, ibuf, cost);
     return true;
   }
   else {
@@ -996,6 +1005,7 @@ static ImBuf *movieclip_get_postprocessed_ibuf(
   }
 
   if (!ibuf) {
+    const double start_time = PIL_check_seconds_timer();
     bool use_sequence = false;
 
     /* undistorted proxies for movies should be read as image sequence */
@@ -1010,7 +1020,8 @@ static ImBuf *movieclip_get_postprocessed_ibuf(
     }
 
     if (ibuf && (cache_flag & MOVIECLIP_CACHE_SKIP) == 0) {
-      put_imbuf_cache(clip, user, ibuf, flag, true);
+      put_imbuf_cache(
+          clip, user, ibuf, flag, (float)(PIL_check_seconds_timer() - start_time), true);
     }
   }
 
@@ -1732,7 +1743,7 @@ bool BKE_movieclip_put_frame_if_possible(MovieClip *clip, MovieClipUser *user, I
   bool result;
 
   BLI_thread_lock(LOCK_MOVIECLIP);
-  result = put_imbuf_cache(clip, user, ibuf, clip->flag, false);
+  result = put_imbuf_cache(clip, user, ibuf, clip->flag, 0.0f, false);
   BLI_thread_unlock(LOCK_MOVIECLIP);
 
   return result;
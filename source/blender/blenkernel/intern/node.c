@@ -1151,6 +1151,7 @@ bNode *BKE_node_copy_ex(bNodeTree *ntree,
   }
 
   node_dst->new_node = NULL;
+  node_dst->execution_stats = NULL;
 
   /* Only call copy function when a copy is made for the main database, not
    * for cases like the dependency graph and localization. */
@@ -1986,6 +1987,8 @@ static void node_free_node(bNodeTree *ntree, bNode *node)
 
   BLI_freelistN(&node->internal_links);
 
+  MEM_SAFE_FREE(node->execution_stats);
+
   if (node->prop) {
     /* Remember, no ID user refcount management here! */
     IDP_FreePropertyContent_ex(node->prop, false);
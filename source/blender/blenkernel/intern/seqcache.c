@@ -20,11 +20,15 @@
  * \ingroup bke
  */
 
+#include <float.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <memory.h>
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "DNA_sequence_types.h"
 #include "DNA_scene_types.h"
 
@@ -35,6 +39,7 @@
 #include "BLI_threads.h"
 #include "BLI_listbase.h"
 #include "BLI_ghash.h"
+#include "BLI_hash.h"
 
 #include "BKE_sequencer.h"
 #include "BKE_scene.h"
@@ -63,15 +68,35 @@
  * entries one by one in reverse order to their creation.
  *
  * User can exclude caching of some images. Such entries will have is_temp_cache set.
+ *
+ * Recycling picks the frames to free by a score: frames far from the current frame, which are
+ * cheap to render again, are freed first (see #seq_cache_recycle_score).
+ *
+ * Threading: entries are spread over #SEQ_CACHE_SHARDS_NUM hash tables, each with its own
+ * read-write lock. Looking up an image only takes a shared lock of one table, so the UI and the
+ * prefetch threads don't wait for each other. Adding and removing entries and everything using
+ * the links between them is serialized by #SeqCache.iterator_mutex, entries can be iterated
+ * while holding it (with no table lock).
  */
 
-typedef struct SeqCache {
+/** Number of hash tables the entries are spread over, a power of 2. */
+#define SEQ_CACHE_SHARDS_NUM 16
+
+typedef struct SeqCacheShard {
   struct GHash *hash;
+  /** Read lock to look up entries, write lock to add or remove them. */
+  ThreadRWMutex lock;
+} SeqCacheShard;
+
+typedef struct SeqCache {
+  SeqCacheShard shards[SEQ_CACHE_SHARDS_NUM];
   ThreadMutex iterator_mutex;
   struct BLI_mempool *keys_pool;
   struct BLI_mempool *items_pool;
   struct SeqCacheKey *last_key;
   size_t memory_used;
+  /** Hits and misses are counted with atomics, the rest with #iterator_mutex locked. */
+  SeqCacheStats stats;
 } SeqCache;
 
 typedef struct SeqCacheItem {
@@ -191,31 +216,58 @@ static void seq_cache_valfree(void *val)
   BLI_mempool_free(item->cache_owner->items_pool, item);
 }
 
+static SeqCacheShard *seq_cache_shard_get(SeqCache *cache, const SeqCacheKey *key)
+{
+  const uint hash = BLI_hash_int(seq_cache_hashhash(key));
+  return &cache->shards[hash & (SEQ_CACHE_SHARDS_NUM - 1)];
+}
+
 static void seq_cache_put(SeqCache *cache, SeqCacheKey *key, ImBuf *ibuf)
 {
+  SeqCacheShard *shard = seq_cache_shard_get(cache, key);
   SeqCacheItem *item;
   item = BLI_mempool_alloc(cache->items_pool);
   item->cache_owner = cache;
   item->ibuf = ibuf;
 
-  if (BLI_ghash_reinsert(cache->hash, key, item, seq_cache_keyfree, seq_cache_valfree)) {
+  BLI_rw_mutex_lock(&shard->lock, THREAD_LOCK_WRITE);
+  if (BLI_ghash_reinsert(shard->hash, key, item, seq_cache_keyfree, seq_cache_valfree)) {
     IMB_refImBuf(ibuf);
     cache->last_key = key;
     cache->memory_used += IMB_get_size_in_memory(ibuf);
   }
+  BLI_rw_mutex_unlock(&shard->lock);
 }
 
-static ImBuf *seq_cache_get(SeqCache *cache, void *key)
+/* Doesn't need #SeqCache.iterator_mutex. */
+static ImBuf *seq_cache_get(SeqCache *cache, const SeqCacheKey *key)
 {
-  SeqCacheItem *item = BLI_ghash_lookup(cache->hash, key);
+  SeqCacheShard *shard = seq_cache_shard_get(cache, key);
+  ImBuf *ibuf = NULL;
 
+  BLI_rw_mutex_lock(&shard->lock, THREAD_LOCK_READ);
+  SeqCacheItem *item = BLI_ghash_lookup(shard->hash, key);
   if (item && item->ibuf) {
-    IMB_refImBuf(item->ibuf);
-
-    return item->ibuf;
+    ibuf = item->ibuf;
+    IMB_refImBuf(ibuf);
   }
+  BLI_rw_mutex_unlock(&shard->lock);
 
-  return NULL;
+  return ibuf;
+}
+
+static void seq_cache_remove(SeqCache *cache, SeqCacheKey *key)
+{
+  SeqCacheShard *shard = seq_cache_shard_get(cache, key);
+
+  BLI_rw_mutex_lock(&shard->lock, THREAD_LOCK_WRITE);
+  BLI_ghash_remove(shard->hash, key, seq_cache_keyfree, seq_cache_valfree);
+  BLI_rw_mutex_unlock(&shard->lock);
+}
+
+static int seq_cache_key_cfra(const SeqCacheKey *key)
+{
+  return (int)(key->seq->start + key->nfra);
 }
 
 static void seq_cache_relink_keys(SeqCacheKey *link_next, SeqCacheKey *link_prev)
@@ -228,75 +280,6 @@ static void seq_cache_relink_keys(SeqCacheKey *link_next, SeqCacheKey *link_prev
   }
 }
 
-/* Choose a key out of 2 candidates(leftmost and rightmost items)
- * to recycle based on currently used strategy */
-static SeqCacheKey *seq_cache_choose_key(Scene *scene, SeqCacheKey *lkey, SeqCacheKey *rkey)
-{
-  SeqCacheKey *finalkey = NULL;
-
-  /* Ideally, cache would not need to check the state of prefetching task
-   * that is tricky to do however, because prefetch would need to know,
-   * if a key, that is about to be created would be removed by itself.
-   *
-   * This can happen because only FINAL_OUT item insertion will trigger recycling
-   * but that is also the point, where prefetch can be suspended.
-   *
-   * We could use temp cache as a shield and later make it a non-temporary entry,
-   * but it is not worth of increasing system complexity.
-   */
-  if (scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE &&
-      BKE_sequencer_prefetch_job_is_running(scene)) {
-    int pfjob_start, pfjob_end;
-    BKE_sequencer_prefetch_get_time_range(scene, &pfjob_start, &pfjob_end);
-
-    if (lkey) {
-      int lkey_cfra = lkey->seq->start + lkey->nfra;
-      if (lkey_cfra < pfjob_start || lkey_cfra > pfjob_end) {
-        return lkey;
-      }
-    }
-
-    if (rkey) {
-      int rkey_cfra = rkey->seq->start + rkey->nfra;
-      if (rkey_cfra < pfjob_start || rkey_cfra > pfjob_end) {
-        return rkey;
-      }
-    }
-
-    return NULL;
-  }
-
-  if (rkey && lkey) {
-    int lkey_cfra = lkey->seq->start + lkey->nfra;
-    int rkey_cfra = rkey->seq->start + rkey->nfra;
-
-    if (lkey_cfra > rkey_cfra) {
-      SeqCacheKey *swapkey = lkey;
-      lkey = rkey;
-      rkey = swapkey;
-    }
-
-    int l_diff = scene->r.cfra - lkey_cfra;
-    int r_diff = rkey_cfra - scene->r.cfra;
-
-    if (l_diff > r_diff) {
-      finalkey = lkey;
-    }
-    else {
-      finalkey = rkey;
-    }
-  }
-  else {
-    if (lkey) {
-      finalkey = lkey;
-    }
-    else {
-      finalkey = rkey;
-    }
-  }
-  return finalkey;
-}
-
 static void seq_cache_recycle_linked(Scene *scene, SeqCacheKey *base)
 {
   SeqCache *cache = seq_cache_get_from_scene(scene);
@@ -308,76 +291,122 @@ static void seq_cache_recycle_linked(Scene *scene, SeqCacheKey *base)
 
   while (base) {
     SeqCacheKey *prev = base->link_prev;
-    BLI_ghash_remove(cache->hash, base, seq_cache_keyfree, seq_cache_valfree);
+    seq_cache_remove(cache, base);
+    cache->stats.evictions++;
     base = prev;
   }
 
   base = next;
   while (base) {
     next = base->link_next;
-    BLI_ghash_remove(cache->hash, base, seq_cache_keyfree, seq_cache_valfree);
+    seq_cache_remove(cache, base);
+    cache->stats.evictions++;
     base = next;
   }
 }
 
-static SeqCacheKey *seq_cache_get_item_for_removal(Scene *scene)
+typedef struct SeqCacheRecycleCandidate {
+  SeqCacheKey *key;
+  float score;
+} SeqCacheRecycleCandidate;
+
+/**
+ * Frames with the highest score are recycled first: frames far from the current frame are less
+ * likely to be needed soon, frames which took long to render are expensive to render again.
+ */
+static float seq_cache_recycle_score(const Scene *scene, const SeqCacheKey *key)
+{
+  const int distance = abs(seq_cache_key_cfra(key) - scene->r.cfra);
+  return (float)distance / (1.0f + key->cost);
+}
+
+static int seq_cache_recycle_candidate_cmp(const void *a_, const void *b_)
+{
+  const SeqCacheRecycleCandidate *a = a_;
+  const SeqCacheRecycleCandidate *b = b_;
+
+  if (a->score > b->score) {
+    return -1;
+  }
+  if (a->score < b->score) {
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * Return the "base" keys which can be recycled, sorted in the order they should be.
+ */
+static SeqCacheRecycleCandidate *seq_cache_recycle_candidates_get(Scene *scene, int *r_len)
 {
   SeqCache *cache = seq_cache_get_from_scene(scene);
-  SeqCacheKey *finalkey = NULL;
-  /*leftmost key*/
-  SeqCacheKey *lkey = NULL;
-  /*rightmost key*/
-  SeqCacheKey *rkey = NULL;
-  SeqCacheKey *key = NULL;
-
-  GHashIterator gh_iter;
-  BLI_ghashIterator_init(&gh_iter, cache->hash);
-  int total_count = 0;
-  int cheap_count = 0;
-
-  while (!BLI_ghashIterator_done(&gh_iter)) {
-    key = BLI_ghashIterator_getKey(&gh_iter);
-    SeqCacheItem *item = BLI_ghashIterator_getValue(&gh_iter);
-    BLI_ghashIterator_step(&gh_iter);
-
-    /* this shouldn't happen, but better be safe than sorry */
-    if (!item->ibuf) {
-      seq_cache_recycle_linked(scene, key);
-      /* can not continue iterating after linked remove */
-      BLI_ghashIterator_init(&gh_iter, cache->hash);
-      continue;
-    }
+  SeqCacheRecycleCandidate *candidates = NULL;
+  int candidates_len = 0;
+  size_t items_len = 0;
 
-    if (key->is_temp_cache || key->link_next != NULL) {
-      continue;
-    }
+  for (int i = 0; i < SEQ_CACHE_SHARDS_NUM; i++) {
+    items_len += BLI_ghash_len(cache->shards[i].hash);
+  }
+  if (items_len == 0) {
+    *r_len = 0;
+    return NULL;
+  }
 
-    total_count++;
+  /* Ideally, cache would not need to check the state of prefetching task
+   * that is tricky to do however, because prefetch would need to know,
+   * if a key, that is about to be created would be removed by itself.
+   *
+   * This can happen because only FINAL_OUT item insertion will trigger recycling
+   * but that is also the point, where prefetch can be suspended.
+   *
+   * We could use temp cache as a shield and later make it a non-temporary entry,
+   * but it is not worth of increasing system complexity.
+   */
+  const bool use_prefetch_range = (scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE) &&
+                                  BKE_sequencer_prefetch_job_is_running(scene);
+  int pfjob_start = 0, pfjob_end = 0;
+  if (use_prefetch_range) {
+    BKE_sequencer_prefetch_get_time_range(scene, &pfjob_start, &pfjob_end);
+  }
 
-    if (key->cost <= scene->ed->recycle_max_cost) {
-      cheap_count++;
-      if (lkey) {
-        if (key->seq->start + key->nfra < lkey->seq->start + lkey->nfra) {
-          lkey = key;
-        }
+  candidates = MEM_mallocN(sizeof(*candidates) * items_len, __func__);
+
+  for (int i = 0; i < SEQ_CACHE_SHARDS_NUM; i++) {
+    GHashIterator gh_iter;
+    GHASH_ITER (gh_iter, cache->shards[i].hash) {
+      SeqCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
+      SeqCacheItem *item = BLI_ghashIterator_getValue(&gh_iter);
+      float score;
+
+      if (key->is_temp_cache || key->link_next != NULL) {
+        continue;
       }
-      else {
-        lkey = key;
+
+      if (!item->ibuf) {
+        /* this shouldn't happen, but better be safe than sorry */
+        score = FLT_MAX;
       }
-      if (rkey) {
-        if (key->seq->start + key->nfra > rkey->seq->start + rkey->nfra) {
-          rkey = key;
-        }
+      else if (key->cost > scene->ed->recycle_max_cost) {
+        continue;
       }
       else {
-        rkey = key;
+        const int key_cfra = seq_cache_key_cfra(key);
+        if (use_prefetch_range && key_cfra >= pfjob_start && key_cfra <= pfjob_end) {
+          continue;
+        }
+        score = seq_cache_recycle_score(scene, key);
       }
+
+      candidates[candidates_len].key = key;
+      candidates[candidates_len].score = score;
+      candidates_len++;
     }
   }
 
-  finalkey = seq_cache_choose_key(scene, lkey, rkey);
+  qsort(candidates, (size_t)candidates_len, sizeof(*candidates), seq_cache_recycle_candidate_cmp);
 
-  return finalkey;
+  *r_len = candidates_len;
+  return candidates;
 }
 
 /* Find only "base" keys
@@ -393,19 +422,20 @@ bool BKE_sequencer_cache_recycle_item(Scene *scene)
 
   seq_cache_lock(scene);
 
-  while (cache->memory_used > memory_total) {
-    SeqCacheKey *finalkey = seq_cache_get_item_for_removal(scene);
-
-    if (finalkey) {
-      seq_cache_recycle_linked(scene, finalkey);
-    }
-    else {
-      seq_cache_unlock(scene);
-      return false;
+  if (cache->memory_used > memory_total) {
+    /* Each candidate is the last key of its own links, so recycling one never frees another. */
+    int candidates_len;
+    SeqCacheRecycleCandidate *candidates = seq_cache_recycle_candidates_get(scene,
+                                                                            &candidates_len);
+    for (int i = 0; i < candidates_len && cache->memory_used > memory_total; i++) {
+      seq_cache_recycle_linked(scene, candidates[i].key);
     }
+    MEM_SAFE_FREE(candidates);
   }
+
+  const bool is_recycled = (cache->memory_used <= memory_total);
   seq_cache_unlock(scene);
-  return true;
+  return is_recycled;
 }
 
 static void seq_cache_set_temp_cache_linked(Scene *scene, SeqCacheKey *base)
@@ -439,7 +469,10 @@ static void BKE_sequencer_cache_create(Scene *scene)
     SeqCache *cache = MEM_callocN(sizeof(SeqCache), "SeqCache");
     cache->keys_pool = BLI_mempool_create(sizeof(SeqCacheKey), 0, 64, BLI_MEMPOOL_NOP);
     cache->items_pool = BLI_mempool_create(sizeof(SeqCacheItem), 0, 64, BLI_MEMPOOL_NOP);
-    cache->hash = BLI_ghash_new(seq_cache_hashhash, seq_cache_hashcmp, "SeqCache hash");
+    for (int i = 0; i < SEQ_CACHE_SHARDS_NUM; i++) {
+      cache->shards[i].hash = BLI_ghash_new(seq_cache_hashhash, seq_cache_hashcmp, __func__);
+      BLI_rw_mutex_init(&cache->shards[i].lock);
+    }
     cache->last_key = NULL;
     BLI_mutex_init(&cache->iterator_mutex);
     scene->ed->cache = cache;
@@ -458,14 +491,16 @@ void BKE_sequencer_cache_free_temp_cache(Scene *scene, short id, int cfra)
 
   seq_cache_lock(scene);
 
-  GHashIterator gh_iter;
-  BLI_ghashIterator_init(&gh_iter, cache->hash);
-  while (!BLI_ghashIterator_done(&gh_iter)) {
-    SeqCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
-    BLI_ghashIterator_step(&gh_iter);
+  for (int i = 0; i < SEQ_CACHE_SHARDS_NUM; i++) {
+    GHashIterator gh_iter;
+    BLI_ghashIterator_init(&gh_iter, cache->shards[i].hash);
+    while (!BLI_ghashIterator_done(&gh_iter)) {
+      SeqCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
+      BLI_ghashIterator_step(&gh_iter);
 
-    if (key->is_temp_cache && key->task_id == id && key->seq->start + key->nfra != cfra) {
-      BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
+      if (key->is_temp_cache && key->task_id == id && seq_cache_key_cfra(key) != cfra) {
+        seq_cache_remove(cache, key);
+      }
     }
   }
   seq_cache_unlock(scene);
@@ -478,7 +513,10 @@ void BKE_sequencer_cache_destruct(Scene *scene)
     return;
   }
 
-  BLI_ghash_free(cache->hash, seq_cache_keyfree, seq_cache_valfree);
+  for (int i = 0; i < SEQ_CACHE_SHARDS_NUM; i++) {
+    BLI_ghash_free(cache->shards[i].hash, seq_cache_keyfree, seq_cache_valfree);
+    BLI_rw_mutex_end(&cache->shards[i].lock);
+  }
   BLI_mempool_destroy(cache->keys_pool);
   BLI_mempool_destroy(cache->items_pool);
   BLI_mutex_end(&cache->iterator_mutex);
@@ -503,13 +541,11 @@ void BKE_sequencer_cache_cleanup(Scene *scene)
 
   seq_cache_lock(scene);
 
-  GHashIterator gh_iter;
-  BLI_ghashIterator_init(&gh_iter, cache->hash);
-  while (!BLI_ghashIterator_done(&gh_iter)) {
-    SeqCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
-
-    BLI_ghashIterator_step(&gh_iter);
-    BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
+  for (int i = 0; i < SEQ_CACHE_SHARDS_NUM; i++) {
+    SeqCacheShard *shard = &cache->shards[i];
+    BLI_rw_mutex_lock(&shard->lock, THREAD_LOCK_WRITE);
+    BLI_ghash_clear(shard->hash, seq_cache_keyfree, seq_cache_valfree);
+    BLI_rw_mutex_unlock(&shard->lock);
   }
   cache->last_key = NULL;
   seq_cache_unlock(scene);
@@ -542,30 +578,31 @@ void BKE_sequencer_cache_cleanup_sequence(Scene *scene,
   int invalidate_source = invalidate_types & (SEQ_CACHE_STORE_RAW | SEQ_CACHE_STORE_PREPROCESSED |
                                               SEQ_CACHE_STORE_COMPOSITE);
 
-  GHashIterator gh_iter;
-  BLI_ghashIterator_init(&gh_iter, cache->hash);
-  while (!BLI_ghashIterator_done(&gh_iter)) {
-    SeqCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
-    BLI_ghashIterator_step(&gh_iter);
+  for (int i = 0; i < SEQ_CACHE_SHARDS_NUM; i++) {
+    GHashIterator gh_iter;
+    BLI_ghashIterator_init(&gh_iter, cache->shards[i].hash);
+    while (!BLI_ghashIterator_done(&gh_iter)) {
+      SeqCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
+      BLI_ghashIterator_step(&gh_iter);
 
-    int key_cfra = key->seq->start + key->nfra;
+      int key_cfra = seq_cache_key_cfra(key);
 
-    /* clean all final and composite in intersection of seq and seq_changed */
-    if (key->type & invalidate_composite && key_cfra >= range_start && key_cfra <= range_end) {
-      if (key->link_next || key->link_prev) {
-        seq_cache_relink_keys(key->link_next, key->link_prev);
-      }
-
-      BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
-    }
+      /* clean all final and composite in intersection of seq and seq_changed */
+      if (key->type & invalidate_composite && key_cfra >= range_start && key_cfra <= range_end) {
+        if (key->link_next || key->link_prev) {
+          seq_cache_relink_keys(key->link_next, key->link_prev);
+        }
 
-    if (key->type & invalidate_source && key->seq == seq && key_cfra >= seq_changed->startdisp &&
-        key_cfra <= seq_changed->enddisp) {
-      if (key->link_next || key->link_prev) {
-        seq_cache_relink_keys(key->link_next, key->link_prev);
+        seq_cache_remove(cache, key);
       }
+      else if (key->type & invalidate_source && key->seq == seq &&
+               key_cfra >= seq_changed->startdisp && key_cfra <= seq_changed->enddisp) {
+        if (key->link_next || key->link_prev) {
+          seq_cache_relink_keys(key->link_next, key->link_prev);
+        }
 
-      BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
+        seq_cache_remove(cache, key);
+      }
     }
   }
   cache->last_key = NULL;
@@ -590,7 +627,6 @@ struct ImBuf *BKE_sequencer_cache_get(const SeqRenderData *context,
     return NULL;
   }
 
-  seq_cache_lock(scene);
   SeqCache *cache = seq_cache_get_from_scene(scene);
   ImBuf *ibuf = NULL;
 
@@ -603,8 +639,8 @@ struct ImBuf *BKE_sequencer_cache_get(const SeqRenderData *context,
     key.type = type;
 
     ibuf = seq_cache_get(cache, &key);
+    atomic_add_and_fetch_z(ibuf ? &cache->stats.hits : &cache->stats.misses, 1);
   }
-  seq_cache_unlock(scene);
 
   return ibuf;
 }
@@ -646,13 +682,6 @@ void BKE_sequencer_cache_put(
     return;
   }
 
-  /* Prevent reinserting, it breaks cache key linking */
-  ImBuf *test = BKE_sequencer_cache_get(context, seq, cfra, type);
-  if (test) {
-    IMB_freeImBuf(test);
-    return;
-  }
-
   if (!scene->ed->cache) {
     BKE_sequencer_cache_create(scene);
   }
@@ -660,6 +689,20 @@ void BKE_sequencer_cache_put(
   seq_cache_lock(scene);
 
   SeqCache *cache = seq_cache_get_from_scene(scene);
+
+  /* Prevent reinserting, it breaks cache key linking */
+  SeqCacheKey test_key = {
+      .seq = seq,
+      .context = *context,
+      .nfra = cfra - seq->start,
+      .type = type,
+  };
+  ImBuf *test = seq_cache_get(cache, &test_key);
+  if (test) {
+    IMB_freeImBuf(test);
+    seq_cache_unlock(scene);
+    return;
+  }
   int flag;
 
   if (seq->cache_flag & SEQ_CACHE_OVERRIDE) {
@@ -725,7 +768,10 @@ size_t BKE_sequencer_cache_get_num_items(struct Scene *scene)
   }
 
   seq_cache_lock(scene);
-  size_t num_items = BLI_ghash_len(cache->hash);
+  size_t num_items = 0;
+  for (int i = 0; i < SEQ_CACHE_SHARDS_NUM; i++) {
+    num_items += BLI_ghash_len(cache->shards[i].hash);
+  }
   seq_cache_unlock(scene);
 
   return num_items;
@@ -742,15 +788,17 @@ void BKE_sequencer_cache_iterate(
   }
 
   seq_cache_lock(scene);
-  GHashIterator gh_iter;
-  BLI_ghashIterator_init(&gh_iter, cache->hash);
   bool interrupt = false;
 
-  while (!BLI_ghashIterator_done(&gh_iter) && !interrupt) {
-    SeqCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
-    BLI_ghashIterator_step(&gh_iter);
+  for (int i = 0; i < SEQ_CACHE_SHARDS_NUM && !interrupt; i++) {
+    GHashIterator gh_iter;
+    BLI_ghashIterator_init(&gh_iter, cache->shards[i].hash);
+    while (!BLI_ghashIterator_done(&gh_iter) && !interrupt) {
+      SeqCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
+      BLI_ghashIterator_step(&gh_iter);
 
-    interrupt = callback(userdata, key->seq, key->nfra, key->type, key->cost);
+      interrupt = callback(userdata, key->seq, key->nfra, key->type, key->cost);
+    }
   }
 
   cache->last_key = NULL;
@@ -767,3 +815,20 @@ bool BKE_sequencer_cache_is_full(Scene *scene)
 
   return memory_total < cache->memory_used;
 }
+
+/**
+ * Counters of the cache lookups and of the frames freed to make room for new ones,
+ * since the cache was created.
+ */
+void BKE_sequencer_cache_stats_get(Scene *scene, SeqCacheStats *r_stats)
+{
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  if (!cache) {
+    memset(r_stats, 0, sizeof(*r_stats));
+    return;
+  }
+
+  seq_cache_lock(scene);
+  *r_stats = cache->stats;
+  seq_cache_unlock(scene);
+}
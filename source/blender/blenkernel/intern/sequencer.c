@@ -1584,6 +1584,16 @@ typedef struct SeqIndexBuildContext {
   Depsgraph *depsgraph;
   Scene *scene;
   Sequence *seq, *orig_seq;
+
+  /* Progress of this context when the queue is rebuilt in parallel. Written by the worker and
+   * read by the thread running the queue without synchronization, like the progress of jobs is
+   * read by the window manager. A stale value only shows in the progress bar for an update, the
+   * end of the context is known from `done`. */
+  float progress;
+  /* Set by the thread running the queue once the context came back from a worker. */
+  bool done;
+  /* Built completely, the result is kept even if the rest of the queue is stopped. */
+  bool built;
 } SeqIndexBuildContext;
 
 #define PROXY_MAXFILE (2 * FILE_MAXDIR + FILE_MAXFILE)
@@ -2177,6 +2187,7 @@ void BKE_sequencer_proxy_rebuild(SeqIndexBuildContext *context,
   if (seq->type == SEQ_TYPE_MOVIE) {
     if (context->index_context) {
       IMB_anim_index_rebuild(context->index_context, stop, do_update, progress);
+      context->built = !*stop;
     }
 
     return;
@@ -2233,6 +2244,116 @@ void BKE_sequencer_proxy_rebuild(SeqIndexBuildContext *context,
   }
 }
 
+typedef struct SeqProxyRebuildQueueData {
+  /* Movie strips waiting for a worker. */
+  ThreadQueue *todo;
+  /* Movie strips which are finished, returned to the thread running the queue. */
+  ThreadQueue *done;
+  short *stop;
+  short *do_update;
+} SeqProxyRebuildQueueData;
+
+static void *seq_proxy_rebuild_thread(void *data_v)
+{
+  SeqProxyRebuildQueueData *data = data_v;
+  SeqIndexBuildContext *context;
+
+  while ((context = BLI_thread_queue_pop(data->todo))) {
+    if (!*data->stop) {
+      BKE_sequencer_proxy_rebuild(context, data->stop, data->do_update, &context->progress);
+    }
+    BLI_thread_queue_push(data->done, context);
+  }
+
+  return NULL;
+}
+
+static void seq_proxy_rebuild_queue_update(ListBase *queue, float *progress)
+{
+  LinkData *link;
+  float total = 0.0f;
+  int num_contexts = 0;
+
+  for (link = queue->first; link; link = link->next) {
+    SeqIndexBuildContext *context = link->data;
+    /* Racy read of a worker's progress, only used for display. */
+    total += context->done ? 1.0f : context->progress;
+    num_contexts++;
+  }
+
+  if (num_contexts) {
+    *progress = total / num_contexts;
+  }
+}
+
+/* Movie strips decode with their own FFmpeg contexts and are rebuilt concurrently, other strips
+ * go through the sequencer render pipeline and are rebuilt one after another on this thread.
+ *
+ * Every movie strip decodes with IMB_INDEX_BUILD_DECODE_THREADS threads, so only as many strips
+ * as fit in the cores are rebuilt at once. Their proxy sizes are encoded on the task scheduler,
+ * which is bounded by the cores too. */
+void BKE_sequencer_proxy_rebuild_queue(ListBase *queue,
+                                       short *stop,
+                                       short *do_update,
+                                       float *progress)
+{
+  SeqProxyRebuildQueueData data = {
+      BLI_thread_queue_init(), BLI_thread_queue_init(), stop, do_update};
+  ListBase threads;
+  LinkData *link;
+  int num_movies = 0;
+
+  for (link = queue->first; link; link = link->next) {
+    SeqIndexBuildContext *context = link->data;
+    context->progress = 0.0f;
+    context->done = false;
+
+    if (context->seq->type == SEQ_TYPE_MOVIE) {
+      BLI_thread_queue_push(data.todo, context);
+      num_movies++;
+    }
+  }
+  /* Workers stop once all movie strips are taken. */
+  BLI_thread_queue_nowait(data.todo);
+
+  const int num_threads = min_ii(
+      num_movies, max_ii(1, BLI_system_thread_count() / IMB_INDEX_BUILD_DECODE_THREADS));
+  if (num_threads) {
+    BLI_threadpool_init(&threads, seq_proxy_rebuild_thread, num_threads);
+    for (int i = 0; i < num_threads; i++) {
+      BLI_threadpool_insert(&threads, &data);
+    }
+  }
+
+  for (link = queue->first; link; link = link->next) {
+    SeqIndexBuildContext *context = link->data;
+
+    if (context->seq->type != SEQ_TYPE_MOVIE) {
+      if (!*stop) {
+        BKE_sequencer_proxy_rebuild(context, stop, do_update, &context->progress);
+      }
+      context->done = true;
+      seq_proxy_rebuild_queue_update(queue, progress);
+    }
+  }
+
+  /* Wait for the movie strips, waking up regularly to update the progress. */
+  for (int num_done = 0; num_done < num_movies;) {
+    SeqIndexBuildContext *context = BLI_thread_queue_pop_timeout(data.done, 100);
+    if (context) {
+      context->done = true;
+      num_done++;
+    }
+    seq_proxy_rebuild_queue_update(queue, progress);
+  }
+
+  if (num_threads) {
+    BLI_threadpool_end(&threads);
+  }
+  BLI_thread_queue_free(data.todo);
+  BLI_thread_queue_free(data.done);
+}
+
 void BKE_sequencer_proxy_rebuild_finish(SeqIndexBuildContext *context, bool stop)
 {
   if (context->index_context) {
@@ -2246,7 +2367,8 @@ void BKE_sequencer_proxy_rebuild_finish(SeqIndexBuildContext *context, bool stop
       IMB_close_anim_proxies(sanim->anim);
     }
 
-    IMB_anim_index_rebuild_finish(context->index_context, stop);
+    /* Only roll back what was interrupted, a rebuild skipping existing proxies resumes. */
+    IMB_anim_index_rebuild_finish(context->index_context, stop && !context->built);
   }
 
   seq_free_sequence_recurse(NULL, context->seq, true);
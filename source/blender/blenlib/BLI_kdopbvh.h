@@ -89,6 +89,11 @@ typedef struct BVHTreeRayHit {
   float dist;
 } BVHTreeRayHit;
 
+enum {
+  /* Split branches with the surface area heuristic instead of at the median leaf,
+   * slower to build but faster to query (see #BLI_bvhtree_new_ex) */
+  BVH_BUILD_SAH = (1 << 0),
+};
 enum {
   /* Use a priority queue to process nodes in the optimal order (for slow callbacks) */
   BVH_OVERLAP_USE_THREADING = (1 << 0),
@@ -131,6 +136,13 @@ typedef void (*BVHTree_NearestProjectedCallback)(void *userdata,
                                                  const int clip_plane_len,
                                                  BVHTreeNearest *nearest);
 
+/* callback to get the points of a leaf, to refit (must be thread-safe),
+ * returns the number of points written (at most BVH_REFIT_POINTS_MAX) */
+#define BVH_REFIT_POINTS_MAX 4
+typedef int (*BVHTree_RefitCallback)(void *userdata,
+                                     int index,
+                                     float r_co[BVH_REFIT_POINTS_MAX][3]);
+
 /* callbacks to BLI_bvhtree_walk_dfs */
 /* return true to traverse into this nodes children, else skip. */
 typedef bool (*BVHTree_WalkParentCallback)(const BVHTreeAxisRange *bounds, void *userdata);
@@ -144,6 +156,7 @@ typedef bool (*BVHTree_WalkOrderCallback)(const BVHTreeAxisRange *bounds,
                                           void *userdata);
 
 BVHTree *BLI_bvhtree_new(int maxsize, float epsilon, char tree_type, char axis);
+BVHTree *BLI_bvhtree_new_ex(int maxsize, float epsilon, char tree_type, char axis, int flag);
 void BLI_bvhtree_free(BVHTree *tree);
 
 /* construct: first insert points, then call balance */
@@ -154,6 +167,8 @@ void BLI_bvhtree_balance(BVHTree *tree);
 bool BLI_bvhtree_update_node(
     BVHTree *tree, int index, const float co[3], const float co_moving[3], int numpoints);
 void BLI_bvhtree_update_tree(BVHTree *tree);
+/* update all nodes at once, getting the points from a callback */
+void BLI_bvhtree_refit(BVHTree *tree, BVHTree_RefitCallback callback, void *userdata);
 
 int BLI_bvhtree_overlap_thread_num(const BVHTree *tree);
 
@@ -231,6 +246,24 @@ void BLI_bvhtree_ray_cast_all(BVHTree *tree,
                               BVHTree_RayCastCallback callback,
                               void *userdata);
 
+/* batched queries (callbacks must be thread-safe) */
+void BLI_bvhtree_ray_cast_batch(BVHTree *tree,
+                                const float (*co)[3],
+                                const float (*dir)[3],
+                                const int rays_num,
+                                float radius,
+                                BVHTreeRayHit *hits,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata,
+                                int flag);
+void BLI_bvhtree_find_nearest_batch(BVHTree *tree,
+                                    const float (*co)[3],
+                                    const int co_num,
+                                    BVHTreeNearest *nearest,
+                                    BVHTree_NearestPointCallback callback,
+                                    void *userdata,
+                                    int flag);
+
 float BLI_bvhtree_bb_raycast(const float bv[6],
                              const float light_start[3],
                              const float light_end[3],
@@ -36,8 +36,10 @@ struct BLI_mempool;
 
 /* Task Scheduler
  *
- * Central scheduler that holds running threads ready to execute tasks. A single
- * queue holds the task from all pools.
+ * Central scheduler that holds running threads ready to execute tasks. A global
+ * queue holds the tasks pushed from outside of the scheduler threads, while tasks
+ * pushed from within scheduler threads (including nested pools and parallel ranges)
+ * go to a per-thread deque, from which idle threads steal work.
  *
  * Init/exit must be called before/after any task pools are created/freed, and
  * must be called from the main threads. All other scheduler and pool functions
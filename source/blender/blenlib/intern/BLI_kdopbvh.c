@@ -36,6 +36,8 @@
  *   #BLI_bvhtree_overlap, #BVHOverlapData_Shared, #BVHOverlapData_Thread
  * - Range Query:
  *   #BLI_bvhtree_range_query
+ * - Batched ray-cast and nearest point, traversing packets of queries with SIMD:
+ *   #BLI_bvhtree_ray_cast_batch, #BLI_bvhtree_find_nearest_batch
  */
 
 #include <assert.h>
@@ -47,9 +49,14 @@
 #include "BLI_stack.h"
 #include "BLI_kdopbvh.h"
 #include "BLI_math.h"
+#include "BLI_math_bits.h"
 #include "BLI_task.h"
 #include "BLI_heap_simple.h"
 
+#ifdef __SSE2__
+#  include <xmmintrin.h>
+#endif
+
 #include "BLI_strict_flags.h"
 
 /* used for iterative_raycast */
@@ -102,11 +109,12 @@ struct BVHTree {
   axis_t start_axis, stop_axis; /* bvhtree_kdop_axes array indices according to axis */
   axis_t axis;                  /* kdop type (6 => OBB, 7 => AABB, ...) */
   char tree_type;               /* type of tree (4 => quadtree) */
+  char flag;                    /* BVH_BUILD_* flags */
 };
 
 /* optimization, ensure we stay small */
-BLI_STATIC_ASSERT((sizeof(void *) == 8 && sizeof(BVHTree) <= 48) ||
-                      (sizeof(void *) == 4 && sizeof(BVHTree) <= 32),
+BLI_STATIC_ASSERT((sizeof(void *) == 8 && sizeof(BVHTree) <= 56) ||
+                      (sizeof(void *) == 4 && sizeof(BVHTree) <= 36),
                   "over sized")
 
 /* avoid duplicating vars in BVHOverlapData_Thread */
@@ -433,7 +441,7 @@ static char get_largest_axis(const float *bv)
 /**
  * bottom-up update of bvh node BV
  * join the children on the parent BV */
-static void node_join(BVHTree *tree, BVHNode *node)
+static void node_join(const BVHTree *tree, BVHNode *node)
 {
   int i;
   axis_t axis_iter;
@@ -859,6 +867,444 @@ static void non_recursive_bvh_div_nodes(const BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Binned SAH Build
+ *
+ * Used by trees created with #BVH_BUILD_SAH. Leafs are placed in bins along the x, y and z axis
+ * by the center of their bounds, and branches are split between the bins with the lowest
+ * surface area heuristic cost instead of at the median leaf.
+ *
+ * As for the implicit tree, the branches are built one level at a time and the branches of a
+ * level are split in parallel. The branches of a level are stored one after the other, followed
+ * by the branches of the next level, so they can be joined bottom-up one level at a time too.
+ * \{ */
+
+#define BVH_SAH_BINS 16
+
+typedef struct BVHSahBin {
+  float bv[6];
+  int count;
+} BVHSahBin;
+
+typedef struct BVHSahData {
+  BVHNode **leafs_array;
+  /** Axes to split on. */
+  int axis_begin, axis_end;
+  /** Bounds of the leaf centers (times two). */
+  float centroid_bv[6];
+  float bin_scale[3];
+  BVHSahBin bins[3][BVH_SAH_BINS];
+} BVHSahData;
+
+static void bvh_sah_bin_init(BVHSahBin *bin)
+{
+  for (int axis = 0; axis < 3; axis++) {
+    bin->bv[2 * axis] = FLT_MAX;
+    bin->bv[2 * axis + 1] = -FLT_MAX;
+  }
+  bin->count = 0;
+}
+
+static void bvh_sah_bv_join(float bv[6], const float bv_other[6])
+{
+  for (int axis = 0; axis < 3; axis++) {
+    bv[2 * axis] = min_ff(bv[2 * axis], bv_other[2 * axis]);
+    bv[2 * axis + 1] = max_ff(bv[2 * axis + 1], bv_other[2 * axis + 1]);
+  }
+}
+
+static float bvh_sah_bv_area(const float bv[6])
+{
+  const float size[3] = {bv[1] - bv[0], bv[3] - bv[2], bv[5] - bv[4]};
+  return size[0] * size[1] + size[1] * size[2] + size[2] * size[0];
+}
+
+BLI_INLINE int bvh_sah_bin_index(const BVHSahData *data, const float *bv, const int axis)
+{
+  const float centroid = bv[2 * axis] + bv[2 * axis + 1];
+  const int bin = (int)((centroid - data->centroid_bv[2 * axis]) * data->bin_scale[axis]);
+  return min_ii(bin, BVH_SAH_BINS - 1);
+}
+
+static void bvh_sah_centroid_bounds_task_cb(void *__restrict userdata,
+                                            const int i,
+                                            const TaskParallelTLS *__restrict tls)
+{
+  const BVHSahData *data = userdata;
+  const float *bv = data->leafs_array[i]->bv;
+  float *centroid_bv = tls->userdata_chunk;
+
+  for (int axis = data->axis_begin; axis < data->axis_end; axis++) {
+    const float centroid = bv[2 * axis] + bv[2 * axis + 1];
+    centroid_bv[2 * axis] = min_ff(centroid_bv[2 * axis], centroid);
+    centroid_bv[2 * axis + 1] = max_ff(centroid_bv[2 * axis + 1], centroid);
+  }
+}
+
+static void bvh_sah_centroid_bounds_finalize(void *__restrict userdata,
+                                             void *__restrict userdata_chunk)
+{
+  BVHSahData *data = userdata;
+  bvh_sah_bv_join(data->centroid_bv, userdata_chunk);
+}
+
+static void bvh_sah_bins_task_cb(void *__restrict userdata,
+                                 const int i,
+                                 const TaskParallelTLS *__restrict tls)
+{
+  const BVHSahData *data = userdata;
+  const float *bv = data->leafs_array[i]->bv;
+  BVHSahBin(*bins)[BVH_SAH_BINS] = tls->userdata_chunk;
+
+  for (int axis = data->axis_begin; axis < data->axis_end; axis++) {
+    BVHSahBin *bin = &bins[axis][bvh_sah_bin_index(data, bv, axis)];
+    bvh_sah_bv_join(bin->bv, bv);
+    bin->count++;
+  }
+}
+
+static void bvh_sah_bins_finalize(void *__restrict userdata, void *__restrict userdata_chunk)
+{
+  BVHSahData *data = userdata;
+  const BVHSahBin(*bins)[BVH_SAH_BINS] = userdata_chunk;
+
+  for (int axis = data->axis_begin; axis < data->axis_end; axis++) {
+    for (int i = 0; i < BVH_SAH_BINS; i++) {
+      bvh_sah_bv_join(data->bins[axis][i].bv, bins[axis][i].bv);
+      data->bins[axis][i].count += bins[axis][i].count;
+    }
+  }
+}
+
+/**
+ * Split the leafs in [begin, end) in two with the lowest SAH cost.
+ *
+ * \param r_axis: The axis to split on, any axis when -1, set to the axis that was used.
+ * \return the index of the first leaf of the second part.
+ */
+static int bvh_sah_split(BVHNode **leafs_array, const int begin, const int end, int *r_axis)
+{
+  BVHSahData data = {
+      .leafs_array = leafs_array,
+      .axis_begin = (*r_axis == -1) ? 0 : *r_axis,
+      .axis_end = (*r_axis == -1) ? 3 : *r_axis + 1,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (end - begin > KDOPBVH_THREAD_LEAF_THRESHOLD);
+
+  /* Bounds of the leaf centers, to place the leafs in bins. */
+  float centroid_bv[6];
+  for (int axis = 0; axis < 3; axis++) {
+    centroid_bv[2 * axis] = FLT_MAX;
+    centroid_bv[2 * axis + 1] = -FLT_MAX;
+  }
+  memcpy(data.centroid_bv, centroid_bv, sizeof(centroid_bv));
+  settings.userdata_chunk = centroid_bv;
+  settings.userdata_chunk_size = sizeof(centroid_bv);
+  settings.func_finalize = bvh_sah_centroid_bounds_finalize;
+  BLI_task_parallel_range(begin, end, &data, bvh_sah_centroid_bounds_task_cb, &settings);
+
+  for (int axis = data.axis_begin; axis < data.axis_end; axis++) {
+    const float extent = data.centroid_bv[2 * axis + 1] - data.centroid_bv[2 * axis];
+    const float scale = (float)BVH_SAH_BINS / extent;
+    /* All leafs go to the first bin when they can't be split on this axis. */
+    data.bin_scale[axis] = (extent > 0.0f && isfinite(scale)) ? scale : 0.0f;
+  }
+
+  BVHSahBin bins[3][BVH_SAH_BINS];
+  for (int axis = 0; axis < 3; axis++) {
+    for (int i = 0; i < BVH_SAH_BINS; i++) {
+      bvh_sah_bin_init(&bins[axis][i]);
+    }
+  }
+  memcpy(data.bins, bins, sizeof(bins));
+  settings.userdata_chunk = bins;
+  settings.userdata_chunk_size = sizeof(bins);
+  settings.func_finalize = bvh_sah_bins_finalize;
+  BLI_task_parallel_range(begin, end, &data, bvh_sah_bins_task_cb, &settings);
+
+  /* Cost of splitting after each bin: the area of each part times its number of leafs. */
+  int best_axis = -1, best_bin = 0;
+  float best_cost = FLT_MAX;
+  for (int axis = data.axis_begin; axis < data.axis_end; axis++) {
+    float area_right[BVH_SAH_BINS];
+    int count_right[BVH_SAH_BINS];
+    BVHSahBin part;
+
+    bvh_sah_bin_init(&part);
+    for (int i = BVH_SAH_BINS - 1; i > 0; i--) {
+      bvh_sah_bv_join(part.bv, data.bins[axis][i].bv);
+      part.count += data.bins[axis][i].count;
+      area_right[i] = bvh_sah_bv_area(part.bv);
+      count_right[i] = part.count;
+    }
+
+    bvh_sah_bin_init(&part);
+    for (int i = 0; i < BVH_SAH_BINS - 1; i++) {
+      bvh_sah_bv_join(part.bv, data.bins[axis][i].bv);
+      part.count += data.bins[axis][i].count;
+      if (part.count == 0 || count_right[i + 1] == 0) {
+        continue;
+      }
+
+      const float cost = bvh_sah_bv_area(part.bv) * (float)part.count +
+                         area_right[i + 1] * (float)count_right[i + 1];
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_axis = axis;
+        best_bin = i;
+      }
+    }
+  }
+
+  if (best_axis == -1) {
+    /* All leafs have the same center on the axis, any split is as good. */
+    *r_axis = data.axis_begin;
+    return (begin + end) / 2;
+  }
+
+  int i = begin, j = end - 1;
+  while (i <= j) {
+    if (bvh_sah_bin_index(&data, leafs_array[i]->bv, best_axis) <= best_bin) {
+      i++;
+    }
+    else {
+      SWAP(BVHNode *, leafs_array[i], leafs_array[j]);
+      j--;
+    }
+  }
+
+  *r_axis = best_axis;
+  return i;
+}
+
+/**
+ * Split the leafs of a branch in up to tree_type parts, the part with the most leafs is split
+ * again until there are enough parts. Parts are given as in #split_leafs,
+ * positions after the last part are set to \a end.
+ *
+ * All parts are split on the axis of the first split, so the children are ordered along
+ * the main axis of the branch (which ray-casts use to visit the closest child first).
+ */
+static void bvh_sah_split_leafs(
+    const BVHTree *tree, BVHNode *parent, BVHNode **leafs_array, int begin, int end, int nth[])
+{
+  int parts_len = 1;
+  nth[0] = begin;
+  nth[1] = end;
+
+  int split_axis = -1;
+  while (parts_len < tree->tree_type) {
+    int part = -1, part_leafs_len = 1;
+    for (int k = 0; k < parts_len; k++) {
+      if (nth[k + 1] - nth[k] > part_leafs_len) {
+        part = k;
+        part_leafs_len = nth[k + 1] - nth[k];
+      }
+    }
+    if (part == -1) {
+      break;
+    }
+
+    const int split = bvh_sah_split(leafs_array, nth[part], nth[part + 1], &split_axis);
+    memmove(&nth[part + 2], &nth[part + 1], sizeof(*nth) * (size_t)(parts_len - part));
+    nth[part + 1] = split;
+    parts_len++;
+  }
+
+  for (int k = parts_len + 1; k <= tree->tree_type; k++) {
+    nth[k] = end;
+  }
+
+  /* Save split axis (this can be used on raytracing to speedup the query time) */
+  parent->main_axis = (split_axis != -1) ? (char)split_axis : get_largest_axis(parent->bv) / 2;
+}
+
+typedef struct BVHSahDivNodesData {
+  const BVHTree *tree;
+  BVHNode *branches_array;
+  BVHNode **leafs_array;
+
+  /** Leafs range of each branch, set when its parent is split. */
+  int (*branch_leafs)[2];
+  /** Parts of the branches of the current level, tree_type + 1 positions for each. */
+  int *nth_positions;
+  int level_first;
+} BVHSahDivNodesData;
+
+static void bvh_sah_div_nodes_task_cb(void *__restrict userdata,
+                                      const int j,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BVHSahDivNodesData *data = userdata;
+  const BVHTree *tree = data->tree;
+  BVHNode *parent = &data->branches_array[j];
+  const int *parent_leafs = data->branch_leafs[j];
+  int *nth = &data->nth_positions[(j - data->level_first) * (tree->tree_type + 1)];
+
+  refit_kdop_hull(tree, parent, parent_leafs[0], parent_leafs[1]);
+  bvh_sah_split_leafs(tree, parent, data->leafs_array, parent_leafs[0], parent_leafs[1], nth);
+}
+
+/**
+ * Build a tree from the given leafs, splitting branches with the surface area heuristic.
+ * Like #non_recursive_bvh_div_nodes the branches are stored from index 1 of \a branches_array.
+ *
+ * \return the number of branches.
+ */
+static int sah_bvh_div_nodes(const BVHTree *tree,
+                             BVHNode *branches_array,
+                             BVHNode **leafs_array,
+                             int num_leafs)
+{
+  const int tree_type = tree->tree_type;
+  const int num_branches_max = max_ii(1, num_leafs - 1);
+
+  BVHSahDivNodesData data = {
+      .tree = tree,
+      .branches_array = branches_array,
+      .leafs_array = leafs_array,
+      .branch_leafs = MEM_malloc_arrayN((size_t)num_branches_max + 1, sizeof(int[2]), __func__),
+  };
+
+  BVHNode *root = &branches_array[1];
+  root->parent = NULL;
+  data.branch_leafs[1][0] = 0;
+  data.branch_leafs[1][1] = num_leafs;
+
+  int level_first = 1, level_stop = 2;
+  while (level_first < level_stop) {
+    const int level_len = level_stop - level_first;
+    data.nth_positions = MEM_malloc_arrayN(
+        (size_t)(level_len * (tree_type + 1)), sizeof(int), __func__);
+    data.level_first = level_first;
+
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = (num_leafs > KDOPBVH_THREAD_LEAF_THRESHOLD);
+    BLI_task_parallel_range(level_first, level_stop, &data, bvh_sah_div_nodes_task_cb, &settings);
+
+    /* Link the children, branches get the next indices so they make the next level. */
+    int next_level_stop = level_stop;
+    for (int j = level_first; j < level_stop; j++) {
+      BVHNode *parent = &branches_array[j];
+      const int *nth = &data.nth_positions[(j - level_first) * (tree_type + 1)];
+      int k;
+
+      for (k = 0; k < tree_type && nth[k] < nth[k + 1]; k++) {
+        BVHNode *child;
+        if (nth[k + 1] - nth[k] > 1) {
+          BLI_assert(next_level_stop <= num_branches_max);
+          child = &branches_array[next_level_stop];
+          data.branch_leafs[next_level_stop][0] = nth[k];
+          data.branch_leafs[next_level_stop][1] = nth[k + 1];
+          next_level_stop++;
+        }
+        else {
+          child = leafs_array[nth[k]];
+        }
+        parent->children[k] = child;
+        child->parent = parent;
+      }
+      parent->totnode = (char)k;
+    }
+
+    MEM_freeN(data.nth_positions);
+    level_first = level_stop;
+    level_stop = next_level_stop;
+  }
+
+  MEM_freeN(data.branch_leafs);
+  return level_stop - 1;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Bottom-Up Join
+ *
+ * The branches of each level of the tree are stored one after the other,
+ * so a level can be joined in parallel once the level below it is done.
+ * \{ */
+
+typedef struct BVHJoinBranchesData {
+  const BVHTree *tree;
+  BVHNode *branches_array;
+} BVHJoinBranchesData;
+
+static void bvhtree_join_branches_task_cb(void *__restrict userdata,
+                                          const int j,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BVHJoinBranchesData *data = userdata;
+  BVHNode *node = &data->branches_array[j];
+
+  node_join(data->tree, node);
+}
+
+/**
+ * Update the bounds of all branches from their children, deepest level first.
+ */
+static void bvhtree_join_branches(const BVHTree *tree)
+{
+  const int tree_type = tree->tree_type;
+  const int tree_offset = 2 - tree->tree_type;
+  const int num_branches = tree->totbranch;
+  BVHNode *branches_array = tree->nodearray + (tree->totleaf - 1);
+  int level_first_buf[33];
+  int *level_first = level_first_buf;
+  int levels_len = 0;
+
+  if (tree->flag & BVH_BUILD_SAH) {
+    /* Levels aren't implicit, the next level ends after the last branch linked by this one. */
+    level_first = MEM_malloc_arrayN((size_t)num_branches + 1, sizeof(int), __func__);
+    for (int i = 1, i_stop = min_ii(2, num_branches + 1); i < i_stop;) {
+      int next_i_stop = i_stop;
+      for (int j = i; j < i_stop; j++) {
+        const BVHNode *node = &branches_array[j];
+        for (int k = 0; k < node->totnode; k++) {
+          if (node->children[k]->totnode != 0) {
+            next_i_stop = max_ii(next_i_stop, (int)(node->children[k] - branches_array) + 1);
+          }
+        }
+      }
+      level_first[levels_len++] = i;
+      i = i_stop;
+      i_stop = next_i_stop;
+    }
+  }
+  else {
+    for (int i = 1; i <= num_branches; i = i * tree_type + tree_offset) {
+      BLI_assert(levels_len < (int)ARRAY_SIZE(level_first_buf) - 1);
+      level_first[levels_len++] = i;
+    }
+  }
+  level_first[levels_len] = num_branches + 1;
+
+  BVHJoinBranchesData data = {
+      .tree = tree,
+      .branches_array = branches_array,
+  };
+
+  for (int level = levels_len - 1; level >= 0; level--) {
+    const int i = level_first[level];
+    const int i_stop = level_first[level + 1];
+
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = (i_stop - i > KDOPBVH_THREAD_LEAF_THRESHOLD);
+    BLI_task_parallel_range(i, i_stop, &data, bvhtree_join_branches_task_cb, &settings);
+  }
+
+  if (level_first != level_first_buf) {
+    MEM_freeN(level_first);
+  }
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree API
  * \{ */
@@ -867,9 +1313,18 @@ static void non_recursive_bvh_div_nodes(const BVHTree *tree,
  * \note many callers don't check for ``NULL`` return.
  */
 BVHTree *BLI_bvhtree_new(int maxsize, float epsilon, char tree_type, char axis)
+{
+  return BLI_bvhtree_new_ex(maxsize, epsilon, tree_type, axis, 0);
+}
+
+/**
+ * \param flag: #BVH_BUILD_SAH to split the branches with the surface area heuristic,
+ * the tree takes longer to build but queries visit fewer nodes.
+ */
+BVHTree *BLI_bvhtree_new_ex(int maxsize, float epsilon, char tree_type, char axis, int flag)
 {
   BVHTree *tree;
-  int numnodes, i;
+  int numnodes, num_branches, i;
 
   BLI_assert(tree_type >= 2 && tree_type <= MAX_TREETYPE);
 
@@ -885,6 +1340,7 @@ BVHTree *BLI_bvhtree_new(int maxsize, float epsilon, char tree_type, char axis)
     tree->epsilon = epsilon;
     tree->tree_type = tree_type;
     tree->axis = axis;
+    tree->flag = (char)flag;
 
     if (axis == 26) {
       tree->start_axis = 0;
@@ -913,8 +1369,10 @@ BVHTree *BLI_bvhtree_new(int maxsize, float epsilon, char tree_type, char axis)
       goto fail;
     }
 
-    /* Allocate arrays */
-    numnodes = maxsize + implicit_needed_branches(tree_type, maxsize) + tree_type;
+    /* Allocate arrays, branches of SAH trees may have two children whatever the tree type */
+    num_branches = (flag & BVH_BUILD_SAH) ? max_ii(1, maxsize - 1) :
+                                            implicit_needed_branches(tree_type, maxsize);
+    numnodes = maxsize + num_branches + tree_type;
 
     tree->nodes = MEM_callocN(sizeof(BVHNode *) * (size_t)numnodes, "BVHNodes");
     tree->nodebv = MEM_callocN(sizeof(float) * (size_t)(axis * numnodes), "BVHNodeBV");
@@ -957,13 +1415,19 @@ void BLI_bvhtree_balance(BVHTree *tree)
    * (some big bug goes here if its being called more than once per tree) */
   BLI_assert(tree->totbranch == 0);
 
-  /* Build the implicit tree */
-  non_recursive_bvh_div_nodes(
-      tree, tree->nodearray + (tree->totleaf - 1), leafs_array, tree->totleaf);
+  if (tree->flag & BVH_BUILD_SAH) {
+    tree->totbranch = sah_bvh_div_nodes(
+        tree, tree->nodearray + (tree->totleaf - 1), leafs_array, tree->totleaf);
+  }
+  else {
+    /* Build the implicit tree */
+    non_recursive_bvh_div_nodes(
+        tree, tree->nodearray + (tree->totleaf - 1), leafs_array, tree->totleaf);
+    tree->totbranch = implicit_needed_branches(tree->tree_type, tree->totleaf);
+  }
 
   /* current code expects the branches to be linked to the nodes array
    * we perform that linkage here */
-  tree->totbranch = implicit_needed_branches(tree->tree_type, tree->totleaf);
   for (int i = 0; i < tree->totbranch; i++) {
     tree->nodes[tree->totleaf + i] = &tree->nodearray[tree->totleaf + i];
   }
@@ -1037,15 +1501,60 @@ void BLI_bvhtree_update_tree(BVHTree *tree)
 {
   /* Update bottom=>top
    * TRICKY: the way we build the tree all the childs have an index greater than the parent
-   * This allows us todo a bottom up update by starting on the bigger numbered branch */
+   * This allows us todo a bottom up update, one level at a time. */
+  bvhtree_join_branches(tree);
+}
 
-  BVHNode **root = tree->nodes + tree->totleaf;
-  BVHNode **index = tree->nodes + tree->totleaf + tree->totbranch - 1;
+typedef struct BVHRefitData {
+  const BVHTree *tree;
+  BVHTree_RefitCallback callback;
+  void *userdata;
+} BVHRefitData;
 
-  for (; index >= root; index--) {
-    node_join(tree, *index);
+static void bvhtree_refit_leafs_task_cb(void *__restrict userdata,
+                                        const int i,
+                                        const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BVHRefitData *data = userdata;
+  const BVHTree *tree = data->tree;
+  BVHNode *node = tree->nodes[i];
+  float co[BVH_REFIT_POINTS_MAX][3];
+  axis_t axis_iter;
+
+  const int numpoints = data->callback(data->userdata, node->index, co);
+  BLI_assert(IN_RANGE_INCL(numpoints, 1, BVH_REFIT_POINTS_MAX));
+
+  create_kdop_hull(tree, node, co[0], numpoints, 0);
+
+  /* inflate the bv with some epsilon */
+  for (axis_iter = tree->start_axis; axis_iter < tree->stop_axis; axis_iter++) {
+    node->bv[(2 * axis_iter)] -= tree->epsilon;     /* minimum */
+    node->bv[(2 * axis_iter) + 1] += tree->epsilon; /* maximum */
   }
 }
+
+/**
+ * Update the bounds of all leafs and branches of a balanced tree, in parallel.
+ * Much faster than building a new tree when the elements moved (for deforming geometry),
+ * queries get slower when they moved far from their neighbors in the tree though.
+ *
+ * \param callback: Gets the points of the leaf with the index given to #BLI_bvhtree_insert.
+ */
+void BLI_bvhtree_refit(BVHTree *tree, BVHTree_RefitCallback callback, void *userdata)
+{
+  BVHRefitData data = {
+      .tree = tree,
+      .callback = callback,
+      .userdata = userdata,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (tree->totleaf > KDOPBVH_THREAD_LEAF_THRESHOLD);
+  BLI_task_parallel_range(0, tree->totleaf, &data, bvhtree_refit_leafs_task_cb, &settings);
+
+  bvhtree_join_branches(tree);
+}
 /**
  * Number of times #BLI_bvhtree_insert has been called.
  * mainly useful for asserts functions to check we added the correct number.
@@ -1989,6 +2498,485 @@ void BLI_bvhtree_ray_cast_all(BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name BLI_bvhtree_ray_cast_batch / BLI_bvhtree_find_nearest_batch
+ *
+ * Queries are traversed in packets, a node is tested against all queries of the packet at once
+ * (with SIMD when available) and is only entered by the queries which may find a result in it.
+ * Consecutive queries are usually close to each other (e.g. following the vertex order of a mesh),
+ * so they mostly visit the same nodes. Packets run in parallel.
+ *
+ * \{ */
+
+#define BVH_PACKET_SIZE 4
+/* Number of packets below which threading isn't worth it. */
+#define BVH_PACKET_BATCH_MIN_ITER 64
+
+/** Rays as structure of arrays, for the node tests. */
+typedef struct BVHRayCastPacket {
+  float origin[3][BVH_PACKET_SIZE];
+  float idot_axis[3][BVH_PACKET_SIZE];
+  /** Copy of #BVHTreeRayHit.dist of each ray. */
+  float dist[BVH_PACKET_SIZE];
+  BVHRayCastData *data[BVH_PACKET_SIZE];
+} BVHRayCastPacket;
+
+/** Points as structure of arrays, for the node tests. */
+typedef struct BVHNearestPacket {
+  float co[3][BVH_PACKET_SIZE];
+  /** Copy of #BVHTreeNearest.dist_sq of each point. */
+  float dist_sq[BVH_PACKET_SIZE];
+  /**
+   * Nodes are tested against the k-DOP axes from 3 to this one, on top of the AABB.
+   * Set to 3 when only the AABB is tested.
+   */
+  axis_t stop_axis;
+  /** Projection of the points on the k-DOP axes past the AABB ones. */
+  float proj[13 - 3][BVH_PACKET_SIZE];
+  /** The k-DOP axes are not normalized, scales the squared distance to their slabs. */
+  float axis_inv_len_sq[13 - 3];
+  BVHNearestData *data[BVH_PACKET_SIZE];
+} BVHNearestPacket;
+
+/**
+ * Packet version of #fast_ray_nearest_hit.
+ * \return The rays of \a mask which hit the node closer than their current hit.
+ */
+static int ray_packet_nearest_hit(const BVHRayCastPacket *packet,
+                                  const BVHNode *node,
+                                  const int mask,
+                                  float r_dist[BVH_PACKET_SIZE])
+{
+  const float *bv = node->bv;
+
+#ifdef __SSE2__
+  __m128 tnear, tfar;
+  for (int i = 0; i < 3; i++, bv += 2) {
+    const __m128 origin = _mm_loadu_ps(packet->origin[i]);
+    const __m128 idot_axis = _mm_loadu_ps(packet->idot_axis[i]);
+    const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bv[0]), origin), idot_axis);
+    const __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bv[1]), origin), idot_axis);
+    if (i == 0) {
+      tnear = _mm_min_ps(t1, t2);
+      tfar = _mm_max_ps(t1, t2);
+    }
+    else {
+      tnear = _mm_max_ps(tnear, _mm_min_ps(t1, t2));
+      tfar = _mm_min_ps(tfar, _mm_max_ps(t1, t2));
+    }
+  }
+  const __m128 is_hit = _mm_and_ps(
+      _mm_and_ps(_mm_cmple_ps(tnear, tfar), _mm_cmpge_ps(tfar, _mm_setzero_ps())),
+      _mm_cmplt_ps(tnear, _mm_loadu_ps(packet->dist)));
+  _mm_storeu_ps(r_dist, tnear);
+  return mask & _mm_movemask_ps(is_hit);
+#else
+  int mask_hit = 0;
+  for (int lane = 0; lane < BVH_PACKET_SIZE; lane++) {
+    float tnear = -FLT_MAX, tfar = FLT_MAX;
+    for (int i = 0; i < 3; i++) {
+      const float t1 = (bv[i * 2] - packet->origin[i][lane]) * packet->idot_axis[i][lane];
+      const float t2 = (bv[i * 2 + 1] - packet->origin[i][lane]) * packet->idot_axis[i][lane];
+      tnear = max_ff(tnear, min_ff(t1, t2));
+      tfar = min_ff(tfar, max_ff(t1, t2));
+    }
+    if ((tnear <= tfar) && (tfar >= 0.0f) && (tnear < packet->dist[lane])) {
+      mask_hit |= 1 << lane;
+    }
+    r_dist[lane] = tnear;
+  }
+  return mask & mask_hit;
+#endif
+}
+
+/**
+ * Packet version of #calc_nearest_point_squared (without the nearest point).
+ * The distance to the slabs of the other k-DOP axes of the node is taken into account too,
+ * this is still a lower bound of the distance to anything inside the node.
+ * \return The points of \a mask which may have a nearer node than their current nearest.
+ */
+static int nearest_packet_test(const BVHNearestPacket *packet, const BVHNode *node, const int mask)
+{
+  const float *bv = node->bv;
+
+#ifdef __SSE2__
+  __m128 dist_sq = _mm_setzero_ps();
+  for (int i = 0; i < 3; i++, bv += 2) {
+    const __m128 co = _mm_loadu_ps(packet->co[i]);
+    const __m128 nearest = _mm_min_ps(_mm_max_ps(co, _mm_set1_ps(bv[0])), _mm_set1_ps(bv[1]));
+    const __m128 d = _mm_sub_ps(co, nearest);
+    dist_sq = _mm_add_ps(dist_sq, _mm_mul_ps(d, d));
+  }
+  for (axis_t axis = 3; axis < packet->stop_axis; axis++, bv += 2) {
+    const __m128 proj = _mm_loadu_ps(packet->proj[axis - 3]);
+    const __m128 d = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(bv[0]), proj),
+                                           _mm_sub_ps(proj, _mm_set1_ps(bv[1]))),
+                                _mm_setzero_ps());
+    dist_sq = _mm_max_ps(
+        dist_sq, _mm_mul_ps(_mm_mul_ps(d, d), _mm_set1_ps(packet->axis_inv_len_sq[axis - 3])));
+  }
+  return mask & _mm_movemask_ps(_mm_cmplt_ps(dist_sq, _mm_loadu_ps(packet->dist_sq)));
+#else
+  int mask_hit = 0;
+  for (int lane = 0; lane < BVH_PACKET_SIZE; lane++) {
+    float dist_sq = 0.0f;
+    for (int i = 0; i < 3; i++) {
+      const float co = packet->co[i][lane];
+      const float d = co - min_ff(max_ff(co, bv[i * 2]), bv[i * 2 + 1]);
+      dist_sq += d * d;
+    }
+    for (axis_t axis = 3; axis < packet->stop_axis; axis++) {
+      const float proj = packet->proj[axis - 3][lane];
+      const float d = max_fff(bv[axis * 2] - proj, proj - bv[axis * 2 + 1], 0.0f);
+      dist_sq = max_ff(dist_sq, d * d * packet->axis_inv_len_sq[axis - 3]);
+    }
+    if (dist_sq < packet->dist_sq[lane]) {
+      mask_hit |= 1 << lane;
+    }
+  }
+  return mask & mask_hit;
+#endif
+}
+
+/** Packet version of #dfs_raycast. */
+static void dfs_raycast_packet(BVHRayCastPacket *packet, const BVHNode *node, int mask)
+{
+  float dist[BVH_PACKET_SIZE];
+  mask = ray_packet_nearest_hit(packet, node, mask, dist);
+  if (mask == 0) {
+    return;
+  }
+
+  if (node->totnode == 0) {
+    for (int lane = 0; lane < BVH_PACKET_SIZE; lane++) {
+      if ((mask & (1 << lane)) == 0) {
+        continue;
+      }
+      BVHRayCastData *data = packet->data[lane];
+      if (data->callback) {
+        data->callback(data->userdata, node->index, &data->ray, &data->hit);
+      }
+      else {
+        data->hit.index = node->index;
+        data->hit.dist = dist[lane];
+        madd_v3_v3v3fl(data->hit.co, data->ray.origin, data->ray.direction, dist[lane]);
+      }
+      packet->dist[lane] = data->hit.dist;
+    }
+  }
+  else {
+    /* Pick loop direction from the first ray, others are assumed to be similar. */
+    const BVHRayCastData *data = packet->data[bitscan_forward_i(mask)];
+    if (data->ray_dot_axis[node->main_axis] > 0.0f) {
+      for (int i = 0; i != node->totnode; i++) {
+        dfs_raycast_packet(packet, node->children[i], mask);
+      }
+    }
+    else {
+      for (int i = node->totnode - 1; i >= 0; i--) {
+        dfs_raycast_packet(packet, node->children[i], mask);
+      }
+    }
+  }
+}
+
+/** Packet version of #dfs_find_nearest_dfs, \a mask must already be tested against \a node. */
+static void dfs_find_nearest_packet(BVHNearestPacket *packet, const BVHNode *node, const int mask)
+{
+  if (node->totnode == 0) {
+    for (int lane = 0; lane < BVH_PACKET_SIZE; lane++) {
+      if ((mask & (1 << lane)) == 0) {
+        continue;
+      }
+      BVHNearestData *data = packet->data[lane];
+      if (data->callback) {
+        data->callback(data->userdata, node->index, data->co, &data->nearest);
+      }
+      else {
+        data->nearest.index = node->index;
+        data->nearest.dist_sq = calc_nearest_point_squared(
+            data->proj, (BVHNode *)node, data->nearest.co);
+      }
+      packet->dist_sq[lane] = data->nearest.dist_sq;
+    }
+  }
+  else {
+    /* Pick loop direction from the first point, others are assumed to be close. */
+    const BVHNearestData *data = packet->data[bitscan_forward_i(mask)];
+    if (data->proj[node->main_axis] <= node->children[0]->bv[node->main_axis * 2 + 1]) {
+      for (int i = 0; i != node->totnode; i++) {
+        const int mask_child = nearest_packet_test(packet, node->children[i], mask);
+        if (mask_child) {
+          dfs_find_nearest_packet(packet, node->children[i], mask_child);
+        }
+      }
+    }
+    else {
+      for (int i = node->totnode - 1; i >= 0; i--) {
+        const int mask_child = nearest_packet_test(packet, node->children[i], mask);
+        if (mask_child) {
+          dfs_find_nearest_packet(packet, node->children[i], mask_child);
+        }
+      }
+    }
+  }
+}
+
+typedef struct BVHRayCastBatchData {
+  BVHTree *tree;
+  const float (*co)[3];
+  const float (*dir)[3];
+  int rays_num;
+  float radius;
+  BVHTreeRayHit *hits;
+  BVHTree_RayCastCallback callback;
+  void *userdata;
+  int flag;
+} BVHRayCastBatchData;
+
+static void bvhtree_ray_cast_batch_cb(void *__restrict userdata,
+                                      const int packet_index,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const BVHRayCastBatchData *batch = userdata;
+  BVHNode *root = batch->tree->nodes[batch->tree->totleaf];
+  const int ray_start = packet_index * BVH_PACKET_SIZE;
+  const int rays_len = min_ii(BVH_PACKET_SIZE, batch->rays_num - ray_start);
+
+  BVHRayCastData data[BVH_PACKET_SIZE];
+  BVHRayCastPacket packet;
+  int mask = 0;
+
+  for (int lane = 0; lane < BVH_PACKET_SIZE; lane++) {
+    if (lane >= rays_len) {
+      /* Unused lanes are never traversed, only initialize the values read by the node tests. */
+      for (int i = 0; i < 3; i++) {
+        packet.origin[i][lane] = 0.0f;
+        packet.idot_axis[i][lane] = 0.0f;
+      }
+      packet.dist[lane] = 0.0f;
+      packet.data[lane] = NULL;
+      continue;
+    }
+
+    const int ray_index = ray_start + lane;
+    BVHRayCastData *data_lane = &data[lane];
+
+    BLI_ASSERT_UNIT_V3(batch->dir[ray_index]);
+
+    data_lane->tree = batch->tree;
+    data_lane->callback = batch->callback;
+    data_lane->userdata = batch->userdata;
+    copy_v3_v3(data_lane->ray.origin, batch->co[ray_index]);
+    copy_v3_v3(data_lane->ray.direction, batch->dir[ray_index]);
+    data_lane->ray.radius = batch->radius;
+    bvhtree_ray_cast_data_precalc(data_lane, batch->flag);
+    memcpy(&data_lane->hit, &batch->hits[ray_index], sizeof(data_lane->hit));
+
+    if (batch->radius != 0.0f) {
+      /* The packet test doesn't support a radius (like #fast_ray_nearest_hit). */
+      dfs_raycast(data_lane, root);
+      memcpy(&batch->hits[ray_index], &data_lane->hit, sizeof(data_lane->hit));
+      continue;
+    }
+
+    for (int i = 0; i < 3; i++) {
+      packet.origin[i][lane] = data_lane->ray.origin[i];
+      packet.idot_axis[i][lane] = data_lane->idot_axis[i];
+    }
+    packet.dist[lane] = data_lane->hit.dist;
+    packet.data[lane] = data_lane;
+    mask |= 1 << lane;
+  }
+
+  if (mask == 0) {
+    return;
+  }
+
+  dfs_raycast_packet(&packet, root, mask);
+
+  for (int lane = 0; lane < BVH_PACKET_SIZE; lane++) {
+    if (mask & (1 << lane)) {
+      memcpy(&batch->hits[ray_start + lane], &data[lane].hit, sizeof(data[lane].hit));
+    }
+  }
+}
+
+/**
+ * Cast many rays, like calling #BLI_bvhtree_ray_cast_ex for each of them,
+ * but traversing the tree with packets of rays, in parallel.
+ *
+ * \param hits: One for each ray, used like the hit argument of #BLI_bvhtree_ray_cast_ex
+ * (the index and distance must be initialized).
+ * \note The callback is called from multiple threads.
+ */
+void BLI_bvhtree_ray_cast_batch(BVHTree *tree,
+                                const float (*co)[3],
+                                const float (*dir)[3],
+                                const int rays_num,
+                                float radius,
+                                BVHTreeRayHit *hits,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata,
+                                int flag)
+{
+  if ((rays_num == 0) || (tree->nodes[tree->totleaf] == NULL)) {
+    return;
+  }
+
+  BVHRayCastBatchData batch = {
+      .tree = tree,
+      .co = co,
+      .dir = dir,
+      .rays_num = rays_num,
+      .radius = radius,
+      .hits = hits,
+      .callback = callback,
+      .userdata = userdata,
+      .flag = flag,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = BVH_PACKET_BATCH_MIN_ITER;
+  BLI_task_parallel_range(0,
+                          (rays_num + BVH_PACKET_SIZE - 1) / BVH_PACKET_SIZE,
+                          &batch,
+                          bvhtree_ray_cast_batch_cb,
+                          &settings);
+}
+
+typedef struct BVHNearestBatchData {
+  BVHTree *tree;
+  const float (*co)[3];
+  int co_num;
+  BVHTreeNearest *nearest;
+  BVHTree_NearestPointCallback callback;
+  void *userdata;
+  int flag;
+} BVHNearestBatchData;
+
+static void bvhtree_find_nearest_batch_cb(void *__restrict userdata,
+                                          const int packet_index,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const BVHNearestBatchData *batch = userdata;
+  BVHTree *tree = batch->tree;
+  BVHNode *root = tree->nodes[tree->totleaf];
+  const int co_start = packet_index * BVH_PACKET_SIZE;
+  const int co_len = min_ii(BVH_PACKET_SIZE, batch->co_num - co_start);
+
+  if ((batch->flag & BVH_NEAREST_OPTIMAL_ORDER) || (tree->start_axis != 0)) {
+    /* The priority queue is specific to each point, don't use packets.
+     * Trees without the AABB axes (18-DOP) aren't supported by the packet test either. */
+    for (int i = co_start; i < co_start + co_len; i++) {
+      BLI_bvhtree_find_nearest_ex(
+          tree, batch->co[i], &batch->nearest[i], batch->callback, batch->userdata, batch->flag);
+    }
+    return;
+  }
+
+  BVHNearestData data[BVH_PACKET_SIZE];
+  BVHNearestPacket packet;
+  int mask = 0;
+
+  /* Without callback the nearest point of a leaf is the one on its AABB, like
+   * #BLI_bvhtree_find_nearest_ex. Testing the other axes would skip leaves it doesn't skip. */
+  packet.stop_axis = batch->callback ? tree->stop_axis : 3;
+  for (axis_t axis = 3; axis < packet.stop_axis; axis++) {
+    packet.axis_inv_len_sq[axis - 3] = 1.0f / len_squared_v3(bvhtree_kdop_axes[axis]);
+  }
+
+  for (int lane = 0; lane < BVH_PACKET_SIZE; lane++) {
+    if (lane >= co_len) {
+      /* Unused lanes are never traversed, only initialize the values read by the node tests. */
+      for (int i = 0; i < 3; i++) {
+        packet.co[i][lane] = 0.0f;
+      }
+      for (axis_t axis = 3; axis < packet.stop_axis; axis++) {
+        packet.proj[axis - 3][lane] = 0.0f;
+      }
+      packet.dist_sq[lane] = 0.0f;
+      packet.data[lane] = NULL;
+      continue;
+    }
+
+    BVHNearestData *data_lane = &data[lane];
+    data_lane->tree = tree;
+    data_lane->co = batch->co[co_start + lane];
+    data_lane->callback = batch->callback;
+    data_lane->userdata = batch->userdata;
+    for (axis_t axis_iter = tree->start_axis; axis_iter != tree->stop_axis; axis_iter++) {
+      data_lane->proj[axis_iter] = dot_v3v3(data_lane->co, bvhtree_kdop_axes[axis_iter]);
+    }
+    memcpy(&data_lane->nearest, &batch->nearest[co_start + lane], sizeof(data_lane->nearest));
+
+    for (int i = 0; i < 3; i++) {
+      packet.co[i][lane] = data_lane->proj[i];
+    }
+    for (axis_t axis = 3; axis < packet.stop_axis; axis++) {
+      packet.proj[axis - 3][lane] = data_lane->proj[axis];
+    }
+    packet.dist_sq[lane] = data_lane->nearest.dist_sq;
+    packet.data[lane] = data_lane;
+    mask |= 1 << lane;
+  }
+
+  mask = nearest_packet_test(&packet, root, mask);
+  if (mask != 0) {
+    dfs_find_nearest_packet(&packet, root, mask);
+  }
+
+  for (int lane = 0; lane < co_len; lane++) {
+    memcpy(&batch->nearest[co_start + lane], &data[lane].nearest, sizeof(data[lane].nearest));
+  }
+}
+
+/**
+ * Find the nearest node of many points, like calling #BLI_bvhtree_find_nearest_ex for each of
+ * them, but traversing the tree with packets of points, in parallel.
+ *
+ * \param nearest: One for each point, used like the nearest argument of
+ * #BLI_bvhtree_find_nearest_ex (the index and squared distance must be initialized).
+ * \note The callback is called from multiple threads.
+ */
+void BLI_bvhtree_find_nearest_batch(BVHTree *tree,
+                                    const float (*co)[3],
+                                    const int co_num,
+                                    BVHTreeNearest *nearest,
+                                    BVHTree_NearestPointCallback callback,
+                                    void *userdata,
+                                    int flag)
+{
+  if ((co_num == 0) || (tree->nodes[tree->totleaf] == NULL)) {
+    return;
+  }
+
+  BVHNearestBatchData batch = {
+      .tree = tree,
+      .co = co,
+      .co_num = co_num,
+      .nearest = nearest,
+      .callback = callback,
+      .userdata = userdata,
+      .flag = flag,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = BVH_PACKET_BATCH_MIN_ITER;
+  BLI_task_parallel_range(0,
+                          (co_num + BVH_PACKET_SIZE - 1) / BVH_PACKET_SIZE,
+                          &batch,
+                          bvhtree_find_nearest_batch_cb,
+                          &settings);
+}
+
+#undef BVH_PACKET_SIZE
+#undef BVH_PACKET_BATCH_MIN_ITER
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree_range_query
  *
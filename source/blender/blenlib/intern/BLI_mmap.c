@@ -0,0 +1,229 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bli
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_mmap.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#ifndef WIN32
+#  include <signal.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#else
+#  include "BLI_winstuff.h"
+#  include <io.h>
+#endif
+
+struct BLI_mmap_file {
+  /* Next in the list of all open mappings, used by the SIGBUS handler. */
+  struct BLI_mmap_file *next;
+
+  /* The address to which the file was mapped. */
+  char *memory;
+
+  /* The length of the file (and therefore the mapping). */
+  size_t length;
+
+  /* Platform-specific handle for the mapping. */
+  void *handle;
+
+  /* Flag to indicate IO errors. Needs to be volatile since it's being set from
+   * within the signal handler, which is not part of the normal execution flow. */
+  volatile bool io_error;
+};
+
+#ifndef WIN32
+
+/* When an IO error occurs while accessing mapped memory the kernel raises SIGBUS.
+ * The handler looks up the mapping that caused it, replaces it by zeroed pages so the
+ * faulting read can complete and flags the error, which #BLI_mmap_read then reports. */
+
+/* List of all open mappings. Only modified while holding #mmap_lock, the signal handler
+ * only ever reads it. */
+static BLI_mmap_file *volatile mmap_files = NULL;
+static ThreadMutex mmap_lock = BLI_MUTEX_INITIALIZER;
+
+static bool sigbus_handler_installed = false;
+static struct sigaction sigbus_handler_prev;
+
+static void sigbus_handler(int sig, siginfo_t *siginfo, void *ptr)
+{
+  const char *error_addr = (const char *)siginfo->si_addr;
+
+  for (BLI_mmap_file *file = mmap_files; file != NULL; file = file->next) {
+    if (file->memory <= error_addr && error_addr < file->memory + file->length) {
+      file->io_error = true;
+      /* Replace the mapped memory with zeroes, the faulting access is then retried. */
+      mmap(file->memory, file->length, PROT_READ, MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      return;
+    }
+  }
+
+  /* Not one of our mappings: chain to the previous handler, keeping ours installed. */
+  if (sigbus_handler_prev.sa_flags & SA_SIGINFO) {
+    if (sigbus_handler_prev.sa_sigaction != NULL) {
+      sigbus_handler_prev.sa_sigaction(sig, siginfo, ptr);
+      return;
+    }
+  }
+  else if (!ELEM(sigbus_handler_prev.sa_handler, SIG_DFL, SIG_IGN)) {
+    sigbus_handler_prev.sa_handler(sig);
+    return;
+  }
+
+  /* Default action, which terminates the process. Ignoring the signal would only make the
+   * faulting access fail again. */
+  signal(SIGBUS, SIG_DFL);
+  raise(SIGBUS);
+}
+
+static void sigbus_handler_ensure(void)
+{
+  if (sigbus_handler_installed) {
+    return;
+  }
+
+  struct sigaction newact;
+  memset(&newact, 0, sizeof(newact));
+  newact.sa_flags = SA_SIGINFO;
+  newact.sa_sigaction = sigbus_handler;
+  sigemptyset(&newact.sa_mask);
+
+  if (sigaction(SIGBUS, &newact, &sigbus_handler_prev) == 0) {
+    sigbus_handler_installed = true;
+  }
+}
+
+#endif /* WIN32 */
+
+BLI_mmap_file *BLI_mmap_open(int fd)
+{
+  void *memory, *handle = NULL;
+  const int64_t length = lseek(fd, 0, SEEK_END);
+  if (length <= 0) {
+    return NULL;
+  }
+
+#ifndef WIN32
+  /* Use a private copy-on-write mapping, readers are allowed to modify data in place
+   * (e.g. switching endianness) without it ending up in the file. */
+  memory = mmap(NULL, (size_t)length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if (memory == MAP_FAILED) {
+    return NULL;
+  }
+#else
+  /* Get the handle of the file. */
+  HANDLE file_handle = (HANDLE)_get_osfhandle(fd);
+  if (file_handle == INVALID_HANDLE_VALUE) {
+    return NULL;
+  }
+
+  /* Create the mapping object, which keeps the file open until it is closed itself. */
+  handle = CreateFileMapping(file_handle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+  if (handle == NULL) {
+    return NULL;
+  }
+
+  /* Map the whole file into memory, copy-on-write like on other platforms. */
+  memory = MapViewOfFile(handle, FILE_MAP_COPY, 0, 0, 0);
+  if (memory == NULL) {
+    CloseHandle(handle);
+    return NULL;
+  }
+#endif
+
+  BLI_mmap_file *file = MEM_callocN(sizeof(BLI_mmap_file), __func__);
+  file->memory = memory;
+  file->handle = handle;
+  file->length = (size_t)length;
+
+#ifndef WIN32
+  BLI_mutex_lock(&mmap_lock);
+  sigbus_handler_ensure();
+  file->next = mmap_files;
+  mmap_files = file;
+  BLI_mutex_unlock(&mmap_lock);
+#endif
+
+  return file;
+}
+
+bool BLI_mmap_read(BLI_mmap_file *file, void *dest, size_t offset, size_t length)
+{
+  /* If a previous read has already failed or we try to read past the end,
+   * don't even attempt to read any further. */
+  if (file->io_error || (offset > file->length) || (length > file->length - offset)) {
+    return false;
+  }
+
+#ifndef WIN32
+  /* If an error occurs in this call, sigbus_handler will be called and will set
+   * file->io_error to true. */
+  memcpy(dest, file->memory + offset, length);
+#else
+  /* On Windows, we use exception handling to be notified of errors. */
+  __try {
+    memcpy(dest, file->memory + offset, length);
+  }
+  __except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ? EXCEPTION_EXECUTE_HANDLER :
+                                                            EXCEPTION_CONTINUE_SEARCH) {
+    file->io_error = true;
+    return false;
+  }
+#endif
+
+  return !file->io_error;
+}
+
+void *BLI_mmap_get_pointer(BLI_mmap_file *file)
+{
+  return file->memory;
+}
+
+size_t BLI_mmap_get_length(const BLI_mmap_file *file)
+{
+  return file->length;
+}
+
+void BLI_mmap_free(BLI_mmap_file *file)
+{
+#ifndef WIN32
+  BLI_mutex_lock(&mmap_lock);
+  for (BLI_mmap_file *volatile *file_p = &mmap_files; *file_p != NULL;
+       file_p = &(*file_p)->next) {
+    if (*file_p == file) {
+      *file_p = file->next;
+      break;
+    }
+  }
+  BLI_mutex_unlock(&mmap_lock);
+
+  munmap(file->memory, file->length);
+#else
+  UnmapViewOfFile(file->memory);
+  CloseHandle(file->handle);
+#endif
+
+  MEM_freeN(file);
+}
@@ -58,6 +58,13 @@
  */
 #define DELAYED_QUEUE_SIZE 4096
 
+/* Initial number of tasks which fit into per-thread work-stealing deque.
+ *
+ * The deque grows on demand, so this only defines how soon the first
+ * re-allocation happens. Must be power of two.
+ */
+#define STEAL_DEQUE_INIT_SIZE 64
+
 #ifndef NDEBUG
 #  define ASSERT_THREAD_ID(scheduler, thread_id) \
     do { \
@@ -201,6 +208,30 @@ struct TaskPool {
 #endif
 };
 
+/* Per-thread double-ended queue of tasks used for work stealing.
+ *
+ * Tasks which are pushed from a scheduler thread (for example, by a nested
+ * BLI_task_parallel_range() or by a task spawning sub-tasks) go to the deque
+ * of that thread instead of the global scheduler queue. The owner thread takes
+ * tasks from the bottom (most recently pushed, LIFO, which keeps caches warm
+ * and bounds the depth of nested waits), while idle threads steal from the
+ * top (oldest, FIFO, which tends to be the biggest chunk of remaining work).
+ *
+ * Access is guarded by a per-deque spin lock. It is only contended when
+ * somebody is stealing, which is much cheaper than having all threads going
+ * through the single global queue mutex.
+ */
+typedef struct TaskDeque {
+  SpinLock lock;
+  Task **tasks;
+  /* Capacity of the tasks array, always power of two. */
+  int size;
+  /* Index of the oldest task in the ring buffer. */
+  int top;
+  /* Number of tasks in the deque, can be read without lock for a quick emptiness check. */
+  volatile int num;
+} TaskDeque;
+
 struct TaskScheduler {
   pthread_t *threads;
   struct TaskThread *task_threads;
@@ -211,6 +242,13 @@ struct TaskScheduler {
   ThreadMutex queue_mutex;
   ThreadCondition queue_cond;
 
+  /* Work stealing between per-thread deques, see TaskDeque. */
+  bool use_work_stealing;
+  /* Total number of tasks in all deques. */
+  volatile uint32_t num_stealable;
+  /* Number of worker threads waiting on queue_cond for new work. */
+  volatile uint32_t num_sleeping;
+
   ThreadMutex startup_mutex;
   ThreadCondition startup_cond;
   volatile int num_thread_started;
@@ -225,6 +263,7 @@ typedef struct TaskThread {
   TaskScheduler *scheduler;
   int id;
   TaskThreadLocalStorage tls;
+  TaskDeque deque;
 } TaskThread;
 
 /* Helper */
@@ -326,6 +365,180 @@ static void task_free(TaskPool *pool, Task *task, const int thread_id)
   }
 }
 
+/* Work-stealing deques */
+
+static void task_deque_init(TaskDeque *deque)
+{
+  BLI_spin_init(&deque->lock);
+  deque->tasks = MEM_mallocN(sizeof(Task *) * STEAL_DEQUE_INIT_SIZE, "TaskDeque tasks");
+  deque->size = STEAL_DEQUE_INIT_SIZE;
+  deque->top = 0;
+  deque->num = 0;
+}
+
+static void task_deque_free(TaskDeque *deque)
+{
+  /* Delete leftover tasks. */
+  for (int i = 0; i < deque->num; i++) {
+    Task *task = deque->tasks[(deque->top + i) & (deque->size - 1)];
+    task_data_free(task, 0);
+    MEM_freeN(task);
+  }
+  MEM_freeN(deque->tasks);
+  BLI_spin_end(&deque->lock);
+}
+
+/* Make sure deque can hold given number of tasks. Must be called with the lock held. */
+static void task_deque_ensure_size(TaskDeque *deque, const int num_tasks)
+{
+  if (num_tasks <= deque->size) {
+    return;
+  }
+  int new_size = deque->size;
+  while (new_size < num_tasks) {
+    new_size *= 2;
+  }
+  Task **new_tasks = MEM_mallocN(sizeof(Task *) * new_size, "TaskDeque tasks");
+  for (int i = 0; i < deque->num; i++) {
+    new_tasks[i] = deque->tasks[(deque->top + i) & (deque->size - 1)];
+  }
+  MEM_freeN(deque->tasks);
+  deque->tasks = new_tasks;
+  deque->size = new_size;
+  deque->top = 0;
+}
+
+/* Push high priority tasks to the bottom of the deque, last task of the array will be taken
+ * first by the owner thread. Other tasks go to the top, the owner takes them after the tasks
+ * which are already in the deque, but they are the first ones to be stolen. */
+static void task_deque_push(TaskDeque *deque,
+                            Task **tasks,
+                            const int num_tasks,
+                            const TaskPriority priority)
+{
+  BLI_spin_lock(&deque->lock);
+  task_deque_ensure_size(deque, deque->num + num_tasks);
+  const int mask = deque->size - 1;
+  if (priority == TASK_PRIORITY_HIGH) {
+    for (int i = 0; i < num_tasks; i++) {
+      deque->tasks[(deque->top + deque->num + i) & mask] = tasks[i];
+    }
+  }
+  else {
+    for (int i = 0; i < num_tasks; i++) {
+      deque->top = (deque->top - 1) & mask;
+      deque->tasks[deque->top] = tasks[i];
+    }
+  }
+  deque->num += num_tasks;
+  BLI_spin_unlock(&deque->lock);
+}
+
+static void task_deque_push_list(TaskDeque *deque, ListBase *tasks, const int num_tasks)
+{
+  BLI_spin_lock(&deque->lock);
+  task_deque_ensure_size(deque, deque->num + num_tasks);
+  const int mask = deque->size - 1;
+  int i = 0;
+  for (Task *task = tasks->first; task != NULL; task = task->next, i++) {
+    deque->tasks[(deque->top + deque->num + i) & mask] = task;
+  }
+  BLI_assert(i == num_tasks);
+  deque->num += num_tasks;
+  BLI_spin_unlock(&deque->lock);
+  BLI_listbase_clear(tasks);
+}
+
+/* Take a task from the deque, either from its bottom (owner thread) or from its top (stealing
+ * thread). If pool is given, only tasks from that pool are considered: this is what
+ * BLI_task_pool_work_and_wait() needs to avoid running tasks from unrelated pools. */
+static Task *task_deque_take(TaskDeque *deque, TaskPool *pool, const bool from_bottom)
+{
+  if (deque->num == 0) {
+    return NULL;
+  }
+
+  Task *task = NULL;
+
+  BLI_spin_lock(&deque->lock);
+  const int mask = deque->size - 1;
+  for (int i = 0; i < deque->num; i++) {
+    const int index = from_bottom ? deque->num - 1 - i : i;
+    Task *current_task = deque->tasks[(deque->top + index) & mask];
+    if (pool != NULL && current_task->pool != pool) {
+      continue;
+    }
+    task = current_task;
+    /* Close the gap. In the common case the task is at the end we are taking from, so nothing
+     * is to be moved. */
+    if (from_bottom) {
+      for (int j = index; j < deque->num - 1; j++) {
+        deque->tasks[(deque->top + j) & mask] = deque->tasks[(deque->top + j + 1) & mask];
+      }
+    }
+    else {
+      for (int j = index; j > 0; j--) {
+        deque->tasks[(deque->top + j) & mask] = deque->tasks[(deque->top + j - 1) & mask];
+      }
+      deque->top = (deque->top + 1) & mask;
+    }
+    deque->num--;
+    break;
+  }
+  BLI_spin_unlock(&deque->lock);
+
+  return task;
+}
+
+/* Remove all tasks of the given pool from the deque, returns number of removed tasks. */
+static int task_deque_clear(TaskDeque *deque, TaskPool *pool)
+{
+  if (deque->num == 0) {
+    return 0;
+  }
+
+  int num_removed = 0;
+
+  BLI_spin_lock(&deque->lock);
+  const int mask = deque->size - 1;
+  int num_kept = 0;
+  for (int i = 0; i < deque->num; i++) {
+    Task *task = deque->tasks[(deque->top + i) & mask];
+    if (task->pool == pool) {
+      task_data_free(task, pool->thread_id);
+      MEM_freeN(task);
+      num_removed++;
+    }
+    else {
+      deque->tasks[(deque->top + num_kept) & mask] = task;
+      num_kept++;
+    }
+  }
+  deque->num = num_kept;
+  BLI_spin_unlock(&deque->lock);
+
+  return num_removed;
+}
+
+/* Index of the scheduler thread whose deque receives tasks pushed from the given thread,
+ * or -1 when tasks are to go to the global queue. */
+BLI_INLINE int task_deque_index(TaskPool *pool, const int thread_id)
+{
+  if (!pool->scheduler->use_work_stealing || thread_id == -1) {
+    return -1;
+  }
+  if (pool->run_in_background || pool->scheduler->background_thread_only) {
+    /* Only the global queue knows which threads may run background tasks. */
+    return -1;
+  }
+  if (thread_id == 0 && pool->use_local_tls) {
+    /* Thread is not managed by the scheduler, so it has no deque. */
+    return -1;
+  }
+  BLI_assert(thread_id <= pool->scheduler->num_threads);
+  return thread_id;
+}
+
 /* Task Scheduler */
 
 static void task_pool_num_decrease(TaskPool *pool, size_t done)
@@ -353,13 +566,105 @@ static void task_pool_num_increase(TaskPool *pool, size_t new)
   BLI_mutex_unlock(&pool->num_mutex);
 }
 
-static bool task_scheduler_thread_wait_pop(TaskScheduler *scheduler, Task **task)
+/* Account tasks which were just pushed to a deque and wake up threads to steal them. */
+static void task_scheduler_stealable_added(TaskScheduler *scheduler, const int num_tasks)
+{
+  /* NOTE: The counter is to be incremented before checking for sleeping threads, and sleeping
+   * threads do the opposite, see task_scheduler_thread_wait_pop(). Atomic operations imply full
+   * memory barrier, so either we see the sleeping thread or it sees new tasks. */
+  atomic_add_and_fetch_uint32((uint32_t *)&scheduler->num_stealable, (uint32_t)num_tasks);
+  if (scheduler->num_sleeping != 0) {
+    BLI_mutex_lock(&scheduler->queue_mutex);
+    if (num_tasks == 1) {
+      BLI_condition_notify_one(&scheduler->queue_cond);
+    }
+    else {
+      BLI_condition_notify_all(&scheduler->queue_cond);
+    }
+    BLI_mutex_unlock(&scheduler->queue_mutex);
+  }
+}
+
+static void task_scheduler_push_stealable(TaskScheduler *scheduler,
+                                          TaskPool *pool,
+                                          const int deque_index,
+                                          Task **tasks,
+                                          const int num_tasks,
+                                          const TaskPriority priority)
+{
+  task_pool_num_increase(pool, num_tasks);
+  task_deque_push(&scheduler->task_threads[deque_index].deque, tasks, num_tasks, priority);
+  task_scheduler_stealable_added(scheduler, num_tasks);
+}
+
+/* Get next task to be executed by the given thread from the work-stealing deques: own deque is
+ * checked first, then tasks are stolen from other threads.
+ *
+ * If pool is not NULL only tasks of that pool are considered. */
+static Task *task_scheduler_steal(TaskScheduler *scheduler, const int thread_index, TaskPool *pool)
 {
+  if (scheduler->num_stealable == 0) {
+    return NULL;
+  }
+
+  const int num_deques = scheduler->num_threads + 1;
+  Task *task = NULL;
+
+  if (thread_index != -1) {
+    task = task_deque_take(&scheduler->task_threads[thread_index].deque, pool, true);
+  }
+
+  /* Start with the next thread, so that stealing threads do not all hammer the same deque. */
+  const int start_index = thread_index + 1;
+  for (int i = 0; task == NULL && i < num_deques; i++) {
+    const int victim_index = (start_index + i) % num_deques;
+    if (victim_index != thread_index) {
+      task = task_deque_take(&scheduler->task_threads[victim_index].deque, pool, false);
+    }
+  }
+
+  if (task != NULL) {
+    atomic_sub_and_fetch_uint32((uint32_t *)&scheduler->num_stealable, 1);
+  }
+
+  return task;
+}
+
+static bool task_scheduler_thread_wait_pop(TaskScheduler *scheduler,
+                                           TaskThread *thread,
+                                           Task **task)
+{
+  const bool use_work_stealing = scheduler->use_work_stealing;
   bool found_task = false;
+
+  /* Tasks from deques are preferred over the global queue: they are typically parts of some
+   * bigger task which is waiting for them, and taking them does not need global lock. */
+  if (use_work_stealing && (*task = task_scheduler_steal(scheduler, thread->id, NULL)) != NULL) {
+    return true;
+  }
+
   BLI_mutex_lock(&scheduler->queue_mutex);
 
   while (!scheduler->queue.first && !scheduler->do_exit) {
-    BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+    if (use_work_stealing) {
+      /* See task_scheduler_push_stealable() for details about the order of atomic operations. */
+      atomic_add_and_fetch_uint32((uint32_t *)&scheduler->num_sleeping, 1);
+      if (scheduler->num_stealable == 0) {
+        BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+      }
+      atomic_sub_and_fetch_uint32((uint32_t *)&scheduler->num_sleeping, 1);
+
+      if (scheduler->num_stealable != 0 && !scheduler->do_exit) {
+        BLI_mutex_unlock(&scheduler->queue_mutex);
+        if ((*task = task_scheduler_steal(scheduler, thread->id, NULL)) != NULL) {
+          return true;
+        }
+        BLI_mutex_lock(&scheduler->queue_mutex);
+      }
+    }
+    else {
+      BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+    }
   }
 
   do {
@@ -442,7 +747,7 @@ static void *task_scheduler_thread_run(void *thread_p)
   BLI_mutex_unlock(&scheduler->startup_mutex);
 
   /* keep popping off tasks */
-  while (task_scheduler_thread_wait_pop(scheduler, &task)) {
+  while (task_scheduler_thread_wait_pop(scheduler, thread, &task)) {
     TaskPool *pool = task->pool;
 
     /* run task */
@@ -499,6 +804,15 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
   /* Initialize TLS for main thread. */
   initialize_task_tls(&scheduler->task_threads[0].tls);
 
+  /* Background-only thread is only to pick up tasks from background pools, which always go
+   * through the global queue, so there is nothing to steal in that case. */
+  scheduler->use_work_stealing = !scheduler->background_thread_only;
+  scheduler->num_stealable = 0;
+  scheduler->num_sleeping = 0;
+  for (int i = 0; i < num_threads + 1; i++) {
+    task_deque_init(&scheduler->task_threads[i].deque);
+  }
+
   pthread_key_create(&scheduler->tls_id_key, NULL);
 
   /* launch threads that will be waiting for work */
@@ -564,6 +878,7 @@ void BLI_task_scheduler_free(TaskScheduler *scheduler)
     for (int i = 0; i < scheduler->num_threads + 1; i++) {
       TaskThreadLocalStorage *tls = &scheduler->task_threads[i].tls;
       free_task_tls(tls);
+      task_deque_free(&scheduler->task_threads[i].deque);
     }
 
     MEM_freeN(scheduler->task_threads);
@@ -610,12 +925,20 @@ static void task_scheduler_push(TaskScheduler *scheduler, Task *task, TaskPriori
 static void task_scheduler_push_all(TaskScheduler *scheduler,
                                     TaskPool *pool,
                                     Task **tasks,
-                                    int num_tasks)
+                                    int num_tasks,
+                                    int thread_id)
 {
   if (num_tasks == 0) {
     return;
   }
 
+  const int deque_index = task_deque_index(pool, thread_id);
+  if (deque_index != -1) {
+    task_scheduler_push_stealable(
+        scheduler, pool, deque_index, tasks, num_tasks, TASK_PRIORITY_HIGH);
+    return;
+  }
+
   task_pool_num_increase(pool, num_tasks);
 
   BLI_mutex_lock(&scheduler->queue_mutex);
@@ -649,6 +972,17 @@ static void task_scheduler_clear(TaskScheduler *scheduler, TaskPool *pool)
 
   BLI_mutex_unlock(&scheduler->queue_mutex);
 
+  /* free all tasks from this pool from the work-stealing deques */
+  if (scheduler->use_work_stealing) {
+    for (int i = 0; i < scheduler->num_threads + 1; i++) {
+      const int num_removed = task_deque_clear(&scheduler->task_threads[i].deque, pool);
+      if (num_removed != 0) {
+        atomic_sub_and_fetch_uint32((uint32_t *)&scheduler->num_stealable, (uint32_t)num_removed);
+        done += (size_t)num_removed;
+      }
+    }
+  }
+
   /* notify done */
   task_pool_num_decrease(pool, done);
 }
@@ -849,6 +1183,14 @@ static void task_pool_push(TaskPool *pool,
       return;
     }
   }
+  /* Push to the deque of the current thread, from where the task will be picked up by this
+   * thread once it is done with the current task, or stolen by an idle thread.
+   */
+  const int deque_index = task_deque_index(pool, thread_id);
+  if (deque_index != -1) {
+    task_scheduler_push_stealable(pool->scheduler, pool, deque_index, &task, 1, priority);
+    return;
+  }
   /* Do push to a global execution pool, slowest possible method,
    * causes quite reasonable amount of threading overhead.
    */
@@ -885,9 +1227,22 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 {
   TaskThreadLocalStorage *tls = get_task_tls(pool, pool->thread_id);
   TaskScheduler *scheduler = pool->scheduler;
+  const int deque_index = task_deque_index(pool, pool->thread_id);
 
   if (atomic_fetch_and_and_uint8((uint8_t *)&pool->is_suspended, 0)) {
-    if (pool->num_suspended) {
+    if (pool->num_suspended && deque_index != -1) {
+      /* Suspended tasks go to the deque of this thread, so that other threads can steal them
+       * without going through the global queue lock. This is what makes nested pools (such as
+       * parallel range from within a task) cheap. */
+      const int num_suspended = (int)pool->num_suspended;
+      task_pool_num_increase(pool, pool->num_suspended);
+      task_deque_push_list(
+          &scheduler->task_threads[deque_index].deque, &pool->suspended_queue, num_suspended);
+      task_scheduler_stealable_added(scheduler, num_suspended);
+
+      pool->num_suspended = 0;
+    }
+    else if (pool->num_suspended) {
       task_pool_num_increase(pool, pool->num_suspended);
       BLI_mutex_lock(&scheduler->queue_mutex);
 
@@ -914,21 +1269,28 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 
     BLI_mutex_unlock(&pool->num_mutex);
 
-    BLI_mutex_lock(&scheduler->queue_mutex);
-
     /* find task from this pool. if we get a task from another pool,
      * we can get into deadlock */
 
-    for (task = scheduler->queue.first; task; task = task->next) {
-      if (task->pool == pool) {
-        work_task = task;
-        found_task = true;
-        BLI_remlink(&scheduler->queue, task);
-        break;
-      }
+    if (scheduler->use_work_stealing) {
+      work_task = task_scheduler_steal(scheduler, deque_index, pool);
+      found_task = (work_task != NULL);
     }
 
-    BLI_mutex_unlock(&scheduler->queue_mutex);
+    if (!found_task) {
+      BLI_mutex_lock(&scheduler->queue_mutex);
+
+      for (task = scheduler->queue.first; task; task = task->next) {
+        if (task->pool == pool) {
+          work_task = task;
+          found_task = true;
+          BLI_remlink(&scheduler->queue, task);
+          break;
+        }
+      }
+
+      BLI_mutex_unlock(&scheduler->queue_mutex);
+    }
 
     /* if found task, do it, otherwise wait until other tasks are done */
     if (found_task) {
@@ -938,7 +1300,7 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
       BLI_assert(!tls->do_delayed_push);
 
       /* delete task */
-      task_free(pool, task, pool->thread_id);
+      task_free(pool, work_task, pool->thread_id);
 
       /* Handle all tasks from local queue. */
       handle_local_queue(tls, pool->thread_id);
@@ -1016,7 +1378,8 @@ void BLI_task_pool_delayed_push_end(TaskPool *pool, int thread_id)
     ASSERT_THREAD_ID(pool->scheduler, thread_id);
     TaskThreadLocalStorage *tls = get_task_tls(pool, thread_id);
     BLI_assert(tls->do_delayed_push);
-    task_scheduler_push_all(pool->scheduler, pool, tls->delayed_queue, tls->num_delayed_queue);
+    task_scheduler_push_all(
+        pool->scheduler, pool, tls->delayed_queue, tls->num_delayed_queue, thread_id);
     tls->do_delayed_push = false;
     tls->num_delayed_queue = 0;
   }
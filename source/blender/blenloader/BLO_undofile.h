@@ -25,22 +25,49 @@
  * \ingroup blenloader
  */
 
-struct Scene;
+struct GHash;
+
+struct MemFileChunkBuffer;
 
 typedef struct {
   void *next, *prev;
   const char *buf;
   /** Size in bytes. */
   unsigned int size;
-  /** When true, this chunk doesn't own the memory, it's shared with a previous #MemFileChunk */
+  /**
+   * When true, the memory was already stored by another #MemFileChunk (of this or any other
+   * #MemFile), so it doesn't add to the size of this #MemFile.
+   */
   bool is_identical;
+  /** Reference counted storage of #MemFileChunk.buf, shared between identical chunks. */
+  struct MemFileChunkBuffer *buffer;
+  /**
+   * Address of the data-block this chunk is part of, NULL for other data.
+   * Each data-block starts a new chunk, so its chunks can be compared between memfiles.
+   */
+  const void *id_address;
 } MemFileChunk;
 
 typedef struct MemFile {
   ListBase chunks;
   size_t size;
+  /**
+   * Maps the data-block addresses stored in this memfile to the data-blocks in memory,
+   * set when this memfile was last read for undo (after writing, the addresses match).
+   */
+  struct GHash *id_address_map;
 } MemFile;
 
+/** Memory statistics of the chunk storage shared by all #MemFile's. */
+typedef struct MemFileChunkStats {
+  /** Number of unique chunk buffers and the memory they use. */
+  size_t num_buffers;
+  size_t size_buffers;
+  /** Number of chunks in all memfiles and the memory they would use without sharing. */
+  size_t num_chunks;
+  size_t size_chunks;
+} MemFileChunkStats;
+
 typedef struct MemFileUndoData {
   char filename[1024]; /* FILE_MAX */
   MemFile memfile;
@@ -51,16 +78,15 @@ typedef struct MemFileUndoData {
 extern void memfile_chunk_add(MemFile *memfile,
                               const char *buf,
                               unsigned int size,
-                              MemFileChunk **compchunk_step);
+                              MemFileChunk **compchunk_step,
+                              const void *id_address);
 
 /* exports */
 extern void BLO_memfile_free(MemFile *memfile);
 extern void BLO_memfile_merge(MemFile *first, MemFile *second);
+extern void BLO_memfile_chunk_stats_get(MemFileChunkStats *r_stats);
 
 /* utilities */
-extern struct Main *BLO_memfile_main_get(struct MemFile *memfile,
-                                         struct Main *bmain,
-                                         struct Scene **r_scene);
 extern bool BLO_memfile_write_file(struct MemFile *memfile, const char *filename);
 
 #endif /* __BLO_UNDOFILE_H__ */
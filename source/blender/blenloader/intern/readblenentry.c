@@ -359,10 +359,13 @@ BlendFileData *BLO_read_from_memory(const void *mem,
  * \param oldmain: old main,
  * from which we will keep libraries and other data-blocks that should not have changed.
  * \param filename: current file, only for retrieving library data.
+ * \param memfile_reference: The memfile \a oldmain was last written to or read from (optional),
+ * data-blocks unchanged since are kept from \a oldmain instead of being read again.
  */
 BlendFileData *BLO_read_from_memfile(Main *oldmain,
                                      const char *filename,
                                      MemFile *memfile,
+                                     MemFile *memfile_reference,
                                      eBLOReadSkip skip_flags,
                                      ReportList *reports)
 {
@@ -396,10 +399,16 @@ BlendFileData *BLO_read_from_memfile(Main *oldmain,
     /* make lookups of existing sound data in old main */
     blo_make_sound_pointer_map(fd, oldmain);
 
+    /* makes lookup of unchanged data-blocks in old main */
+    blo_make_undo_reuse_map(fd, oldmain, memfile_reference);
+
     /* removed packed data from this trick - it's internal data that needs saves */
 
     bfd = blo_read_file_internal(fd, filename);
 
+    /* the data-blocks in memory now match the memfile read */
+    blo_end_undo_reuse_map(fd);
+
     /* ensures relinked light caches are not freed */
     blo_end_scene_pointer_map(fd, oldmain);
 
@@ -23,6 +23,10 @@
 
 #include "zlib.h"
 
+#ifdef WITH_ZSTD
+#  include <zstd.h>
+#endif
+
 #include <limits.h>
 #include <stdlib.h> /* for atoi. */
 #include <stddef.h> /* for offsetof. */
@@ -98,8 +102,10 @@
 #include "BLI_endian_switch.h"
 #include "BLI_blenlib.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_mempool.h"
+#include "BLI_mmap.h"
 #include "BLI_ghash.h"
 
 #include "BLT_translation.h"
@@ -218,8 +224,10 @@
  * Delay reading blocks we might not use (especially applies to library linking).
  * which keeps large arrays in memory from data-blocks we may not even use.
  *
- * \note This is disabled when using compression,
+ * \note This is disabled when using gzip compression,
  * while zlib supports seek it's unusably slow, see: T61880.
+ * Zstd compressed files written with a seek table support it.
+ * Uncompressed files are memory-mapped, so skipped blocks are never loaded from disk.
  */
 #define USE_BHEAD_READ_ON_DEMAND
 
@@ -1175,6 +1183,373 @@ static int fd_read_gzip_from_file(FileData *filedata, void *buffer, uint size)
   return (readsize);
 }
 
+/* Zstd file reading. */
+
+#ifdef WITH_ZSTD
+
+#  define ZSTD_SEEKABLE_SKIPPABLE_MAGIC 0x184D2A5E
+#  define ZSTD_SEEKABLE_FOOTER_MAGIC 0x8F92EAB1
+#  define ZSTD_SEEKABLE_FOOTER_SIZE 9
+/* Maximum number of frames decompressed at once when reading sequentially. */
+#  define ZSTD_READ_WINDOW_MAX 16
+
+typedef struct ZstdFrame {
+  /* Offsets in the compressed file and in the uncompressed stream. */
+  size_t compressed_offset;
+  size_t uncompressed_offset;
+  uint32_t compressed_size;
+  uint32_t uncompressed_size;
+} ZstdFrame;
+
+/**
+ * Files written with a seek table (see writefile.c) consist of independent frames.
+ * Frames are decompressed in windows of consecutive frames in parallel, and reading
+ * can seek to any offset by only decompressing the frame containing it.
+ *
+ * Files without seek table (e.g. compressed by the zstd command line tool) are
+ * decompressed as a stream, without seeking support.
+ */
+typedef struct ZstdReader {
+  /* Owned by the #FileData. */
+  int file;
+
+  /* Seekable reading. */
+  ZstdFrame *frames;
+  int num_frames;
+
+  /* Decompressed frames [window_start, window_start + window_len). */
+  int window_start;
+  int window_len;
+  int window_size;
+  char *window_compressed;
+  char *window_data[ZSTD_READ_WINDOW_MAX];
+  bool window_error;
+
+  /* Streaming reading. */
+  ZSTD_DCtx *dctx;
+  ZSTD_inBuffer in;
+  void *in_buf;
+  size_t in_buf_size;
+} ZstdReader;
+
+static uint32_t zstd_uint32_decode(const uchar *buf)
+{
+  return ((uint32_t)buf[0]) | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) |
+         ((uint32_t)buf[3] << 24);
+}
+
+/* Read the seek table from the end of the file, return false if there is none. */
+static bool zstd_read_seek_table(ZstdReader *reader)
+{
+  uchar footer[ZSTD_SEEKABLE_FOOTER_SIZE];
+  const off64_t file_size = lseek(reader->file, 0, SEEK_END);
+  if (file_size < ZSTD_SEEKABLE_FOOTER_SIZE + 8 ||
+      lseek(reader->file, -ZSTD_SEEKABLE_FOOTER_SIZE, SEEK_END) == -1 ||
+      read(reader->file, footer, sizeof(footer)) != sizeof(footer)) {
+    return false;
+  }
+  if (zstd_uint32_decode(footer + 5) != ZSTD_SEEKABLE_FOOTER_MAGIC) {
+    return false;
+  }
+
+  const int num_frames = (int)zstd_uint32_decode(footer);
+  /* Entries have an additional checksum when highest bit of descriptor is set. */
+  const int entry_size = (footer[4] & (1 << 7)) ? 12 : 8;
+  const off64_t table_size = (off64_t)num_frames * entry_size + ZSTD_SEEKABLE_FOOTER_SIZE;
+  if (num_frames <= 0 || table_size + 8 > file_size) {
+    return false;
+  }
+
+  uchar *table = MEM_mallocN((size_t)table_size + 8, __func__);
+  if (lseek(reader->file, -(table_size + 8), SEEK_END) == -1 ||
+      read(reader->file, table, (size_t)table_size + 8) != table_size + 8 ||
+      zstd_uint32_decode(table) != ZSTD_SEEKABLE_SKIPPABLE_MAGIC ||
+      zstd_uint32_decode(table + 4) != table_size) {
+    MEM_freeN(table);
+    return false;
+  }
+
+  ZstdFrame *frames = MEM_mallocN(sizeof(*frames) * (size_t)num_frames, __func__);
+  size_t compressed_offset = 0;
+  size_t uncompressed_offset = 0;
+  for (int i = 0; i < num_frames; i++) {
+    const uchar *entry = table + 8 + i * entry_size;
+    frames[i].compressed_offset = compressed_offset;
+    frames[i].uncompressed_offset = uncompressed_offset;
+    frames[i].compressed_size = zstd_uint32_decode(entry);
+    frames[i].uncompressed_size = zstd_uint32_decode(entry + 4);
+    compressed_offset += frames[i].compressed_size;
+    uncompressed_offset += frames[i].uncompressed_size;
+  }
+  MEM_freeN(table);
+
+  /* Frames and the seek table must cover the whole file. */
+  if (compressed_offset + (size_t)table_size + 8 != (size_t)file_size) {
+    MEM_freeN(frames);
+    return false;
+  }
+
+  reader->frames = frames;
+  reader->num_frames = num_frames;
+  return true;
+}
+
+static ZstdReader *zstd_reader_new(int file)
+{
+  ZstdReader *reader = MEM_callocN(sizeof(*reader), __func__);
+  reader->file = file;
+
+  if (zstd_read_seek_table(reader)) {
+    reader->window_size = min_ii(BLI_system_thread_count(), ZSTD_READ_WINDOW_MAX);
+  }
+  else {
+    reader->dctx = ZSTD_createDCtx();
+    reader->in_buf_size = ZSTD_DStreamInSize();
+    reader->in_buf = MEM_mallocN(reader->in_buf_size, __func__);
+    reader->in.src = reader->in_buf;
+    reader->in.size = 0;
+    reader->in.pos = 0;
+  }
+
+  lseek(file, 0, SEEK_SET);
+  return reader;
+}
+
+static void zstd_reader_free(ZstdReader *reader)
+{
+  for (int i = 0; i < ZSTD_READ_WINDOW_MAX; i++) {
+    MEM_SAFE_FREE(reader->window_data[i]);
+  }
+  MEM_SAFE_FREE(reader->window_compressed);
+  MEM_SAFE_FREE(reader->frames);
+  if (reader->dctx) {
+    ZSTD_freeDCtx(reader->dctx);
+  }
+  MEM_SAFE_FREE(reader->in_buf);
+  MEM_freeN(reader);
+}
+
+static void zstd_window_decompress_cb(void *__restrict userdata,
+                                      const int i,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  ZstdReader *reader = userdata;
+  const ZstdFrame *first_frame = &reader->frames[reader->window_start];
+  const ZstdFrame *frame = &reader->frames[reader->window_start + i];
+
+  const size_t size = ZSTD_decompress(
+      reader->window_data[i],
+      frame->uncompressed_size,
+      reader->window_compressed + (frame->compressed_offset - first_frame->compressed_offset),
+      frame->compressed_size);
+  if (size != frame->uncompressed_size) {
+    reader->window_error = true;
+  }
+}
+
+/* Make frame available in the decompressed window, return its data or NULL on error. */
+static const char *zstd_frame_ensure(ZstdReader *reader, const int frame_index)
+{
+  const int window_index = frame_index - reader->window_start;
+  if (window_index >= 0 && window_index < reader->window_len) {
+    return reader->window_data[window_index];
+  }
+
+  /* Decompress multiple frames ahead when reading sequentially, otherwise only decompress the
+   * requested frame, since only a small part of it is likely to be used (BHead read on
+   * demand, for example). */
+  const bool is_sequential = (frame_index == reader->window_start + reader->window_len);
+  const int window_len = is_sequential ? min_ii(reader->window_size,
+                                                reader->num_frames - frame_index) :
+                                         1;
+  const ZstdFrame *first_frame = &reader->frames[frame_index];
+  const ZstdFrame *last_frame = &reader->frames[frame_index + window_len - 1];
+  const size_t compressed_size = last_frame->compressed_offset + last_frame->compressed_size -
+                                 first_frame->compressed_offset;
+
+  reader->window_start = frame_index;
+  reader->window_len = 0;
+
+  /* Frames of a window are consecutive in the file, read them at once. */
+  MEM_SAFE_FREE(reader->window_compressed);
+  reader->window_compressed = MEM_mallocN(compressed_size, __func__);
+  if (lseek(reader->file, (off64_t)first_frame->compressed_offset, SEEK_SET) == -1 ||
+      read(reader->file, reader->window_compressed, compressed_size) != compressed_size) {
+    return NULL;
+  }
+
+  for (int i = 0; i < window_len; i++) {
+    const size_t size = reader->frames[frame_index + i].uncompressed_size;
+    if (reader->window_data[i] == NULL || MEM_allocN_len(reader->window_data[i]) < size) {
+      MEM_SAFE_FREE(reader->window_data[i]);
+      reader->window_data[i] = MEM_mallocN(size, __func__);
+    }
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (window_len > 1);
+  settings.min_iter_per_thread = 1;
+  reader->window_error = false;
+  BLI_task_parallel_range(0, window_len, reader, zstd_window_decompress_cb, &settings);
+
+  if (reader->window_error) {
+    return NULL;
+  }
+
+  reader->window_len = window_len;
+  return reader->window_data[0];
+}
+
+static int zstd_frame_find(const ZstdReader *reader, const size_t offset)
+{
+  /* Binary search for the frame containing the offset. */
+  int low = 0, high = reader->num_frames;
+  while (low < high) {
+    const int mid = (low + high) / 2;
+    const ZstdFrame *frame = &reader->frames[mid];
+    if (offset < frame->uncompressed_offset) {
+      high = mid;
+    }
+    else if (offset >= frame->uncompressed_offset + frame->uncompressed_size) {
+      low = mid + 1;
+    }
+    else {
+      return mid;
+    }
+  }
+  return -1;
+}
+
+static int fd_read_zstd_seekable(FileData *filedata, void *buffer, uint size)
+{
+  ZstdReader *reader = filedata->zstd_reader;
+  uint readsize = 0;
+
+  while (readsize < size) {
+    const int frame_index = zstd_frame_find(reader, (size_t)filedata->file_offset);
+    if (frame_index == -1) {
+      /* End of file. */
+      break;
+    }
+    const char *data = zstd_frame_ensure(reader, frame_index);
+    if (data == NULL) {
+      return EOF;
+    }
+    const ZstdFrame *frame = &reader->frames[frame_index];
+    const size_t frame_offset = (size_t)filedata->file_offset - frame->uncompressed_offset;
+    const uint len = (uint)MIN2(size - readsize, frame->uncompressed_size - frame_offset);
+
+    memcpy((char *)buffer + readsize, data + frame_offset, len);
+    readsize += len;
+    filedata->file_offset += len;
+  }
+
+  return (int)readsize;
+}
+
+static off64_t fd_seek_zstd_seekable(FileData *filedata, off64_t offset, int whence)
+{
+  ZstdReader *reader = filedata->zstd_reader;
+  const ZstdFrame *last_frame = &reader->frames[reader->num_frames - 1];
+  const off64_t size = (off64_t)(last_frame->uncompressed_offset + last_frame->uncompressed_size);
+
+  off64_t new_offset;
+  switch (whence) {
+    case SEEK_CUR:
+      new_offset = filedata->file_offset + offset;
+      break;
+    case SEEK_END:
+      new_offset = size + offset;
+      break;
+    default:
+      new_offset = offset;
+      break;
+  }
+
+  if (new_offset < 0 || new_offset > size) {
+    return -1;
+  }
+  filedata->file_offset = new_offset;
+  return new_offset;
+}
+
+static int fd_read_zstd_stream(FileData *filedata, void *buffer, uint size)
+{
+  ZstdReader *reader = filedata->zstd_reader;
+  ZSTD_outBuffer output = {buffer, size, 0};
+
+  while (output.pos < output.size) {
+    if (reader->in.pos == reader->in.size) {
+      const int len = read(reader->file, reader->in_buf, reader->in_buf_size);
+      if (len < 0) {
+        return EOF;
+      }
+      if (len == 0) {
+        /* End of file. */
+        break;
+      }
+      reader->in.size = (size_t)len;
+      reader->in.pos = 0;
+    }
+
+    const size_t ret = ZSTD_decompressStream(reader->dctx, &output, &reader->in);
+    if (ZSTD_isError(ret)) {
+      return EOF;
+    }
+  }
+
+  filedata->file_offset += output.pos;
+  return (int)output.pos;
+}
+
+#endif /* WITH_ZSTD */
+
+/* Memory-mapped file reading.
+ * Only the pages that are actually accessed are loaded, so indexing the BHeads of a large file
+ * and reading the few blocks needed (e.g. when linking from a library) is cheap. */
+
+static int fd_read_from_mmap(FileData *filedata, void *buffer, uint size)
+{
+  /* Don't read more bytes than there are available in the file. */
+  const size_t length = BLI_mmap_get_length(filedata->mmap_file);
+  const size_t readsize = MIN2((size_t)size, length - (size_t)filedata->file_offset);
+
+  if (!BLI_mmap_read(filedata->mmap_file, buffer, (size_t)filedata->file_offset, readsize)) {
+    return 0;
+  }
+
+  filedata->file_offset += readsize;
+
+  return (int)readsize;
+}
+
+static off64_t fd_seek_from_mmap(FileData *filedata, off64_t offset, int whence)
+{
+  const off64_t length = (off64_t)BLI_mmap_get_length(filedata->mmap_file);
+  off64_t new_pos;
+
+  if (whence == SEEK_CUR) {
+    new_pos = filedata->file_offset + offset;
+  }
+  else if (whence == SEEK_SET) {
+    new_pos = offset;
+  }
+  else if (whence == SEEK_END) {
+    new_pos = length + offset;
+  }
+  else {
+    return -1;
+  }
+
+  if (new_pos < 0 || new_pos > length) {
+    return -1;
+  }
+
+  filedata->file_offset = new_pos;
+  return filedata->file_offset;
+}
+
 /* Memory reading. */
 
 static int fd_read_from_memory(FileData *filedata, void *buffer, uint size)
@@ -1301,6 +1676,7 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
   FileDataSeekFn *seek_fn = NULL; /* Optional. */
 
   gzFile gzfile = (gzFile)Z_NULL;
+  BLI_mmap_file *mmap_file = NULL;
 
   char header[7];
 
@@ -1320,10 +1696,37 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
 
   /* Regular file. */
   if (memcmp(header, "BLENDER", sizeof(header)) == 0) {
-    read_fn = fd_read_data_from_file;
-    seek_fn = fd_seek_data_from_file;
+    /* Prefer memory-mapping, this avoids a system call for every BHead read and seek. */
+    mmap_file = BLI_mmap_open(file);
+    if (mmap_file != NULL) {
+      read_fn = fd_read_from_mmap;
+      seek_fn = fd_seek_from_mmap;
+      /* The mapping doesn't need the file to stay open, caller must close. */
+      file = -1;
+    }
+    else {
+      read_fn = fd_read_data_from_file;
+      seek_fn = fd_seek_data_from_file;
+    }
   }
 
+#ifdef WITH_ZSTD
+  /* Zstd file. */
+  ZstdReader *zstd_reader = NULL;
+  if ((read_fn == NULL) &&
+      /* Check header magic. */
+      (memcmp(header, "\x28\xb5\x2f\xfd", 4) == 0)) {
+    zstd_reader = zstd_reader_new(file);
+    if (zstd_reader->frames != NULL) {
+      read_fn = fd_read_zstd_seekable;
+      seek_fn = fd_seek_zstd_seekable;
+    }
+    else {
+      read_fn = fd_read_zstd_stream;
+    }
+  }
+#endif
+
   /* Gzip file. */
   errno = 0;
   if ((read_fn == NULL) &&
@@ -1355,6 +1758,10 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
 
   fd->filedes = file;
   fd->gzfiledes = gzfile;
+  fd->mmap_file = mmap_file;
+#ifdef WITH_ZSTD
+  fd->zstd_reader = zstd_reader;
+#endif
 
   fd->read = read_fn;
   fd->seek = seek_fn;
@@ -1500,6 +1907,8 @@ FileData *blo_filedata_from_memfile(MemFile *memfile, ReportList *reports)
   }
 }
 
+static void undo_reuse_free(struct UndoReuse *reuse);
+
 void blo_filedata_free(FileData *fd)
 {
   if (fd) {
@@ -1511,6 +1920,16 @@ void blo_filedata_free(FileData *fd)
       gzclose(fd->gzfiledes);
     }
 
+    if (fd->mmap_file != NULL) {
+      BLI_mmap_free(fd->mmap_file);
+    }
+
+#ifdef WITH_ZSTD
+    if (fd->zstd_reader != NULL) {
+      zstd_reader_free(fd->zstd_reader);
+    }
+#endif
+
     if (fd->strm.next_in) {
       if (inflateEnd(&fd->strm) != Z_OK) {
         printf("close gzip stream error\n");
@@ -1560,6 +1979,9 @@ void blo_filedata_free(FileData *fd)
     if (fd->soundmap) {
       oldnewmap_free(fd->soundmap);
     }
+    if (fd->undo_reuse) {
+      undo_reuse_free(fd->undo_reuse);
+    }
     if (fd->packedmap) {
       oldnewmap_free(fd->packedmap);
     }
@@ -2181,6 +2603,289 @@ void blo_add_library_pointer_map(ListBase *old_mainlist, FileData *fd)
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Undo Data-Block Reuse
+ *
+ * When reading a memfile for undo, data-blocks stored in chunks identical to the ones of the
+ * memfile matching the current state (the reference) already exist in memory as they would be
+ * read. They are moved from the old main instead of being read and linked again, only their
+ * pointers to other data-blocks need to be updated since those may have been re-allocated.
+ *
+ * This makes undo cost depend on the amount of changed data instead of the whole file.
+ * \{ */
+
+typedef struct UndoReuse {
+  /** Addresses (in the memfile read) of data-blocks with chunks identical in the reference. */
+  GSet *addresses_identical;
+  /** Local data-blocks of the old main. */
+  GSet *ids_old;
+  /**
+   * Map between the addresses stored in the reference memfile and the data-blocks in memory,
+   * both are NULL when they match (the reference was written from memory, not read).
+   */
+  GHash *reference_id_map;
+  GHash *reference_address_map;
+  MemFile *memfile_reference;
+  /** Maps addresses in the memfile being read to the data-blocks read or reused. */
+  GHash *id_address_map;
+  /** Reused data-blocks, their pointers to other data-blocks are remapped after linking. */
+  ID **ids_reused;
+  int ids_reused_len;
+  int ids_reused_alloc;
+} UndoReuse;
+
+/**
+ * Data-block types that can be reused. Others either hold pointers into data of other
+ * data-blocks, or runtime data handled by the pointer maps above (images, sounds, scenes...).
+ */
+static bool undo_reuse_idcode_is_supported(const short idcode)
+{
+  return ELEM(idcode,
+              ID_ME,
+              ID_CU,
+              ID_MB,
+              ID_LT,
+              ID_KE,
+              ID_CA,
+              ID_LA,
+              ID_SPK,
+              ID_LP,
+              ID_TXT,
+              ID_AC,
+              ID_AR);
+}
+
+static bool undo_reuse_chunk_is_id_start(const MemFileChunk *chunk)
+{
+  const MemFileChunk *chunk_prev = chunk->prev;
+  return (chunk->id_address != NULL) &&
+         ((chunk_prev == NULL) || (chunk_prev->id_address != chunk->id_address));
+}
+
+/**
+ * Compare the chunks of every data-block, since chunk buffers are shared by content,
+ * identical chunks use the same buffer.
+ */
+static GSet *undo_reuse_addresses_identical_ensure(MemFile *memfile, MemFile *memfile_reference)
+{
+  GHash *reference_chunks = BLI_ghash_ptr_new(__func__);
+  LISTBASE_FOREACH (MemFileChunk *, chunk, &memfile_reference->chunks) {
+    if (undo_reuse_chunk_is_id_start(chunk)) {
+      BLI_ghash_insert(reference_chunks, (void *)chunk->id_address, chunk);
+    }
+  }
+
+  GSet *addresses_identical = BLI_gset_ptr_new(__func__);
+  LISTBASE_FOREACH (MemFileChunk *, chunk, &memfile->chunks) {
+    if (!undo_reuse_chunk_is_id_start(chunk)) {
+      continue;
+    }
+    const void *id_address = chunk->id_address;
+    const MemFileChunk *chunk_ref = BLI_ghash_lookup(reference_chunks, id_address);
+    const MemFileChunk *chunk_iter = chunk;
+    while (chunk_ref && chunk_iter && (chunk_ref->id_address == id_address) &&
+           (chunk_iter->id_address == id_address) && (chunk_ref->buffer == chunk_iter->buffer)) {
+      chunk_ref = chunk_ref->next;
+      chunk_iter = chunk_iter->next;
+    }
+    /* Both runs of chunks must have ended at the same time. */
+    const bool is_ref_end = (chunk_ref == NULL) || (chunk_ref->id_address != id_address);
+    const bool is_iter_end = (chunk_iter == NULL) || (chunk_iter->id_address != id_address);
+    if (is_ref_end && is_iter_end && (chunk_iter != chunk)) {
+      BLI_gset_add(addresses_identical, (void *)id_address);
+    }
+  }
+
+  BLI_ghash_free(reference_chunks, NULL, NULL);
+  return addresses_identical;
+}
+
+/**
+ * \param memfile_reference: The memfile \a oldmain matches (optional),
+ * when NULL nothing is reused but the addresses of the read data-blocks are still stored,
+ * so the memfile being read can be used as reference for the next undo step.
+ */
+void blo_make_undo_reuse_map(FileData *fd, Main *oldmain, MemFile *memfile_reference)
+{
+  UndoReuse *reuse = MEM_callocN(sizeof(*reuse), __func__);
+  reuse->id_address_map = BLI_ghash_ptr_new(__func__);
+  fd->undo_reuse = reuse;
+
+  if (memfile_reference == NULL) {
+    return;
+  }
+
+  reuse->memfile_reference = memfile_reference;
+  reuse->addresses_identical = undo_reuse_addresses_identical_ensure(fd->memfile,
+                                                                     memfile_reference);
+
+  reuse->ids_old = BLI_gset_ptr_new(__func__);
+  ListBase *lbarray[MAX_LIBARRAY];
+  int i = set_listbasepointers(oldmain, lbarray);
+  while (i--) {
+    LISTBASE_FOREACH (ID *, id, lbarray[i]) {
+      BLI_gset_add(reuse->ids_old, id);
+    }
+  }
+
+  if (memfile_reference->id_address_map != NULL) {
+    reuse->reference_id_map = memfile_reference->id_address_map;
+    reuse->reference_address_map = BLI_ghash_ptr_new_ex(
+        __func__, BLI_ghash_len(reuse->reference_id_map));
+    GHashIterator gh_iter;
+    GHASH_ITER (gh_iter, reuse->reference_id_map) {
+      BLI_ghash_insert(reuse->reference_address_map,
+                       BLI_ghashIterator_getValue(&gh_iter),
+                       BLI_ghashIterator_getKey(&gh_iter));
+    }
+  }
+}
+
+/**
+ * Store the addresses of the data-blocks read in the memfile,
+ * the data-blocks in memory now match it instead of the reference.
+ */
+void blo_end_undo_reuse_map(FileData *fd)
+{
+  UndoReuse *reuse = fd->undo_reuse;
+  MemFile *memfile_reference = reuse->memfile_reference;
+
+  if (memfile_reference && memfile_reference->id_address_map) {
+    BLI_ghash_free(memfile_reference->id_address_map, NULL, NULL);
+    memfile_reference->id_address_map = NULL;
+  }
+  if (fd->memfile->id_address_map) {
+    BLI_ghash_free(fd->memfile->id_address_map, NULL, NULL);
+  }
+  fd->memfile->id_address_map = reuse->id_address_map;
+  reuse->id_address_map = NULL;
+  reuse->reference_id_map = NULL;
+}
+
+static void undo_reuse_free(UndoReuse *reuse)
+{
+  if (reuse->addresses_identical) {
+    BLI_gset_free(reuse->addresses_identical, NULL);
+  }
+  if (reuse->ids_old) {
+    BLI_gset_free(reuse->ids_old, NULL);
+  }
+  if (reuse->reference_address_map) {
+    BLI_ghash_free(reuse->reference_address_map, NULL, NULL);
+  }
+  if (reuse->id_address_map) {
+    BLI_ghash_free(reuse->id_address_map, NULL, NULL);
+  }
+  MEM_SAFE_FREE(reuse->ids_reused);
+  MEM_freeN(reuse);
+}
+
+static void undo_reuse_id_address_add(FileData *fd, const void *address, ID *id)
+{
+  if (fd->undo_reuse && (id->lib == NULL)) {
+    BLI_ghash_reinsert(fd->undo_reuse->id_address_map, (void *)address, id, NULL, NULL);
+  }
+}
+
+/** Return the data-block of the old main that can be used for \a bhead, if any. */
+static ID *undo_reuse_id_find(FileData *fd, BHead *bhead)
+{
+  UndoReuse *reuse = fd->undo_reuse;
+  if ((reuse == NULL) || (reuse->addresses_identical == NULL) ||
+      !undo_reuse_idcode_is_supported((short)bhead->code) ||
+      !BLI_gset_haskey(reuse->addresses_identical, bhead->old)) {
+    return NULL;
+  }
+
+  ID *id_old = (reuse->reference_id_map != NULL) ?
+                   BLI_ghash_lookup(reuse->reference_id_map, bhead->old) :
+                   (ID *)bhead->old;
+  /* Check membership before accessing it, the address may not be a data-block anymore. */
+  if ((id_old == NULL) || !BLI_gset_haskey(reuse->ids_old, id_old)) {
+    return NULL;
+  }
+  if (!STREQ(id_old->name, blo_bhead_id_name(fd, bhead))) {
+    return NULL;
+  }
+  return id_old;
+}
+
+/** Move \a id_old from the old main to \a main, in place of reading it from \a bhead. */
+static BHead *undo_reuse_id_read(FileData *fd, Main *main, BHead *bhead, const int tag, ID *id_old)
+{
+  UndoReuse *reuse = fd->undo_reuse;
+  Main *old_main = fd->old_mainlist->first;
+  const short idcode = GS(id_old->name);
+
+  BLI_gset_remove(reuse->ids_old, id_old, NULL);
+  BLI_remlink(which_libbase(old_main, idcode), id_old);
+  BLI_addtail(which_libbase(main, idcode), id_old);
+
+  oldnewmap_insert(fd->libmap, bhead->old, id_old, bhead->code);
+  undo_reuse_id_address_add(fd, bhead->old, id_old);
+
+  /* Same state as a data-block being read, but it doesn't need to be linked. */
+  id_old->tag = tag | LIB_TAG_NEW;
+  id_old->us = ID_FAKE_USERS(id_old);
+  id_old->newid = NULL;
+  id_old->orig_id = NULL;
+
+  if (reuse->ids_reused_len == reuse->ids_reused_alloc) {
+    reuse->ids_reused_alloc = max_ii(64, reuse->ids_reused_alloc * 2);
+    reuse->ids_reused = MEM_reallocN(reuse->ids_reused,
+                                     sizeof(*reuse->ids_reused) * (size_t)reuse->ids_reused_alloc);
+  }
+  reuse->ids_reused[reuse->ids_reused_len++] = id_old;
+
+  /* Skip the data of the data-block. */
+  bhead = blo_bhead_next(fd, bhead);
+  while (bhead && bhead->code == DATA) {
+    bhead = blo_bhead_next(fd, bhead);
+  }
+  return bhead;
+}
+
+static int undo_reuse_id_remap_cb(LibraryIDLinkCallbackData *cb_data)
+{
+  ID **id_pointer = cb_data->id_pointer;
+  /* Embedded data-blocks (node trees...) are part of the reused data-block. */
+  if ((*id_pointer != NULL) && (cb_data->cb_flag & IDWALK_CB_PRIVATE) == 0) {
+    FileData *fd = cb_data->user_data;
+    UndoReuse *reuse = fd->undo_reuse;
+    /* Pointers of reused data-blocks are in-memory addresses, get back to the stored ones. */
+    const void *address = (reuse->reference_address_map != NULL) ?
+                              BLI_ghash_lookup_default(
+                                  reuse->reference_address_map, *id_pointer, *id_pointer) :
+                              *id_pointer;
+    *id_pointer = newlibadr(fd, NULL, address);
+  }
+  return IDWALK_RET_NOP;
+}
+
+static void undo_reuse_id_remap_fn(void *__restrict userdata,
+                                   const int iter,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  FileData *fd = userdata;
+  ID *id = fd->undo_reuse->ids_reused[iter];
+  BKE_library_foreach_ID_link(NULL, id, undo_reuse_id_remap_cb, fd, IDWALK_NOP);
+}
+
+/**
+ * Update the pointers of reused data-blocks to the data-blocks read.
+ * Each only modifies its own pointers and look-ups don't modify the maps, so run in parallel.
+ */
+static void undo_reuse_ids_remap(FileData *fd)
+{
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 16;
+  BLI_task_parallel_range(
+      0, fd->undo_reuse->ids_reused_len, fd, undo_reuse_id_remap_fn, &settings);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name DNA Struct Loading
  * \{ */
@@ -3493,6 +4198,7 @@ static void direct_link_nodetree(FileData *fd, bNodeTree *ntree)
   link_list(fd, &ntree->nodes);
   for (node = ntree->nodes.first; node; node = node->next) {
     node->typeinfo = NULL;
+    node->execution_stats = NULL;
 
     link_list(fd, &node->inputs);
     link_list(fd, &node->outputs);
@@ -8995,6 +9701,17 @@ static BHead *read_libblock(FileData *fd,
     }
   }
 
+  /* In undo case, unchanged data-blocks are kept as is from previous state. */
+  if (fd->undo_reuse && (main->curlib == NULL)) {
+    ID *id_old = undo_reuse_id_find(fd, bhead);
+    if (id_old != NULL) {
+      if (r_id) {
+        *r_id = id_old;
+      }
+      return undo_reuse_id_read(fd, main, bhead, tag, id_old);
+    }
+  }
+
   /* read libblock */
   id = read_struct(fd, bhead, "lib block");
 
@@ -9029,6 +9746,8 @@ static BHead *read_libblock(FileData *fd,
   id->newid = NULL; /* Needed because .blend may have been saved with crap value here... */
   id->orig_id = NULL;
 
+  undo_reuse_id_address_add(fd, bhead->old, id);
+
   /* this case cannot be direct_linked: it's just the ID part */
   if (bhead->code == ID_LINK_PLACEHOLDER) {
     /* That way, we know which data-lock needs do_versions (required currently for linking). */
@@ -9738,6 +10457,10 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 
     lib_link_all(fd, bfd->main);
 
+    if (fd->undo_reuse) {
+      undo_reuse_ids_remap(fd);
+    }
+
     /* Skip in undo case. */
     if (fd->memfile == NULL) {
       /* Yep, second splitting... but this is a very cheap operation, so no big deal. */
@@ -76,11 +76,15 @@ typedef struct FileData {
 
   /** Variables needed for reading from memory / stream. */
   const char *buffer;
+  /** Variables needed for reading from memory-mapped file. */
+  struct BLI_mmap_file *mmap_file;
   /** Variables needed for reading from memfile (undo). */
   struct MemFile *memfile;
 
   /** Variables needed for reading from file. */
   gzFile gzfiledes;
+  /** Variables needed for reading from zstd compressed file, see: #ZstdReader. */
+  struct ZstdReader *zstd_reader;
   /** Gzip stream for memory decompression. */
   z_stream strm;
 
@@ -120,6 +124,8 @@ typedef struct FileData {
   ListBase *mainlist;
   /** Used for undo. */
   ListBase *old_mainlist;
+  /** Used for undo, see: #blo_make_undo_reuse_map. */
+  struct UndoReuse *undo_reuse;
 
   struct ReportList *reports;
 } FileData;
@@ -149,6 +155,10 @@ void blo_end_sound_pointer_map(FileData *fd, struct Main *oldmain);
 void blo_make_packed_pointer_map(FileData *fd, struct Main *oldmain);
 void blo_end_packed_pointer_map(FileData *fd, struct Main *oldmain);
 void blo_add_library_pointer_map(ListBase *old_mainlist, FileData *fd);
+void blo_make_undo_reuse_map(FileData *fd,
+                             struct Main *oldmain,
+                             struct MemFile *memfile_reference);
+void blo_end_undo_reuse_map(FileData *fd);
 
 void blo_filedata_free(FileData *fd);
 
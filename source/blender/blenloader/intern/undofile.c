@@ -41,15 +41,132 @@
 #include "DNA_listBase.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
 
 #include "BLO_undofile.h"
-#include "BLO_readfile.h"
-
-#include "BKE_main.h"
 
 /* keep last */
 #include "BLI_strict_flags.h"
 
+/* -------------------------------------------------------------------- */
+/** \name Chunk Storage
+ *
+ * Chunk buffers are shared between all memfiles (so between all global undo steps)
+ * and de-duplicated by their content. A chunk reuses the buffer of any identical chunk,
+ * not only the one at the same position in the previous memfile, so inserting, removing
+ * or re-ordering data-blocks doesn't duplicate all the data written after them.
+ *
+ * \note Only accessed when writing and freeing undo steps, which happens in the main thread.
+ * \{ */
+
+typedef struct MemFileChunkBuffer {
+  const char *buf;
+  uint size;
+  uint hash;
+  /** Number of #MemFileChunk using this buffer. */
+  uint users;
+} MemFileChunkBuffer;
+
+static struct {
+  /** Set of #MemFileChunkBuffer, freed when the last chunk is. */
+  GSet *buffers;
+  MemFileChunkStats stats;
+} g_chunk_store = {NULL};
+
+static uint chunk_buffer_hash(const void *key)
+{
+  return ((const MemFileChunkBuffer *)key)->hash;
+}
+
+static bool chunk_buffer_cmp(const void *a, const void *b)
+{
+  const MemFileChunkBuffer *buffer_a = a;
+  const MemFileChunkBuffer *buffer_b = b;
+  if (buffer_a == buffer_b) {
+    return false;
+  }
+  return !((buffer_a->hash == buffer_b->hash) && (buffer_a->size == buffer_b->size) &&
+           (memcmp(buffer_a->buf, buffer_b->buf, buffer_a->size) == 0));
+}
+
+static void chunk_buffer_user_add(MemFileChunkBuffer *buffer)
+{
+  buffer->users++;
+  g_chunk_store.stats.num_chunks++;
+  g_chunk_store.stats.size_chunks += buffer->size;
+}
+
+/**
+ * Return the stored buffer with the same content as \a buf, adding it when there is none.
+ * \param r_is_new: Set when the buffer has been added (so uses new memory).
+ */
+static MemFileChunkBuffer *chunk_buffer_ensure(const char *buf, uint size, bool *r_is_new)
+{
+  if (g_chunk_store.buffers == NULL) {
+    g_chunk_store.buffers = BLI_gset_new(chunk_buffer_hash, chunk_buffer_cmp, __func__);
+  }
+
+  MemFileChunkBuffer buffer_key = {
+      .buf = buf,
+      .size = size,
+      .hash = BLI_hash_mm2((const uchar *)buf, size, 0),
+  };
+
+  MemFileChunkBuffer *buffer = BLI_gset_lookup(g_chunk_store.buffers, &buffer_key);
+  *r_is_new = (buffer == NULL);
+  if (buffer == NULL) {
+    char *buf_new = MEM_mallocN(size, "Chunk buffer");
+    memcpy(buf_new, buf, size);
+
+    buffer = MEM_mallocN(sizeof(*buffer), __func__);
+    *buffer = buffer_key;
+    buffer->buf = buf_new;
+    buffer->users = 0;
+    BLI_gset_insert(g_chunk_store.buffers, buffer);
+
+    g_chunk_store.stats.num_buffers++;
+    g_chunk_store.stats.size_buffers += size;
+  }
+
+  chunk_buffer_user_add(buffer);
+  return buffer;
+}
+
+static void chunk_buffer_user_remove(MemFileChunkBuffer *buffer)
+{
+  BLI_assert(buffer->users > 0);
+  g_chunk_store.stats.num_chunks--;
+  g_chunk_store.stats.size_chunks -= buffer->size;
+
+  buffer->users--;
+  if (buffer->users != 0) {
+    return;
+  }
+
+  BLI_gset_remove(g_chunk_store.buffers, buffer, NULL);
+  g_chunk_store.stats.num_buffers--;
+  g_chunk_store.stats.size_buffers -= buffer->size;
+  MEM_freeN((void *)buffer->buf);
+  MEM_freeN(buffer);
+
+  if (BLI_gset_len(g_chunk_store.buffers) == 0) {
+    BLI_gset_free(g_chunk_store.buffers, NULL);
+    g_chunk_store.buffers = NULL;
+  }
+}
+
+/**
+ * Statistics of the storage shared by all memfiles,
+ * the difference between the chunk and buffer sizes is the memory saved by sharing.
+ */
+void BLO_memfile_chunk_stats_get(MemFileChunkStats *r_stats)
+{
+  *r_stats = g_chunk_store.stats;
+}
+
+/** \} */
+
 /* **************** support for memory-write, for undo buffers *************** */
 
 /* not memfile itself */
@@ -58,87 +175,64 @@ void BLO_memfile_free(MemFile *memfile)
   MemFileChunk *chunk;
 
   while ((chunk = BLI_pophead(&memfile->chunks))) {
-    if (chunk->is_identical == false) {
-      MEM_freeN((void *)chunk->buf);
-    }
+    chunk_buffer_user_remove(chunk->buffer);
     MEM_freeN(chunk);
   }
   memfile->size = 0;
+
+  if (memfile->id_address_map != NULL) {
+    BLI_ghash_free(memfile->id_address_map, NULL, NULL);
+    memfile->id_address_map = NULL;
+  }
 }
 
 /* to keep list of memfiles consistent, 'first' is always first in list */
 /* result is that 'first' is being freed */
-void BLO_memfile_merge(MemFile *first, MemFile *second)
+void BLO_memfile_merge(MemFile *first, MemFile *UNUSED(second))
 {
-  MemFileChunk *fc, *sc;
-
-  fc = first->chunks.first;
-  sc = second->chunks.first;
-  while (fc || sc) {
-    if (fc && sc) {
-      if (sc->is_identical) {
-        sc->is_identical = false;
-        fc->is_identical = true;
-      }
-    }
-    if (fc) {
-      fc = fc->next;
-    }
-    if (sc) {
-      sc = sc->next;
-    }
-  }
-
+  /* Chunk buffers are reference counted, chunks of 'second' sharing memory with 'first'
+   * keep it alive, so there is no ownership to transfer. */
   BLO_memfile_free(first);
 }
 
-void memfile_chunk_add(MemFile *memfile, const char *buf, uint size, MemFileChunk **compchunk_step)
+void memfile_chunk_add(MemFile *memfile,
+                       const char *buf,
+                       uint size,
+                       MemFileChunk **compchunk_step,
+                       const void *id_address)
 {
   MemFileChunk *curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
   curchunk->size = size;
   curchunk->buf = NULL;
+  curchunk->buffer = NULL;
   curchunk->is_identical = false;
+  curchunk->id_address = id_address;
   BLI_addtail(&memfile->chunks, curchunk);
 
-  /* we compare compchunk with buf */
+  /* we compare compchunk with buf, which avoids hashing in the common case of unchanged data */
   if (*compchunk_step != NULL) {
     MemFileChunk *compchunk = *compchunk_step;
     if (compchunk->size == curchunk->size) {
       if (memcmp(compchunk->buf, buf, size) == 0) {
-        curchunk->buf = compchunk->buf;
+        curchunk->buffer = compchunk->buffer;
         curchunk->is_identical = true;
+        chunk_buffer_user_add(curchunk->buffer);
       }
     }
     *compchunk_step = compchunk->next;
   }
 
-  /* not equal... */
-  if (curchunk->buf == NULL) {
-    char *buf_new = MEM_mallocN(size, "Chunk buffer");
-    memcpy(buf_new, buf, size);
-    curchunk->buf = buf_new;
-    memfile->size += size;
+  /* not equal, look for identical data anywhere in the storage. */
+  if (curchunk->buffer == NULL) {
+    bool is_new;
+    curchunk->buffer = chunk_buffer_ensure(buf, size, &is_new);
+    curchunk->is_identical = !is_new;
   }
-}
 
-struct Main *BLO_memfile_main_get(struct MemFile *memfile,
-                                  struct Main *oldmain,
-                                  struct Scene **r_scene)
-{
-  struct Main *bmain_undo = NULL;
-  BlendFileData *bfd = BLO_read_from_memfile(
-      oldmain, BKE_main_blendfile_path(oldmain), memfile, BLO_READ_SKIP_NONE, NULL);
-
-  if (bfd) {
-    bmain_undo = bfd->main;
-    if (r_scene) {
-      *r_scene = bfd->curscene;
-    }
-
-    MEM_freeN(bfd);
+  curchunk->buf = curchunk->buffer->buf;
+  if (!curchunk->is_identical) {
+    memfile->size += size;
   }
-
-  return bmain_undo;
 }
 
 /**
@@ -88,6 +88,10 @@
 #  include <unistd.h> /* FreeBSD, for write() and close(). */
 #endif
 
+#ifdef WITH_ZSTD
+#  include <zstd.h>
+#endif
+
 #include "BLI_utildefines.h"
 
 /* allow writefile to use deprecated functionality (for forward compatibility code) */
@@ -145,6 +149,8 @@
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_action.h"
 #include "BKE_blender_version.h"
@@ -200,6 +206,7 @@
 typedef enum {
   WW_WRAP_NONE = 1,
   WW_WRAP_ZLIB,
+  WW_WRAP_ZSTD,
 } eWriteWrapType;
 
 typedef struct WriteWrap WriteWrap;
@@ -216,6 +223,7 @@ struct WriteWrap {
   union {
     int file_handle;
     gzFile gz_handle;
+    struct ZstdWriteWrap *zstd_handle;
   } _user_data;
 };
 
@@ -273,6 +281,263 @@ static size_t ww_write_zlib(WriteWrap *ww, const char *buf, size_t buf_len)
 }
 #undef FILE_HANDLE
 
+/* zstd */
+#ifdef WITH_ZSTD
+
+/**
+ * The file is written as a sequence of independent zstd frames, each holding
+ * #ZSTD_FRAME_SIZE bytes of uncompressed data, followed by a seek table in the
+ * "Zstandard Seekable Format" (a skippable frame, so any zstd decoder can still
+ * read the file as a regular stream).
+ *
+ * Frames are compressed in parallel by the task scheduler, the writing thread
+ * then writes them to the file in order. The seek table lets the reader decompress
+ * frames in parallel too, and jump to any offset without decompressing the whole
+ * file, see readfile.c.
+ */
+#  define ZSTD_FRAME_SIZE (1 << 20)   /* 1mb */
+#  define ZSTD_COMPRESSION_LEVEL 3
+#  define ZSTD_SEEKABLE_SKIPPABLE_MAGIC 0x184D2A5E
+#  define ZSTD_SEEKABLE_FOOTER_MAGIC 0x8F92EAB1
+
+typedef struct ZstdWriteWrap {
+  int file_handle;
+
+  TaskPool *task_pool;
+  /* Maximum number of frames being compressed at once, limits memory usage. */
+  int max_frames_in_flight;
+
+  /* Frame which is being filled by ww_write_zstd(). */
+  char *frame_buf;
+  size_t frame_buf_used;
+
+  /* Number of frames passed to the task pool. */
+  int num_frames;
+
+  /* Frames passed to the task pool which are not written yet, in file order. */
+  ListBase frames;
+  int num_frames_in_flight;
+  /* Protects the result of the compression tasks. */
+  ThreadMutex mutex;
+
+  /* Compressed and uncompressed size of every written frame, for the seek table. */
+  uint32_t *seek_table;
+  int seek_table_alloc;
+  bool error;
+} ZstdWriteWrap;
+
+typedef struct ZstdWriteFrame {
+  struct ZstdWriteFrame *next, *prev;
+  int index;
+  char *data;
+  size_t size;
+
+  /* Result of the compression task, protected by the mutex. */
+  void *compressed;
+  size_t compressed_size;
+  bool done;
+} ZstdWriteFrame;
+
+#  define FILE_HANDLE(ww) (ww)->_user_data.zstd_handle
+
+static void ww_zstd_frame_compress_task(TaskPool *__restrict pool,
+                                        void *taskdata,
+                                        int UNUSED(thread_id))
+{
+  ZstdWriteWrap *zstd = BLI_task_pool_userdata(pool);
+  ZstdWriteFrame *frame = taskdata;
+
+  const size_t compressed_bound = ZSTD_compressBound(frame->size);
+  void *compressed = MEM_mallocN(compressed_bound, __func__);
+  const size_t compressed_size = ZSTD_compress(
+      compressed, compressed_bound, frame->data, frame->size, ZSTD_COMPRESSION_LEVEL);
+
+  MEM_freeN(frame->data);
+  frame->data = NULL;
+
+  BLI_mutex_lock(&zstd->mutex);
+  frame->compressed = compressed;
+  frame->compressed_size = compressed_size;
+  frame->done = true;
+  BLI_mutex_unlock(&zstd->mutex);
+}
+
+static void ww_zstd_frame_write(ZstdWriteWrap *zstd, ZstdWriteFrame *frame)
+{
+  if (ZSTD_isError(frame->compressed_size)) {
+    zstd->error = true;
+  }
+  else if (!zstd->error) {
+    if (write(zstd->file_handle, frame->compressed, frame->compressed_size) !=
+        frame->compressed_size) {
+      zstd->error = true;
+    }
+    else {
+      if (zstd->seek_table_alloc <= frame->index) {
+        zstd->seek_table_alloc = MAX2(zstd->seek_table_alloc * 2, 64);
+        zstd->seek_table = MEM_reallocN(zstd->seek_table,
+                                        sizeof(uint32_t[2]) * (size_t)zstd->seek_table_alloc);
+      }
+      zstd->seek_table[frame->index * 2 + 0] = (uint32_t)frame->compressed_size;
+      zstd->seek_table[frame->index * 2 + 1] = (uint32_t)frame->size;
+    }
+  }
+}
+
+/* Write the compressed frames at the start of the queue, stopping at the first one which is
+ * still being compressed. */
+static void ww_zstd_frames_write_done(ZstdWriteWrap *zstd)
+{
+  ZstdWriteFrame *frame;
+  while ((frame = zstd->frames.first)) {
+    BLI_mutex_lock(&zstd->mutex);
+    const bool done = frame->done;
+    BLI_mutex_unlock(&zstd->mutex);
+
+    if (!done) {
+      break;
+    }
+
+    ww_zstd_frame_write(zstd, frame);
+
+    BLI_remlink(&zstd->frames, frame);
+    zstd->num_frames_in_flight--;
+    MEM_freeN(frame->compressed);
+    MEM_freeN(frame);
+  }
+}
+
+static void ww_zstd_frame_push(ZstdWriteWrap *zstd)
+{
+  if (zstd->frame_buf_used == 0) {
+    return;
+  }
+
+  ZstdWriteFrame *frame = MEM_callocN(sizeof(*frame), __func__);
+  frame->index = zstd->num_frames++;
+  frame->data = zstd->frame_buf;
+  frame->size = zstd->frame_buf_used;
+  BLI_addtail(&zstd->frames, frame);
+  zstd->num_frames_in_flight++;
+
+  /* The frames stay owned by the queue, they are freed once written. */
+  BLI_task_pool_push(
+      zstd->task_pool, ww_zstd_frame_compress_task, frame, false, TASK_PRIORITY_LOW);
+
+  zstd->frame_buf = MEM_mallocN(ZSTD_FRAME_SIZE, __func__);
+  zstd->frame_buf_used = 0;
+
+  ww_zstd_frames_write_done(zstd);
+
+  /* Don't let the writing get too far ahead of compression. Waiting on the pool compresses from
+   * the current thread as well, so this also works when there are no worker threads. */
+  if (zstd->num_frames_in_flight >= zstd->max_frames_in_flight) {
+    BLI_task_pool_work_and_wait(zstd->task_pool);
+    ww_zstd_frames_write_done(zstd);
+  }
+}
+
+static void ww_zstd_uint32_encode(uchar *r_buf, const uint32_t value)
+{
+  /* The seek table is little-endian, regardless of the platform. */
+  r_buf[0] = (uchar)(value & 0xff);
+  r_buf[1] = (uchar)((value >> 8) & 0xff);
+  r_buf[2] = (uchar)((value >> 16) & 0xff);
+  r_buf[3] = (uchar)((value >> 24) & 0xff);
+}
+
+static bool ww_zstd_write_seek_table(ZstdWriteWrap *zstd)
+{
+  const int num_frames = zstd->num_frames;
+  /* Frame table entries, then footer: number of frames, descriptor and magic. */
+  const size_t table_size = (size_t)num_frames * 8 + 9;
+  const size_t buf_size = table_size + 8;
+  uchar *buf = MEM_mallocN(buf_size, __func__);
+  uchar *p = buf;
+
+  ww_zstd_uint32_encode(p, ZSTD_SEEKABLE_SKIPPABLE_MAGIC);
+  ww_zstd_uint32_encode(p + 4, (uint32_t)table_size);
+  p += 8;
+  for (int i = 0; i < num_frames; i++) {
+    ww_zstd_uint32_encode(p, zstd->seek_table[i * 2 + 0]);
+    ww_zstd_uint32_encode(p + 4, zstd->seek_table[i * 2 + 1]);
+    p += 8;
+  }
+  ww_zstd_uint32_encode(p, (uint32_t)num_frames);
+  /* Descriptor: no checksums. */
+  p[4] = 0;
+  ww_zstd_uint32_encode(p + 5, ZSTD_SEEKABLE_FOOTER_MAGIC);
+
+  const bool ok = (write(zstd->file_handle, buf, buf_size) == buf_size);
+  MEM_freeN(buf);
+  return ok;
+}
+
+static bool ww_open_zstd(WriteWrap *ww, const char *filepath)
+{
+  int file = BLI_open(filepath, O_BINARY + O_WRONLY + O_CREAT + O_TRUNC, 0666);
+
+  if (file == -1) {
+    return false;
+  }
+
+  ZstdWriteWrap *zstd = MEM_callocN(sizeof(*zstd), __func__);
+  TaskScheduler *scheduler = BLI_task_scheduler_get();
+
+  zstd->file_handle = file;
+  zstd->task_pool = BLI_task_pool_create(scheduler, zstd);
+  zstd->max_frames_in_flight = 2 * BLI_task_scheduler_num_threads(scheduler);
+  zstd->frame_buf = MEM_mallocN(ZSTD_FRAME_SIZE, __func__);
+  BLI_mutex_init(&zstd->mutex);
+
+  FILE_HANDLE(ww) = zstd;
+  return true;
+}
+static bool ww_close_zstd(WriteWrap *ww)
+{
+  ZstdWriteWrap *zstd = FILE_HANDLE(ww);
+
+  ww_zstd_frame_push(zstd);
+  BLI_task_pool_work_and_wait(zstd->task_pool);
+  BLI_task_pool_free(zstd->task_pool);
+  ww_zstd_frames_write_done(zstd);
+  BLI_assert(BLI_listbase_is_empty(&zstd->frames));
+
+  bool ok = !zstd->error && ww_zstd_write_seek_table(zstd);
+  ok &= (close(zstd->file_handle) != -1);
+
+  BLI_mutex_end(&zstd->mutex);
+  MEM_SAFE_FREE(zstd->seek_table);
+  MEM_freeN(zstd->frame_buf);
+  MEM_freeN(zstd);
+
+  return ok;
+}
+static size_t ww_write_zstd(WriteWrap *ww, const char *buf, size_t buf_len)
+{
+  ZstdWriteWrap *zstd = FILE_HANDLE(ww);
+
+  if (zstd->error) {
+    return 0;
+  }
+
+  size_t written = 0;
+  while (written < buf_len) {
+    const size_t len = MIN2(buf_len - written, ZSTD_FRAME_SIZE - zstd->frame_buf_used);
+    memcpy(zstd->frame_buf + zstd->frame_buf_used, buf + written, len);
+    zstd->frame_buf_used += len;
+    written += len;
+    if (zstd->frame_buf_used == ZSTD_FRAME_SIZE) {
+      ww_zstd_frame_push(zstd);
+    }
+  }
+
+  return buf_len;
+}
+#  undef FILE_HANDLE
+
+#endif /* WITH_ZSTD */
+
 /* --- end compression types --- */
 
 static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
@@ -280,6 +545,15 @@ static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
   memset(r_ww, 0, sizeof(*r_ww));
 
   switch (ww_type) {
+#ifdef WITH_ZSTD
+    case WW_WRAP_ZSTD: {
+      r_ww->open = ww_open_zstd;
+      r_ww->close = ww_close_zstd;
+      r_ww->write = ww_write_zstd;
+      r_ww->use_buf = true;
+      break;
+    }
+#endif
     case WW_WRAP_ZLIB: {
       r_ww->open = ww_open_zlib;
       r_ww->close = ww_close_zlib;
@@ -325,6 +599,8 @@ typedef struct {
     MemFile *compare;
     /** Use to de-duplicate chunks when writing. */
     MemFileChunk *compare_chunk;
+    /** The data-block being written, see: #mywrite_id_begin. */
+    const ID *current_id;
   } mem;
   /** When true, write to #WriteData.current, could also call 'is_undo'. */
   bool use_memfile;
@@ -364,7 +640,8 @@ static void writedata_do_write(WriteData *wd, const void *mem, int memlen)
 
   /* memory based save */
   if (wd->use_memfile) {
-    memfile_chunk_add(wd->mem.current, mem, memlen, &wd->mem.compare_chunk);
+    memfile_chunk_add(
+        wd->mem.current, mem, memlen, &wd->mem.compare_chunk, wd->mem.current_id);
   }
   else {
     if (wd->ww->write(wd->ww, mem, memlen) != memlen) {
@@ -453,6 +730,26 @@ static void mywrite(WriteData *wd, const void *adr, int len)
   }
 }
 
+/**
+ * Start writing the data of \a id, when writing to a memfile its data is stored
+ * in its own chunks so it can be compared between undo steps (see: #BLO_read_from_memfile).
+ */
+static void mywrite_id_begin(WriteData *wd, const ID *id)
+{
+  if (wd->use_memfile) {
+    mywrite_flush(wd);
+    wd->mem.current_id = id;
+  }
+}
+
+static void mywrite_id_end(WriteData *wd, const ID *UNUSED(id))
+{
+  if (wd->use_memfile) {
+    mywrite_flush(wd);
+    wd->mem.current_id = NULL;
+  }
+}
+
 /**
  * BeGiN initializer for mywrite
  * \param ww: File write wrapper.
@@ -3811,6 +4108,8 @@ static bool write_file_handle(Main *mainvar,
           BKE_lib_override_library_operations_store_start(bmain, override_storage, id);
         }
 
+        mywrite_id_begin(wd, id);
+
         switch ((ID_Type)GS(id->name)) {
           case ID_WM:
             write_windowmanager(wd, (wmWindowManager *)id);
@@ -3927,6 +4226,8 @@ static bool write_file_handle(Main *mainvar,
             break;
         }
 
+        mywrite_id_end(wd, id);
+
         if (do_override) {
           BKE_lib_override_library_operations_store_end(override_storage, id);
         }
@@ -4042,7 +4343,11 @@ bool BLO_write_file(Main *mainvar,
   BLI_snprintf(tempname, sizeof(tempname), "%s@", filepath);
 
   if (write_flags & G_FILE_COMPRESS) {
+#ifdef WITH_ZSTD
+    ww_type = (write_flags & G_FILE_COMPRESS_ZSTD) ? WW_WRAP_ZSTD : WW_WRAP_ZLIB;
+#else
     ww_type = WW_WRAP_ZLIB;
+#endif
   }
   else {
     ww_type = WW_WRAP_NONE;
@@ -29,6 +29,7 @@ CompositorContext::CompositorContext()
   this->m_fastCalculation = false;
   this->m_viewSettings = NULL;
   this->m_displaySettings = NULL;
+  this->m_profiler = NULL;
 }
 
 int CompositorContext::getFramenumber() const
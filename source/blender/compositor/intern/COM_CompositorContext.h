@@ -27,6 +27,8 @@
 #include "DNA_scene_types.h"
 #include "COM_defines.h"
 
+class Profiler;
+
 /**
  * \brief Overall context of the compositor
  */
@@ -87,6 +89,12 @@ class CompositorContext {
    */
   const char *m_viewName;
 
+  /**
+   * \brief profiler of the current execution, NULL when not executing
+   * \see ExecutionSystem
+   */
+  Profiler *m_profiler;
+
  public:
   /**
    * \brief constructor initializes the context with default values.
@@ -268,6 +276,15 @@ class CompositorContext {
   {
     return (this->getbNodeTree()->flag & NTREE_COM_GROUPNODE_BUFFER) != 0;
   }
+
+  void setProfiler(Profiler *profiler)
+  {
+    this->m_profiler = profiler;
+  }
+  Profiler *getProfiler() const
+  {
+    return this->m_profiler;
+  }
 };
 
 #endif
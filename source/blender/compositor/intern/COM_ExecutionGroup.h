@@ -329,6 +329,14 @@ class ExecutionGroup {
    */
   NodeOperation *getOutputOperation() const;
 
+  /**
+   * \brief get the operations of this ExecutionGroup
+   */
+  const Operations &getOperations() const
+  {
+    return m_operations;
+  }
+
   /**
    * \brief compose multiple chunks into a single chunk
    * \return Memorybuffer *consolidated chunk
@@ -436,6 +444,14 @@ class ExecutionGroup {
 
   void setRenderBorder(float xmin, float xmax, float ymin, float ymax);
 
+  /**
+   * \brief get the area of the output operation to calculate, in pixel space
+   */
+  const rcti *getViewerBorder() const
+  {
+    return &this->m_viewerBorder;
+  }
+
   /* allow the DebugInfo class to look at internals */
   friend class DebugInfo;
 
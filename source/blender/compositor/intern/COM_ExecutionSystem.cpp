@@ -30,8 +30,11 @@ extern "C" {
 #include "COM_NodeOperationBuilder.h"
 #include "COM_NodeOperation.h"
 #include "COM_ExecutionGroup.h"
+#include "COM_FullFrameExecution.h"
+#include "COM_Profiler.h"
 #include "COM_WorkScheduler.h"
 #include "COM_ReadBufferOperation.h"
+#include "COM_ResultCache.h"
 #include "COM_Debug.h"
 
 #ifdef WITH_CXX_GUARDEDALLOC
@@ -135,6 +138,23 @@ void ExecutionSystem::execute()
 
   DebugInfo::execute_started(this);
 
+  Profiler profiler;
+  this->m_context.setProfiler(&profiler);
+
+  if (editingtree->execution_mode == NTREE_EXECUTION_MODE_FULL_FRAME) {
+    /* Operations are initialized one by one while they're calculated. */
+    FullFrameExecution execution(this->m_context, this->m_groups);
+    execution.execute();
+
+    profiler.finish(this->m_context, this->m_operations, this->m_groups);
+    this->m_context.setProfiler(NULL);
+    return;
+  }
+
+  /* Results are only cached by full frame execution, free the ones of this tree when switching
+   * to tiles. */
+  ResultCache::clear(ResultCache::originalTree(this->m_context));
+
   unsigned int order = 0;
   for (vector<NodeOperation *>::iterator iter = this->m_operations.begin();
        iter != this->m_operations.end();
@@ -198,6 +218,9 @@ void ExecutionSystem::execute()
     ExecutionGroup *executionGroup = this->m_groups[index];
     executionGroup->deinitExecution();
   }
+
+  profiler.finish(this->m_context, this->m_operations, this->m_groups);
+  this->m_context.setProfiler(NULL);
 }
 
 void ExecutionSystem::executeGroups(CompositorPriority priority)
@@ -0,0 +1,521 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "COM_FullFrameExecution.h"
+#include "COM_Profiler.h"
+#include "COM_ReadBufferOperation.h"
+#include "COM_ResultCache.h"
+#include "COM_WriteBufferOperation.h"
+
+extern "C" {
+#include "BLI_string.h"
+#include "BLI_task.h"
+}
+
+#include "BLT_translation.h"
+
+#include "PIL_time.h"
+
+#ifdef WITH_CXX_GUARDEDALLOC
+#  include "MEM_guardedalloc.h"
+#endif
+
+FullFrameExecution::FullFrameExecution(const CompositorContext &context, const Groups &groups)
+    : m_context(context), m_groups(groups)
+{
+  m_cacheLimit = (size_t)context.getbNodeTree()->cache_size * 1024 * 1024;
+  m_contextKey = m_cacheLimit ? ResultCache::contextKey(context) : 0;
+  m_cacheTree = ResultCache::originalTree(context);
+}
+
+FullFrameExecution::~FullFrameExecution()
+{
+  for (std::set<MemoryBuffer *>::iterator it = m_ownedBuffers.begin();
+       it != m_ownedBuffers.end();
+       ++it) {
+    delete *it;
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Scheduling
+ * \{ */
+
+void FullFrameExecution::scheduleOperation(NodeOperation *operation)
+{
+  if (m_readerCounts.find(operation) != m_readerCounts.end()) {
+    return;
+  }
+  m_readerCounts[operation] = 0;
+
+  if (operation->isReadBufferOperation() && m_cacheLimit) {
+    const uint64_t key = getKey(operation);
+    MemoryBuffer *buffer = key ? ResultCache::find(key) : NULL;
+    if (buffer) {
+      /* The operations the result depends on don't have to be calculated. */
+      m_cachedBuffers[operation] = buffer;
+      m_operations.push_back(operation);
+      return;
+    }
+  }
+
+  for (unsigned int index = 0; index < operation->getNumberOfInputSockets(); index++) {
+    NodeOperationInput *input = operation->getInputSocket(index);
+    if (input->isConnected()) {
+      NodeOperation *inputOperation = &input->getLink()->getOperation();
+      scheduleOperation(inputOperation);
+      m_readerCounts[inputOperation]++;
+
+      if (operation->isWriteBufferOperation()) {
+        m_writeOperations[inputOperation] = (WriteBufferOperation *)operation;
+      }
+    }
+  }
+
+  if (operation->isReadBufferOperation()) {
+    ReadBufferOperation *readOperation = (ReadBufferOperation *)operation;
+    scheduleOperation(readOperation->getMemoryProxy()->getWriteBufferOperation());
+  }
+
+  m_operations.push_back(operation);
+}
+
+/**
+ * The key of the result of an operation, zero if any of the operations it depends on can't be
+ * cached. Buffer operations store the result of the operation they're connected to.
+ */
+uint64_t FullFrameExecution::getKey(NodeOperation *operation)
+{
+  Keys::iterator it = m_keys.find(operation);
+  if (it != m_keys.end()) {
+    return it->second;
+  }
+
+  uint64_t key;
+  if (operation->isReadBufferOperation()) {
+    ReadBufferOperation *readOperation = (ReadBufferOperation *)operation;
+    key = getKey(readOperation->getMemoryProxy()->getWriteBufferOperation());
+  }
+  else if (operation->isWriteBufferOperation()) {
+    key = getKey(&operation->getInputSocket(0)->getLink()->getOperation());
+  }
+  else {
+    const unsigned int resolution[2] = {operation->getWidth(), operation->getHeight()};
+    key = operation->getKey();
+    if (key) {
+      key = ResultCache::hash(key, &m_contextKey, sizeof(m_contextKey));
+      key = ResultCache::hash(key, resolution, sizeof(resolution));
+    }
+    for (unsigned int index = 0; key && index < operation->getNumberOfInputSockets(); index++) {
+      NodeOperationInput *input = operation->getInputSocket(index);
+      if (input->isConnected()) {
+        const uint64_t inputKey = getKey(&input->getLink()->getOperation());
+        key = inputKey ? ResultCache::hash(key, &inputKey, sizeof(inputKey)) : 0;
+      }
+    }
+  }
+
+  m_keys[operation] = key;
+  return key;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Buffers
+ * \{ */
+
+MemoryBuffer *FullFrameExecution::createOutputBuffer(NodeOperation *operation)
+{
+  if (operation->getNumberOfOutputSockets() == 0) {
+    return NULL;
+  }
+
+  const DataType datatype = operation->getOutputSocket()->getDataType();
+  MemoryBuffer *buffer;
+  rcti rect;
+
+  if (operation->isSetOperation()) {
+    BLI_rcti_init(&rect, 0, 1, 0, 1);
+    buffer = new MemoryBuffer(datatype, &rect, true);
+    m_ownedBuffers.insert(buffer);
+    return buffer;
+  }
+
+  /* Write directly to the MemoryProxy when the result is buffered anyway. */
+  WriteOperations::iterator it = m_writeOperations.find(operation);
+  if (it != m_writeOperations.end()) {
+    WriteBufferOperation *writeOperation = it->second;
+    buffer = writeOperation->getMemoryProxy()->getBuffer();
+    if (!writeOperation->isSingleValue() && buffer->getWidth() == (int)operation->getWidth() &&
+        buffer->getHeight() == (int)operation->getHeight()) {
+      return buffer;
+    }
+  }
+
+  BLI_rcti_init(&rect, 0, operation->getWidth(), 0, operation->getHeight());
+  buffer = new MemoryBuffer(datatype, &rect);
+  m_ownedBuffers.insert(buffer);
+  return buffer;
+}
+
+/**
+ * Sample the input at the pixels of the operation, for operations reading the input buffers
+ * directly when the input has another resolution.
+ */
+MemoryBuffer *FullFrameExecution::createConformedBuffer(NodeOperation *operation,
+                                                        NodeOperationInput *input)
+{
+  SocketReader *reader = input->getReader();
+  rcti rect;
+  BLI_rcti_init(&rect, 0, operation->getWidth(), 0, operation->getHeight());
+  MemoryBuffer *buffer = new MemoryBuffer(input->getLink()->getDataType(), &rect);
+
+  for (int y = rect.ymin; y < rect.ymax; y++) {
+    for (int x = rect.xmin; x < rect.xmax; x++) {
+      reader->readSampled(buffer->getElem(x, y), x, y, COM_PS_NEAREST);
+    }
+  }
+  return buffer;
+}
+
+void FullFrameExecution::freeBuffer(NodeOperation *operation)
+{
+  Buffers::iterator it = m_buffers.find(operation);
+  if (it == m_buffers.end()) {
+    return;
+  }
+
+  MemoryBuffer *buffer = it->second;
+  if (m_ownedBuffers.erase(buffer)) {
+    delete buffer;
+  }
+  m_buffers.erase(it);
+}
+
+void FullFrameExecution::releaseInputBuffers(NodeOperation *operation)
+{
+  for (unsigned int index = 0; index < operation->getNumberOfInputSockets(); index++) {
+    NodeOperationInput *input = operation->getInputSocket(index);
+    if (input->isConnected()) {
+      NodeOperation *inputOperation = &input->getLink()->getOperation();
+      if (--m_readerCounts[inputOperation] == 0) {
+        freeBuffer(inputOperation);
+      }
+    }
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Execution
+ * \{ */
+
+typedef struct FullFrameStripData {
+  NodeOperation *operation;
+  MemoryBuffer *output;
+  MemoryBuffer **inputs;
+  const rcti *area;
+  int strip_height;
+} FullFrameStripData;
+
+static void full_frame_strip_execute(void *__restrict userdata,
+                                     const int strip,
+                                     const TaskParallelTLS *__restrict /*tls*/)
+{
+  FullFrameStripData *data = (FullFrameStripData *)userdata;
+  rcti rect = *data->area;
+  rect.ymin = data->area->ymin + strip * data->strip_height;
+  rect.ymax = min(rect.ymin + data->strip_height, data->area->ymax);
+
+  if (data->output) {
+    data->operation->executeBufferRegion(data->output, &rect, data->inputs);
+  }
+  else {
+    /* Output operations write their result themselves. */
+    data->operation->executeRegion(&rect, strip);
+  }
+}
+
+void FullFrameExecution::executeOperation(NodeOperation *operation)
+{
+  const unsigned int numInputs = operation->getNumberOfInputSockets();
+  std::vector<MemoryBuffer *> inputs(numInputs, (MemoryBuffer *)NULL);
+  std::vector<NodeOperationOutput *> links(numInputs, (NodeOperationOutput *)NULL);
+  std::vector<ReadBufferOperation *> readers;
+  std::vector<MemoryBuffer *> conformedBuffers;
+
+  /* Link the inputs to the results of their operations. */
+  for (unsigned int index = 0; index < numInputs; index++) {
+    NodeOperationInput *input = operation->getInputSocket(index);
+    if (!input->isConnected()) {
+      continue;
+    }
+
+    NodeOperation *inputOperation = &input->getLink()->getOperation();
+    MemoryBuffer *buffer = m_buffers[inputOperation];
+
+    /* Read buffer operations read their MemoryProxy already. */
+    if (!inputOperation->isReadBufferOperation()) {
+      const unsigned int resolution[2] = {inputOperation->getWidth(),
+                                          inputOperation->getHeight()};
+      ReadBufferOperation *reader = new ReadBufferOperation(input->getLink()->getDataType());
+      reader->setbNodeTree(m_context.getbNodeTree());
+      reader->setMemoryBuffer(buffer, resolution);
+      readers.push_back(reader);
+
+      links[index] = input->getLink();
+      input->setLink(reader->getOutputSocket());
+    }
+
+    if (operation->readsInputBuffers() && !buffer->isSingleElem() &&
+        (buffer->getWidth() != (int)operation->getWidth() ||
+         buffer->getHeight() != (int)operation->getHeight())) {
+      buffer = createConformedBuffer(operation, input);
+      conformedBuffers.push_back(buffer);
+    }
+    inputs[index] = buffer;
+  }
+
+  operation->setbNodeTree(m_context.getbNodeTree());
+  operation->initExecution();
+
+  MemoryBuffer *output = createOutputBuffer(operation);
+  rcti area;
+  if (operation->isSetOperation()) {
+    BLI_rcti_init(&area, 0, 1, 0, 1);
+  }
+  else if (m_outputGroups.find(operation) != m_outputGroups.end()) {
+    area = *m_outputGroups[operation]->getViewerBorder();
+  }
+  else {
+    BLI_rcti_init(&area, 0, operation->getWidth(), 0, operation->getHeight());
+  }
+
+  if (!BLI_rcti_is_empty(&area)) {
+    FullFrameStripData data;
+    data.operation = operation;
+    data.output = output;
+    data.inputs = inputs.empty() ? NULL : &inputs[0];
+    data.area = &area;
+    data.strip_height = BLI_rcti_size_y(&area);
+    if (!operation->isSingleThreaded()) {
+      data.strip_height = min(data.strip_height, m_context.getChunksize());
+    }
+
+    const int numStrips = (BLI_rcti_size_y(&area) + data.strip_height - 1) / data.strip_height;
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = (numStrips > 1);
+    BLI_task_parallel_range(0, numStrips, &data, full_frame_strip_execute, &settings);
+  }
+
+  operation->deinitExecution();
+
+  for (unsigned int index = 0; index < numInputs; index++) {
+    if (links[index]) {
+      operation->getInputSocket(index)->setLink(links[index]);
+    }
+  }
+  for (unsigned int index = 0; index < readers.size(); index++) {
+    delete readers[index];
+  }
+  for (unsigned int index = 0; index < conformedBuffers.size(); index++) {
+    delete conformedBuffers[index];
+  }
+
+  if (output) {
+    m_buffers[operation] = output;
+  }
+  releaseInputBuffers(operation);
+}
+
+void FullFrameExecution::executeWriteBufferOperation(WriteBufferOperation *operation)
+{
+  NodeOperation *inputOperation = &operation->getInputSocket(0)->getLink()->getOperation();
+  MemoryBuffer *source = m_buffers[inputOperation];
+  MemoryBuffer *buffer = operation->getMemoryProxy()->getBuffer();
+
+  if (source != buffer) {
+    if (source->isSingleElem()) {
+      buffer->fill(buffer->getRect(), source->getElem(0, 0));
+    }
+    else {
+      buffer->copyContentFrom(source);
+    }
+  }
+  buffer->setCreatedState();
+
+  if (m_cacheLimit) {
+    cacheResult(operation);
+  }
+  releaseInputBuffers(operation);
+}
+
+void FullFrameExecution::cacheResult(WriteBufferOperation *operation)
+{
+  const bNodeTree *btree = m_context.getbNodeTree();
+  const uint64_t key = getKey(operation);
+  /* Results of a cancelled execution may be incomplete. */
+  if (key == 0 || (btree->test_break && btree->test_break(btree->tbh))) {
+    return;
+  }
+
+  MemoryProxy *memoryProxy = operation->getMemoryProxy();
+  MemoryBuffer *buffer = memoryProxy->getBuffer();
+  MemoryBuffer *result;
+  if (operation->isSingleValue()) {
+    rcti rect;
+    BLI_rcti_init(&rect, 0, 1, 0, 1);
+    result = new MemoryBuffer(memoryProxy->getDataType(), &rect, true);
+    result->fill(&rect, buffer->getElem(0, 0));
+  }
+  else {
+    const size_t size = sizeof(float) * buffer->get_num_channels() * buffer->getWidth() *
+                        buffer->getHeight();
+    if (size > m_cacheLimit) {
+      return;
+    }
+    result = new MemoryBuffer(memoryProxy->getDataType(), buffer->getRect());
+    result->copyContentFrom(buffer);
+  }
+  ResultCache::add(key, result, m_cacheTree);
+}
+
+void FullFrameExecution::executeReadBufferOperation(ReadBufferOperation *operation)
+{
+  Buffers::iterator it = m_cachedBuffers.find(operation);
+  if (it != m_cachedBuffers.end()) {
+    const unsigned int resolution[2] = {operation->getWidth(), operation->getHeight()};
+    operation->setMemoryBuffer(it->second, resolution);
+    m_buffers[operation] = it->second;
+    return;
+  }
+
+  operation->updateMemoryBuffer();
+  operation->initExecution();
+
+  MemoryProxy *memoryProxy = operation->getMemoryProxy();
+  MemoryBuffer *buffer = memoryProxy->getBuffer();
+  if (memoryProxy->getWriteBufferOperation()->isSingleValue()) {
+    rcti rect;
+    BLI_rcti_init(&rect, 0, 1, 0, 1);
+    MemoryBuffer *single = new MemoryBuffer(memoryProxy->getDataType(), &rect, true);
+    single->fill(&rect, buffer->getElem(0, 0));
+    m_ownedBuffers.insert(single);
+    buffer = single;
+  }
+  m_buffers[operation] = buffer;
+}
+
+static size_t full_frame_buffer_memory(MemoryBuffer *buffer)
+{
+  return sizeof(float) * buffer->get_num_channels() *
+         (buffer->isSingleElem() ? 1 : buffer->getWidth() * buffer->getHeight());
+}
+
+size_t FullFrameExecution::getResultMemory(NodeOperation *operation)
+{
+  if (operation->isWriteBufferOperation()) {
+    return full_frame_buffer_memory(
+        ((WriteBufferOperation *)operation)->getMemoryProxy()->getBuffer());
+  }
+  /* Read operations share the buffers of the write operations or the cache. */
+  Buffers::iterator it = m_buffers.find(operation);
+  if (it == m_buffers.end() || m_ownedBuffers.find(it->second) == m_ownedBuffers.end()) {
+    return 0;
+  }
+  return full_frame_buffer_memory(it->second);
+}
+
+void FullFrameExecution::execute()
+{
+  const bNodeTree *btree = m_context.getbNodeTree();
+  Profiler *profiler = m_context.getProfiler();
+  const CompositorPriority priorities[3] = {
+      COM_PRIORITY_HIGH, COM_PRIORITY_MEDIUM, COM_PRIORITY_LOW};
+  const int numPriorities = m_context.isFastCalculation() ? 1 : 3;
+
+  for (int priority = 0; priority < numPriorities; priority++) {
+    for (unsigned int index = 0; index < m_groups.size(); index++) {
+      ExecutionGroup *group = m_groups[index];
+      NodeOperation *operation = group->getOutputOperation();
+      if (group->isOutputExecutionGroup() &&
+          group->getRenderPriotrity() == priorities[priority] && operation->getWidth() != 0 &&
+          operation->getHeight() != 0) {
+        m_outputGroups[operation] = group;
+        scheduleOperation(operation);
+      }
+    }
+  }
+
+  /* Buffers of the write operations are written to directly, allocate them first. */
+  Operations bufferOperations;
+  for (unsigned int index = 0; index < m_operations.size(); index++) {
+    NodeOperation *operation = m_operations[index];
+    if (operation->isWriteBufferOperation()) {
+      operation->setbNodeTree(btree);
+      operation->initExecution();
+      bufferOperations.push_back(operation);
+    }
+  }
+
+  for (unsigned int index = 0; index < m_operations.size(); index++) {
+    NodeOperation *operation = m_operations[index];
+    if (btree->test_break && btree->test_break(btree->tbh)) {
+      break;
+    }
+
+    const double start = PIL_check_seconds_timer();
+    if (operation->isWriteBufferOperation()) {
+      executeWriteBufferOperation((WriteBufferOperation *)operation);
+    }
+    else if (operation->isReadBufferOperation()) {
+      operation->setbNodeTree(btree);
+      executeReadBufferOperation((ReadBufferOperation *)operation);
+      bufferOperations.push_back(operation);
+    }
+    else {
+      executeOperation(operation);
+    }
+    if (profiler) {
+      profiler->addOperation(
+          operation, start, PIL_check_seconds_timer() - start, getResultMemory(operation));
+    }
+
+    if (m_outputGroups.find(operation) != m_outputGroups.end() && btree->update_draw) {
+      btree->update_draw(btree->udh);
+    }
+
+    btree->progress(btree->prh, (float)(index + 1) / m_operations.size());
+    char buf[128];
+    BLI_snprintf(buf,
+                 sizeof(buf),
+                 TIP_("Compositing | Operation %u-%u"),
+                 index + 1,
+                 (unsigned int)m_operations.size());
+    btree->stats_draw(btree->sdh, buf);
+  }
+
+  for (unsigned int index = 0; index < bufferOperations.size(); index++) {
+    bufferOperations[index]->deinitExecution();
+  }
+
+  ResultCache::trim(m_cacheLimit);
+}
+
+/** \} */
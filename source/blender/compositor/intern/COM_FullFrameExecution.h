@@ -0,0 +1,127 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __COM_FULLFRAMEEXECUTION_H__
+#define __COM_FULLFRAMEEXECUTION_H__
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "COM_CompositorContext.h"
+#include "COM_ExecutionGroup.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_NodeOperation.h"
+
+class ReadBufferOperation;
+class WriteBufferOperation;
+
+/**
+ * \brief Execution model calculating one operation at a time for its whole area.
+ *
+ * Alternative to the tiled execution of ExecutionGroup's, selected by the execution mode of the
+ * node tree. The operations needed by the outputs are calculated in dependency order, each
+ * writing its result to a MemoryBuffer which is shared by all operations reading it and freed
+ * after the last one has been calculated. So every operation is calculated once, instead of
+ * once for every pixel read by the operations depending on it.
+ *
+ * Operations are calculated by NodeOperation.executeBufferRegion, on horizontal strips of the
+ * image in parallel. While an operation is calculated, its inputs are linked to temporary
+ * ReadBufferOperation's reading the results of the input operations, so operations reading
+ * their inputs pixel by pixel work unchanged.
+ *
+ * The group structure is kept: a WriteBufferOperation stores the result of its input operation
+ * in its MemoryProxy and ReadBufferOperation's read it from there, like in tiled execution.
+ * When the node tree has a cache size, these results are also added to the ResultCache. A
+ * ReadBufferOperation of a cached result reads the cache, without calculating the operations
+ * the result depends on.
+ *
+ * \note OpenCL is not used in this execution model.
+ * \see ExecutionSystem.execute
+ */
+class FullFrameExecution {
+ public:
+  typedef std::vector<NodeOperation *> Operations;
+  typedef std::vector<ExecutionGroup *> Groups;
+
+ private:
+  typedef std::map<NodeOperation *, MemoryBuffer *> Buffers;
+  typedef std::map<NodeOperation *, WriteBufferOperation *> WriteOperations;
+  typedef std::map<NodeOperation *, unsigned int> ReaderCounts;
+  typedef std::map<NodeOperation *, ExecutionGroup *> OutputGroups;
+  typedef std::map<NodeOperation *, uint64_t> Keys;
+
+  const CompositorContext &m_context;
+  const Groups &m_groups;
+
+  /** Operations to calculate, in dependency order. */
+  Operations m_operations;
+  /** Output operations, with the execution group they're the output of. */
+  OutputGroups m_outputGroups;
+  /** The WriteBufferOperation storing the result of an operation, if any. */
+  WriteOperations m_writeOperations;
+  /** Number of operations still to calculate that read the result of an operation. */
+  ReaderCounts m_readerCounts;
+
+  /** Result of the calculated operations. */
+  Buffers m_buffers;
+  /** Results which are not stored in a MemoryProxy, freed when they're not read anymore. */
+  std::set<MemoryBuffer *> m_ownedBuffers;
+
+  /** Memory limit of the ResultCache in bytes, zero when results aren't cached. */
+  size_t m_cacheLimit;
+  /** Key of the context, part of the keys of all results. */
+  uint64_t m_contextKey;
+  /** Node tree the results are cached for, see ResultCache::originalTree. */
+  const bNodeTree *m_cacheTree;
+  /** Keys of the results of operations, see ResultCache. */
+  Keys m_keys;
+  /** Results read by ReadBufferOperation's from the ResultCache. */
+  Buffers m_cachedBuffers;
+
+ public:
+  FullFrameExecution(const CompositorContext &context, const Groups &groups);
+  ~FullFrameExecution();
+
+  /**
+   * \brief calculate the output operations and the operations they depend on
+   * Outputs are calculated in order of their priority, only the high priority ones when the
+   * context is a fast calculation.
+   */
+  void execute();
+
+ private:
+  void scheduleOperation(NodeOperation *operation);
+  uint64_t getKey(NodeOperation *operation);
+
+  MemoryBuffer *createOutputBuffer(NodeOperation *operation);
+  MemoryBuffer *createConformedBuffer(NodeOperation *operation, NodeOperationInput *input);
+
+  void executeOperation(NodeOperation *operation);
+  void executeWriteBufferOperation(WriteBufferOperation *operation);
+  void executeReadBufferOperation(ReadBufferOperation *operation);
+  void cacheResult(WriteBufferOperation *operation);
+
+  void releaseInputBuffers(NodeOperation *operation);
+  void freeBuffer(NodeOperation *operation);
+  size_t getResultMemory(NodeOperation *operation);
+
+#ifdef WITH_CXX_GUARDEDALLOC
+  MEM_CXX_CLASS_ALLOC_FUNCS("COM:FullFrameExecution")
+#endif
+};
+
+#endif /* __COM_FULLFRAMEEXECUTION_H__ */
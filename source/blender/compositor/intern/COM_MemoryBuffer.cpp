@@ -62,6 +62,7 @@ MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, unsigned int chunkNumber, r
       sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
   this->m_state = COM_MB_ALLOCATED;
   this->m_datatype = memoryProxy->getDataType();
+  this->m_is_single_elem = false;
 }
 
 MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, rcti *rect)
@@ -76,9 +77,11 @@ MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, rcti *rect)
       sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
   this->m_state = COM_MB_TEMPORARILY;
   this->m_datatype = memoryProxy->getDataType();
+  this->m_is_single_elem = false;
 }
-MemoryBuffer::MemoryBuffer(DataType dataType, rcti *rect)
+MemoryBuffer::MemoryBuffer(DataType dataType, rcti *rect, bool is_single_elem)
 {
+  BLI_assert(!is_single_elem || (BLI_rcti_size_x(rect) == 1 && BLI_rcti_size_y(rect) == 1));
   BLI_rcti_init(&this->m_rect, rect->xmin, rect->xmax, rect->ymin, rect->ymax);
   this->m_width = BLI_rcti_size_x(&this->m_rect);
   this->m_height = BLI_rcti_size_y(&this->m_rect);
@@ -90,6 +93,7 @@ MemoryBuffer::MemoryBuffer(DataType dataType, rcti *rect)
       sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
   this->m_state = COM_MB_TEMPORARILY;
   this->m_datatype = dataType;
+  this->m_is_single_elem = is_single_elem;
 }
 MemoryBuffer *MemoryBuffer::duplicate()
 {
@@ -176,6 +180,21 @@ void MemoryBuffer::copyContentFrom(MemoryBuffer *otherBuffer)
   }
 }
 
+void MemoryBuffer::fill(const rcti *area, const float *value)
+{
+  if (this->m_is_single_elem) {
+    memcpy(this->m_buffer, value, sizeof(float) * this->m_num_channels);
+    return;
+  }
+
+  for (int y = area->ymin; y < area->ymax; y++) {
+    float *elem = this->getElem(area->xmin, y);
+    for (int x = area->xmin; x < area->xmax; x++, elem += this->m_num_channels) {
+      memcpy(elem, value, sizeof(float) * this->m_num_channels);
+    }
+  }
+}
+
 void MemoryBuffer::writePixel(int x, int y, const float color[4])
 {
   if (x >= this->m_rect.xmin && x < this->m_rect.xmax && y >= this->m_rect.ymin &&
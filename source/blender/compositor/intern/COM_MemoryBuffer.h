@@ -97,6 +97,12 @@ class MemoryBuffer {
   int m_width;
   int m_height;
 
+  /**
+   * \brief the buffer stores a single element, which is the value of every pixel
+   * \see isSingleElem
+   */
+  bool m_is_single_elem;
+
  public:
   /**
    * \brief construct new MemoryBuffer for a chunk
@@ -110,8 +116,9 @@ class MemoryBuffer {
 
   /**
    * \brief construct new temporarily MemoryBuffer for an area
+   * \param is_single_elem: store a single element used for every pixel, \a rect must be 1x1
    */
-  MemoryBuffer(DataType datatype, rcti *rect);
+  MemoryBuffer(DataType datatype, rcti *rect, bool is_single_elem = false);
 
   /**
    * \brief destructor
@@ -140,6 +147,42 @@ class MemoryBuffer {
     return this->m_buffer;
   }
 
+  /**
+   * \brief does this buffer store a single element for all pixels
+   * (the result of an operation with a constant output)
+   */
+  bool isSingleElem() const
+  {
+    return this->m_is_single_elem;
+  }
+
+  /**
+   * \brief get the element of pixel (x, y), which must be inside the rect of this MemoryBuffer
+   */
+  float *getElem(int x, int y)
+  {
+    if (this->m_is_single_elem) {
+      return this->m_buffer;
+    }
+    BLI_assert(BLI_rcti_isect_pt(&this->m_rect, x, y));
+    return &this->m_buffer[(this->m_width * (y - this->m_rect.ymin) + x - this->m_rect.xmin) *
+                           this->m_num_channels];
+  }
+
+  /**
+   * \brief number of floats between the elements of two consecutive pixels of a row,
+   * zero for single element buffers so loops can read them like any other buffer
+   */
+  int getElemStride() const
+  {
+    return this->m_is_single_elem ? 0 : this->m_num_channels;
+  }
+
+  /**
+   * \brief set the pixels of \a area to \a value
+   */
+  void fill(const rcti *area, const float *value);
+
   /**
    * \brief after execution the state will be set to available by calling this method
    */
@@ -36,6 +36,9 @@ NodeOperation::NodeOperation()
   this->m_height = 0;
   this->m_isResolutionSet = false;
   this->m_openCL = false;
+  this->m_readsInputBuffers = false;
+  this->m_key = 0;
+  this->m_bNode = NULL;
   this->m_btree = NULL;
 }
 
@@ -134,6 +137,36 @@ void NodeOperation::deinitExecution()
 {
   /* pass */
 }
+
+void NodeOperation::executeBufferRegion(MemoryBuffer *output,
+                                        rcti *rect,
+                                        MemoryBuffer ** /*inputs*/)
+{
+  const int elem_stride = output->getElemStride();
+  void *data = NULL;
+  if (this->isComplex()) {
+    data = this->initializeTileData(rect);
+  }
+
+  for (int y = rect->ymin; y < rect->ymax; y++) {
+    float *elem = output->getElem(rect->xmin, y);
+    for (int x = rect->xmin; x < rect->xmax; x++, elem += elem_stride) {
+      if (this->isComplex()) {
+        this->read(elem, x, y, data);
+      }
+      else {
+        this->readSampled(elem, x, y, COM_PS_NEAREST);
+      }
+    }
+    if (isBraked()) {
+      break;
+    }
+  }
+
+  if (data) {
+    this->deinitializeTileData(rect, data);
+  }
+}
 SocketReader *NodeOperation::getInputSocketReader(unsigned int inputSocketIndex)
 {
   return this->getInputSocket(inputSocketIndex)->getReader();
@@ -105,6 +105,25 @@ class NodeOperation : public SocketReader {
    */
   bool m_openCL;
 
+  /**
+   * \brief does executeBufferRegion read the input buffers directly
+   * \see NodeOperation.executeBufferRegion
+   */
+  bool m_readsInputBuffers;
+
+  /**
+   * \brief key of the settings this operation depends on besides its inputs
+   * zero when its result can't be cached.
+   * \see ResultCache
+   */
+  uint64_t m_key;
+
+  /**
+   * \brief node this operation was created for, NULL for operations connecting nodes
+   * \see Profiler
+   */
+  bNode *m_bNode;
+
   /**
    * \brief mutex reference for very special node initializations
    * \note only use when you really know what you are doing.
@@ -203,6 +222,20 @@ class NodeOperation : public SocketReader {
   {
   }
 
+  /**
+   * \brief calculate the pixels of a region at once, used by the full-frame execution model
+   * \ingroup execution
+   * The default implementation calculates every pixel like a WriteBufferOperation would,
+   * reading the inputs through their SocketReader. Operations which set #setReadsInputBuffers
+   * override it with loops over the input buffers instead.
+   * \param output: the buffer of the whole operation to write to
+   * \param rect: the region to calculate, inside \a output
+   * \param inputs: the results of the operations connected to the input sockets, either single
+   * element buffers or buffers with the resolution of this operation when #readsInputBuffers
+   * \see FullFrameExecution
+   */
+  virtual void executeBufferRegion(MemoryBuffer *output, rcti *rect, MemoryBuffer **inputs);
+
   /**
    * \brief when a chunk is executed by an OpenCLDevice, this method is called
    * \ingroup execution
@@ -346,6 +379,41 @@ class NodeOperation : public SocketReader {
     return this->m_openCL;
   }
 
+  /**
+   * \brief does executeBufferRegion read the input buffers directly
+   * \see FullFrameExecution
+   */
+  bool readsInputBuffers() const
+  {
+    return this->m_readsInputBuffers;
+  }
+
+  /**
+   * \brief key of the settings this operation depends on besides its inputs
+   * \see ResultCache
+   */
+  uint64_t getKey() const
+  {
+    return this->m_key;
+  }
+  void setKey(uint64_t key)
+  {
+    this->m_key = key;
+  }
+
+  /**
+   * \brief node this operation was created for
+   * \see Profiler
+   */
+  bNode *getbNode() const
+  {
+    return this->m_bNode;
+  }
+  void setbNode(bNode *node)
+  {
+    this->m_bNode = node;
+  }
+
   virtual bool isViewerOperation() const
   {
     return false;
@@ -423,6 +491,14 @@ class NodeOperation : public SocketReader {
     this->m_openCL = openCL;
   }
 
+  /**
+   * \brief set if executeBufferRegion is overridden to read the input buffers directly
+   */
+  void setReadsInputBuffers(bool readsInputBuffers)
+  {
+    this->m_readsInputBuffers = readsInputBuffers;
+  }
+
   /* allow the DebugInfo class to look at internals */
   friend class DebugInfo;
 
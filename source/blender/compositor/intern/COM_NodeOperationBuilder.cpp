@@ -16,6 +16,9 @@
  * Copyright 2013, Blender Foundation.
  */
 
+#include <string.h>
+#include <typeinfo>
+
 extern "C" {
 #include "BLI_utildefines.h"
 }
@@ -25,6 +28,7 @@ extern "C" {
 #include "COM_Debug.h"
 #include "COM_ExecutionSystem.h"
 #include "COM_Node.h"
+#include "COM_ResultCache.h"
 #include "COM_SocketProxyNode.h"
 
 #include "COM_NodeOperation.h"
@@ -40,8 +44,14 @@ extern "C" {
 #include "COM_NodeOperationBuilder.h" /* own include */
 
 NodeOperationBuilder::NodeOperationBuilder(const CompositorContext *context, bNodeTree *b_nodetree)
-    : m_context(context), m_current_node(NULL), m_active_viewer(NULL)
-{
+    : m_context(context),
+      m_current_node(NULL),
+      m_current_key(0),
+      m_current_num_operations(0),
+      m_active_viewer(NULL)
+{
+  m_use_result_cache = (b_nodetree->execution_mode == NTREE_EXECUTION_MODE_FULL_FRAME &&
+                        b_nodetree->cache_size > 0);
   m_graph.from_bNodeTree(*context, b_nodetree);
 }
 
@@ -58,6 +68,11 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
     Node *node = (Node *)m_graph.nodes()[index];
 
     m_current_node = node;
+    m_current_key = 0;
+    m_current_num_operations = 0;
+    if (m_use_result_cache && node->getbNode()) {
+      m_current_key = ResultCache::nodeKey(*m_context, node->getbNode());
+    }
 
     DebugInfo::node_to_operations(node);
     node->convertToOperations(converter, *m_context);
@@ -127,6 +142,29 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 
 void NodeOperationBuilder::addOperation(NodeOperation *operation)
 {
+  if (m_use_result_cache) {
+    /* Operations connecting the nodes and socket proxies (of muted nodes and groups)
+     * only depend on their type and inputs. */
+    const char *name = typeid(*operation).name();
+    uint64_t key = ResultCache::hash(ResultCache::KEY_INIT, name, strlen(name));
+    if (operation->isProxyOperation()) {
+      const DataType datatype = operation->getOutputSocket()->getDataType();
+      key = ResultCache::hash(key, &datatype, sizeof(datatype));
+    }
+    else if (m_current_node) {
+      /* Nodes add the same operations in the same order for the same settings. */
+      key = ResultCache::hash(key, &m_current_key, sizeof(m_current_key));
+      key = ResultCache::hash(key, &m_current_num_operations, sizeof(m_current_num_operations));
+      m_current_num_operations++;
+      if (m_current_key == 0) {
+        key = 0;
+      }
+    }
+    operation->setKey(key);
+  }
+  if (m_current_node) {
+    operation->setbNode(m_current_node->getbNode());
+  }
   m_operations.push_back(operation);
 }
 
@@ -339,6 +377,7 @@ void NodeOperationBuilder::add_input_constant_value(NodeOperationInput *input,
       SetValueOperation *op = new SetValueOperation();
       op->setValue(value);
       addOperation(op);
+      op->setKey(ResultCache::hash(op->getKey(), &value, sizeof(value)));
       addLink(op->getOutputSocket(), input);
       break;
     }
@@ -354,6 +393,7 @@ void NodeOperationBuilder::add_input_constant_value(NodeOperationInput *input,
       SetColorOperation *op = new SetColorOperation();
       op->setChannels(value);
       addOperation(op);
+      op->setKey(ResultCache::hash(op->getKey(), value, sizeof(value)));
       addLink(op->getOutputSocket(), input);
       break;
     }
@@ -369,6 +409,7 @@ void NodeOperationBuilder::add_input_constant_value(NodeOperationInput *input,
       SetVectorOperation *op = new SetVectorOperation();
       op->setVector(value);
       addOperation(op);
+      op->setKey(ResultCache::hash(op->getKey(), value, sizeof(value)));
       addLink(op->getOutputSocket(), input);
       break;
     }
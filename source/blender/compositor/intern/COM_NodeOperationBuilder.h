@@ -89,6 +89,11 @@ class NodeOperationBuilder {
   OutputSocketMap m_output_map;
 
   Node *m_current_node;
+  /** Key of the current node and number of operations it added, see ResultCache. */
+  uint64_t m_current_key;
+  unsigned int m_current_num_operations;
+  /** Results are cached, so operations need a key. */
+  bool m_use_result_cache;
 
   /** Operation that will be writing to the viewer image
    *  Only one operation can occupy this place at a time,
@@ -0,0 +1,261 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <set>
+#include <stdio.h>
+
+#include "COM_Profiler.h"
+
+#include "COM_CompositorContext.h"
+#include "COM_ExecutionGroup.h"
+#include "COM_NodeOperation.h"
+#include "COM_WriteBufferOperation.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "PIL_time.h"
+
+extern "C" {
+#include "BLI_fileops.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+
+#include "BKE_appdir.h"
+#include "BKE_global.h"
+#include "BKE_node.h"
+}
+
+Profiler::Profiler()
+{
+  m_startTime = PIL_check_seconds_timer();
+  m_useTrace = (G.debug & G_DEBUG_COMPOSITOR) != 0;
+  BLI_mutex_init(&m_mutex);
+}
+
+Profiler::~Profiler()
+{
+  BLI_mutex_end(&m_mutex);
+}
+
+void Profiler::addChunk(ExecutionGroup *group,
+                        unsigned int chunkNumber,
+                        int thread,
+                        double start,
+                        double duration)
+{
+  BLI_mutex_lock(&m_mutex);
+  m_groupTimes[group] += duration;
+  if (m_useTrace) {
+    ProfilerEvent event = {group, NULL, chunkNumber, thread, start - m_startTime, duration, 0};
+    m_events.push_back(event);
+  }
+  BLI_mutex_unlock(&m_mutex);
+}
+
+void Profiler::addOperation(NodeOperation *operation, double start, double duration, size_t memory)
+{
+  m_operationTimes[operation] += duration;
+  m_operationMemory[operation] += memory;
+  if (m_useTrace) {
+    ProfilerEvent event = {NULL, operation, 0, 0, start - m_startTime, duration, memory};
+    m_events.push_back(event);
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Nodes
+ * \{ */
+
+#define PROFILER_MB(bytes) ((float)(bytes) / (1024.0f * 1024.0f))
+
+static void profiler_nodes_clear(bNodeTree *ntree)
+{
+  for (bNode *node = (bNode *)ntree->nodes.first; node; node = node->next) {
+    if (node->execution_stats == NULL) {
+      node->execution_stats = (bNodeExecutionStats *)MEM_callocN(sizeof(bNodeExecutionStats),
+                                                                 __func__);
+    }
+    node->execution_stats->time = 0.0f;
+    node->execution_stats->memory = 0.0f;
+    if (node->type == NODE_GROUP && node->id) {
+      profiler_nodes_clear((bNodeTree *)node->id);
+    }
+  }
+}
+
+static size_t profiler_buffer_memory(DataType datatype, unsigned int width, unsigned int height)
+{
+  size_t num_channels;
+  switch (datatype) {
+    case COM_DT_VALUE:
+      num_channels = COM_NUM_CHANNELS_VALUE;
+      break;
+    case COM_DT_VECTOR:
+      num_channels = COM_NUM_CHANNELS_VECTOR;
+      break;
+    case COM_DT_COLOR:
+    default:
+      num_channels = COM_NUM_CHANNELS_COLOR;
+      break;
+  }
+  /* Single values are stored in a buffer of one pixel. */
+  return sizeof(float) * num_channels * max(width, 1u) * max(height, 1u);
+}
+
+void Profiler::finish(const CompositorContext &context,
+                      const Operations &operations,
+                      const Groups &groups)
+{
+  profiler_nodes_clear((bNodeTree *)context.getbNodeTree());
+
+  /* Full-frame execution. */
+  for (std::map<NodeOperation *, double>::iterator it = m_operationTimes.begin();
+       it != m_operationTimes.end();
+       ++it) {
+    bNode *node = it->first->getbNode();
+    if (node && node->execution_stats) {
+      node->execution_stats->time += it->second;
+      node->execution_stats->memory += PROFILER_MB(m_operationMemory[it->first]);
+    }
+  }
+
+  /* Tiled execution. */
+  if (!m_groupTimes.empty()) {
+    for (std::map<ExecutionGroup *, double>::iterator it = m_groupTimes.begin();
+         it != m_groupTimes.end();
+         ++it) {
+      const ExecutionGroup::Operations &groupOperations = it->first->getOperations();
+      std::set<bNode *> nodes;
+      for (unsigned int index = 0; index < groupOperations.size(); index++) {
+        if (groupOperations[index]->getbNode() &&
+            groupOperations[index]->getbNode()->execution_stats) {
+          nodes.insert(groupOperations[index]->getbNode());
+        }
+      }
+      for (std::set<bNode *>::iterator node = nodes.begin(); node != nodes.end(); ++node) {
+        (*node)->execution_stats->time += it->second / nodes.size();
+      }
+    }
+
+    for (unsigned int index = 0; index < operations.size(); index++) {
+      NodeOperation *operation = operations[index];
+      if (operation->isWriteBufferOperation()) {
+        WriteBufferOperation *writeOperation = (WriteBufferOperation *)operation;
+        NodeOperationInput *input = operation->getInputSocket(0);
+        bNode *node = input->isConnected() ? input->getLink()->getOperation().getbNode() : NULL;
+        if (node && node->execution_stats) {
+          const size_t memory = profiler_buffer_memory(
+              writeOperation->getMemoryProxy()->getDataType(),
+              operation->getWidth(),
+              operation->getHeight());
+          node->execution_stats->memory += PROFILER_MB(memory);
+        }
+      }
+    }
+  }
+
+  if (m_useTrace) {
+    writeTrace(context, groups);
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Trace
+ * \{ */
+
+static void profiler_write_string(FILE *file, const char *str)
+{
+  fputc('"', file);
+  for (const char *c = str; *c; c++) {
+    if (ELEM(*c, '"', '\\')) {
+      fputc('\\', file);
+      fputc(*c, file);
+    }
+    else if ((unsigned char)*c >= ' ') {
+      fputc(*c, file);
+    }
+  }
+  fputc('"', file);
+}
+
+static const char *profiler_operation_name(NodeOperation *operation)
+{
+  if (operation->getbNode()) {
+    return operation->getbNode()->name;
+  }
+  if (operation->isWriteBufferOperation()) {
+    return "Write Buffer";
+  }
+  if (operation->isReadBufferOperation()) {
+    return "Read Buffer";
+  }
+  return "Conversion";
+}
+
+void Profiler::writeTrace(const CompositorContext &context, const Groups &groups)
+{
+  char filename[FILE_MAXFILE], filepath[FILE_MAX];
+  BLI_snprintf(filename, sizeof(filename), "compositor_trace_%04d.json", context.getFramenumber());
+  BLI_join_dirfile(filepath, sizeof(filepath), BKE_tempdir_session(), filename);
+
+  FILE *file = BLI_fopen(filepath, "w");
+  if (file == NULL) {
+    printf("Compositor: can't write trace to %s\n", filepath);
+    return;
+  }
+
+  std::map<ExecutionGroup *, unsigned int> groupIndices;
+  for (unsigned int index = 0; index < groups.size(); index++) {
+    groupIndices[groups[index]] = index;
+  }
+
+  fprintf(file, "{\"traceEvents\": [\n");
+  for (unsigned int index = 0; index < m_events.size(); index++) {
+    const ProfilerEvent &event = m_events[index];
+    fprintf(file, "  {\"name\": ");
+    if (event.group) {
+      profiler_write_string(file, profiler_operation_name(event.group->getOutputOperation()));
+    }
+    else {
+      profiler_write_string(file, profiler_operation_name(event.operation));
+    }
+    fprintf(file,
+            ", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, "
+            "\"ts\": %.3f, \"dur\": %.3f, \"args\": {",
+            event.group ? "chunk" : "operation",
+            event.thread,
+            event.start * 1e6,
+            event.duration * 1e6);
+    if (event.group) {
+      fprintf(file,
+              "\"group\": %u, \"chunk\": %u",
+              groupIndices[event.group],
+              event.chunkNumber);
+    }
+    else {
+      fprintf(file, "\"memory\": %lu", (unsigned long)event.memory);
+    }
+    fprintf(file, "}}%s\n", (index + 1 < m_events.size()) ? "," : "");
+  }
+  fprintf(file, "]}\n");
+  fclose(file);
+
+  printf("Compositor: trace written to %s\n", filepath);
+}
+
+/** \} */
@@ -0,0 +1,106 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __COM_PROFILER_H__
+#define __COM_PROFILER_H__
+
+#include <map>
+#include <vector>
+
+extern "C" {
+#include "BLI_threads.h"
+}
+
+class CompositorContext;
+class ExecutionGroup;
+class NodeOperation;
+
+/**
+ * \brief time and memory used by the nodes during an execution of the compositor
+ * \ingroup execution
+ *
+ * In tiled execution the WorkScheduler adds the time of every chunk to its ExecutionGroup. The
+ * operations of a group are calculated together, so the time of a group is divided over the
+ * nodes of its operations. The memory of a node is the memory of the MemoryProxy's storing the
+ * results of its operations.
+ *
+ * In full-frame execution the operations are calculated one at a time, their time and the
+ * memory of their results is added to their node.
+ *
+ * When the execution is finished the results are stored in the nodes of the executed tree, see
+ * bNode.execution_stats, and moved to the original tree by #ntreeCompositMergeExecutionStats.
+ * With `--debug-compositor` the chunks and operations are also written to a JSON trace
+ * (chrome://tracing format) in the temporary directory.
+ */
+class Profiler {
+ public:
+  typedef std::vector<NodeOperation *> Operations;
+  typedef std::vector<ExecutionGroup *> Groups;
+
+ private:
+  typedef struct ProfilerEvent {
+    ExecutionGroup *group;
+    NodeOperation *operation;
+    unsigned int chunkNumber;
+    int thread;
+    double start, duration;
+    size_t memory;
+  } ProfilerEvent;
+
+  /** Start of the execution, events are relative to it. */
+  double m_startTime;
+  bool m_useTrace;
+
+  std::map<ExecutionGroup *, double> m_groupTimes;
+  std::map<NodeOperation *, double> m_operationTimes;
+  std::map<NodeOperation *, size_t> m_operationMemory;
+  std::vector<ProfilerEvent> m_events;
+
+  /** Chunks are added by the threads of the WorkScheduler. */
+  ThreadMutex m_mutex;
+
+ public:
+  Profiler();
+  ~Profiler();
+
+  /**
+   * \brief add the time of calculating a chunk of an ExecutionGroup
+   * \note thread safe, called by the WorkScheduler
+   */
+  void addChunk(ExecutionGroup *group,
+                unsigned int chunkNumber,
+                int thread,
+                double start,
+                double duration);
+
+  /**
+   * \brief add the time of calculating an operation and the \a memory of its result in bytes
+   */
+  void addOperation(NodeOperation *operation, double start, double duration, size_t memory);
+
+  /**
+   * \brief store the time and memory of the nodes in the node tree of \a context
+   * and write the trace when enabled.
+   */
+  void finish(const CompositorContext &context,
+              const Operations &operations,
+              const Groups &groups);
+
+ private:
+  void writeTrace(const CompositorContext &context, const Groups &groups);
+};
+
+#endif /* __COM_PROFILER_H__ */
@@ -0,0 +1,350 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <map>
+#include <string.h>
+#include <vector>
+
+#include "COM_ResultCache.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "DNA_camera_types.h"
+#include "DNA_color_types.h"
+#include "DNA_image_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_image.h"
+#include "BKE_node.h"
+
+#include "IMB_imbuf_types.h"
+
+#include "RE_pipeline.h"
+}
+
+typedef struct ResultCacheEntry {
+  MemoryBuffer *buffer;
+  size_t size;
+  /** Original node tree of the execution which added the result. */
+  const bNodeTree *tree;
+  /** Value of the clock when the result was last used. */
+  unsigned int last_used;
+} ResultCacheEntry;
+
+typedef std::map<uint64_t, ResultCacheEntry> ResultCacheEntries;
+
+static ResultCacheEntries g_entries;
+static size_t g_size = 0;
+static unsigned int g_clock = 0;
+
+/* -------------------------------------------------------------------- */
+/** \name Keys
+ * \{ */
+
+/* FNV-1a, 64 bit. */
+#define RESULT_CACHE_KEY_PRIME 0x100000001b3ULL
+
+uint64_t ResultCache::hash(uint64_t key, const void *data, size_t size)
+{
+  const unsigned char *bytes = (const unsigned char *)data;
+  for (size_t i = 0; i < size; i++) {
+    key = (key ^ bytes[i]) * RESULT_CACHE_KEY_PRIME;
+  }
+  return key;
+}
+
+static uint64_t result_cache_hash_alloc(uint64_t key, const void *data)
+{
+  if (data == NULL) {
+    return ResultCache::hash(key, &data, sizeof(data));
+  }
+  return ResultCache::hash(key, data, MEM_allocN_len(data));
+}
+
+uint64_t ResultCache::contextKey(const CompositorContext &context)
+{
+  const RenderData *rd = context.getRenderData();
+  const char *viewName = context.getViewName();
+  const int framenumber = context.getFramenumber();
+  const CompositorQuality quality = context.getQuality();
+  const bool rendering = context.isRendering();
+  const bool fastCalculation = context.isFastCalculation();
+  const int border = rd->mode & (R_BORDER | R_CROP);
+
+  uint64_t key = KEY_INIT;
+  key = hash(key, &framenumber, sizeof(framenumber));
+  key = hash(key, &quality, sizeof(quality));
+  key = hash(key, &rendering, sizeof(rendering));
+  key = hash(key, &fastCalculation, sizeof(fastCalculation));
+  key = hash(key, &rd->size, sizeof(rd->size));
+  key = hash(key, &border, sizeof(border));
+  if (border) {
+    key = hash(key, &rd->border, sizeof(rd->border));
+  }
+  if (viewName) {
+    key = hash(key, viewName, strlen(viewName));
+  }
+  return key;
+}
+
+/** Identify the contents of the render result read by render layer nodes. */
+static uint64_t result_cache_render_key(uint64_t key, Scene *scene)
+{
+  Render *re = scene ? RE_GetSceneRender(scene) : NULL;
+  if (re == NULL) {
+    return key;
+  }
+  RenderResult *rr = RE_AcquireResultRead(re);
+  const unsigned int update_counter = rr ? rr->update_counter : 0;
+  key = ResultCache::hash(key, &update_counter, sizeof(update_counter));
+  RE_ReleaseResult(re);
+  return key;
+}
+
+/** Identify the contents of the image buffer read by image nodes, zero while it is painted. */
+static uint64_t result_cache_image_key(uint64_t key, Image *image, ImageUser *iuser)
+{
+  if (ELEM(image->type, IMA_TYPE_R_RESULT, IMA_TYPE_COMPOSITE)) {
+    return 0;
+  }
+  ImBuf *ibuf = BKE_image_acquire_ibuf(image, iuser, NULL);
+  if (ibuf && (ibuf->userflags & IB_BITMAPDIRTY)) {
+    key = 0;
+  }
+  else {
+    const unsigned int update_counter = ibuf ? ibuf->update_counter : 0;
+    key = ResultCache::hash(key, &update_counter, sizeof(update_counter));
+  }
+  BKE_image_release_ibuf(image, ibuf, NULL);
+  return key;
+}
+
+/** Curve points of curve nodes, the storage only holds pointers to them. */
+static uint64_t result_cache_curve_mapping_key(uint64_t key, const CurveMapping *cumap)
+{
+  key = ResultCache::hash(key, &cumap->flag, sizeof(cumap->flag));
+  key = ResultCache::hash(key, &cumap->clipr, sizeof(cumap->clipr));
+  key = ResultCache::hash(key, cumap->black, sizeof(cumap->black));
+  key = ResultCache::hash(key, cumap->white, sizeof(cumap->white));
+  key = ResultCache::hash(key, &cumap->tone, sizeof(cumap->tone));
+  for (int a = 0; a < CM_TOT; a++) {
+    const CurveMap *cuma = &cumap->cm[a];
+    key = ResultCache::hash(key, &cuma->totpoint, sizeof(cuma->totpoint));
+    key = ResultCache::hash(key, cuma->ext_in, sizeof(cuma->ext_in));
+    key = ResultCache::hash(key, cuma->ext_out, sizeof(cuma->ext_out));
+    for (int i = 0; i < cuma->totpoint; i++) {
+      const CurveMapPoint *cmp = &cuma->curve[i];
+      key = ResultCache::hash(key, &cmp->x, sizeof(cmp->x));
+      key = ResultCache::hash(key, &cmp->y, sizeof(cmp->y));
+      key = ResultCache::hash(key, &cmp->flag, sizeof(cmp->flag));
+    }
+  }
+  return key;
+}
+
+/** The camera used by defocus nodes for the radius of the Z-buffer. */
+static uint64_t result_cache_camera_key(uint64_t key, const Object *camera)
+{
+  key = ResultCache::hash(key, &camera, sizeof(camera));
+  if (camera && camera->type == OB_CAMERA) {
+    const Camera *cam = (const Camera *)camera->data;
+    key = ResultCache::hash(key, camera->obmat, sizeof(camera->obmat));
+    key = ResultCache::hash(key, &cam->lens, sizeof(cam->lens));
+    key = ResultCache::hash(key, &cam->sensor_x, sizeof(cam->sensor_x));
+    key = ResultCache::hash(key, &cam->sensor_y, sizeof(cam->sensor_y));
+    key = ResultCache::hash(key, &cam->sensor_fit, sizeof(cam->sensor_fit));
+    key = ResultCache::hash(key, &cam->dof, sizeof(cam->dof));
+    if (cam->dof.focus_object) {
+      key = ResultCache::hash(
+          key, cam->dof.focus_object->obmat, sizeof(cam->dof.focus_object->obmat));
+    }
+  }
+  return key;
+}
+
+uint64_t ResultCache::nodeKey(const CompositorContext &context, bNode *node)
+{
+  switch (node->type) {
+    /* Nodes reading data which isn't hashed. */
+    case CMP_NODE_CRYPTOMATTE:
+    case CMP_NODE_KEYINGSCREEN:
+    case CMP_NODE_MASK:
+    case CMP_NODE_MOVIECLIP:
+    case CMP_NODE_MOVIEDISTORTION:
+    case CMP_NODE_PLANETRACKDEFORM:
+    case CMP_NODE_STABILIZE2D:
+    case CMP_NODE_TEXTURE:
+    case CMP_NODE_TRACKPOS:
+      return 0;
+  }
+
+  const short muted = node->flag & NODE_MUTED;
+  uint64_t key = KEY_INIT;
+  key = hash(key, &node->type, sizeof(node->type));
+  key = hash(key, &muted, sizeof(muted));
+  key = hash(key, &node->custom1, sizeof(node->custom1));
+  key = hash(key, &node->custom2, sizeof(node->custom2));
+  key = hash(key, &node->custom3, sizeof(node->custom3));
+  key = hash(key, &node->custom4, sizeof(node->custom4));
+  key = hash(key, &node->id, sizeof(node->id));
+  switch (node->type) {
+    case CMP_NODE_CURVE_RGB:
+    case CMP_NODE_CURVE_VEC:
+    case CMP_NODE_HUECORRECT:
+    case CMP_NODE_TIME:
+      key = result_cache_curve_mapping_key(key, (const CurveMapping *)node->storage);
+      break;
+    default:
+      key = result_cache_hash_alloc(key, node->storage);
+      break;
+  }
+
+  /* Values of unlinked inputs and of input nodes. */
+  for (bNodeSocket *sock = (bNodeSocket *)node->inputs.first; sock; sock = sock->next) {
+    key = hash(key, &sock->type, sizeof(sock->type));
+    key = result_cache_hash_alloc(key, sock->default_value);
+  }
+  for (bNodeSocket *sock = (bNodeSocket *)node->outputs.first; sock; sock = sock->next) {
+    key = hash(key, &sock->type, sizeof(sock->type));
+    key = result_cache_hash_alloc(key, sock->default_value);
+  }
+
+  switch (node->type) {
+    case CMP_NODE_R_LAYERS:
+      key = result_cache_render_key(key, node->id ? (Scene *)node->id : context.getScene());
+      break;
+    case CMP_NODE_IMAGE:
+      if (node->id) {
+        key = result_cache_image_key(key, (Image *)node->id, (ImageUser *)node->storage);
+      }
+      break;
+    case CMP_NODE_DEFOCUS: {
+      Scene *scene = node->id ? (Scene *)node->id : context.getScene();
+      key = result_cache_camera_key(key, scene ? scene->camera : NULL);
+      break;
+    }
+  }
+
+  /* Zero is reserved for results which can't be cached. */
+  return key ? key : 1;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Results
+ * \{ */
+
+const bNodeTree *ResultCache::originalTree(const CompositorContext &context)
+{
+  /* Compositing trees belong to their scene, rendering executes the tree of the evaluated one. */
+  const Scene *scene = context.getScene();
+  if (scene == NULL) {
+    return context.getbNodeTree();
+  }
+  if (scene->id.orig_id) {
+    scene = (const Scene *)scene->id.orig_id;
+  }
+  return scene->nodetree;
+}
+
+MemoryBuffer *ResultCache::find(uint64_t key)
+{
+  ResultCacheEntries::iterator it = g_entries.find(key);
+  if (it == g_entries.end()) {
+    return NULL;
+  }
+  it->second.last_used = g_clock;
+  return it->second.buffer;
+}
+
+void ResultCache::add(uint64_t key, MemoryBuffer *buffer, const bNodeTree *tree)
+{
+  BLI_assert(key != 0);
+  if (g_entries.find(key) != g_entries.end()) {
+    /* Same result, the cached buffer may be in use. */
+    delete buffer;
+    return;
+  }
+
+  ResultCacheEntry entry;
+  entry.buffer = buffer;
+  entry.size = sizeof(float) * buffer->get_num_channels() *
+               (buffer->isSingleElem() ? 1 : buffer->getWidth() * buffer->getHeight());
+  entry.tree = tree;
+  entry.last_used = g_clock;
+  g_entries[key] = entry;
+  g_size += entry.size;
+}
+
+static bool result_cache_entry_older(const ResultCacheEntries::iterator &a,
+                                     const ResultCacheEntries::iterator &b)
+{
+  return a->second.last_used < b->second.last_used;
+}
+
+void ResultCache::trim(size_t limit)
+{
+  if (g_size > limit) {
+    std::vector<ResultCacheEntries::iterator> entries;
+    for (ResultCacheEntries::iterator it = g_entries.begin(); it != g_entries.end(); ++it) {
+      entries.push_back(it);
+    }
+    std::sort(entries.begin(), entries.end(), result_cache_entry_older);
+
+    for (unsigned int index = 0; index < entries.size() && g_size > limit; index++) {
+      g_size -= entries[index]->second.size;
+      delete entries[index]->second.buffer;
+      g_entries.erase(entries[index]);
+    }
+  }
+
+  /* Next execution. */
+  g_clock++;
+}
+
+void ResultCache::clear(const bNodeTree *tree)
+{
+  for (ResultCacheEntries::iterator it = g_entries.begin(); it != g_entries.end();) {
+    if (it->second.tree == tree) {
+      g_size -= it->second.size;
+      delete it->second.buffer;
+      g_entries.erase(it++);
+    }
+    else {
+      ++it;
+    }
+  }
+}
+
+void ResultCache::clear()
+{
+  for (ResultCacheEntries::iterator it = g_entries.begin(); it != g_entries.end(); ++it) {
+    delete it->second.buffer;
+  }
+  g_entries.clear();
+  g_size = 0;
+}
+
+size_t ResultCache::size()
+{
+  return g_size;
+}
+
+/** \} */
@@ -0,0 +1,105 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __COM_RESULTCACHE_H__
+#define __COM_RESULTCACHE_H__
+
+#include "BLI_sys_types.h"
+
+#include "COM_CompositorContext.h"
+#include "COM_MemoryBuffer.h"
+
+struct bNode;
+struct bNodeTree;
+
+/**
+ * \brief cache of operation results between executions of the compositor
+ * \ingroup execution
+ *
+ * Results are identified by a key hashing everything the result depends on: the settings of the
+ * node the operation was created for, the keys of its inputs, its resolution and the context.
+ * When an unchanged part of the node tree is calculated again its results are found in the cache
+ * instead, so only the part downstream of a changed node is recalculated.
+ *
+ * A key of zero means the result can't be cached, because it depends on data that isn't hashed.
+ *
+ * Only used by the full-frame execution model, which caches the results stored by
+ * WriteBufferOperation's. Like the rest of the compositor the cache is used under the lock of
+ * COM_execute, it isn't thread safe.
+ *
+ * \see FullFrameExecution
+ */
+class ResultCache {
+ public:
+  /** Initial value of keys. */
+  static const uint64_t KEY_INIT = 0xcbf29ce484222325ULL;
+
+  /**
+   * \brief add \a size bytes of \a data to \a key
+   */
+  static uint64_t hash(uint64_t key, const void *data, size_t size);
+
+  /**
+   * \brief key of the settings of the context which results depend on
+   */
+  static uint64_t contextKey(const CompositorContext &context);
+
+  /**
+   * \brief key of the settings of a node, or zero when results of its operations can't be cached
+   */
+  static uint64_t nodeKey(const CompositorContext &context, bNode *node);
+
+  /**
+   * \brief the node tree which results of an execution are added for
+   * Executions use a local copy of the node tree of the scene, the original tree identifies it
+   * between executions.
+   */
+  static const bNodeTree *originalTree(const CompositorContext &context);
+
+  /**
+   * \brief find the cached result with \a key, NULL when not cached
+   * The buffer remains owned by the cache.
+   */
+  static MemoryBuffer *find(uint64_t key);
+
+  /**
+   * \brief add a result of \a tree to the cache, which takes ownership of \a buffer
+   */
+  static void add(uint64_t key, MemoryBuffer *buffer, const bNodeTree *tree);
+
+  /**
+   * \brief free the least recently used results until the cache is below \a limit bytes
+   * Call after execution, the results used by the last execution are freed last.
+   */
+  static void trim(size_t limit);
+
+  /**
+   * \brief free the cached results added for \a tree
+   */
+  static void clear(const bNodeTree *tree);
+
+  /**
+   * \brief free all cached results
+   */
+  static void clear();
+
+  /**
+   * \brief memory used by the cached results in bytes
+   */
+  static size_t size();
+};
+
+#endif /* __COM_RESULTCACHE_H__ */
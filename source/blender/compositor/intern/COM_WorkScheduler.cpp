@@ -24,6 +24,7 @@
 #include "COM_CPUDevice.h"
 #include "COM_OpenCLDevice.h"
 #include "COM_OpenCLKernels.cl.h"
+#include "COM_Profiler.h"
 #include "clew.h"
 #include "COM_WriteBufferOperation.h"
 
@@ -47,6 +48,8 @@
 /// \brief list of all CPUDevices. for every hardware thread an instance of CPUDevice is created
 static vector<CPUDevice *> g_cpudevices;
 static ThreadLocal(CPUDevice *) g_thread_device;
+/// \brief profiler of the current execution, see CompositorContext.getProfiler
+static Profiler *g_profiler = NULL;
 
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
 /// \brief list of all thread for every CPUDevice in cpudevices a thread exists
@@ -71,6 +74,22 @@ static bool g_openclInitialized = false;
 #  endif
 #endif
 
+/// \brief execute \a work on \a device, adding its time to the profiler
+static void work_scheduler_execute(Device *device, WorkPackage *work, int thread)
+{
+  if (g_profiler == NULL) {
+    device->execute(work);
+    return;
+  }
+  const double start = PIL_check_seconds_timer();
+  device->execute(work);
+  g_profiler->addChunk(work->getExecutionGroup(),
+                       work->getChunkNumber(),
+                       thread,
+                       start,
+                       PIL_check_seconds_timer() - start);
+}
+
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
 void *WorkScheduler::thread_execute_cpu(void *data)
 {
@@ -78,7 +97,7 @@ void *WorkScheduler::thread_execute_cpu(void *data)
   WorkPackage *work;
   BLI_thread_local_set(g_thread_device, device);
   while ((work = (WorkPackage *)BLI_thread_queue_pop(g_cpuqueue))) {
-    device->execute(work);
+    work_scheduler_execute(device, work, device->thread_id());
     delete work;
   }
 
@@ -91,7 +110,8 @@ void *WorkScheduler::thread_execute_gpu(void *data)
   WorkPackage *work;
 
   while ((work = (WorkPackage *)BLI_thread_queue_pop(g_gpuqueue))) {
-    device->execute(work);
+    /* GPU work is traced after the CPU threads. */
+    work_scheduler_execute(device, work, g_cpudevices.size());
     delete work;
   }
 
@@ -104,7 +124,7 @@ void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber)
   WorkPackage *package = new WorkPackage(group, chunkNumber);
 #if COM_CURRENT_THREADING_MODEL == COM_TM_NOTHREAD
   CPUDevice device(0);
-  device.execute(package);
+  work_scheduler_execute(&device, package, 0);
   delete package;
 #elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
 #  ifdef COM_OPENCL_ENABLED
@@ -122,6 +142,7 @@ void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber)
 
 void WorkScheduler::start(CompositorContext &context)
 {
+  g_profiler = context.getProfiler();
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
   unsigned int index;
   g_cpuqueue = BLI_thread_queue_init();
@@ -164,6 +185,7 @@ void WorkScheduler::finish()
 }
 void WorkScheduler::stop()
 {
+  g_profiler = NULL;
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
   BLI_thread_queue_nowait(g_cpuqueue);
   BLI_threadpool_end(&g_cputhreads);
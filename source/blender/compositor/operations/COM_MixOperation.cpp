@@ -65,6 +65,52 @@ void MixBaseOperation::executePixelSampled(float output[4], float x, float y, Pi
   output[3] = inputColor1[3];
 }
 
+void MixBaseOperation::mixColors(float output[4],
+                                 float value,
+                                 const float color1[4],
+                                 const float color2[4]) const
+{
+  float valuem = 1.0f - value;
+  output[0] = valuem * (color1[0]) + value * (color2[0]);
+  output[1] = valuem * (color1[1]) + value * (color2[1]);
+  output[2] = valuem * (color1[2]) + value * (color2[2]);
+  output[3] = color1[3];
+}
+
+void MixBaseOperation::executeBufferRegion(MemoryBuffer *output,
+                                           rcti *rect,
+                                           MemoryBuffer **inputs)
+{
+  if (!this->readsInputBuffers()) {
+    /* Mixing not implemented by mixColors. */
+    NodeOperation::executeBufferRegion(output, rect, inputs);
+    return;
+  }
+
+  const int output_stride = output->getElemStride();
+  const int value_stride = inputs[0]->getElemStride();
+  const int color1_stride = inputs[1]->getElemStride();
+  const int color2_stride = inputs[2]->getElemStride();
+  const bool use_alpha = this->useValueAlphaMultiply();
+
+  for (int y = rect->ymin; y < rect->ymax; y++) {
+    float *out = output->getElem(rect->xmin, y);
+    const float *value = inputs[0]->getElem(rect->xmin, y);
+    const float *color1 = inputs[1]->getElem(rect->xmin, y);
+    const float *color2 = inputs[2]->getElem(rect->xmin, y);
+
+    for (int x = rect->xmin; x < rect->xmax; x++) {
+      mixColors(out, use_alpha ? value[0] * color2[3] : value[0], color1, color2);
+      clampIfNeeded(out);
+
+      out += output_stride;
+      value += value_stride;
+      color1 += color1_stride;
+      color2 += color2_stride;
+    }
+  }
+}
+
 void MixBaseOperation::determineResolution(unsigned int resolution[2],
                                            unsigned int preferredResolution[2])
 {
@@ -101,7 +147,18 @@ void MixBaseOperation::deinitExecution()
 
 MixAddOperation::MixAddOperation() : MixBaseOperation()
 {
-  /* pass */
+  this->setReadsInputBuffers(true);
+}
+
+void MixAddOperation::mixColors(float output[4],
+                                float value,
+                                const float color1[4],
+                                const float color2[4]) const
+{
+  output[0] = color1[0] + value * color2[0];
+  output[1] = color1[1] + value * color2[1];
+  output[2] = color1[2] + value * color2[2];
+  output[3] = color1[3];
 }
 
 void MixAddOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
@@ -118,10 +175,7 @@ void MixAddOperation::executePixelSampled(float output[4], float x, float y, Pix
   if (this->useValueAlphaMultiply()) {
     value *= inputColor2[3];
   }
-  output[0] = inputColor1[0] + value * inputColor2[0];
-  output[1] = inputColor1[1] + value * inputColor2[1];
-  output[2] = inputColor1[2] + value * inputColor2[2];
-  output[3] = inputColor1[3];
+  mixColors(output, value, inputColor1, inputColor2);
 
   clampIfNeeded(output);
 }
@@ -130,7 +184,8 @@ void MixAddOperation::executePixelSampled(float output[4], float x, float y, Pix
 
 MixBlendOperation::MixBlendOperation() : MixBaseOperation()
 {
-  /* pass */
+  /* Blending is the mixColors of the base class. */
+  this->setReadsInputBuffers(true);
 }
 
 void MixBlendOperation::executePixelSampled(float output[4],
@@ -141,21 +196,16 @@ void MixBlendOperation::executePixelSampled(float output[4],
   float inputColor1[4];
   float inputColor2[4];
   float inputValue[4];
-  float value;
 
   this->m_inputValueOperation->readSampled(inputValue, x, y, sampler);
   this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
   this->m_inputColor2Operation->readSampled(inputColor2, x, y, sampler);
-  value = inputValue[0];
 
+  float value = inputValue[0];
   if (this->useValueAlphaMultiply()) {
     value *= inputColor2[3];
   }
-  float valuem = 1.0f - value;
-  output[0] = valuem * (inputColor1[0]) + value * (inputColor2[0]);
-  output[1] = valuem * (inputColor1[1]) + value * (inputColor2[1]);
-  output[2] = valuem * (inputColor1[2]) + value * (inputColor2[2]);
-  output[3] = inputColor1[3];
+  mixColors(output, value, inputColor1, inputColor2);
 
   clampIfNeeded(output);
 }
@@ -678,7 +728,19 @@ void MixLinearLightOperation::executePixelSampled(float output[4],
 
 MixMultiplyOperation::MixMultiplyOperation() : MixBaseOperation()
 {
-  /* pass */
+  this->setReadsInputBuffers(true);
+}
+
+void MixMultiplyOperation::mixColors(float output[4],
+                                     float value,
+                                     const float color1[4],
+                                     const float color2[4]) const
+{
+  float valuem = 1.0f - value;
+  output[0] = color1[0] * (valuem + value * color2[0]);
+  output[1] = color1[1] * (valuem + value * color2[1]);
+  output[2] = color1[2] * (valuem + value * color2[2]);
+  output[3] = color1[3];
 }
 
 void MixMultiplyOperation::executePixelSampled(float output[4],
@@ -698,11 +760,7 @@ void MixMultiplyOperation::executePixelSampled(float output[4],
   if (this->useValueAlphaMultiply()) {
     value *= inputColor2[3];
   }
-  float valuem = 1.0f - value;
-  output[0] = inputColor1[0] * (valuem + value * inputColor2[0]);
-  output[1] = inputColor1[1] * (valuem + value * inputColor2[1]);
-  output[2] = inputColor1[2] * (valuem + value * inputColor2[2]);
-  output[3] = inputColor1[3];
+  mixColors(output, value, inputColor1, inputColor2);
 
   clampIfNeeded(output);
 }
@@ -883,7 +941,18 @@ void MixSoftLightOperation::executePixelSampled(float output[4],
 
 MixSubtractOperation::MixSubtractOperation() : MixBaseOperation()
 {
-  /* pass */
+  this->setReadsInputBuffers(true);
+}
+
+void MixSubtractOperation::mixColors(float output[4],
+                                     float value,
+                                     const float color1[4],
+                                     const float color2[4]) const
+{
+  output[0] = color1[0] - value * (color2[0]);
+  output[1] = color1[1] - value * (color2[1]);
+  output[2] = color1[2] - value * (color2[2]);
+  output[3] = color1[3];
 }
 
 void MixSubtractOperation::executePixelSampled(float output[4],
@@ -903,10 +972,7 @@ void MixSubtractOperation::executePixelSampled(float output[4],
   if (this->useValueAlphaMultiply()) {
     value *= inputColor2[3];
   }
-  output[0] = inputColor1[0] - value * (inputColor2[0]);
-  output[1] = inputColor1[1] - value * (inputColor2[1]);
-  output[2] = inputColor1[2] - value * (inputColor2[2]);
-  output[3] = inputColor1[3];
+  mixColors(output, value, inputColor1, inputColor2);
 
   clampIfNeeded(output);
 }
@@ -46,6 +46,15 @@ class MixBaseOperation : public NodeOperation {
     }
   }
 
+  /**
+   * Mix the colors of a pixel, for operations calculating regions from their input buffers.
+   * \see setReadsInputBuffers
+   */
+  virtual void mixColors(float output[4],
+                         float value,
+                         const float color1[4],
+                         const float color2[4]) const;
+
  public:
   /**
    * Default constructor
@@ -56,6 +65,7 @@ class MixBaseOperation : public NodeOperation {
    * the inner loop of this program
    */
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeBufferRegion(MemoryBuffer *output, rcti *rect, MemoryBuffer **inputs);
 
   /**
    * Initialize the execution
@@ -84,6 +94,12 @@ class MixBaseOperation : public NodeOperation {
 };
 
 class MixAddOperation : public MixBaseOperation {
+ protected:
+  void mixColors(float output[4],
+                 float value,
+                 const float color1[4],
+                 const float color2[4]) const;
+
  public:
   MixAddOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
@@ -156,6 +172,12 @@ class MixLinearLightOperation : public MixBaseOperation {
 };
 
 class MixMultiplyOperation : public MixBaseOperation {
+ protected:
+  void mixColors(float output[4],
+                 float value,
+                 const float color1[4],
+                 const float color2[4]) const;
+
  public:
   MixMultiplyOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
@@ -186,6 +208,12 @@ class MixSoftLightOperation : public MixBaseOperation {
 };
 
 class MixSubtractOperation : public MixBaseOperation {
+ protected:
+  void mixColors(float output[4],
+                 float value,
+                 const float color1[4],
+                 const float color2[4]) const;
+
  public:
   MixSubtractOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
@@ -131,3 +131,11 @@ void ReadBufferOperation::updateMemoryBuffer()
 {
   this->m_buffer = this->getMemoryProxy()->getBuffer();
 }
+
+void ReadBufferOperation::setMemoryBuffer(MemoryBuffer *buffer, const unsigned int resolution[2])
+{
+  this->m_buffer = buffer;
+  this->m_single_value = buffer->isSingleElem();
+  this->setWidth(resolution[0]);
+  this->setHeight(resolution[1]);
+}
@@ -72,6 +72,13 @@ class ReadBufferOperation : public NodeOperation {
   }
   void readResolutionFromWriteBuffer();
   void updateMemoryBuffer();
+
+  /**
+   * Read from \a buffer instead of a MemoryProxy, used by full-frame execution to give operations
+   * the result of another operation.
+   * \param resolution: the resolution of the operation which calculated \a buffer
+   */
+  void setMemoryBuffer(MemoryBuffer *buffer, const unsigned int resolution[2]);
 };
 
 #endif
@@ -31,6 +31,13 @@ void SetColorOperation::executePixelSampled(float output[4],
   copy_v4_v4(output, this->m_color);
 }
 
+void SetColorOperation::executeBufferRegion(MemoryBuffer *output,
+                                            rcti *rect,
+                                            MemoryBuffer ** /*inputs*/)
+{
+  output->fill(rect, this->m_color);
+}
+
 void SetColorOperation::determineResolution(unsigned int resolution[2],
                                             unsigned int preferredResolution[2])
 {
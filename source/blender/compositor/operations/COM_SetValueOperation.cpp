@@ -31,6 +31,13 @@ void SetValueOperation::executePixelSampled(float output[4],
   output[0] = this->m_value;
 }
 
+void SetValueOperation::executeBufferRegion(MemoryBuffer *output,
+                                            rcti *rect,
+                                            MemoryBuffer ** /*inputs*/)
+{
+  output->fill(rect, &this->m_value);
+}
+
 void SetValueOperation::determineResolution(unsigned int resolution[2],
                                             unsigned int preferredResolution[2])
 {
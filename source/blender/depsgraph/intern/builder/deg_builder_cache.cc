@@ -152,10 +152,12 @@ bool AnimatedPropertyStorage::isPropertyAnimated(const PointerRNA *pointer_rna,
 
 DepsgraphBuilderCache::DepsgraphBuilderCache()
 {
+  BLI_spin_init(&lock_);
 }
 
 DepsgraphBuilderCache::~DepsgraphBuilderCache()
 {
+  BLI_spin_end(&lock_);
   for (AnimatedPropertyStorageMap::value_type &iter : animated_property_storage_map_) {
     AnimatedPropertyStorage *animated_property_storage = iter.second;
     OBJECT_GUARDED_DELETE(animated_property_storage, AnimatedPropertyStorage);
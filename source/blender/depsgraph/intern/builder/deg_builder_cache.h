@@ -23,6 +23,8 @@
 
 #pragma once
 
+#include "BLI_threads.h"
+
 #include "intern/depsgraph_type.h"
 
 #include "RNA_access.h"
@@ -92,12 +94,18 @@ class DepsgraphBuilderCache {
    * the better name? */
   template<typename... Args> bool isPropertyAnimated(ID *id, Args... args)
   {
+    BLI_spin_lock(&lock_);
     AnimatedPropertyStorage *animated_property_storage = ensureInitializedAnimatedPropertyStorage(
         id);
-    return animated_property_storage->isPropertyAnimated(args...);
+    const bool is_animated = animated_property_storage->isPropertyAnimated(args...);
+    BLI_spin_unlock(&lock_);
+    return is_animated;
   }
 
   AnimatedPropertyStorageMap animated_property_storage_map_;
+
+  /* Storages are created on demand, also by the relations builder threads. */
+  SpinLock lock_;
 };
 
 }  // namespace DEG
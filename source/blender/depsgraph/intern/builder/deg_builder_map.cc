@@ -29,10 +29,12 @@ namespace DEG {
 
 BuilderMap::BuilderMap()
 {
+  BLI_spin_init(&lock_);
 }
 
 BuilderMap::~BuilderMap()
 {
+  BLI_spin_end(&lock_);
 }
 
 bool BuilderMap::checkIsBuilt(ID *id, int tag) const
@@ -42,33 +44,39 @@ bool BuilderMap::checkIsBuilt(ID *id, int tag) const
 
 void BuilderMap::tagBuild(ID *id, int tag)
 {
+  BLI_spin_lock(&lock_);
   IDTagMap::iterator it = id_tags_.find(id);
   if (it == id_tags_.end()) {
     id_tags_.insert(make_pair(id, tag));
-    return;
   }
-  it->second |= tag;
+  else {
+    it->second |= tag;
+  }
+  BLI_spin_unlock(&lock_);
 }
 
 bool BuilderMap::checkIsBuiltAndTag(ID *id, int tag)
 {
+  BLI_spin_lock(&lock_);
   IDTagMap::iterator it = id_tags_.find(id);
   if (it == id_tags_.end()) {
     id_tags_.insert(make_pair(id, tag));
+    BLI_spin_unlock(&lock_);
     return false;
   }
   const bool result = (it->second & tag) == tag;
   it->second |= tag;
+  BLI_spin_unlock(&lock_);
   return result;
 }
 
 int BuilderMap::getIDTag(ID *id) const
 {
+  BLI_spin_lock(&lock_);
   IDTagMap::const_iterator it = id_tags_.find(id);
-  if (it == id_tags_.end()) {
-    return 0;
-  }
-  return it->second;
+  const int tag = (it != id_tags_.end()) ? it->second : 0;
+  BLI_spin_unlock(&lock_);
+  return tag;
 }
 
 }  // namespace DEG
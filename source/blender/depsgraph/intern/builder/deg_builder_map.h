@@ -23,6 +23,8 @@
 
 #pragma once
 
+#include "BLI_threads.h"
+
 #include "intern/depsgraph_type.h"
 
 struct ID;
@@ -77,6 +79,9 @@ class BuilderMap {
 
   typedef map<ID *, int> IDTagMap;
   IDTagMap id_tags_;
+
+  /* The relations builder checks and tags IDs from multiple threads. */
+  mutable SpinLock lock_;
 };
 
 }  // namespace DEG
@@ -25,6 +25,7 @@
 
 #include "intern/builder/deg_builder_relations.h"
 
+#include <algorithm>
 #include <stdio.h>
 #include <stdlib.h>
 #include <cstring> /* required for STREQ later on. */
@@ -33,6 +34,7 @@
 
 #include "BLI_utildefines.h"
 #include "BLI_blenlib.h"
+#include "BLI_task.h"
 
 extern "C" {
 #include "DNA_action_types.h"
@@ -75,6 +77,7 @@ extern "C" {
 #include "BKE_effect.h"
 #include "BKE_collision.h"
 #include "BKE_fcurve.h"
+#include "BKE_global.h"
 #include "BKE_image.h"
 #include "BKE_key.h"
 #include "BKE_layer.h"
@@ -234,8 +237,51 @@ bool object_have_geometry_component(const Object *object)
   return ELEM(object->type, OB_MESH, OB_CURVE, OB_FONT, OB_SURF, OB_MBALL, OB_LATTICE, OB_GPENCIL);
 }
 
+/* Nodes are compared by their custom flags, which hold the operation indices while sorting. */
+bool relation_order_less(const Relation *a, const Relation *b)
+{
+  if (a->from->custom_flags != b->from->custom_flags) {
+    return a->from->custom_flags < b->from->custom_flags;
+  }
+  if (a->to->custom_flags != b->to->custom_flags) {
+    return a->to->custom_flags < b->to->custom_flags;
+  }
+  const int name_order = strcmp(a->name, b->name);
+  if (name_order != 0) {
+    return name_order < 0;
+  }
+  return a->flag < b->flag;
+}
+
+/* Relations added from multiple threads are stored in the order they were added in, which
+ * differs between builds. Sort them by the operations they connect, so that traversals of the
+ * graph, and with them the relations chosen to break dependency cycles, are the same for every
+ * build. */
+void sort_relations(Depsgraph *graph)
+{
+  int index = 0;
+  for (OperationNode *op_node : graph->operations) {
+    op_node->custom_flags = index++;
+  }
+  TimeSourceNode *time_source = graph->time_source;
+  time_source->custom_flags = -1;
+  std::sort(time_source->outlinks.begin(), time_source->outlinks.end(), relation_order_less);
+  for (OperationNode *op_node : graph->operations) {
+    std::sort(op_node->inlinks.begin(), op_node->inlinks.end(), relation_order_less);
+    std::sort(op_node->outlinks.begin(), op_node->outlinks.end(), relation_order_less);
+  }
+  for (OperationNode *op_node : graph->operations) {
+    op_node->custom_flags = 0;
+  }
+  time_source->custom_flags = 0;
+}
+
 }  // namespace
 
+/* Scenes with fewer bases are built on a single thread, sorting the relations afterwards would
+ * cost more than what is gained. */
+#define DEG_RELATIONS_PARALLEL_MIN_BASES 1024
+
 /* **** General purpose functions ****  */
 
 DepsgraphRelationBuilder::DepsgraphRelationBuilder(Main *bmain,
@@ -243,6 +289,12 @@ DepsgraphRelationBuilder::DepsgraphRelationBuilder(Main *bmain,
                                                    DepsgraphBuilderCache *cache)
     : DepsgraphBuilder(bmain, graph, cache), scene_(nullptr), rna_node_query_(graph, this)
 {
+  BLI_spin_init(&lock_);
+}
+
+DepsgraphRelationBuilder::~DepsgraphRelationBuilder()
+{
+  BLI_spin_end(&lock_);
 }
 
 TimeSourceNode *DepsgraphRelationBuilder::get_node(const TimeSourceKey &key) const
@@ -284,7 +336,10 @@ OperationNode *DepsgraphRelationBuilder::get_node(const OperationKey &key) const
 
 Node *DepsgraphRelationBuilder::get_node(const RNAPathKey &key)
 {
-  return rna_node_query_.find_node(&key.ptr, key.prop, key.source);
+  BLI_spin_lock(&lock_);
+  Node *node = rna_node_query_.find_node(&key.ptr, key.prop, key.source);
+  BLI_spin_unlock(&lock_);
+  return node;
 }
 
 OperationNode *DepsgraphRelationBuilder::find_node(const OperationKey &key) const
@@ -326,7 +381,9 @@ void DepsgraphRelationBuilder::add_customdata_mask(Object *object,
       BLI_assert(!"ID should always be valid");
     }
     else {
+      BLI_spin_lock(&lock_);
       id_node->customdata_masks |= customdata_masks;
+      BLI_spin_unlock(&lock_);
     }
   }
 }
@@ -338,7 +395,9 @@ void DepsgraphRelationBuilder::add_special_eval_flag(ID *id, uint32_t flag)
     BLI_assert(!"ID should always be valid");
   }
   else {
+    BLI_spin_lock(&lock_);
     id_node->eval_flags |= flag;
+    BLI_spin_unlock(&lock_);
   }
 }
 
@@ -348,7 +407,10 @@ Relation *DepsgraphRelationBuilder::add_time_relation(TimeSourceNode *timesrc,
                                                       int flags)
 {
   if (timesrc && node_to) {
-    return graph_->add_new_relation(timesrc, node_to, description, flags);
+    BLI_spin_lock(&lock_);
+    Relation *rel = graph_->add_new_relation(timesrc, node_to, description, flags);
+    BLI_spin_unlock(&lock_);
+    return rel;
   }
   else {
     DEG_DEBUG_PRINTF((::Depsgraph *)graph_,
@@ -369,7 +431,10 @@ Relation *DepsgraphRelationBuilder::add_operation_relation(OperationNode *node_f
                                                            int flags)
 {
   if (node_from && node_to) {
-    return graph_->add_new_relation(node_from, node_to, description, flags);
+    BLI_spin_lock(&lock_);
+    Relation *rel = graph_->add_new_relation(node_from, node_to, description, flags);
+    BLI_spin_unlock(&lock_);
+    return rel;
   }
   else {
     DEG_DEBUG_PRINTF((::Depsgraph *)graph_,
@@ -601,6 +666,32 @@ void DepsgraphRelationBuilder::build_collection(LayerCollection *from_layer_coll
   }
 }
 
+void DepsgraphRelationBuilder::build_object_base_cb(void *__restrict userdata,
+                                                    const int index,
+                                                    const TaskParallelTLS *__restrict /*tls*/)
+{
+  BuildObjectBasesTaskData *data = (BuildObjectBasesTaskData *)userdata;
+  Base *base = (*data->bases)[index];
+  data->builder->build_object(base, base->object);
+}
+
+/* Objects only add relations between nodes which already exist, so the bases are built in
+ * parallel. IDs shared between objects are still built once, by whichever thread reaches them
+ * first through the built map. */
+void DepsgraphRelationBuilder::build_object_bases(const vector<Base *> &bases)
+{
+  BuildObjectBasesTaskData data = {this, &bases};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (bases.size() >= DEG_RELATIONS_PARALLEL_MIN_BASES) &&
+                           (G.debug & G_DEBUG_DEPSGRAPH_NO_THREADS) == 0;
+  settings.min_iter_per_thread = 64;
+  BLI_task_parallel_range(0, bases.size(), &data, build_object_base_cb, &settings);
+  if (settings.use_threading) {
+    sort_relations(graph_);
+  }
+}
+
 void DepsgraphRelationBuilder::build_object(Base *base, Object *object)
 {
   if (built_map_.checkIsBuiltAndTag(object)) {
@@ -1265,7 +1356,9 @@ void DepsgraphRelationBuilder::build_animdata_curves_targets(ID *id,
     if (!RNA_path_resolve_full(&id_ptr, fcu->rna_path, &ptr, &prop, &index)) {
       continue;
     }
+    BLI_spin_lock(&lock_);
     Node *node_to = rna_node_query_.find_node(&ptr, prop, RNAPointerSource::ENTRY);
+    BLI_spin_unlock(&lock_);
     if (node_to == nullptr) {
       continue;
     }
@@ -1278,7 +1371,7 @@ void DepsgraphRelationBuilder::build_animdata_curves_targets(ID *id,
       add_relation(adt_key, pose_init_key, "Animation -> Prop", RELATION_CHECK_BEFORE_ADD);
       continue;
     }
-    graph_->add_new_relation(
+    add_operation_relation(
         operation_from, operation_to, "Animation -> Prop", RELATION_CHECK_BEFORE_ADD);
     /* It is possible that animation is writing to a nested ID data-block,
      * need to make sure animation is evaluated after target ID is copied. */
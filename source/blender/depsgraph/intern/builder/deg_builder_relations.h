@@ -81,6 +81,7 @@ struct bPoseChannel;
 struct bSound;
 
 struct PropertyRNA;
+struct TaskParallelTLS;
 
 namespace DEG {
 
@@ -158,6 +159,7 @@ struct RNAPathKey {
 class DepsgraphRelationBuilder : public DepsgraphBuilder {
  public:
   DepsgraphRelationBuilder(Main *bmain, Depsgraph *graph, DepsgraphBuilderCache *cache);
+  ~DepsgraphRelationBuilder();
 
   void begin_build();
 
@@ -207,6 +209,7 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
                                 Object *object,
                                 Collection *collection);
   virtual void build_object(Base *base, Object *object);
+  virtual void build_object_bases(const vector<Base *> &bases);
   virtual void build_object_proxy_from(Object *object);
   virtual void build_object_proxy_group(Object *object);
   virtual void build_object_flags(Base *base, Object *object);
@@ -355,11 +358,24 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
 
   static void constraint_walk(bConstraint *con, ID **idpoin, bool is_reference, void *user_data);
 
+  struct BuildObjectBasesTaskData {
+    DepsgraphRelationBuilder *builder;
+    const vector<Base *> *bases;
+  };
+
+  static void build_object_base_cb(void *__restrict userdata,
+                                   const int index,
+                                   const TaskParallelTLS *__restrict tls);
+
   /* State which demotes currently built entities. */
   Scene *scene_;
 
   BuilderMap built_map_;
   RNANodeQuery rna_node_query_;
+
+  /* Guards the relations of the graph, the flags of its ID nodes and the RNA node query while
+   * objects are built from multiple threads. */
+  SpinLock lock_;
 };
 
 struct DepsNodeHandle {
@@ -96,11 +96,13 @@ void DepsgraphRelationBuilder::build_view_layer(Scene *scene,
   /* NOTE: Nodes builder requires us to pass CoW base because it's being
    * passed to the evaluation functions. During relations builder we only
    * do nullptr-pointer check of the base, so it's fine to pass original one. */
+  vector<Base *> bases;
   LISTBASE_FOREACH (Base *, base, &view_layer->object_bases) {
     if (need_pull_base_into_graph(base)) {
-      build_object(base, base->object);
+      bases.push_back(base);
     }
   }
+  build_object_bases(bases);
 
   build_layer_collections(&view_layer->layer_collections);
 
@@ -246,17 +246,36 @@ void DEG_graph_build_from_view_layer(Depsgraph *graph,
   node_builder.begin_build();
   node_builder.build_view_layer(scene, view_layer, DEG::DEG_ID_LINKED_DIRECTLY);
   node_builder.end_build();
+  double nodes_time = 0.0;
+  if (G.debug & G_DEBUG_DEPSGRAPH_TIME) {
+    nodes_time = PIL_check_seconds_timer();
+  }
   /* Hook up relationships between operations - to determine evaluation order. */
   DEG::DepsgraphRelationBuilder relation_builder(bmain, deg_graph, &builder_cache);
   relation_builder.begin_build();
   relation_builder.build_view_layer(scene, view_layer, DEG::DEG_ID_LINKED_DIRECTLY);
+  double relations_time = 0.0;
+  if (G.debug & G_DEBUG_DEPSGRAPH_TIME) {
+    relations_time = PIL_check_seconds_timer();
+  }
   relation_builder.build_copy_on_write_relations();
+  double copy_on_write_time = 0.0;
+  if (G.debug & G_DEBUG_DEPSGRAPH_TIME) {
+    copy_on_write_time = PIL_check_seconds_timer();
+  }
   /* Finalize building. */
   graph_build_finalize_common(deg_graph, bmain);
   /* Finish statistics. */
   if (G.debug & (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_TIME)) {
     printf("Depsgraph built in %f seconds.\n", PIL_check_seconds_timer() - start_time);
   }
+  if (G.debug & G_DEBUG_DEPSGRAPH_TIME) {
+    printf("  Nodes: %f, relations: %f, copy-on-write relations: %f, finalize: %f seconds.\n",
+           nodes_time - start_time,
+           relations_time - nodes_time,
+           copy_on_write_time - relations_time,
+           PIL_check_seconds_timer() - copy_on_write_time);
+  }
 }
 
 void DEG_graph_build_for_render_pipeline(Depsgraph *graph,
@@ -163,8 +163,11 @@ void DEG_add_forcefield_relations(DepsNodeHandle *handle,
 
 namespace DEG {
 
+/* NOTE: Relations of objects are built from multiple threads, the relations caches are shared
+ * by all of them. */
 ListBase *build_effector_relations(Depsgraph *graph, Collection *collection)
 {
+  BLI_spin_lock(&graph->lock);
   GHash *hash = graph->physics_relations[DEG_PHYSICS_EFFECTOR];
   if (hash == nullptr) {
     graph->physics_relations[DEG_PHYSICS_EFFECTOR] = BLI_ghash_ptr_new(
@@ -177,6 +180,7 @@ ListBase *build_effector_relations(Depsgraph *graph, Collection *collection)
     relations = BKE_effector_relations_create(depsgraph, graph->view_layer, collection);
     BLI_ghash_insert(hash, &collection->id, relations);
   }
+  BLI_spin_unlock(&graph->lock);
   return relations;
 }
 
@@ -185,6 +189,7 @@ ListBase *build_collision_relations(Depsgraph *graph,
                                     unsigned int modifier_type)
 {
   const ePhysicsRelationType type = modifier_to_relation_type(modifier_type);
+  BLI_spin_lock(&graph->lock);
   GHash *hash = graph->physics_relations[type];
   if (hash == nullptr) {
     graph->physics_relations[type] = BLI_ghash_ptr_new("Depsgraph physics relations hash");
@@ -196,6 +201,7 @@ ListBase *build_collision_relations(Depsgraph *graph,
     relations = BKE_collision_relations_create(depsgraph, collection, modifier_type);
     BLI_ghash_insert(hash, &collection->id, relations);
   }
+  BLI_spin_unlock(&graph->lock);
   return relations;
 }
 
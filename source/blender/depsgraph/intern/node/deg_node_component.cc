@@ -280,7 +280,8 @@ OperationNode *ComponentNode::get_entry_operation()
       op_node = tmp;
     }
     GHASH_FOREACH_END();
-    /* Cache for the subsequent usage. */
+    /* Cache for the subsequent usage.
+     * NOTE: Relations are built from multiple threads, they all store the same operation. */
     entry_operation = op_node;
     return op_node;
   }
@@ -20,10 +20,13 @@
  * Wrapper between 'ED_undo.h' and 'BKE_undo_system.h' API's.
  */
 
+#include "CLG_log.h"
+
 #include "BLI_utildefines.h"
 #include "BLI_sys_types.h"
 
 #include "DNA_object_enums.h"
+#include "DNA_userdef_types.h"
 
 #include "BKE_blender_undo.h"
 #include "BKE_context.h"
@@ -41,6 +44,8 @@
 
 #include "undo_intern.h"
 
+static CLG_LogRef LOG = {"ed.undo.memfile"};
+
 /* -------------------------------------------------------------------- */
 /** \name Implements ED Undo System
  * \{ */
@@ -85,16 +90,81 @@ static bool memfile_undosys_step_encode(struct bContext *UNUSED(C),
   us->data = BKE_memfile_undo_encode(bmain, us_prev ? us_prev->data : NULL);
   us->step.data_size = us->data->undo_size;
 
+  if (CLOG_CHECK(&LOG, 1)) {
+    /* Memory saved by sharing chunks between all global undo steps. */
+    MemFileChunkStats stats;
+    BLO_memfile_chunk_stats_get(&stats);
+    CLOG_INFO(&LOG,
+              1,
+              "step_size=%zu, chunks=%zu (%zu bytes), unique=%zu (%zu bytes)",
+              us->step.data_size,
+              stats.num_chunks,
+              stats.size_chunks,
+              stats.num_buffers,
+              stats.size_buffers);
+  }
+
   return true;
 }
 
+/**
+ * Check there are only global undo steps from \a us_a to \a us_b (in either direction),
+ * steps of other types modify data-blocks without writing them to a memfile.
+ */
+static bool memfile_undosys_steps_are_memfile(UndoStep *us_a, UndoStep *us_b)
+{
+  for (UndoStep *us_iter = us_a; us_iter; us_iter = us_iter->next) {
+    if (us_iter->type != BKE_UNDOSYS_TYPE_MEMFILE) {
+      break;
+    }
+    if (us_iter == us_b) {
+      return true;
+    }
+  }
+  for (UndoStep *us_iter = us_a; us_iter; us_iter = us_iter->prev) {
+    if (us_iter->type != BKE_UNDOSYS_TYPE_MEMFILE) {
+      break;
+    }
+    if (us_iter == us_b) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * The undo data matching the data-blocks currently in memory, if it's known to match,
+ * so unchanged data-blocks can be reused when decoding \a us_target.
+ */
+static MemFileUndoData *memfile_undosys_step_reference_get(struct Main *bmain,
+                                                           UndoStep *us_target)
+{
+  if (!USER_EXPERIMENTAL_TEST(&U, use_undo_speedup) || bmain->is_memfile_undo_flush_needed) {
+    return NULL;
+  }
+
+  UndoStack *ustack = ED_undo_stack_get();
+  UndoStep *us_reference = ustack->step_active_memfile;
+  if ((us_reference == NULL) || (ustack->step_active == NULL)) {
+    return NULL;
+  }
+  if (!memfile_undosys_steps_are_memfile(us_reference, ustack->step_active) ||
+      !memfile_undosys_steps_are_memfile(us_reference, us_target)) {
+    return NULL;
+  }
+  return ((MemFileUndoStep *)us_reference)->data;
+}
+
 static void memfile_undosys_step_decode(
     struct bContext *C, struct Main *bmain, UndoStep *us_p, int UNUSED(dir), bool UNUSED(is_final))
 {
+  /* Before exiting editors, which may flush changes to the data-blocks. */
+  MemFileUndoData *data_reference = memfile_undosys_step_reference_get(bmain, us_p);
+
   ED_editors_exit(bmain, false);
 
   MemFileUndoStep *us = (MemFileUndoStep *)us_p;
-  BKE_memfile_undo_decode(us->data, C);
+  BKE_memfile_undo_decode(us->data, data_reference, C);
 
   for (UndoStep *us_iter = us_p->next; us_iter; us_iter = us_iter->next) {
     if (BKE_UNDOSYS_TYPE_IS_MEMFILE_SKIP(us_iter->type)) {
@@ -160,6 +160,14 @@ struct ImBuf *IMB_allocFromBuffer(const unsigned int *rect,
 void IMB_refImBuf(struct ImBuf *ibuf);
 struct ImBuf *IMB_makeSingleUser(struct ImBuf *ibuf);
 
+/**
+ * Give the contents of the buffer a new #ImBuf.update_counter,
+ * call after modifying pixels so caches of derived data can tell.
+ *
+ * \attention Defined in allocimbuf.c
+ */
+void IMB_tag_update(struct ImBuf *ibuf);
+
 /**
  *
  * \attention Defined in allocimbuf.c
@@ -324,6 +332,9 @@ IMB_Proxy_Size IMB_anim_proxy_get_existing(struct anim *anim);
 
 struct IndexBuildContext;
 
+/* Threads decoding the movie of one proxies/timecodes builder. */
+#define IMB_INDEX_BUILD_DECODE_THREADS 4
+
 /* prepare context for proxies/imecodes builder */
 struct IndexBuildContext *IMB_anim_index_rebuild_context(struct anim *anim,
                                                          IMB_Timecode_Type tcs_in_use,
@@ -452,6 +463,26 @@ bool IMB_scalefastImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy
  */
 void IMB_scaleImBuf_threaded(struct ImBuf *ibuf, unsigned int newx, unsigned int newy);
 
+typedef enum IMB_ScaleFilter {
+  /** Box when shrinking and bilinear when enlarging an axis, used by #IMB_scaleImBuf. */
+  IMB_SCALE_FILTER_DEFAULT = 0,
+  IMB_SCALE_FILTER_BOX = 1,
+  IMB_SCALE_FILTER_BILINEAR = 2,
+  IMB_SCALE_FILTER_BICUBIC = 3,
+  IMB_SCALE_FILTER_LANCZOS = 4,
+} IMB_ScaleFilter;
+
+/**
+ * Resample the byte and float buffers with a separable filter, multithreaded.
+ * Return true if \a ibuf is modified.
+ *
+ * \attention Defined in scaling.c
+ */
+bool IMB_scaleImBuf_filter(struct ImBuf *ibuf,
+                           unsigned int newx,
+                           unsigned int newy,
+                           IMB_ScaleFilter filter);
+
 /**
  *
  * \attention Defined in writeimage.c
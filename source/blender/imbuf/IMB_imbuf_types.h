@@ -221,6 +221,8 @@ typedef struct ImBuf {
   struct MEM_CacheLimiterHandle_s *c_handle;
   /** reference counter for multiple users */
   int refcounter;
+  /** unique for the contents of the buffer, changed by #IMB_tag_update */
+  unsigned int update_counter;
 
   /* some parameters to pass along for packing images */
   /** Compressed image only used with png and exr currently */
@@ -291,6 +293,8 @@ enum {
   IB_alphamode_ignore = 1 << 15,
   IB_thumbnail = 1 << 16,
   IB_multiview = 1 << 17,
+  /** multilayer passes are only decoded when requested, see #IMB_exr_read_pass */
+  IB_multilayer_lazy = 1 << 18,
 };
 
 /** \} */
@@ -40,6 +40,20 @@ typedef void *(*MovieCacheGetPriorityDataFP)(void *userkey);
 typedef int (*MovieCacheGetItemPriorityFP)(void *last_userkey, void *priority_data);
 typedef void (*MovieCachePriorityDeleterFP)(void *priority_data);
 
+typedef struct MovieCacheStats {
+  /** Frames in memory, and the memory they use in bytes. */
+  int num_items;
+  size_t memory;
+  /** Cold frames kept compressed instead of being freed, and their compressed size. */
+  int num_compressed;
+  size_t compressed_memory;
+  /** Seconds it took to create the cached frames, as passed to #IMB_moviecache_put_ex. */
+  float cost;
+
+  int hits, misses;
+  int compressions, decompressions, evictions;
+} MovieCacheStats;
+
 void IMB_moviecache_init(void);
 void IMB_moviecache_destruct(void);
 
@@ -53,8 +67,13 @@ void IMB_moviecache_set_priority_callback(struct MovieCache *cache,
                                           MovieCacheGetPriorityDataFP getprioritydatafp,
                                           MovieCacheGetItemPriorityFP getitempriorityfp,
                                           MovieCachePriorityDeleterFP prioritydeleterfp);
+void IMB_moviecache_set_compression(struct MovieCache *cache, bool use_compression);
 
 void IMB_moviecache_put(struct MovieCache *cache, void *userkey, struct ImBuf *ibuf);
+void IMB_moviecache_put_ex(struct MovieCache *cache,
+                           void *userkey,
+                           struct ImBuf *ibuf,
+                           float cost);
 bool IMB_moviecache_put_if_possible(struct MovieCache *cache, void *userkey, struct ImBuf *ibuf);
 struct ImBuf *IMB_moviecache_get(struct MovieCache *cache, void *userkey);
 void IMB_moviecache_remove(struct MovieCache *cache, void *userkey);
@@ -70,6 +89,9 @@ void IMB_moviecache_cleanup(struct MovieCache *cache,
 void IMB_moviecache_get_cache_segments(
     struct MovieCache *cache, int proxy, int render_flags, int *totseg_r, int **points_r);
 
+void IMB_moviecache_get_stats(struct MovieCache *cache, MovieCacheStats *r_stats);
+void IMB_moviecache_print_stats(void);
+
 struct MovieCacheIter;
 struct MovieCacheIter *IMB_moviecacheIter_new(struct MovieCache *cache);
 void IMB_moviecacheIter_free(struct MovieCacheIter *iter);
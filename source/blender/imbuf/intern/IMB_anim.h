@@ -81,6 +81,7 @@
 
 #define MAXNUMSTREAMS 50
 
+struct AnimPrefetch;
 struct IDProperty;
 struct _AviMovie;
 struct anim_index;
@@ -137,6 +138,9 @@ struct anim {
   int64_t last_pts;
   int64_t next_pts;
   AVPacket next_packet;
+
+  /* Decodes ahead during sequential playback, created on demand. */
+  struct AnimPrefetch *prefetch;
 #endif
 
   char index_dir[768];
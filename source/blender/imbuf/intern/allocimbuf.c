@@ -38,6 +38,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "BLI_utildefines.h"
 #include "BLI_threads.h"
 
@@ -243,6 +245,13 @@ void IMB_refImBuf(ImBuf *ibuf)
   BLI_spin_unlock(&refcounter_spin);
 }
 
+static unsigned int imb_update_counter = 0;
+
+void IMB_tag_update(ImBuf *ibuf)
+{
+  ibuf->update_counter = atomic_add_and_fetch_u(&imb_update_counter, 1);
+}
+
 ImBuf *IMB_makeSingleUser(ImBuf *ibuf)
 {
   ImBuf *rval;
@@ -507,6 +516,7 @@ bool IMB_initImBuf(
   ibuf->channels = 4;
   /* IMB_DPI_DEFAULT -> pixels-per-meter. */
   ibuf->ppm[0] = ibuf->ppm[1] = IMB_DPI_DEFAULT / 0.0254f;
+  IMB_tag_update(ibuf);
 
   if (flags & IB_rect) {
     if (imb_addrectImBuf(ibuf) == false) {
@@ -615,6 +625,7 @@ ImBuf *IMB_dupImBuf(const ImBuf *ibuf1)
   tbuf.mall = ibuf2->mall;
   tbuf.c_handle = NULL;
   tbuf.refcounter = 0;
+  tbuf.update_counter = ibuf2->update_counter;
 
   /* for now don't duplicate metadata */
   tbuf.metadata = NULL;
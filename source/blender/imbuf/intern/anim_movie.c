@@ -61,8 +61,14 @@
 #include "BLI_utildefines.h"
 #include "BLI_string.h"
 #include "BLI_path_util.h"
+#include "BLI_threads.h"
+
+#include "DNA_listBase.h"
 
 #include "MEM_guardedalloc.h"
+#include "MEM_CacheLimiterC-Api.h"
+
+#include "atomic_ops.h"
 
 #ifdef WITH_AVI
 #  include "AVI_avi.h"
@@ -205,6 +211,7 @@ static void free_anim_avi(struct anim *anim)
 
 #ifdef WITH_FFMPEG
 static void free_anim_ffmpeg(struct anim *anim);
+static void ffmpeg_prefetch_free(struct anim *anim);
 #endif
 
 void IMB_free_anim(struct anim *anim)
@@ -244,6 +251,10 @@ void IMB_close_anim_proxies(struct anim *anim)
     return;
   }
 
+#ifdef WITH_FFMPEG
+  /* The prefetch thread reads the time-code indices. */
+  ffmpeg_prefetch_free(anim);
+#endif
   IMB_free_indices(anim);
 }
 
@@ -486,6 +497,10 @@ static ImBuf *avi_fetchibuf(struct anim *anim, int position)
 
 #ifdef WITH_FFMPEG
 
+/* Threads of the decoder of one movie. Every frame thread keeps a frame in flight, which delays
+ * the first frame and adds up when several strips play at once, so use no more than this. */
+#  define FFMPEG_DECODE_THREADS 8
+
 BLI_INLINE bool need_aligned_ffmpeg_buffer(struct anim *anim)
 {
   return (anim->x & 31) != 0;
@@ -559,6 +574,10 @@ static int startffmpeg(struct anim *anim)
 
   pCodecCtx->workaround_bugs = 1;
 
+  /* Frame threading keeps several frames in flight, which suits sequential playback. */
+  pCodecCtx->thread_count = MIN2(BLI_system_thread_count(), FFMPEG_DECODE_THREADS);
+  pCodecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
   if (avcodec_open2(pCodecCtx, pCodec, NULL) < 0) {
     avformat_close_input(&pFormatCtx);
     return -1;
@@ -1207,12 +1226,316 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Typ
   return anim->last_frame;
 }
 
+/* Prefetching
+ *
+ * Once frames are requested sequentially, a worker thread decodes the frames following the last
+ * requested one into a small ring of ImBufs. The decoder state of the anim is shared, every
+ * ffmpeg_fetchibuf() call is done with decode_mutex held.
+ *
+ * The ring is not part of the cache limiter, so the memory of all rings is capped to a part of
+ * its limit. Prefetching stops and the ring is freed when frames are requested out of order,
+ * or when no frame was requested for a while, e.g. when playback stopped. */
+
+#  define FFMPEG_PREFETCH_FRAMES 6
+#  define FFMPEG_PREFETCH_IDLE_MS 1000
+
+typedef struct AnimPrefetchFrame {
+  int position;
+  IMB_Timecode_Type tc;
+  ImBuf *ibuf;
+  /* Memory reserved in ffmpeg_prefetch_memory. */
+  size_t size;
+} AnimPrefetchFrame;
+
+typedef struct AnimPrefetch {
+  ListBase threads;
+  ThreadMutex decode_mutex;
+  /* Wakes up the worker with every request, it stops when nothing arrives for a while. */
+  ThreadQueue *requests;
+
+  /* Guards everything below. */
+  ThreadMutex mutex;
+
+  AnimPrefetchFrame frames[FFMPEG_PREFETCH_FRAMES];
+
+  /* Last frame requested by the caller, frames after it are decoded. */
+  int position;
+  IMB_Timecode_Type tc;
+  /* Only decode ahead while the caller steps through frames one by one. */
+  bool sequential;
+  /* The caller is decoding a frame that missed the ring. */
+  bool fetching;
+  bool stop;
+  /* The worker stopped after it had nothing to do, the ring is empty. */
+  bool idle;
+} AnimPrefetch;
+
+/* Memory of the frames in the rings of all anims. */
+static size_t ffmpeg_prefetch_memory = 0;
+
+static bool ffmpeg_prefetch_memory_reserve(size_t size)
+{
+  const size_t limit = MEM_CacheLimiter_get_maximum() / 4;
+  if (limit != 0 && atomic_add_and_fetch_z(&ffmpeg_prefetch_memory, 0) + size > limit) {
+    return false;
+  }
+  atomic_add_and_fetch_z(&ffmpeg_prefetch_memory, size);
+  return true;
+}
+
+static void ffmpeg_prefetch_frame_clear(AnimPrefetchFrame *frame)
+{
+  IMB_freeImBuf(frame->ibuf);
+  atomic_sub_and_fetch_z(&ffmpeg_prefetch_memory, frame->size);
+  frame->ibuf = NULL;
+  frame->size = 0;
+  frame->position = -1;
+}
+
+static bool ffmpeg_prefetch_in_window(const AnimPrefetch *prefetch, const AnimPrefetchFrame *frame)
+{
+  return (frame->tc == prefetch->tc && frame->position > prefetch->position &&
+          frame->position <= prefetch->position + FFMPEG_PREFETCH_FRAMES);
+}
+
+static void ffmpeg_prefetch_evict(AnimPrefetch *prefetch)
+{
+  for (int i = 0; i < FFMPEG_PREFETCH_FRAMES; i++) {
+    AnimPrefetchFrame *frame = &prefetch->frames[i];
+
+    if (!prefetch->sequential || !ffmpeg_prefetch_in_window(prefetch, frame)) {
+      ffmpeg_prefetch_frame_clear(frame);
+    }
+  }
+}
+
+/* Find the first frame of the window which is not decoded yet and a free slot for it. */
+static AnimPrefetchFrame *ffmpeg_prefetch_next(struct anim *anim,
+                                               AnimPrefetch *prefetch,
+                                               int *r_position)
+{
+  AnimPrefetchFrame *free_frame = NULL;
+
+  for (int i = 0; i < FFMPEG_PREFETCH_FRAMES; i++) {
+    if (!ffmpeg_prefetch_in_window(prefetch, &prefetch->frames[i])) {
+      free_frame = &prefetch->frames[i];
+    }
+  }
+
+  if (free_frame == NULL) {
+    return NULL;
+  }
+
+  for (int position = prefetch->position + 1;
+       position <= prefetch->position + FFMPEG_PREFETCH_FRAMES &&
+       position < anim->duration_in_frames;
+       position++) {
+    bool found = false;
+
+    for (int i = 0; i < FFMPEG_PREFETCH_FRAMES; i++) {
+      const AnimPrefetchFrame *frame = &prefetch->frames[i];
+      if (frame->position == position && ffmpeg_prefetch_in_window(prefetch, frame)) {
+        found = true;
+        break;
+      }
+    }
+
+    if (!found) {
+      *r_position = position;
+      return free_frame;
+    }
+  }
+
+  return NULL;
+}
+
+static void *ffmpeg_prefetch_frames(void *anim_v)
+{
+  struct anim *anim = (struct anim *)anim_v;
+  AnimPrefetch *prefetch = anim->prefetch;
+  /* Decoded frames are byte buffers of the size of the movie. */
+  const size_t frame_size = (size_t)anim->x * (size_t)anim->y * 4;
+
+  BLI_mutex_lock(&prefetch->mutex);
+
+  while (!prefetch->stop) {
+    AnimPrefetchFrame *frame = NULL;
+    int position = -1;
+
+    if (prefetch->sequential && !prefetch->fetching) {
+      frame = ffmpeg_prefetch_next(anim, prefetch, &position);
+    }
+
+    if (frame) {
+      /* Claim the slot, it is not looked up while ibuf is NULL. */
+      ffmpeg_prefetch_frame_clear(frame);
+      if (!ffmpeg_prefetch_memory_reserve(frame_size)) {
+        /* Other rings use the memory, wait for the next request. */
+        frame = NULL;
+      }
+    }
+
+    if (frame == NULL) {
+      BLI_mutex_unlock(&prefetch->mutex);
+      void *request = BLI_thread_queue_pop_timeout(prefetch->requests, FFMPEG_PREFETCH_IDLE_MS);
+      BLI_mutex_lock(&prefetch->mutex);
+
+      if (request == NULL && BLI_thread_queue_is_empty(prefetch->requests)) {
+        break;
+      }
+      continue;
+    }
+
+    const IMB_Timecode_Type tc = prefetch->tc;
+    frame->position = position;
+    frame->tc = tc;
+    frame->size = frame_size;
+
+    BLI_mutex_unlock(&prefetch->mutex);
+
+    BLI_mutex_lock(&prefetch->decode_mutex);
+    ImBuf *ibuf = ffmpeg_fetchibuf(anim, position, tc);
+    BLI_mutex_unlock(&prefetch->decode_mutex);
+
+    BLI_mutex_lock(&prefetch->mutex);
+
+    /* The caller may have moved elsewhere while decoding. */
+    if (frame->position == position && ffmpeg_prefetch_in_window(prefetch, frame)) {
+      frame->ibuf = ibuf;
+    }
+    else {
+      IMB_freeImBuf(ibuf);
+    }
+  }
+
+  /* Stopped or idle, nothing is prefetched until the thread is started again. */
+  for (int i = 0; i < FFMPEG_PREFETCH_FRAMES; i++) {
+    ffmpeg_prefetch_frame_clear(&prefetch->frames[i]);
+  }
+  prefetch->idle = true;
+
+  BLI_mutex_unlock(&prefetch->mutex);
+
+  return NULL;
+}
+
+static AnimPrefetch *ffmpeg_prefetch_start(struct anim *anim, IMB_Timecode_Type tc)
+{
+  AnimPrefetch *prefetch = MEM_callocN(sizeof(AnimPrefetch), "AnimPrefetch");
+
+  BLI_mutex_init(&prefetch->decode_mutex);
+  BLI_mutex_init(&prefetch->mutex);
+  prefetch->requests = BLI_thread_queue_init();
+
+  for (int i = 0; i < FFMPEG_PREFETCH_FRAMES; i++) {
+    prefetch->frames[i].position = -1;
+  }
+  prefetch->position = anim->curposition;
+  prefetch->tc = tc;
+
+  anim->prefetch = prefetch;
+
+  BLI_threadpool_init(&prefetch->threads, ffmpeg_prefetch_frames, 1);
+  BLI_threadpool_insert(&prefetch->threads, anim);
+
+  return prefetch;
+}
+
+static void ffmpeg_prefetch_free(struct anim *anim)
+{
+  AnimPrefetch *prefetch = anim->prefetch;
+
+  if (prefetch == NULL) {
+    return;
+  }
+
+  BLI_mutex_lock(&prefetch->mutex);
+  prefetch->stop = true;
+  BLI_mutex_unlock(&prefetch->mutex);
+  BLI_thread_queue_nowait(prefetch->requests);
+
+  /* The worker frees the ring when it stops. */
+  BLI_threadpool_end(&prefetch->threads);
+
+  BLI_thread_queue_free(prefetch->requests);
+  BLI_mutex_end(&prefetch->decode_mutex);
+  BLI_mutex_end(&prefetch->mutex);
+
+  MEM_freeN(prefetch);
+  anim->prefetch = NULL;
+}
+
+static ImBuf *ffmpeg_fetchibuf_prefetch(struct anim *anim, int position, IMB_Timecode_Type tc)
+{
+  AnimPrefetch *prefetch = anim->prefetch;
+  ImBuf *ibuf = NULL;
+
+  if (prefetch) {
+    BLI_mutex_lock(&prefetch->mutex);
+    const bool played = (tc == prefetch->tc && (position == prefetch->position ||
+                                                position == prefetch->position + 1));
+    const bool idle = prefetch->idle;
+    BLI_mutex_unlock(&prefetch->mutex);
+
+    /* Not played anymore, stop the thread and free the ring. */
+    if (idle || !played) {
+      ffmpeg_prefetch_free(anim);
+      prefetch = NULL;
+    }
+  }
+
+  if (prefetch == NULL) {
+    /* Random access, e.g. thumbnails, does not need another thread. */
+    if (anim->curposition == -1 || position != anim->curposition + 1) {
+      return ffmpeg_fetchibuf(anim, position, tc);
+    }
+    prefetch = ffmpeg_prefetch_start(anim, tc);
+  }
+
+  BLI_mutex_lock(&prefetch->mutex);
+
+  for (int i = 0; i < FFMPEG_PREFETCH_FRAMES; i++) {
+    AnimPrefetchFrame *frame = &prefetch->frames[i];
+    if (frame->ibuf && frame->position == position && frame->tc == tc) {
+      ibuf = frame->ibuf;
+      IMB_refImBuf(ibuf);
+      break;
+    }
+  }
+
+  /* The same frame can be requested again, keep the window then. */
+  if (!(tc == prefetch->tc && position == prefetch->position)) {
+    prefetch->sequential = (tc == prefetch->tc && position == prefetch->position + 1);
+    prefetch->position = position;
+    prefetch->tc = tc;
+    ffmpeg_prefetch_evict(prefetch);
+  }
+  prefetch->fetching = (ibuf == NULL);
+
+  BLI_mutex_unlock(&prefetch->mutex);
+
+  if (ibuf == NULL) {
+    BLI_mutex_lock(&prefetch->decode_mutex);
+    ibuf = ffmpeg_fetchibuf(anim, position, tc);
+    BLI_mutex_unlock(&prefetch->decode_mutex);
+  }
+
+  BLI_mutex_lock(&prefetch->mutex);
+  prefetch->fetching = false;
+  BLI_mutex_unlock(&prefetch->mutex);
+  BLI_thread_queue_push(prefetch->requests, anim);
+
+  return ibuf;
+}
+
 static void free_anim_ffmpeg(struct anim *anim)
 {
   if (anim == NULL) {
     return;
   }
 
+  ffmpeg_prefetch_free(anim);
+
   if (anim->pCodecCtx) {
     avcodec_close(anim->pCodecCtx);
     avformat_close_input(&anim->pFormatCtx);
@@ -1393,10 +1716,8 @@ struct ImBuf *IMB_anim_absolute(struct anim *anim,
 #endif
 #ifdef WITH_FFMPEG
     case ANIM_FFMPEG:
-      ibuf = ffmpeg_fetchibuf(anim, position, tc);
-      if (ibuf) {
-        anim->curposition = position;
-      }
+      /* The position is updated by the decoder, which may run on the prefetch thread. */
+      ibuf = ffmpeg_fetchibuf_prefetch(anim, position, tc);
       filter_y = 0; /* done internally */
       break;
 #endif
@@ -1406,7 +1727,7 @@ struct ImBuf *IMB_anim_absolute(struct anim *anim,
     if (filter_y) {
       IMB_filtery(ibuf);
     }
-    BLI_snprintf(ibuf->name, sizeof(ibuf->name), "%s.%04d", anim->name, anim->curposition + 1);
+    BLI_snprintf(ibuf->name, sizeof(ibuf->name), "%s.%04d", anim->name, position + 1);
   }
   return (ibuf);
 }
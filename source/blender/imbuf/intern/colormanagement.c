@@ -43,6 +43,7 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_hash.h"
 #include "BLI_math.h"
 #include "BLI_math_color.h"
 #include "BLI_string.h"
@@ -60,6 +61,10 @@
 
 #include <ocio_capi.h>
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 /*********************** Global declarations *************************/
 
 #define DISPLAY_BUFFER_CHANNELS 4
@@ -97,9 +102,38 @@ static float imbuf_linear_srgb_to_xyz[3][3] = {{0.0f}};
  */
 static pthread_mutex_t processor_lock = BLI_MUTEX_INITIALIZER;
 
+/* 3D LUT baked from a display processor, see display_lut_acquire(). */
+typedef struct DisplayLUT {
+  struct DisplayLUT *next, *prev;
+
+  /* Settings of the processor for comparison. */
+  char look[MAX_COLORSPACE_NAME];
+  char view[MAX_COLORSPACE_NAME];
+  char display[MAX_COLORSPACE_NAME];
+  float exposure, gamma;
+  /* Curve mapping baked into the table, compared by address and timestamp like the display
+   * buffer cache does. */
+  CurveMapping *curve_mapping;
+  int curve_mapping_timestamp;
+
+  /* RGB of the nodes padded to 4 floats, NULL when the LUT isn't accurate enough. */
+  float *table;
+  int users;
+} DisplayLUT;
+
+/* Display LUTs of the last display buffer transforms, most recently used first, so switching
+ * between a few views or editors doesn't bake them again. */
+#define DISPLAY_LUT_CACHE_SIZE 4
+static ListBase global_display_luts = {NULL, NULL};
+static pthread_mutex_t display_lut_lock = BLI_MUTEX_INITIALIZER;
+
+static void display_lut_release(DisplayLUT *lut);
+
 typedef struct ColormanageProcessor {
   OCIO_ConstProcessorRcPtr *processor;
   CurveMapping *curve_mapping;
+  /* Applied instead of the processor when set and accurate enough. */
+  DisplayLUT *lut;
   bool is_data_result;
 } ColormanageProcessor;
 
@@ -743,6 +777,12 @@ void colormanagement_exit(void)
     OCIO_processorRelease(global_color_picking_state.processor_from);
   }
 
+  while (global_display_luts.first) {
+    DisplayLUT *lut = global_display_luts.first;
+    BLI_remlink(&global_display_luts, lut);
+    display_lut_release(lut);
+  }
+
   memset(&global_glsl_state, 0, sizeof(global_glsl_state));
   memset(&global_color_picking_state, 0, sizeof(global_color_picking_state));
 
@@ -1439,6 +1479,379 @@ bool IMB_colormanagement_space_name_is_data(const char *name)
   return (colorspace && colorspace->is_data);
 }
 
+/*********************** Baked display LUT *************************/
+
+/* Display transforms of big images are applied with a 3D LUT baked from the OCIO processor,
+ * which is a lot faster than evaluating the processor for every pixel. The input is shaped
+ * logarithmically between DISPLAY_LUT_LOG_MIN and DISPLAY_LUT_LOG_MAX stops, pixels outside of
+ * that range are transformed by the processor.
+ *
+ * The LUT is only used when the result is converted to bytes. After baking it's compared with
+ * the processor, and not used when they differ by more than half a byte step.
+ */
+
+#define DISPLAY_LUT_SIZE 64
+#define DISPLAY_LUT_LOG_MIN -14.0f
+#define DISPLAY_LUT_LOG_MAX 7.0f
+/* Offset of the input so zero is the first node, 2^DISPLAY_LUT_LOG_MIN. */
+#define DISPLAY_LUT_OFFSET (1.0f / 16384.0f)
+#define DISPLAY_LUT_INPUT_MAX (128.0f - DISPLAY_LUT_OFFSET)
+#define DISPLAY_LUT_SCALE \
+  ((float)(DISPLAY_LUT_SIZE - 1) / (DISPLAY_LUT_LOG_MAX - DISPLAY_LUT_LOG_MIN))
+
+/* Only bake for images big enough to make up for the time of baking. */
+#define DISPLAY_LUT_MIN_PIXELS (4 * DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE)
+#define DISPLAY_LUT_TEST_SAMPLES 4096
+#define DISPLAY_LUT_TOLERANCE (0.5f / 255.0f)
+
+/* Polynomial approximation of log2(1 + t) for t in [0, 1), the error is below 2.2e-5. */
+#define DISPLAY_LUT_LOG2_C1 1.44174030f
+#define DISPLAY_LUT_LOG2_C2 -0.70777018f
+#define DISPLAY_LUT_LOG2_C3 0.41234422f
+#define DISPLAY_LUT_LOG2_C4 -0.19031903f
+#define DISPLAY_LUT_LOG2_C5 0.04400469f
+
+#ifdef __SSE2__
+
+/* Same as display_lut_log2(), for 4 positive values. */
+MALWAYS_INLINE __m128 display_lut_log2_simd(const __m128 x)
+{
+  const __m128i bits = _mm_castps_si128(x);
+  const __m128 exponent = _mm_cvtepi32_ps(
+      _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+  const __m128 mantissa = _mm_castsi128_ps(
+      _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+  const __m128 t = _mm_sub_ps(mantissa, _mm_set1_ps(1.0f));
+
+  __m128 p = _mm_set1_ps(DISPLAY_LUT_LOG2_C5);
+  p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(DISPLAY_LUT_LOG2_C4));
+  p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(DISPLAY_LUT_LOG2_C3));
+  p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(DISPLAY_LUT_LOG2_C2));
+  p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(DISPLAY_LUT_LOG2_C1));
+  return _mm_add_ps(exponent, _mm_mul_ps(p, t));
+}
+
+MALWAYS_INLINE __m128 display_lut_interp_simd(const __m128 a, const __m128 b, const __m128 t)
+{
+  return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+}
+
+#else /* __SSE2__ */
+
+/* Fast log2 of a positive value, baking and evaluating use the same approximation. */
+MINLINE float display_lut_log2(float x)
+{
+  union {
+    float f;
+    int i;
+  } u;
+  u.f = x;
+  const float exponent = (float)((u.i >> 23) - 127);
+  u.i = (u.i & 0x007fffff) | 0x3f800000;
+  const float t = u.f - 1.0f;
+  return exponent +
+         t * (DISPLAY_LUT_LOG2_C1 +
+              t * (DISPLAY_LUT_LOG2_C2 +
+                   t * (DISPLAY_LUT_LOG2_C3 +
+                        t * (DISPLAY_LUT_LOG2_C4 + t * DISPLAY_LUT_LOG2_C5))));
+}
+
+#endif /* __SSE2__ */
+
+/* Trilinear interpolation of the LUT, false when the pixel is outside of it. */
+MINLINE bool display_lut_evaluate(const float *table, const float in[3], float out[3])
+{
+  const size_t stride_g = 4 * DISPLAY_LUT_SIZE;
+  const size_t stride_b = 4 * DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE;
+
+#ifdef __SSE2__
+  const __m128 rgb = _mm_set_ps(0.0f, in[2], in[1], in[0]);
+  const __m128 inside = _mm_and_ps(_mm_cmpge_ps(rgb, _mm_setzero_ps()),
+                                   _mm_cmple_ps(rgb, _mm_set1_ps(DISPLAY_LUT_INPUT_MAX)));
+  /* Also false for NaN. */
+  if ((_mm_movemask_ps(inside) & 7) != 7) {
+    return false;
+  }
+
+  __m128 coord = display_lut_log2_simd(_mm_add_ps(rgb, _mm_set1_ps(DISPLAY_LUT_OFFSET)));
+  coord = _mm_mul_ps(_mm_sub_ps(coord, _mm_set1_ps(DISPLAY_LUT_LOG_MIN)),
+                     _mm_set1_ps(DISPLAY_LUT_SCALE));
+  coord = _mm_min_ps(_mm_max_ps(coord, _mm_setzero_ps()), _mm_set1_ps(DISPLAY_LUT_SIZE - 1));
+  const __m128i index = _mm_cvttps_epi32(_mm_min_ps(coord, _mm_set1_ps(DISPLAY_LUT_SIZE - 2)));
+  const __m128 frac = _mm_sub_ps(coord, _mm_cvtepi32_ps(index));
+
+  int i[4];
+  _mm_storeu_si128((__m128i *)i, index);
+  const float *node = table + 4 * i[0] + stride_g * i[1] + stride_b * i[2];
+
+  const __m128 fr = _mm_shuffle_ps(frac, frac, _MM_SHUFFLE(0, 0, 0, 0));
+  const __m128 fg = _mm_shuffle_ps(frac, frac, _MM_SHUFFLE(1, 1, 1, 1));
+  const __m128 fb = _mm_shuffle_ps(frac, frac, _MM_SHUFFLE(2, 2, 2, 2));
+  const float *node_b = node + stride_b;
+  const __m128 c00 = display_lut_interp_simd(_mm_loadu_ps(node), _mm_loadu_ps(node + 4), fr);
+  const __m128 c10 = display_lut_interp_simd(
+      _mm_loadu_ps(node + stride_g), _mm_loadu_ps(node + stride_g + 4), fr);
+  const __m128 c01 = display_lut_interp_simd(_mm_loadu_ps(node_b), _mm_loadu_ps(node_b + 4), fr);
+  const __m128 c11 = display_lut_interp_simd(
+      _mm_loadu_ps(node_b + stride_g), _mm_loadu_ps(node_b + stride_g + 4), fr);
+  const __m128 result = display_lut_interp_simd(display_lut_interp_simd(c00, c10, fg),
+                                                display_lut_interp_simd(c01, c11, fg),
+                                                fb);
+
+  float result_v4[4];
+  _mm_storeu_ps(result_v4, result);
+  copy_v3_v3(out, result_v4);
+#else
+  int i[3];
+  float frac[3];
+  for (int c = 0; c < 3; c++) {
+    /* Also false for NaN. */
+    if (!(in[c] >= 0.0f && in[c] <= DISPLAY_LUT_INPUT_MAX)) {
+      return false;
+    }
+    float coord = (display_lut_log2(in[c] + DISPLAY_LUT_OFFSET) - DISPLAY_LUT_LOG_MIN) *
+                  DISPLAY_LUT_SCALE;
+    CLAMP(coord, 0.0f, DISPLAY_LUT_SIZE - 1);
+    i[c] = (int)min_ff(coord, DISPLAY_LUT_SIZE - 2);
+    frac[c] = coord - i[c];
+  }
+
+  const float *node = table + 4 * i[0] + stride_g * i[1] + stride_b * i[2];
+  const float *node_b = node + stride_b;
+  float c00[3], c10[3], c01[3], c11[3], c0[3], c1[3];
+  interp_v3_v3v3(c00, node, node + 4, frac[0]);
+  interp_v3_v3v3(c10, node + stride_g, node + stride_g + 4, frac[0]);
+  interp_v3_v3v3(c01, node_b, node_b + 4, frac[0]);
+  interp_v3_v3v3(c11, node_b + stride_g, node_b + stride_g + 4, frac[0]);
+  interp_v3_v3v3(c0, c00, c10, frac[1]);
+  interp_v3_v3v3(c1, c01, c11, frac[1]);
+  interp_v3_v3v3(out, c0, c1, frac[2]);
+#endif
+
+  return true;
+}
+
+/* Input value of a LUT coordinate. */
+static float display_lut_node_value(float coord)
+{
+  if (coord == 0.0f) {
+    return 0.0f;
+  }
+  return exp2f(DISPLAY_LUT_LOG_MIN + coord / DISPLAY_LUT_SCALE) - DISPLAY_LUT_OFFSET;
+}
+
+static void display_lut_processor_apply(OCIO_ConstProcessorRcPtr *processor,
+                                        float *rgba,
+                                        int num_pixels)
+{
+  OCIO_PackedImageDesc *img = OCIO_createOCIO_PackedImageDesc(rgba,
+                                                              num_pixels,
+                                                              1,
+                                                              4,
+                                                              sizeof(float),
+                                                              4 * sizeof(float),
+                                                              4 * sizeof(float) * num_pixels);
+  OCIO_processorApply(processor, img);
+  OCIO_PackedImageDescRelease(img);
+}
+
+/* Bake the LUT of a display processor with an optional curve mapping applied before it, NULL
+ * when it isn't accurate enough. */
+static float *display_lut_bake(OCIO_ConstProcessorRcPtr *processor,
+                               const CurveMapping *curve_mapping)
+{
+  const int size = DISPLAY_LUT_SIZE;
+  const int num_nodes = size * size * size;
+  float *table = MEM_mallocN(sizeof(float[4]) * num_nodes, "display LUT");
+
+  float values[DISPLAY_LUT_SIZE];
+  for (int i = 0; i < size; i++) {
+    values[i] = display_lut_node_value(i);
+  }
+
+  float *node = table;
+  for (int b = 0; b < size; b++) {
+    for (int g = 0; g < size; g++) {
+      for (int r = 0; r < size; r++, node += 4) {
+        node[0] = values[r];
+        node[1] = values[g];
+        node[2] = values[b];
+        node[3] = 1.0f;
+        if (curve_mapping) {
+          BKE_curvemapping_evaluate_premulRGBF(curve_mapping, node, node);
+        }
+      }
+    }
+  }
+  display_lut_processor_apply(processor, table, num_nodes);
+
+  /* Compare with the processor between the nodes. */
+  float(*samples)[4] = MEM_mallocN(sizeof(float[4]) * DISPLAY_LUT_TEST_SAMPLES,
+                                   "display LUT samples");
+  float(*results)[3] = MEM_mallocN(sizeof(float[3]) * DISPLAY_LUT_TEST_SAMPLES,
+                                   "display LUT results");
+  bool *inside = MEM_mallocN(sizeof(bool) * DISPLAY_LUT_TEST_SAMPLES, "display LUT inside");
+  for (int i = 0; i < DISPLAY_LUT_TEST_SAMPLES; i++) {
+    for (int c = 0; c < 3; c++) {
+      samples[i][c] = display_lut_node_value(BLI_hash_int_01(i * 3 + c) * (size - 1));
+    }
+    samples[i][3] = 1.0f;
+    inside[i] = display_lut_evaluate(table, samples[i], results[i]);
+    if (curve_mapping) {
+      BKE_curvemapping_evaluate_premulRGBF(curve_mapping, samples[i], samples[i]);
+    }
+  }
+  display_lut_processor_apply(processor, samples[0], DISPLAY_LUT_TEST_SAMPLES);
+
+  float max_error = 0.0f;
+  for (int i = 0; i < DISPLAY_LUT_TEST_SAMPLES; i++) {
+    if (inside[i]) {
+      /* Only the range stored in bytes matters. */
+      for (int c = 0; c < 3; c++) {
+        const float error = fabsf(clamp_f(results[i][c], 0.0f, 1.0f) -
+                                  clamp_f(samples[i][c], 0.0f, 1.0f));
+        max_error = max_ff(max_error, error);
+      }
+    }
+  }
+
+  MEM_freeN(samples);
+  MEM_freeN(results);
+  MEM_freeN(inside);
+
+  if (max_error > DISPLAY_LUT_TOLERANCE) {
+    MEM_freeN(table);
+    return NULL;
+  }
+  return table;
+}
+
+static void display_lut_free_user(DisplayLUT *lut)
+{
+  if (--lut->users == 0) {
+    MEM_SAFE_FREE(lut->table);
+    MEM_freeN(lut);
+  }
+}
+
+static bool display_lut_matches(const DisplayLUT *lut,
+                                const ColorManagedViewSettings *view_settings,
+                                const ColorManagedDisplaySettings *display_settings,
+                                const CurveMapping *curve_mapping)
+{
+  const int curve_mapping_timestamp = curve_mapping ? curve_mapping->changed_timestamp : 0;
+
+  return STREQ(lut->look, view_settings->look) &&
+         STREQ(lut->view, view_settings->view_transform) &&
+         STREQ(lut->display, display_settings->display_device) &&
+         lut->exposure == view_settings->exposure && lut->gamma == view_settings->gamma &&
+         lut->curve_mapping == curve_mapping &&
+         lut->curve_mapping_timestamp == curve_mapping_timestamp;
+}
+
+/* Get the LUT of the display processor created for the settings, baking it when it isn't one
+ * of the last used ones. The curve mapping of the processor is baked into the LUT. */
+static DisplayLUT *display_lut_acquire(const ColormanageProcessor *cm_processor,
+                                       const ColorManagedViewSettings *view_settings,
+                                       const ColorManagedDisplaySettings *display_settings)
+{
+  CurveMapping *curve_mapping = (view_settings->flag & COLORMANAGE_VIEW_USE_CURVES) ?
+                                    view_settings->curve_mapping :
+                                    NULL;
+  DisplayLUT *lut;
+
+  BLI_mutex_lock(&display_lut_lock);
+
+  for (lut = global_display_luts.first; lut; lut = lut->next) {
+    if (display_lut_matches(lut, view_settings, display_settings, curve_mapping)) {
+      break;
+    }
+  }
+
+  if (lut) {
+    BLI_remlink(&global_display_luts, lut);
+  }
+  else {
+    if (BLI_listbase_count_at_most(&global_display_luts, DISPLAY_LUT_CACHE_SIZE) ==
+        DISPLAY_LUT_CACHE_SIZE) {
+      DisplayLUT *lut_last = global_display_luts.last;
+      BLI_remlink(&global_display_luts, lut_last);
+      display_lut_free_user(lut_last);
+    }
+
+    lut = MEM_callocN(sizeof(DisplayLUT), "display LUT");
+    BLI_strncpy(lut->look, view_settings->look, sizeof(lut->look));
+    BLI_strncpy(lut->view, view_settings->view_transform, sizeof(lut->view));
+    BLI_strncpy(lut->display, display_settings->display_device, sizeof(lut->display));
+    lut->exposure = view_settings->exposure;
+    lut->gamma = view_settings->gamma;
+    lut->curve_mapping = curve_mapping;
+    lut->curve_mapping_timestamp = curve_mapping ? curve_mapping->changed_timestamp : 0;
+    lut->table = display_lut_bake(cm_processor->processor, cm_processor->curve_mapping);
+    /* User of the cache. */
+    lut->users = 1;
+  }
+
+  BLI_addhead(&global_display_luts, lut);
+  lut->users++;
+
+  BLI_mutex_unlock(&display_lut_lock);
+
+  return lut;
+}
+
+static void display_lut_release(DisplayLUT *lut)
+{
+  BLI_mutex_lock(&display_lut_lock);
+  display_lut_free_user(lut);
+  BLI_mutex_unlock(&display_lut_lock);
+}
+
+static void display_lut_apply(ColormanageProcessor *cm_processor,
+                              float *buffer,
+                              size_t num_pixels,
+                              int channels,
+                              bool predivide)
+{
+  const float *table = cm_processor->lut->table;
+  CurveMapping *curve_mapping = cm_processor->curve_mapping;
+  float *pixel = buffer;
+
+  for (size_t i = 0; i < num_pixels; i++, pixel += channels) {
+    const float alpha = (channels == 4) ? pixel[3] : 1.0f;
+    const bool straighten = predivide && alpha != 0.0f && alpha != 1.0f;
+
+    if (straighten && curve_mapping) {
+      /* The curve is applied to premultiplied colors, which the LUT doesn't store. */
+      curve_mapping_apply_pixel(curve_mapping, pixel, channels);
+      mul_v3_fl(pixel, 1.0f / alpha);
+      OCIO_processorApplyRGB(cm_processor->processor, pixel);
+      mul_v3_fl(pixel, alpha);
+      continue;
+    }
+
+    if (straighten) {
+      mul_v3_fl(pixel, 1.0f / alpha);
+    }
+
+    if (!display_lut_evaluate(table, pixel, pixel)) {
+      if (curve_mapping) {
+        curve_mapping_apply_pixel(curve_mapping, pixel, channels);
+      }
+      if (channels == 4) {
+        OCIO_processorApplyRGBA(cm_processor->processor, pixel);
+      }
+      else {
+        OCIO_processorApplyRGB(cm_processor->processor, pixel);
+      }
+    }
+
+    if (straighten) {
+      mul_v3_fl(pixel, alpha);
+    }
+  }
+}
+
 /*********************** Threaded display buffer transform routines *************************/
 
 typedef struct DisplayBufferThread {
@@ -1784,6 +2197,12 @@ static void colormanage_display_buffer_process_ex(
 
   if (skip_transform == false) {
     cm_processor = IMB_colormanagement_display_processor_new(view_settings, display_settings);
+
+    /* The baked LUT is accurate enough for bytes only. */
+    if (display_buffer == NULL && cm_processor->processor &&
+        ((size_t)ibuf->x) * ibuf->y >= DISPLAY_LUT_MIN_PIXELS) {
+      cm_processor->lut = display_lut_acquire(cm_processor, view_settings, display_settings);
+    }
   }
 
   display_buffer_apply_threaded(ibuf,
@@ -3850,8 +4269,10 @@ void IMB_colormanagement_processor_apply(ColormanageProcessor *cm_processor,
                                          int channels,
                                          bool predivide)
 {
-  /* apply curve mapping */
-  if (cm_processor->curve_mapping) {
+  const bool use_lut = cm_processor->lut && cm_processor->lut->table && channels >= 3;
+
+  /* apply curve mapping, baked into the LUT */
+  if (cm_processor->curve_mapping && !use_lut) {
     int x, y;
 
     for (y = 0; y < height; y++) {
@@ -3863,7 +4284,10 @@ void IMB_colormanagement_processor_apply(ColormanageProcessor *cm_processor,
     }
   }
 
-  if (cm_processor->processor && channels >= 3) {
+  if (use_lut) {
+    display_lut_apply(cm_processor, buffer, ((size_t)width) * height, channels, predivide);
+  }
+  else if (cm_processor->processor && channels >= 3) {
     OCIO_PackedImageDesc *img;
 
     /* apply OCIO processor */
@@ -3912,6 +4336,9 @@ void IMB_colormanagement_processor_free(ColormanageProcessor *cm_processor)
   if (cm_processor->processor) {
     OCIO_processorRelease(cm_processor->processor);
   }
+  if (cm_processor->lut) {
+    display_lut_release(cm_processor->lut);
+  }
 
   MEM_freeN(cm_processor);
 }
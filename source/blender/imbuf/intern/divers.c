@@ -35,6 +35,10 @@
 
 #include "MEM_guardedalloc.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 /************************* Floyd-Steinberg dithering *************************/
 
 typedef struct DitherContext {
@@ -96,6 +100,89 @@ MINLINE void float_to_byte_dither_v4(
   b[3] = unit_float_to_uchar_clamp(f[3]);
 }
 
+#ifdef __SSE2__
+
+/* Same rounding and clamping as unit_float_to_uchar_clamp, NaN is converted to zero. */
+MALWAYS_INLINE __m128i float_to_byte_v4_simd(const __m128 f)
+{
+  const __m128 v = _mm_max_ps(_mm_mul_ps(f, _mm_set1_ps(255.0f)), _mm_setzero_ps());
+  return _mm_cvttps_epi32(_mm_min_ps(_mm_add_ps(v, _mm_set1_ps(0.5f)), _mm_set1_ps(255.0f)));
+}
+
+/* Same as premul_to_straight_v4_v4. */
+MALWAYS_INLINE __m128 premul_to_straight_v4_simd(const __m128 premul)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 rgb_mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+  const __m128 alpha = _mm_shuffle_ps(premul, premul, _MM_SHUFFLE(3, 3, 3, 3));
+  const __m128 keep = _mm_or_ps(_mm_cmpeq_ps(alpha, _mm_setzero_ps()), _mm_cmpeq_ps(alpha, one));
+  __m128 scale = _bli_math_blend_sse(keep, one, _mm_div_ps(one, alpha));
+  scale = _bli_math_blend_sse(rgb_mask, scale, one);
+  return _mm_mul_ps(premul, scale);
+}
+
+#endif /* __SSE2__ */
+
+/* Convert a row of RGBA float pixels to bytes, without color space conversion. */
+static void float_to_byte_row_v4(uchar *to, const float *from, int width, bool predivide)
+{
+  int x = 0;
+
+#ifdef __SSE2__
+  /* 4 pixels at a time, packed into 16 bytes. */
+  for (; x + 4 <= width; x += 4, from += 16, to += 16) {
+    __m128 p0 = _mm_loadu_ps(from);
+    __m128 p1 = _mm_loadu_ps(from + 4);
+    __m128 p2 = _mm_loadu_ps(from + 8);
+    __m128 p3 = _mm_loadu_ps(from + 12);
+    if (predivide) {
+      p0 = premul_to_straight_v4_simd(p0);
+      p1 = premul_to_straight_v4_simd(p1);
+      p2 = premul_to_straight_v4_simd(p2);
+      p3 = premul_to_straight_v4_simd(p3);
+    }
+    const __m128i b01 = _mm_packs_epi32(float_to_byte_v4_simd(p0), float_to_byte_v4_simd(p1));
+    const __m128i b23 = _mm_packs_epi32(float_to_byte_v4_simd(p2), float_to_byte_v4_simd(p3));
+    _mm_storeu_si128((__m128i *)to, _mm_packus_epi16(b01, b23));
+  }
+#endif
+
+  for (; x < width; x++, from += 4, to += 4) {
+    if (predivide) {
+      float straight[4];
+      premul_to_straight_v4_v4(straight, from);
+      rgba_float_to_uchar(to, straight);
+    }
+    else {
+      rgba_float_to_uchar(to, from);
+    }
+  }
+}
+
+/* Convert a row of RGBA byte pixels to floats, without color space conversion. */
+static void byte_to_float_row_v4(float *to, const uchar *from, int width)
+{
+  int x = 0;
+
+#ifdef __SSE2__
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+  for (; x + 4 <= width; x += 4, from += 16, to += 16) {
+    const __m128i b = _mm_loadu_si128((const __m128i *)from);
+    const __m128i lo = _mm_unpacklo_epi8(b, zero);
+    const __m128i hi = _mm_unpackhi_epi8(b, zero);
+    _mm_storeu_ps(to, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+    _mm_storeu_ps(to + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+    _mm_storeu_ps(to + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+    _mm_storeu_ps(to + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+  }
+#endif
+
+  for (; x < width; x++, from += 4, to += 4) {
+    rgba_uchar_to_float(to, from);
+  }
+}
+
 /* Test if colorspace conversions of pixels in buffer need to take into account alpha. */
 bool IMB_alpha_affects_rgb(const ImBuf *ibuf)
 {
@@ -190,16 +277,8 @@ void IMB_buffer_byte_from_float(uchar *rect_to,
             float_to_byte_dither_v4(to, from, di, (float)x * inv_width, t);
           }
         }
-        else if (predivide) {
-          for (x = 0; x < width; x++, from += 4, to += 4) {
-            premul_to_straight_v4_v4(straight, from);
-            rgba_float_to_uchar(to, straight);
-          }
-        }
         else {
-          for (x = 0; x < width; x++, from += 4, to += 4) {
-            rgba_float_to_uchar(to, from);
-          }
+          float_to_byte_row_v4(to, from, width, predivide);
         }
       }
       else if (profile_to == IB_PROFILE_SRGB) {
@@ -385,9 +464,7 @@ void IMB_buffer_float_from_byte(float *rect_to,
 
     if (profile_to == profile_from) {
       /* no color space conversion */
-      for (x = 0; x < width; x++, from += 4, to += 4) {
-        rgba_uchar_to_float(to, from);
-      }
+      byte_to_float_row_v4(to, from, width);
     }
     else if (profile_to == IB_PROFILE_LINEAR_RGB) {
       /* convert sRGB to linear */
@@ -172,7 +172,7 @@ const ImFileType IMB_FILE_TYPES[] = {
      NULL,
      imb_ftype_default,
      imb_load_openexr,
-     NULL,
+     imb_load_openexr_filepath,
      imb_save_openexr,
      NULL,
      IM_FTYPE_FLOAT,
@@ -30,6 +30,7 @@
 #include "BLI_string.h"
 #include "BLI_fileops.h"
 #include "BLI_ghash.h"
+#include "BLI_task.h"
 
 #include "IMB_indexer.h"
 #include "IMB_anim.h"
@@ -777,6 +778,11 @@ static IndexBuildContext *index_ffmpeg_create_context(struct anim *anim,
 
   context->iCodecCtx->workaround_bugs = 1;
 
+  /* No frame threading, its extra decoder delay would break the seek positions of the index.
+   * The thread count is fixed, multiple movies can be built at once. */
+  context->iCodecCtx->thread_count = IMB_INDEX_BUILD_DECODE_THREADS;
+  context->iCodecCtx->thread_type = FF_THREAD_SLICE;
+
   if (avcodec_open2(context->iCodecCtx, context->iCodec, NULL) < 0) {
     avformat_close_input(&context->iFormatCtx);
     MEM_freeN(context);
@@ -836,6 +842,19 @@ static void index_rebuild_ffmpeg_finish(FFmpegIndexBuilderContext *context, int
   MEM_freeN(context);
 }
 
+typedef struct ProxyOutputTaskData {
+  FFmpegIndexBuilderContext *context;
+  AVFrame *in_frame;
+} ProxyOutputTaskData;
+
+static void index_rebuild_ffmpeg_proxy_output_task(void *__restrict userdata,
+                                                   const int i,
+                                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  ProxyOutputTaskData *data = userdata;
+  add_to_proxy_output_ffmpeg(data->context->proxy_ctx[i], data->in_frame);
+}
+
 static void index_rebuild_ffmpeg_proc_decoded_frame(FFmpegIndexBuilderContext *context,
                                                     AVPacket *curr_packet,
                                                     AVFrame *in_frame)
@@ -845,9 +864,13 @@ static void index_rebuild_ffmpeg_proc_decoded_frame(FFmpegIndexBuilderContext *c
   unsigned long long s_dts = context->seek_pos_dts;
   unsigned long long pts = av_get_pts_from_frame(context->iFormatCtx, in_frame);
 
-  for (i = 0; i < context->num_proxy_sizes; i++) {
-    add_to_proxy_output_ffmpeg(context->proxy_ctx[i], in_frame);
-  }
+  /* The frame is decoded once, every proxy size scales and encodes it on its own. */
+  ProxyOutputTaskData data = {context, in_frame};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(
+      0, context->num_proxy_sizes, &data, index_rebuild_ffmpeg_proxy_output_task, &settings);
 
   if (!context->start_pts_set) {
     context->start_pts = pts;
@@ -32,6 +32,7 @@
 #include "BLI_string.h"
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
+#include "BLI_listbase.h"
 #include "BLI_mempool.h"
 #include "BLI_threads.h"
 
@@ -40,6 +41,10 @@
 #include "IMB_imbuf_types.h"
 #include "IMB_imbuf.h"
 
+#include "atomic_ops.h"
+
+#include "zlib.h"
+
 #ifdef DEBUG_MESSAGES
 #  if defined __GNUC__
 #    define PRINT(format, args...) printf(format, ##args)
@@ -50,10 +55,30 @@
 #  define PRINT(format, ...)
 #endif
 
+/* Priority of a frame per second it took to create, in the unit of the priorities: frames of
+ * distance to the last used frame, or of least recently used order. */
+#define MOVIECACHE_COST_PRIORITY 100.0f
+
+/* Compressed frames are only kept when they are smaller than this fraction of their size. */
+#define MOVIECACHE_COMPRESS_RATIO 0.8f
+
 static MEM_CacheLimiterC *limitor = NULL;
 static pthread_mutex_t limitor_lock = BLI_MUTEX_INITIALIZER;
 
+/* All caches and all items of the caches, to compress the coldest frames over all owners.
+ * The caches are protected by limitor_lock, the items by items_lock. The lock of the items
+ * is taken after limitor_lock. */
+static ListBase moviecache_caches = {NULL, NULL};
+static ListBase moviecache_items = {NULL, NULL};
+static pthread_mutex_t items_lock = BLI_MUTEX_INITIALIZER;
+/* Notified with items_lock when the buffers of an item are (de)compressed. */
+static ThreadCondition items_cond;
+/* Incremented when items are used, to compare how recently they were used. */
+static unsigned int moviecache_clock = 0;
+
 typedef struct MovieCache {
+  struct MovieCache *next, *prev;
+
   char name[64];
 
   GHash *hash;
@@ -74,7 +99,14 @@ typedef struct MovieCache {
   void *last_userkey;
 
   int totseg, *points, proxy, render_flags; /* for visual statistics optimization */
-  int pad;
+
+  bool use_compression;
+  char _pad[3];
+
+  /* Counters of the statistics, the other statistics are counted from the items. The hits and
+   * misses are counted atomically, lookups don't lock when there's no frame. */
+  int hits, misses;
+  int compressions, decompressions, evictions;
 } MovieCache;
 
 typedef struct MovieCacheKey {
@@ -83,10 +115,24 @@ typedef struct MovieCacheKey {
 } MovieCacheKey;
 
 typedef struct MovieCacheItem {
+  struct MovieCacheItem *next, *prev;
+
   MovieCache *cache_owner;
   ImBuf *ibuf;
   MEM_CacheLimiterHandleC *c_handle;
   void *priority_data;
+
+  /* Seconds it took to create the buffer. */
+  float cost;
+  unsigned int last_used;
+
+  /* Buffers of a cold frame, compressed while its ImBuf is kept without them. */
+  void *compressed_rect, *compressed_rect_float;
+  size_t compressed_size;
+  /* Don't try to compress the buffers again when they didn't compress well. */
+  bool skip_compression;
+  /* The buffers are (de)compressed without the locks, protected by items_lock. */
+  bool is_compressing;
 } MovieCacheItem;
 
 static unsigned int moviecache_hashhash(const void *keyv)
@@ -113,6 +159,19 @@ static void moviecache_keyfree(void *val)
   BLI_mempool_free(key->cache_owner->keys_pool, key);
 }
 
+static void moviecache_compressed_free(MovieCacheItem *item)
+{
+  if (item->compressed_rect) {
+    MEM_freeN(item->compressed_rect);
+    item->compressed_rect = NULL;
+  }
+  if (item->compressed_rect_float) {
+    MEM_freeN(item->compressed_rect_float);
+    item->compressed_rect_float = NULL;
+  }
+  item->compressed_size = 0;
+}
+
 static void moviecache_valfree(void *val)
 {
   MovieCacheItem *item = (MovieCacheItem *)val;
@@ -120,6 +179,15 @@ static void moviecache_valfree(void *val)
 
   PRINT("%s: cache '%s' free item %p buffer %p\n", __func__, cache->name, item, item->ibuf);
 
+  BLI_mutex_lock(&items_lock);
+  while (item->is_compressing) {
+    BLI_condition_wait(&items_cond, &items_lock);
+  }
+  BLI_remlink(&moviecache_items, item);
+  BLI_mutex_unlock(&items_lock);
+
+  moviecache_compressed_free(item);
+
   if (item->ibuf) {
     MEM_CacheLimiter_unmanage(item->c_handle);
     IMB_freeImBuf(item->ibuf);
@@ -174,9 +242,11 @@ static void IMB_moviecache_destructor(void *p)
     PRINT("%s: cache '%s' destroy item %p buffer %p\n", __func__, cache->name, item, item->ibuf);
 
     IMB_freeImBuf(item->ibuf);
+    moviecache_compressed_free(item);
 
     item->ibuf = NULL;
     item->c_handle = NULL;
+    cache->evictions++;
 
     /* force cached segments to be updated */
     if (cache->points) {
@@ -204,6 +274,7 @@ static size_t get_item_size(void *p)
   if (item->ibuf) {
     size += get_size_in_memory(item->ibuf);
   }
+  size += item->compressed_size;
 
   return size;
 }
@@ -221,14 +292,16 @@ static int get_item_priority(void *item_v, int default_priority)
           item,
           default_priority);
 
-    return default_priority;
+    priority = default_priority;
   }
+  else {
+    priority = cache->getitempriorityfp(cache->last_userkey, item->priority_data);
 
-  priority = cache->getitempriorityfp(cache->last_userkey, item->priority_data);
-
-  PRINT("%s: cache '%s' item %p priority %d\n", __func__, cache->name, item, priority);
+    PRINT("%s: cache '%s' item %p priority %d\n", __func__, cache->name, item, priority);
+  }
 
-  return priority;
+  /* Frames which are expensive to create again are kept longer. */
+  return priority + (int)(item->cost * MOVIECACHE_COST_PRIORITY);
 }
 
 static bool get_item_destroyable(void *item_v)
@@ -245,18 +318,284 @@ static bool get_item_destroyable(void *item_v)
   return true;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Compression
+ *
+ * Instead of freeing the coldest frames when the cache is full, their buffers are compressed
+ * losslessly and the frames stay in the cache at the size of the compressed buffers. The bytes
+ * of every 4 byte element are shuffled into planes first, which compresses much better for the
+ * float buffers, and also helps for the channels of the byte buffers.
+ * \{ */
+
+static void *moviecache_compress_buffer(const void *buffer, size_t size, size_t *r_size)
+{
+  const unsigned char *in = buffer;
+  const size_t num = size / 4;
+  unsigned char *shuffled = MEM_mallocN(size, "movie cache shuffled buffer");
+
+  for (int b = 0; b < 4; b++) {
+    unsigned char *plane = shuffled + b * num;
+    for (size_t i = 0; i < num; i++) {
+      plane[i] = in[i * 4 + b];
+    }
+  }
+
+  uLongf compressed_size = compressBound(size);
+  void *compressed = MEM_mallocN(compressed_size, "movie cache compressed buffer");
+  const int result = compress2(compressed, &compressed_size, shuffled, size, Z_BEST_SPEED);
+  MEM_freeN(shuffled);
+
+  if (result != Z_OK || compressed_size > size * MOVIECACHE_COMPRESS_RATIO) {
+    MEM_freeN(compressed);
+    return NULL;
+  }
+
+  *r_size = compressed_size;
+  return MEM_reallocN(compressed, compressed_size);
+}
+
+static void *moviecache_decompress_buffer(const void *compressed, size_t size, const char *name)
+{
+  const size_t num = size / 4;
+  unsigned char *shuffled = MEM_mallocN(size, "movie cache shuffled buffer");
+  unsigned char *buffer = MEM_mallocN(size, name);
+  uLongf shuffled_size = size;
+
+  uncompress(shuffled, &shuffled_size, compressed, MEM_allocN_len(compressed));
+  BLI_assert(shuffled_size == size);
+
+  for (int b = 0; b < 4; b++) {
+    const unsigned char *plane = shuffled + b * num;
+    for (size_t i = 0; i < num; i++) {
+      buffer[i * 4 + b] = plane[i];
+    }
+  }
+
+  MEM_freeN(shuffled);
+  return buffer;
+}
+
+static bool moviecache_item_compressible(const MovieCacheItem *item)
+{
+  const ImBuf *ibuf = item->ibuf;
+
+  if (item->is_compressing || !item->cache_owner->use_compression || item->skip_compression ||
+      ibuf == NULL || item->compressed_size != 0) {
+    return false;
+  }
+  /* Used outside of the cache. */
+  if (ibuf->refcounter != 0 || MEM_CacheLimiter_get_refcount(item->c_handle) != 0) {
+    return false;
+  }
+  if (ibuf->userflags & (IB_BITMAPDIRTY | IB_PERSISTENT)) {
+    return false;
+  }
+  /* Only plain frames, other buffers would be kept and freeing the buffers frees mipmaps. */
+  if (ibuf->zbuf || ibuf->zbuf_float || ibuf->mipmap[0] || ibuf->tiles || ibuf->dds_data.data) {
+    return false;
+  }
+  if (ibuf->rect && !(ibuf->mall & IB_rect)) {
+    return false;
+  }
+  if (ibuf->rect_float && (!(ibuf->mall & IB_rectfloat) || ibuf->channels != 4)) {
+    return false;
+  }
+  return ibuf->rect || ibuf->rect_float;
+}
+
+static void moviecache_item_compress_end(MovieCacheItem *item)
+{
+  BLI_mutex_lock(&items_lock);
+  item->is_compressing = false;
+  BLI_condition_notify_all(&items_cond);
+  BLI_mutex_unlock(&items_lock);
+}
+
+/* Compress the buffers into the item without the locks, the ImBuf isn't modified. Returns the
+ * compressed size, zero when the buffers didn't compress well. */
+static size_t moviecache_item_compress(MovieCacheItem *item)
+{
+  const ImBuf *ibuf = item->ibuf;
+  const size_t num_pixels = (size_t)ibuf->x * ibuf->y;
+  size_t rect_size = 0, rect_float_size = 0;
+
+  if (ibuf->rect) {
+    item->compressed_rect = moviecache_compress_buffer(
+        ibuf->rect, num_pixels * sizeof(unsigned int), &rect_size);
+  }
+  if (ibuf->rect_float) {
+    item->compressed_rect_float = moviecache_compress_buffer(
+        ibuf->rect_float, num_pixels * sizeof(float[4]), &rect_float_size);
+  }
+
+  if ((ibuf->rect && !item->compressed_rect) ||
+      (ibuf->rect_float && !item->compressed_rect_float)) {
+    MEM_SAFE_FREE(item->compressed_rect);
+    MEM_SAFE_FREE(item->compressed_rect_float);
+    return 0;
+  }
+  return rect_size + rect_float_size;
+}
+
+/* Replace the buffers by the compressed ones, with limitor_lock. */
+static void moviecache_item_compress_publish(MovieCacheItem *item,
+                                             size_t compressed_size,
+                                             unsigned int last_used)
+{
+  ImBuf *ibuf = item->ibuf;
+
+  if (compressed_size == 0) {
+    item->skip_compression = true;
+    return;
+  }
+  /* Used while compressing, the buffers might have been modified since. */
+  if (item->last_used != last_used || ibuf->refcounter != 0 ||
+      MEM_CacheLimiter_get_refcount(item->c_handle) != 0) {
+    moviecache_compressed_free(item);
+    return;
+  }
+
+  PRINT("%s: cache '%s' compress item %p buffer %p\n",
+        __func__,
+        item->cache_owner->name,
+        item,
+        ibuf);
+
+  /* Keep the ImBuf for its settings and metadata. */
+  if (ibuf->rect) {
+    imb_freerectImBuf(ibuf);
+  }
+  if (ibuf->rect_float) {
+    imb_freerectfloatImBuf(ibuf);
+  }
+  item->compressed_size = compressed_size;
+  item->cache_owner->compressions++;
+}
+
+/* Decompress the buffers of the item without the locks, they're set with
+ * moviecache_item_decompress_publish(). */
+static void moviecache_item_decompress(const MovieCacheItem *item,
+                                       unsigned int **r_rect,
+                                       float **r_rect_float)
+{
+  const ImBuf *ibuf = item->ibuf;
+  const size_t num_pixels = (size_t)ibuf->x * ibuf->y;
+
+  *r_rect = NULL;
+  *r_rect_float = NULL;
+  if (item->compressed_rect) {
+    *r_rect = moviecache_decompress_buffer(
+        item->compressed_rect, num_pixels * sizeof(unsigned int), "movie cache rect");
+  }
+  if (item->compressed_rect_float) {
+    *r_rect_float = moviecache_decompress_buffer(
+        item->compressed_rect_float, num_pixels * sizeof(float[4]), "movie cache rect float");
+  }
+}
+
+/* Called with limitor_lock. */
+static void moviecache_item_decompress_publish(MovieCacheItem *item,
+                                               unsigned int *rect,
+                                               float *rect_float)
+{
+  ImBuf *ibuf = item->ibuf;
+
+  PRINT("%s: cache '%s' decompress item %p buffer %p\n",
+        __func__,
+        item->cache_owner->name,
+        item,
+        ibuf);
+
+  if (rect) {
+    ibuf->rect = rect;
+    ibuf->mall |= IB_rect;
+  }
+  if (rect_float) {
+    ibuf->rect_float = rect_float;
+    ibuf->mall |= IB_rectfloat;
+  }
+  moviecache_compressed_free(item);
+  item->cache_owner->decompressions++;
+}
+
+/* Compress the frames with the least priority until the cache fits into the memory limit, then
+ * free frames when that's not enough. Called with limitor_lock, which is released while the
+ * buffers are compressed. */
+static void moviecache_enforce_limits(void)
+{
+  const size_t mem_limit = MEM_CacheLimiter_get_maximum();
+  size_t mem_in_use = MEM_CacheLimiter_get_memory_in_use(limitor);
+
+  if (mem_limit != 0 && !MEM_CacheLimiter_is_disabled()) {
+    while (mem_in_use > mem_limit) {
+      MovieCacheItem *coldest = NULL;
+      int coldest_priority = 0;
+
+      BLI_mutex_lock(&items_lock);
+      LISTBASE_FOREACH (MovieCacheItem *, item, &moviecache_items) {
+        if (moviecache_item_compressible(item)) {
+          /* Like the default priority of the limiter, of least recently used items. */
+          const int priority = get_item_priority(item,
+                                                 -(int)(moviecache_clock - item->last_used));
+          if (coldest == NULL || priority < coldest_priority) {
+            coldest = item;
+            coldest_priority = priority;
+          }
+        }
+      }
+      if (coldest) {
+        coldest->is_compressing = true;
+      }
+      BLI_mutex_unlock(&items_lock);
+
+      if (coldest == NULL) {
+        break;
+      }
+
+      const unsigned int last_used = coldest->last_used;
+
+      /* Referenced so the limiter doesn't free the frame, its cache waits for is_compressing
+       * to be cleared before freeing it. */
+      MEM_CacheLimiter_ref(coldest->c_handle);
+      BLI_mutex_unlock(&limitor_lock);
+
+      const size_t compressed_size = moviecache_item_compress(coldest);
+
+      BLI_mutex_lock(&limitor_lock);
+      MEM_CacheLimiter_unref(coldest->c_handle);
+      moviecache_item_compress_publish(coldest, compressed_size, last_used);
+      moviecache_item_compress_end(coldest);
+
+      /* Other frames might have been added or used without the lock. */
+      mem_in_use = MEM_CacheLimiter_get_memory_in_use(limitor);
+    }
+  }
+
+  MEM_CacheLimiter_enforce_limits(limitor);
+}
+
+void IMB_moviecache_set_compression(MovieCache *cache, bool use_compression)
+{
+  cache->use_compression = use_compression;
+}
+
+/** \} */
+
 void IMB_moviecache_init(void)
 {
   limitor = new_MEM_CacheLimiter(IMB_moviecache_destructor, get_item_size);
 
   MEM_CacheLimiter_ItemPriority_Func_set(limitor, get_item_priority);
   MEM_CacheLimiter_ItemDestroyable_Func_set(limitor, get_item_destroyable);
+
+  BLI_condition_init(&items_cond);
 }
 
 void IMB_moviecache_destruct(void)
 {
   if (limitor) {
     delete_MEM_CacheLimiter(limitor);
+    BLI_condition_end(&items_cond);
   }
 }
 
@@ -284,6 +623,10 @@ MovieCache *IMB_moviecache_create(const char *name,
   cache->cmpfp = cmpfp;
   cache->proxy = -1;
 
+  BLI_mutex_lock(&limitor_lock);
+  BLI_addtail(&moviecache_caches, cache);
+  BLI_mutex_unlock(&limitor_lock);
+
   return cache;
 }
 
@@ -304,7 +647,8 @@ void IMB_moviecache_set_priority_callback(struct MovieCache *cache,
   cache->prioritydeleterfp = prioritydeleterfp;
 }
 
-static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, bool need_lock)
+static void do_moviecache_put(
+    MovieCache *cache, void *userkey, ImBuf *ibuf, float cost, bool need_lock)
 {
   MovieCacheKey *key;
   MovieCacheItem *item;
@@ -324,10 +668,10 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
 
   PRINT("%s: cache '%s' put %p, item %p\n", __func__, cache->name, ibuf, item);
 
+  memset(item, 0, sizeof(*item));
   item->ibuf = ibuf;
   item->cache_owner = cache;
-  item->c_handle = NULL;
-  item->priority_data = NULL;
+  item->cost = cost;
 
   if (cache->getprioritydatafp) {
     item->priority_data = cache->getprioritydatafp(userkey);
@@ -344,9 +688,14 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
   }
 
   item->c_handle = MEM_CacheLimiter_insert(limitor, item);
+  item->last_used = ++moviecache_clock;
+
+  BLI_mutex_lock(&items_lock);
+  BLI_addtail(&moviecache_items, item);
+  BLI_mutex_unlock(&items_lock);
 
   MEM_CacheLimiter_ref(item->c_handle);
-  MEM_CacheLimiter_enforce_limits(limitor);
+  moviecache_enforce_limits();
   MEM_CacheLimiter_unref(item->c_handle);
 
   if (need_lock) {
@@ -364,7 +713,16 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
 
 void IMB_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf)
 {
-  do_moviecache_put(cache, userkey, ibuf, true);
+  do_moviecache_put(cache, userkey, ibuf, 0.0f, true);
+}
+
+/**
+ * Put \a ibuf into the cache, \a cost is the time in seconds it took to create it. Frames which
+ * are more expensive to create again are kept longer when the cache is full.
+ */
+void IMB_moviecache_put_ex(MovieCache *cache, void *userkey, ImBuf *ibuf, float cost)
+{
+  do_moviecache_put(cache, userkey, ibuf, cost, true);
 }
 
 bool IMB_moviecache_put_if_possible(MovieCache *cache, void *userkey, ImBuf *ibuf)
@@ -379,7 +737,7 @@ bool IMB_moviecache_put_if_possible(MovieCache *cache, void *userkey, ImBuf *ibu
   mem_in_use = MEM_CacheLimiter_get_memory_in_use(limitor);
 
   if (mem_in_use + elem_size <= mem_limit) {
-    do_moviecache_put(cache, userkey, ibuf, false);
+    do_moviecache_put(cache, userkey, ibuf, 0.0f, false);
     result = true;
   }
 
@@ -400,24 +758,69 @@ ImBuf *IMB_moviecache_get(MovieCache *cache, void *userkey)
 {
   MovieCacheKey key;
   MovieCacheItem *item;
+  ImBuf *ibuf;
 
   key.cache_owner = cache;
   key.userkey = userkey;
   item = (MovieCacheItem *)BLI_ghash_lookup(cache->hash, &key);
 
-  if (item) {
-    if (item->ibuf) {
-      BLI_mutex_lock(&limitor_lock);
-      MEM_CacheLimiter_touch(item->c_handle);
-      BLI_mutex_unlock(&limitor_lock);
+  if (item == NULL) {
+    atomic_add_and_fetch_int32(&cache->misses, 1);
+    return NULL;
+  }
 
-      IMB_refImBuf(item->ibuf);
+  BLI_mutex_lock(&limitor_lock);
 
-      return item->ibuf;
+  ibuf = item->ibuf;
+  if (ibuf == NULL) {
+    BLI_mutex_unlock(&limitor_lock);
+    atomic_add_and_fetch_int32(&cache->misses, 1);
+    return NULL;
+  }
+
+  /* Referenced before unlocking, so the buffers aren't compressed again. */
+  IMB_refImBuf(ibuf);
+  MEM_CacheLimiter_touch(item->c_handle);
+  item->last_used = ++moviecache_clock;
+  atomic_add_and_fetch_int32(&cache->hits, 1);
+
+  if (item->compressed_size) {
+    /* Decompressed without the lock, or waiting for another thread decompressing it. */
+    MEM_CacheLimiter_ref(item->c_handle);
+
+    BLI_mutex_lock(&items_lock);
+    const bool do_decompress = !item->is_compressing;
+    item->is_compressing = true;
+    BLI_mutex_unlock(&items_lock);
+
+    BLI_mutex_unlock(&limitor_lock);
+
+    if (do_decompress) {
+      unsigned int *rect;
+      float *rect_float;
+      moviecache_item_decompress(item, &rect, &rect_float);
+
+      BLI_mutex_lock(&limitor_lock);
+      moviecache_item_decompress_publish(item, rect, rect_float);
+      moviecache_item_compress_end(item);
+      moviecache_enforce_limits();
     }
+    else {
+      BLI_mutex_lock(&items_lock);
+      while (item->is_compressing) {
+        BLI_condition_wait(&items_cond, &items_lock);
+      }
+      BLI_mutex_unlock(&items_lock);
+
+      BLI_mutex_lock(&limitor_lock);
+    }
+
+    MEM_CacheLimiter_unref(item->c_handle);
   }
 
-  return NULL;
+  BLI_mutex_unlock(&limitor_lock);
+
+  return ibuf;
 }
 
 bool IMB_moviecache_has_frame(MovieCache *cache, void *userkey)
@@ -436,6 +839,10 @@ void IMB_moviecache_free(MovieCache *cache)
 {
   PRINT("%s: cache '%s' free\n", __func__, cache->name);
 
+  BLI_mutex_lock(&limitor_lock);
+  BLI_remlink(&moviecache_caches, cache);
+  BLI_mutex_unlock(&limitor_lock);
+
   BLI_ghash_free(cache->hash, moviecache_keyfree, moviecache_valfree);
 
   BLI_mempool_destroy(cache->keys_pool);
@@ -568,6 +975,78 @@ void IMB_moviecache_get_cache_segments(
   }
 }
 
+/* Called with limitor_lock and items_lock. */
+static void moviecache_get_stats(MovieCache *cache, MovieCacheStats *r_stats)
+{
+  memset(r_stats, 0, sizeof(*r_stats));
+
+  LISTBASE_FOREACH (MovieCacheItem *, item, &moviecache_items) {
+    if (item->cache_owner != cache || item->ibuf == NULL) {
+      continue;
+    }
+    if (item->compressed_size) {
+      r_stats->num_compressed++;
+      r_stats->compressed_memory += item->compressed_size;
+    }
+    else {
+      r_stats->num_items++;
+      r_stats->memory += get_size_in_memory(item->ibuf);
+    }
+    r_stats->cost += item->cost;
+  }
+
+  r_stats->hits = atomic_add_and_fetch_int32(&cache->hits, 0);
+  r_stats->misses = atomic_add_and_fetch_int32(&cache->misses, 0);
+  r_stats->compressions = cache->compressions;
+  r_stats->decompressions = cache->decompressions;
+  r_stats->evictions = cache->evictions;
+}
+
+void IMB_moviecache_get_stats(MovieCache *cache, MovieCacheStats *r_stats)
+{
+  BLI_mutex_lock(&limitor_lock);
+  BLI_mutex_lock(&items_lock);
+  moviecache_get_stats(cache, r_stats);
+  BLI_mutex_unlock(&items_lock);
+  BLI_mutex_unlock(&limitor_lock);
+}
+
+#define MOVIECACHE_MB(bytes) ((double)(bytes) / (1024.0 * 1024.0))
+
+/* Print the statistics of all caches, for debugging cache policies. */
+void IMB_moviecache_print_stats(void)
+{
+  BLI_mutex_lock(&limitor_lock);
+  BLI_mutex_lock(&items_lock);
+
+  printf("Movie cache: %.2f of %.2f MB in use\n",
+         MOVIECACHE_MB(limitor ? MEM_CacheLimiter_get_memory_in_use(limitor) : 0),
+         MOVIECACHE_MB(MEM_CacheLimiter_get_maximum()));
+
+  LISTBASE_FOREACH (MovieCache *, cache, &moviecache_caches) {
+    MovieCacheStats stats;
+    moviecache_get_stats(cache, &stats);
+
+    printf("  %s %p: %d frames %.2f MB, %d compressed %.2f MB, cost %.3fs\n",
+           cache->name,
+           (void *)cache,
+           stats.num_items,
+           MOVIECACHE_MB(stats.memory),
+           stats.num_compressed,
+           MOVIECACHE_MB(stats.compressed_memory),
+           stats.cost);
+    printf("    %d hits, %d misses, %d compressions, %d decompressions, %d evictions\n",
+           stats.hits,
+           stats.misses,
+           stats.compressions,
+           stats.decompressions,
+           stats.evictions);
+  }
+
+  BLI_mutex_unlock(&items_lock);
+  BLI_mutex_unlock(&limitor_lock);
+}
+
 struct MovieCacheIter *IMB_moviecacheIter_new(MovieCache *cache)
 {
   GHashIterator *iter;
@@ -78,6 +78,7 @@ _CRTIMP void __cdecl _invalid_parameter_noinfo(void)
 
 #include "BLI_blenlib.h"
 #include "BLI_math_color.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BKE_idprop.h"
@@ -1207,83 +1208,216 @@ void IMB_exrtile_write_channels(
   }
 }
 
-void IMB_exr_read_channels(void *handle)
+/* check if exr was saved with previous versions of blender which flipped images */
+static bool imb_exr_is_flipped(ExrHandle *data)
 {
-  ExrHandle *data = (ExrHandle *)handle;
-  int numparts = data->ifile->parts();
-
-  /* check if exr was saved with previous versions of blender which flipped images */
   const StringAttribute *ta = data->ifile->header(0).findTypedAttribute<StringAttribute>(
       "BlenderMultiChannel");
 
   /* 'previous multilayer attribute, flipped. */
-  short flip = (ta && STREQLEN(ta->value().c_str(), "Blender V2.43", 13));
+  return (ta && STREQLEN(ta->value().c_str(), "Blender V2.43", 13));
+}
 
-  exr_printf(
-      "\nIMB_exr_read_channels\n%s %-6s %-22s "
-      "\"%s\"\n---------------------------------------------------------------------\n",
-      "p",
-      "view",
-      "name",
-      "internal_name");
+static void imb_exr_insert_channel(FrameBuffer &frameBuffer,
+                                   ExrHandle *data,
+                                   ExrChannel *echan,
+                                   const Box2i &dw,
+                                   const bool flip)
+{
+  float *rect = echan->rect;
+  size_t xstride = echan->xstride * sizeof(float);
+  size_t ystride = echan->ystride * sizeof(float);
 
-  for (int i = 0; i < numparts; i++) {
+  if (!flip) {
+    /* Inverse correct first pixel for data-window coordinates. */
+    rect -= echan->xstride * (dw.min.x - dw.min.y * data->width);
+    /* move to last scanline to flip to Blender convention */
+    rect += echan->xstride * (data->height - 1) * data->width;
+    ystride = -ystride;
+  }
+  else {
+    /* Inverse correct first pixel for data-window coordinates. */
+    rect -= echan->xstride * (dw.min.x + dw.min.y * data->width);
+  }
+
+  frameBuffer.insert(echan->m->internal_name, Slice(Imf::FLOAT, (char *)rect, xstride, ystride));
+}
+
+typedef struct ExrReadData {
+  ExrHandle *data;
+  /* Only read the channels of this pass, all channels when NULL. */
+  ExrPass *pass;
+  bool flip;
+} ExrReadData;
+
+/* Parts are decoded in parallel, each part further splits its scanline blocks over the
+ * global OpenEXR thread pool. */
+static void imb_exr_read_part_task(void *__restrict userdata,
+                                   const int part,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  ExrReadData *read_data = (ExrReadData *)userdata;
+  ExrHandle *data = read_data->data;
+  ExrChannel *echan;
+  bool has_channels = false;
+
+  try {
     /* Read part header. */
-    InputPart in(*data->ifile, i);
+    InputPart in(*data->ifile, part);
     Header header = in.header();
     Box2i dw = header.dataWindow();
 
     /* Insert all matching channel into framebuffer. */
     FrameBuffer frameBuffer;
-    ExrChannel *echan;
 
-    for (echan = (ExrChannel *)data->channels.first; echan; echan = echan->next) {
-      if (echan->m->part_number != i) {
-        continue;
+    if (read_data->pass) {
+      for (int a = 0; a < read_data->pass->totchan; a++) {
+        echan = read_data->pass->chan[a];
+        if (echan->m->part_number == part) {
+          imb_exr_insert_channel(frameBuffer, data, echan, dw, read_data->flip);
+          has_channels = true;
+        }
       }
+    }
+    else {
+      for (echan = (ExrChannel *)data->channels.first; echan; echan = echan->next) {
+        if (echan->m->part_number != part) {
+          continue;
+        }
 
-      exr_printf("%d %-6s %-22s \"%s\"\n",
-                 echan->m->part_number,
-                 echan->m->view.c_str(),
-                 echan->m->name.c_str(),
-                 echan->m->internal_name.c_str());
+        exr_printf("%d %-6s %-22s \"%s\"\n",
+                   echan->m->part_number,
+                   echan->m->view.c_str(),
+                   echan->m->name.c_str(),
+                   echan->m->internal_name.c_str());
 
-      if (echan->rect) {
-        float *rect = echan->rect;
-        size_t xstride = echan->xstride * sizeof(float);
-        size_t ystride = echan->ystride * sizeof(float);
-
-        if (!flip) {
-          /* Inverse correct first pixel for data-window coordinates. */
-          rect -= echan->xstride * (dw.min.x - dw.min.y * data->width);
-          /* move to last scanline to flip to Blender convention */
-          rect += echan->xstride * (data->height - 1) * data->width;
-          ystride = -ystride;
+        if (echan->rect) {
+          imb_exr_insert_channel(frameBuffer, data, echan, dw, read_data->flip);
+          has_channels = true;
         }
         else {
-          /* Inverse correct first pixel for data-window coordinates. */
-          rect -= echan->xstride * (dw.min.x + dw.min.y * data->width);
+          printf("warning, channel with no rect set %s\n", echan->m->internal_name.c_str());
         }
-
-        frameBuffer.insert(echan->m->internal_name,
-                           Slice(Imf::FLOAT, (char *)rect, xstride, ystride));
-      }
-      else {
-        printf("warning, channel with no rect set %s\n", echan->m->internal_name.c_str());
       }
     }
 
+    if (!has_channels) {
+      return;
+    }
+
     /* Read pixels. */
-    try {
-      in.setFrameBuffer(frameBuffer);
-      exr_printf("readPixels:readPixels[%d]: min.y: %d, max.y: %d\n", i, dw.min.y, dw.max.y);
-      in.readPixels(dw.min.y, dw.max.y);
+    in.setFrameBuffer(frameBuffer);
+    exr_printf("readPixels:readPixels[%d]: min.y: %d, max.y: %d\n", part, dw.min.y, dw.max.y);
+    in.readPixels(dw.min.y, dw.max.y);
+  }
+  catch (const std::exception &exc) {
+    std::cerr << "OpenEXR-readPixels: ERROR: " << exc.what() << std::endl;
+  }
+}
+
+static void imb_exr_read_parts(ExrHandle *data, ExrPass *pass)
+{
+  ExrReadData read_data;
+  read_data.data = data;
+  read_data.pass = pass;
+  read_data.flip = imb_exr_is_flipped(data);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, data->ifile->parts(), &read_data, imb_exr_read_part_task, &settings);
+}
+
+void IMB_exr_read_channels(void *handle)
+{
+  ExrHandle *data = (ExrHandle *)handle;
+
+  exr_printf(
+      "\nIMB_exr_read_channels\n%s %-6s %-22s "
+      "\"%s\"\n---------------------------------------------------------------------\n",
+      "p",
+      "view",
+      "name",
+      "internal_name");
+
+  imb_exr_read_parts(data, NULL);
+}
+
+/* Interleave the channels of a pass in rect, NULL unassigns them. */
+static void imb_exr_pass_assign_rect(ExrPass *pass, float *rect, int width)
+{
+  char lookup[256];
+  int a;
+
+  memset(lookup, 0, sizeof(lookup));
+
+  /* we can have RGB(A), XYZ(W), UVA */
+  const bool use_lookup = (pass->totchan == 3 || pass->totchan == 4);
+  if (use_lookup) {
+    if (pass->chan[0]->chan_id == 'B' || pass->chan[1]->chan_id == 'B' ||
+        pass->chan[2]->chan_id == 'B') {
+      lookup[(unsigned int)'R'] = 0;
+      lookup[(unsigned int)'G'] = 1;
+      lookup[(unsigned int)'B'] = 2;
+      lookup[(unsigned int)'A'] = 3;
+    }
+    else if (pass->chan[0]->chan_id == 'Y' || pass->chan[1]->chan_id == 'Y' ||
+             pass->chan[2]->chan_id == 'Y') {
+      lookup[(unsigned int)'X'] = 0;
+      lookup[(unsigned int)'Y'] = 1;
+      lookup[(unsigned int)'Z'] = 2;
+      lookup[(unsigned int)'W'] = 3;
     }
-    catch (const std::exception &exc) {
-      std::cerr << "OpenEXR-readPixels: ERROR: " << exc.what() << std::endl;
+    else {
+      lookup[(unsigned int)'U'] = 0;
+      lookup[(unsigned int)'V'] = 1;
+      lookup[(unsigned int)'A'] = 2;
+    }
+  }
+
+  for (a = 0; a < pass->totchan; a++) {
+    ExrChannel *echan = pass->chan[a];
+    /* unknown layouts keep the channel order */
+    const int offset = use_lookup ? lookup[(unsigned int)echan->chan_id] : a;
+
+    echan->rect = rect ? rect + offset : NULL;
+    echan->xstride = pass->totchan;
+    echan->ystride = width * pass->totchan;
+    pass->chan_id[offset] = echan->chan_id;
+  }
+}
+
+float *IMB_exr_read_pass(void *handle,
+                         const char *layname,
+                         const char *passname,
+                         const char *viewname)
+{
+  ExrHandle *data = (ExrHandle *)handle;
+  ExrLayer *lay = (ExrLayer *)BLI_findstring(&data->layers, layname, offsetof(ExrLayer, name));
+  ExrPass *pass;
+
+  if (lay == NULL || data->ifile == NULL) {
+    return NULL;
+  }
+
+  for (pass = (ExrPass *)lay->passes.first; pass; pass = pass->next) {
+    if (STREQ(pass->internal_name, passname) && STREQ(pass->view, viewname)) {
       break;
     }
   }
+
+  if (pass == NULL || pass->totchan == 0) {
+    return NULL;
+  }
+
+  float *rect = (float *)MEM_mapallocN(
+      (size_t)data->width * data->height * pass->totchan * sizeof(float), "pass rect");
+
+  imb_exr_pass_assign_rect(pass, rect, data->width);
+  imb_exr_read_parts(data, pass);
+  imb_exr_pass_assign_rect(pass, NULL, data->width);
+
+  return rect;
 }
 
 void IMB_exr_multilayer_convert(void *handle,
@@ -1531,13 +1665,13 @@ static ExrPass *imb_exr_get_pass(ListBase *lb, char *passname)
 static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream,
                                          MultiPartInputFile &file,
                                          int width,
-                                         int height)
+                                         int height,
+                                         const bool lazy)
 {
   ExrLayer *lay;
   ExrPass *pass;
   ExrChannel *echan;
   ExrHandle *data = (ExrHandle *)IMB_exr_get_handle();
-  int a;
   char layname[EXR_TOT_MAXNAME], passname[EXR_TOT_MAXNAME];
 
   data->ifile_stream = &file_stream;
@@ -1602,59 +1736,11 @@ static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream,
   for (lay = (ExrLayer *)data->layers.first; lay; lay = lay->next) {
     for (pass = (ExrPass *)lay->passes.first; pass; pass = pass->next) {
       if (pass->totchan) {
-        pass->rect = (float *)MEM_mapallocN(width * height * pass->totchan * sizeof(float),
-                                            "pass rect");
-        if (pass->totchan == 1) {
-          echan = pass->chan[0];
-          echan->rect = pass->rect;
-          echan->xstride = 1;
-          echan->ystride = width;
-          pass->chan_id[0] = echan->chan_id;
-        }
-        else {
-          char lookup[256];
-
-          memset(lookup, 0, sizeof(lookup));
-
-          /* we can have RGB(A), XYZ(W), UVA */
-          if (pass->totchan == 3 || pass->totchan == 4) {
-            if (pass->chan[0]->chan_id == 'B' || pass->chan[1]->chan_id == 'B' ||
-                pass->chan[2]->chan_id == 'B') {
-              lookup[(unsigned int)'R'] = 0;
-              lookup[(unsigned int)'G'] = 1;
-              lookup[(unsigned int)'B'] = 2;
-              lookup[(unsigned int)'A'] = 3;
-            }
-            else if (pass->chan[0]->chan_id == 'Y' || pass->chan[1]->chan_id == 'Y' ||
-                     pass->chan[2]->chan_id == 'Y') {
-              lookup[(unsigned int)'X'] = 0;
-              lookup[(unsigned int)'Y'] = 1;
-              lookup[(unsigned int)'Z'] = 2;
-              lookup[(unsigned int)'W'] = 3;
-            }
-            else {
-              lookup[(unsigned int)'U'] = 0;
-              lookup[(unsigned int)'V'] = 1;
-              lookup[(unsigned int)'A'] = 2;
-            }
-            for (a = 0; a < pass->totchan; a++) {
-              echan = pass->chan[a];
-              echan->rect = pass->rect + lookup[(unsigned int)echan->chan_id];
-              echan->xstride = pass->totchan;
-              echan->ystride = width * pass->totchan;
-              pass->chan_id[(unsigned int)lookup[(unsigned int)echan->chan_id]] = echan->chan_id;
-            }
-          }
-          else { /* unknown */
-            for (a = 0; a < pass->totchan; a++) {
-              echan = pass->chan[a];
-              echan->rect = pass->rect + a;
-              echan->xstride = pass->totchan;
-              echan->ystride = width * pass->totchan;
-              pass->chan_id[a] = echan->chan_id;
-            }
-          }
+        if (!lazy) {
+          pass->rect = (float *)MEM_mapallocN(width * height * pass->totchan * sizeof(float),
+                                              "pass rect");
         }
+        imb_exr_pass_assign_rect(pass, pass->rect, width);
       }
     }
   }
@@ -1867,26 +1953,20 @@ bool IMB_exr_has_multilayer(void *handle)
   return imb_exr_is_multi(*data->ifile);
 }
 
-struct ImBuf *imb_load_openexr(const unsigned char *mem,
-                               size_t size,
-                               int flags,
-                               char colorspace[IM_MAX_SPACE])
+/* Load from the stream, which is owned by the ImBuf's multilayer handle or deleted. */
+static struct ImBuf *imb_load_openexr_stream(IStream *stream,
+                                             int flags,
+                                             char colorspace[IM_MAX_SPACE])
 {
   struct ImBuf *ibuf = NULL;
-  IMemStream *membuf = NULL;
   MultiPartInputFile *file = NULL;
 
-  if (imb_is_a_openexr(mem) == 0) {
-    return (NULL);
-  }
-
   colorspace_set_default_role(colorspace, IM_MAX_SPACE, COLOR_ROLE_DEFAULT_FLOAT);
 
   try {
     bool is_multi;
 
-    membuf = new IMemStream((unsigned char *)mem, size);
-    file = new MultiPartInputFile(*membuf);
+    file = new MultiPartInputFile(*stream);
 
     Box2i dw = file->header(0).dataWindow();
     const int width = dw.max.x - dw.min.x + 1;
@@ -1904,6 +1984,8 @@ struct ImBuf *imb_load_openexr(const unsigned char *mem,
     /* do not make an ibuf when */
     if (is_multi && !(flags & IB_test) && !(flags & IB_multilayer)) {
       printf("Error: can't process EXR multilayer file\n");
+      delete file;
+      delete stream;
     }
     else {
       const int is_alpha = exr_has_alpha(*file);
@@ -1938,10 +2020,14 @@ struct ImBuf *imb_load_openexr(const unsigned char *mem,
 
         /* Only enters with IB_multilayer flag set. */
         if (is_multi && ((flags & IB_thumbnail) == 0)) {
+          const bool lazy = (flags & IB_multilayer_lazy) != 0;
+
           /* constructs channels for reading, allocates memory in channels */
-          ExrHandle *handle = imb_exr_begin_read_mem(*membuf, *file, width, height);
+          ExrHandle *handle = imb_exr_begin_read_mem(*stream, *file, width, height, lazy);
           if (handle) {
-            IMB_exr_read_channels(handle);
+            if (!lazy) {
+              IMB_exr_read_channels(handle);
+            }
             ibuf->userdata = handle; /* potential danger, the caller has to check for this! */
           }
         }
@@ -2033,12 +2119,12 @@ struct ImBuf *imb_load_openexr(const unsigned char *mem,
           }
 
           /* file is no longer needed */
-          delete membuf;
+          delete stream;
           delete file;
         }
       }
       else {
-        delete membuf;
+        delete stream;
         delete file;
       }
 
@@ -2054,12 +2140,55 @@ struct ImBuf *imb_load_openexr(const unsigned char *mem,
       IMB_freeImBuf(ibuf);
     }
     delete file;
-    delete membuf;
+    delete stream;
 
     return (0);
   }
 }
 
+struct ImBuf *imb_load_openexr(const unsigned char *mem,
+                               size_t size,
+                               int flags,
+                               char colorspace[IM_MAX_SPACE])
+{
+  if (imb_is_a_openexr(mem) == 0) {
+    return (NULL);
+  }
+
+  /* The memory is freed after loading, passes can only be read on demand from a file. */
+  return imb_load_openexr_stream(
+      new IMemStream((unsigned char *)mem, size), flags & ~IB_multilayer_lazy, colorspace);
+}
+
+/* Multilayer files loaded with IB_multilayer_lazy keep reading their passes from the file, other
+ * files are loaded from memory. */
+struct ImBuf *imb_load_openexr_filepath(const char *filepath,
+                                        int flags,
+                                        char colorspace[IM_MAX_SPACE])
+{
+  IFileStream *file_stream = NULL;
+  char magic[4];
+
+  if ((flags & IB_multilayer_lazy) == 0) {
+    return (NULL);
+  }
+
+  try {
+    file_stream = new IFileStream(filepath);
+    if (!file_stream->read(magic, sizeof(magic)) || !Imf::isImfMagic(magic)) {
+      delete file_stream;
+      return (NULL);
+    }
+    file_stream->seekg(0);
+  }
+  catch (const std::exception &) {
+    delete file_stream;
+    return (NULL);
+  }
+
+  return imb_load_openexr_stream(file_stream, flags, colorspace);
+}
+
 void imb_initopenexr(void)
 {
   int num_threads = BLI_system_thread_count();
@@ -38,6 +38,7 @@ int imb_is_a_openexr(const unsigned char *mem);
 int imb_save_openexr(struct ImBuf *ibuf, const char *name, int flags);
 
 struct ImBuf *imb_load_openexr(const unsigned char *mem, size_t size, int flags, char *colorspace);
+struct ImBuf *imb_load_openexr_filepath(const char *filepath, int flags, char *colorspace);
 
 #ifdef __cplusplus
 }
@@ -73,6 +73,11 @@ float *IMB_exr_channel_rect(void *handle,
                             const char *view);
 
 void IMB_exr_read_channels(void *handle);
+/* Decode a single pass of a file loaded with IB_multilayer_lazy, the caller owns the result. */
+float *IMB_exr_read_pass(void *handle,
+                         const char *layname,
+                         const char *passname,
+                         const char *viewname);
 void IMB_exr_write_channels(void *handle);
 void IMB_exrtile_write_channels(
     void *handle, int partx, int party, int level, const char *viewname, bool empty);
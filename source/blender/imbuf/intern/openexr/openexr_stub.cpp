@@ -88,6 +88,13 @@ float *IMB_exr_channel_rect(void * /*handle*/,
 void IMB_exr_read_channels(void * /*handle*/)
 {
 }
+float *IMB_exr_read_pass(void * /*handle*/,
+                         const char * /*layname*/,
+                         const char * /*passname*/,
+                         const char * /*viewname*/)
+{
+  return NULL;
+}
 void IMB_exr_write_channels(void * /*handle*/)
 {
 }
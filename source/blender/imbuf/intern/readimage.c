@@ -132,10 +132,7 @@ ImBuf *IMB_ibImageFromMemory(const unsigned char *mem,
   return NULL;
 }
 
-static ImBuf *IMB_ibImageFromFile(const char *filepath,
-                                  int flags,
-                                  char colorspace[IM_MAX_SPACE],
-                                  const char *descr)
+static ImBuf *imb_load_filepath(const char *filepath, int flags, char colorspace[IM_MAX_SPACE])
 {
   ImBuf *ibuf;
   const ImFileType *type;
@@ -155,11 +152,21 @@ static ImBuf *IMB_ibImageFromFile(const char *filepath,
     }
   }
 
-  if ((flags & IB_test) == 0) {
+  return NULL;
+}
+
+static ImBuf *IMB_ibImageFromFile(const char *filepath,
+                                  int flags,
+                                  char colorspace[IM_MAX_SPACE],
+                                  const char *descr)
+{
+  ImBuf *ibuf = imb_load_filepath(filepath, flags, colorspace);
+
+  if (ibuf == NULL && (flags & IB_test) == 0) {
     fprintf(stderr, "%s: unknown fileformat (%s)\n", __func__, descr);
   }
 
-  return NULL;
+  return ibuf;
 }
 
 static bool imb_is_filepath_format(const char *filepath)
@@ -183,6 +190,14 @@ ImBuf *IMB_loadifffile(
     return IMB_ibImageFromFile(filepath, flags, colorspace, descr);
   }
 
+  /* Multilayer files keep reading their passes from the file, when the format supports it. */
+  if (flags & IB_multilayer_lazy) {
+    ibuf = imb_load_filepath(filepath, flags, colorspace);
+    if (ibuf) {
+      return ibuf;
+    }
+  }
+
   size = BLI_file_descriptor_size(file);
 
   imb_mmap_lock();
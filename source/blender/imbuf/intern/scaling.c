@@ -25,6 +25,7 @@
 #include "BLI_utildefines.h"
 #include "BLI_math_color.h"
 #include "BLI_math_interp.h"
+#include "BLI_task.h"
 #include "MEM_guardedalloc.h"
 
 #include "imbuf.h"
@@ -35,6 +36,10 @@
 
 #include "BLI_sys_types.h"  // for intptr_t support
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 static void imb_half_x_no_alloc(struct ImBuf *ibuf2, struct ImBuf *ibuf1)
 {
   uchar *p1, *_p1, *dest;
@@ -906,648 +911,6 @@ static bool q_scale_linear_interpolation(struct ImBuf *ibuf, int newx, int newy)
   return true;
 }
 
-static ImBuf *scaledownx(struct ImBuf *ibuf, int newx)
-{
-  const int do_rect = (ibuf->rect != NULL);
-  const int do_float = (ibuf->rect_float != NULL);
-  const size_t rect_size = ibuf->x * ibuf->y * 4;
-
-  uchar *rect, *_newrect, *newrect;
-  float *rectf, *_newrectf, *newrectf;
-  float sample, add, val[4], nval[4], valf[4], nvalf[4];
-  int x, y;
-
-  rectf = _newrectf = newrectf = NULL;
-  rect = _newrect = newrect = NULL;
-  nval[0] = nval[1] = nval[2] = nval[3] = 0.0f;
-  nvalf[0] = nvalf[1] = nvalf[2] = nvalf[3] = 0.0f;
-
-  if (!do_rect && !do_float) {
-    return (ibuf);
-  }
-
-  if (do_rect) {
-    _newrect = MEM_mallocN(newx * ibuf->y * sizeof(uchar) * 4, "scaledownx");
-    if (_newrect == NULL) {
-      return (ibuf);
-    }
-  }
-  if (do_float) {
-    _newrectf = MEM_mallocN(newx * ibuf->y * sizeof(float) * 4, "scaledownxf");
-    if (_newrectf == NULL) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
-      }
-      return (ibuf);
-    }
-  }
-
-  add = (ibuf->x - 0.01) / newx;
-
-  if (do_rect) {
-    rect = (uchar *)ibuf->rect;
-    newrect = _newrect;
-  }
-  if (do_float) {
-    rectf = ibuf->rect_float;
-    newrectf = _newrectf;
-  }
-
-  for (y = ibuf->y; y > 0; y--) {
-    sample = 0.0f;
-    val[0] = val[1] = val[2] = val[3] = 0.0f;
-    valf[0] = valf[1] = valf[2] = valf[3] = 0.0f;
-
-    for (x = newx; x > 0; x--) {
-      if (do_rect) {
-        nval[0] = -val[0] * sample;
-        nval[1] = -val[1] * sample;
-        nval[2] = -val[2] * sample;
-        nval[3] = -val[3] * sample;
-      }
-      if (do_float) {
-        nvalf[0] = -valf[0] * sample;
-        nvalf[1] = -valf[1] * sample;
-        nvalf[2] = -valf[2] * sample;
-        nvalf[3] = -valf[3] * sample;
-      }
-
-      sample += add;
-
-      while (sample >= 1.0f) {
-        sample -= 1.0f;
-
-        if (do_rect) {
-          nval[0] += rect[0];
-          nval[1] += rect[1];
-          nval[2] += rect[2];
-          nval[3] += rect[3];
-          rect += 4;
-        }
-        if (do_float) {
-          nvalf[0] += rectf[0];
-          nvalf[1] += rectf[1];
-          nvalf[2] += rectf[2];
-          nvalf[3] += rectf[3];
-          rectf += 4;
-        }
-      }
-
-      if (do_rect) {
-        val[0] = rect[0];
-        val[1] = rect[1];
-        val[2] = rect[2];
-        val[3] = rect[3];
-        rect += 4;
-
-        newrect[0] = ((nval[0] + sample * val[0]) / add + 0.5f);
-        newrect[1] = ((nval[1] + sample * val[1]) / add + 0.5f);
-        newrect[2] = ((nval[2] + sample * val[2]) / add + 0.5f);
-        newrect[3] = ((nval[3] + sample * val[3]) / add + 0.5f);
-
-        newrect += 4;
-      }
-      if (do_float) {
-
-        valf[0] = rectf[0];
-        valf[1] = rectf[1];
-        valf[2] = rectf[2];
-        valf[3] = rectf[3];
-        rectf += 4;
-
-        newrectf[0] = ((nvalf[0] + sample * valf[0]) / add);
-        newrectf[1] = ((nvalf[1] + sample * valf[1]) / add);
-        newrectf[2] = ((nvalf[2] + sample * valf[2]) / add);
-        newrectf[3] = ((nvalf[3] + sample * valf[3]) / add);
-
-        newrectf += 4;
-      }
-
-      sample -= 1.0f;
-    }
-  }
-
-  if (do_rect) {
-    // printf("%ld %ld\n", (uchar *)rect - ((uchar *)ibuf->rect), rect_size);
-    BLI_assert((uchar *)rect - ((uchar *)ibuf->rect) == rect_size); /* see bug [#26502] */
-    imb_freerectImBuf(ibuf);
-    ibuf->mall |= IB_rect;
-    ibuf->rect = (unsigned int *)_newrect;
-  }
-  if (do_float) {
-    // printf("%ld %ld\n", rectf - ibuf->rect_float, rect_size);
-    BLI_assert((rectf - ibuf->rect_float) == rect_size); /* see bug [#26502] */
-    imb_freerectfloatImBuf(ibuf);
-    ibuf->mall |= IB_rectfloat;
-    ibuf->rect_float = _newrectf;
-  }
-  (void)rect_size; /* UNUSED in release builds */
-
-  ibuf->x = newx;
-  return (ibuf);
-}
-
-static ImBuf *scaledowny(struct ImBuf *ibuf, int newy)
-{
-  const int do_rect = (ibuf->rect != NULL);
-  const int do_float = (ibuf->rect_float != NULL);
-  const size_t rect_size = ibuf->x * ibuf->y * 4;
-
-  uchar *rect, *_newrect, *newrect;
-  float *rectf, *_newrectf, *newrectf;
-  float sample, add, val[4], nval[4], valf[4], nvalf[4];
-  int x, y, skipx;
-
-  rectf = _newrectf = newrectf = NULL;
-  rect = _newrect = newrect = NULL;
-  nval[0] = nval[1] = nval[2] = nval[3] = 0.0f;
-  nvalf[0] = nvalf[1] = nvalf[2] = nvalf[3] = 0.0f;
-
-  if (!do_rect && !do_float) {
-    return (ibuf);
-  }
-
-  if (do_rect) {
-    _newrect = MEM_mallocN(newy * ibuf->x * sizeof(uchar) * 4, "scaledowny");
-    if (_newrect == NULL) {
-      return (ibuf);
-    }
-  }
-  if (do_float) {
-    _newrectf = MEM_mallocN(newy * ibuf->x * sizeof(float) * 4, "scaledownyf");
-    if (_newrectf == NULL) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
-      }
-      return (ibuf);
-    }
-  }
-
-  add = (ibuf->y - 0.01) / newy;
-  skipx = 4 * ibuf->x;
-
-  for (x = skipx - 4; x >= 0; x -= 4) {
-    if (do_rect) {
-      rect = ((uchar *)ibuf->rect) + x;
-      newrect = _newrect + x;
-    }
-    if (do_float) {
-      rectf = ibuf->rect_float + x;
-      newrectf = _newrectf + x;
-    }
-
-    sample = 0.0f;
-    val[0] = val[1] = val[2] = val[3] = 0.0f;
-    valf[0] = valf[1] = valf[2] = valf[3] = 0.0f;
-
-    for (y = newy; y > 0; y--) {
-      if (do_rect) {
-        nval[0] = -val[0] * sample;
-        nval[1] = -val[1] * sample;
-        nval[2] = -val[2] * sample;
-        nval[3] = -val[3] * sample;
-      }
-      if (do_float) {
-        nvalf[0] = -valf[0] * sample;
-        nvalf[1] = -valf[1] * sample;
-        nvalf[2] = -valf[2] * sample;
-        nvalf[3] = -valf[3] * sample;
-      }
-
-      sample += add;
-
-      while (sample >= 1.0f) {
-        sample -= 1.0f;
-
-        if (do_rect) {
-          nval[0] += rect[0];
-          nval[1] += rect[1];
-          nval[2] += rect[2];
-          nval[3] += rect[3];
-          rect += skipx;
-        }
-        if (do_float) {
-          nvalf[0] += rectf[0];
-          nvalf[1] += rectf[1];
-          nvalf[2] += rectf[2];
-          nvalf[3] += rectf[3];
-          rectf += skipx;
-        }
-      }
-
-      if (do_rect) {
-        val[0] = rect[0];
-        val[1] = rect[1];
-        val[2] = rect[2];
-        val[3] = rect[3];
-        rect += skipx;
-
-        newrect[0] = ((nval[0] + sample * val[0]) / add + 0.5f);
-        newrect[1] = ((nval[1] + sample * val[1]) / add + 0.5f);
-        newrect[2] = ((nval[2] + sample * val[2]) / add + 0.5f);
-        newrect[3] = ((nval[3] + sample * val[3]) / add + 0.5f);
-
-        newrect += skipx;
-      }
-      if (do_float) {
-
-        valf[0] = rectf[0];
-        valf[1] = rectf[1];
-        valf[2] = rectf[2];
-        valf[3] = rectf[3];
-        rectf += skipx;
-
-        newrectf[0] = ((nvalf[0] + sample * valf[0]) / add);
-        newrectf[1] = ((nvalf[1] + sample * valf[1]) / add);
-        newrectf[2] = ((nvalf[2] + sample * valf[2]) / add);
-        newrectf[3] = ((nvalf[3] + sample * valf[3]) / add);
-
-        newrectf += skipx;
-      }
-
-      sample -= 1.0f;
-    }
-  }
-
-  if (do_rect) {
-    // printf("%ld %ld\n", (uchar *)rect - ((uchar *)ibuf->rect), rect_size);
-    BLI_assert((uchar *)rect - ((uchar *)ibuf->rect) == rect_size); /* see bug [#26502] */
-    imb_freerectImBuf(ibuf);
-    ibuf->mall |= IB_rect;
-    ibuf->rect = (unsigned int *)_newrect;
-  }
-  if (do_float) {
-    // printf("%ld %ld\n", rectf - ibuf->rect_float, rect_size);
-    BLI_assert((rectf - ibuf->rect_float) == rect_size); /* see bug [#26502] */
-    imb_freerectfloatImBuf(ibuf);
-    ibuf->mall |= IB_rectfloat;
-    ibuf->rect_float = (float *)_newrectf;
-  }
-  (void)rect_size; /* UNUSED in release builds */
-
-  ibuf->y = newy;
-  return (ibuf);
-}
-
-static ImBuf *scaleupx(struct ImBuf *ibuf, int newx)
-{
-  uchar *rect, *_newrect = NULL, *newrect;
-  float *rectf, *_newrectf = NULL, *newrectf;
-  float sample, add;
-  float val_a, nval_a, diff_a;
-  float val_b, nval_b, diff_b;
-  float val_g, nval_g, diff_g;
-  float val_r, nval_r, diff_r;
-  float val_af, nval_af, diff_af;
-  float val_bf, nval_bf, diff_bf;
-  float val_gf, nval_gf, diff_gf;
-  float val_rf, nval_rf, diff_rf;
-  int x, y;
-  bool do_rect = false, do_float = false;
-
-  val_a = nval_a = diff_a = val_b = nval_b = diff_b = 0;
-  val_g = nval_g = diff_g = val_r = nval_r = diff_r = 0;
-  val_af = nval_af = diff_af = val_bf = nval_bf = diff_bf = 0;
-  val_gf = nval_gf = diff_gf = val_rf = nval_rf = diff_rf = 0;
-  if (ibuf == NULL) {
-    return (NULL);
-  }
-  if (ibuf->rect == NULL && ibuf->rect_float == NULL) {
-    return (ibuf);
-  }
-
-  if (ibuf->rect) {
-    do_rect = true;
-    _newrect = MEM_mallocN(newx * ibuf->y * sizeof(int), "scaleupx");
-    if (_newrect == NULL) {
-      return (ibuf);
-    }
-  }
-  if (ibuf->rect_float) {
-    do_float = true;
-    _newrectf = MEM_mallocN(newx * ibuf->y * sizeof(float) * 4, "scaleupxf");
-    if (_newrectf == NULL) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
-      }
-      return (ibuf);
-    }
-  }
-
-  add = (ibuf->x - 1.001) / (newx - 1.0);
-
-  rect = (uchar *)ibuf->rect;
-  rectf = (float *)ibuf->rect_float;
-  newrect = _newrect;
-  newrectf = _newrectf;
-
-  for (y = ibuf->y; y > 0; y--) {
-
-    sample = 0;
-
-    if (do_rect) {
-      val_a = rect[0];
-      nval_a = rect[4];
-      diff_a = nval_a - val_a;
-      val_a += 0.5f;
-
-      val_b = rect[1];
-      nval_b = rect[5];
-      diff_b = nval_b - val_b;
-      val_b += 0.5f;
-
-      val_g = rect[2];
-      nval_g = rect[6];
-      diff_g = nval_g - val_g;
-      val_g += 0.5f;
-
-      val_r = rect[3];
-      nval_r = rect[7];
-      diff_r = nval_r - val_r;
-      val_r += 0.5f;
-
-      rect += 8;
-    }
-    if (do_float) {
-      val_af = rectf[0];
-      nval_af = rectf[4];
-      diff_af = nval_af - val_af;
-
-      val_bf = rectf[1];
-      nval_bf = rectf[5];
-      diff_bf = nval_bf - val_bf;
-
-      val_gf = rectf[2];
-      nval_gf = rectf[6];
-      diff_gf = nval_gf - val_gf;
-
-      val_rf = rectf[3];
-      nval_rf = rectf[7];
-      diff_rf = nval_rf - val_rf;
-
-      rectf += 8;
-    }
-    for (x = newx; x > 0; x--) {
-      if (sample >= 1.0f) {
-        sample -= 1.0f;
-
-        if (do_rect) {
-          val_a = nval_a;
-          nval_a = rect[0];
-          diff_a = nval_a - val_a;
-          val_a += 0.5f;
-
-          val_b = nval_b;
-          nval_b = rect[1];
-          diff_b = nval_b - val_b;
-          val_b += 0.5f;
-
-          val_g = nval_g;
-          nval_g = rect[2];
-          diff_g = nval_g - val_g;
-          val_g += 0.5f;
-
-          val_r = nval_r;
-          nval_r = rect[3];
-          diff_r = nval_r - val_r;
-          val_r += 0.5f;
-          rect += 4;
-        }
-        if (do_float) {
-          val_af = nval_af;
-          nval_af = rectf[0];
-          diff_af = nval_af - val_af;
-
-          val_bf = nval_bf;
-          nval_bf = rectf[1];
-          diff_bf = nval_bf - val_bf;
-
-          val_gf = nval_gf;
-          nval_gf = rectf[2];
-          diff_gf = nval_gf - val_gf;
-
-          val_rf = nval_rf;
-          nval_rf = rectf[3];
-          diff_rf = nval_rf - val_rf;
-          rectf += 4;
-        }
-      }
-      if (do_rect) {
-        newrect[0] = val_a + sample * diff_a;
-        newrect[1] = val_b + sample * diff_b;
-        newrect[2] = val_g + sample * diff_g;
-        newrect[3] = val_r + sample * diff_r;
-        newrect += 4;
-      }
-      if (do_float) {
-        newrectf[0] = val_af + sample * diff_af;
-        newrectf[1] = val_bf + sample * diff_bf;
-        newrectf[2] = val_gf + sample * diff_gf;
-        newrectf[3] = val_rf + sample * diff_rf;
-        newrectf += 4;
-      }
-      sample += add;
-    }
-  }
-
-  if (do_rect) {
-    imb_freerectImBuf(ibuf);
-    ibuf->mall |= IB_rect;
-    ibuf->rect = (unsigned int *)_newrect;
-  }
-  if (do_float) {
-    imb_freerectfloatImBuf(ibuf);
-    ibuf->mall |= IB_rectfloat;
-    ibuf->rect_float = (float *)_newrectf;
-  }
-
-  ibuf->x = newx;
-  return (ibuf);
-}
-
-static ImBuf *scaleupy(struct ImBuf *ibuf, int newy)
-{
-  uchar *rect, *_newrect = NULL, *newrect;
-  float *rectf, *_newrectf = NULL, *newrectf;
-  float sample, add;
-  float val_a, nval_a, diff_a;
-  float val_b, nval_b, diff_b;
-  float val_g, nval_g, diff_g;
-  float val_r, nval_r, diff_r;
-  float val_af, nval_af, diff_af;
-  float val_bf, nval_bf, diff_bf;
-  float val_gf, nval_gf, diff_gf;
-  float val_rf, nval_rf, diff_rf;
-  int x, y, skipx;
-  bool do_rect = false, do_float = false;
-
-  val_a = nval_a = diff_a = val_b = nval_b = diff_b = 0;
-  val_g = nval_g = diff_g = val_r = nval_r = diff_r = 0;
-  val_af = nval_af = diff_af = val_bf = nval_bf = diff_bf = 0;
-  val_gf = nval_gf = diff_gf = val_rf = nval_rf = diff_rf = 0;
-  if (ibuf == NULL) {
-    return (NULL);
-  }
-  if (ibuf->rect == NULL && ibuf->rect_float == NULL) {
-    return (ibuf);
-  }
-
-  if (ibuf->rect) {
-    do_rect = true;
-    _newrect = MEM_mallocN(ibuf->x * newy * sizeof(int), "scaleupy");
-    if (_newrect == NULL) {
-      return (ibuf);
-    }
-  }
-  if (ibuf->rect_float) {
-    do_float = true;
-    _newrectf = MEM_mallocN(ibuf->x * newy * sizeof(float) * 4, "scaleupyf");
-    if (_newrectf == NULL) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
-      }
-      return (ibuf);
-    }
-  }
-
-  add = (ibuf->y - 1.001) / (newy - 1.0);
-  skipx = 4 * ibuf->x;
-
-  rect = (uchar *)ibuf->rect;
-  rectf = (float *)ibuf->rect_float;
-  newrect = _newrect;
-  newrectf = _newrectf;
-
-  for (x = ibuf->x; x > 0; x--) {
-
-    sample = 0;
-    if (do_rect) {
-      rect = ((uchar *)ibuf->rect) + 4 * (x - 1);
-      newrect = _newrect + 4 * (x - 1);
-
-      val_a = rect[0];
-      nval_a = rect[skipx];
-      diff_a = nval_a - val_a;
-      val_a += 0.5f;
-
-      val_b = rect[1];
-      nval_b = rect[skipx + 1];
-      diff_b = nval_b - val_b;
-      val_b += 0.5f;
-
-      val_g = rect[2];
-      nval_g = rect[skipx + 2];
-      diff_g = nval_g - val_g;
-      val_g += 0.5f;
-
-      val_r = rect[3];
-      nval_r = rect[skipx + 3];
-      diff_r = nval_r - val_r;
-      val_r += 0.5f;
-
-      rect += 2 * skipx;
-    }
-    if (do_float) {
-      rectf = ibuf->rect_float + 4 * (x - 1);
-      newrectf = _newrectf + 4 * (x - 1);
-
-      val_af = rectf[0];
-      nval_af = rectf[skipx];
-      diff_af = nval_af - val_af;
-
-      val_bf = rectf[1];
-      nval_bf = rectf[skipx + 1];
-      diff_bf = nval_bf - val_bf;
-
-      val_gf = rectf[2];
-      nval_gf = rectf[skipx + 2];
-      diff_gf = nval_gf - val_gf;
-
-      val_rf = rectf[3];
-      nval_rf = rectf[skipx + 3];
-      diff_rf = nval_rf - val_rf;
-
-      rectf += 2 * skipx;
-    }
-
-    for (y = newy; y > 0; y--) {
-      if (sample >= 1.0f) {
-        sample -= 1.0f;
-
-        if (do_rect) {
-          val_a = nval_a;
-          nval_a = rect[0];
-          diff_a = nval_a - val_a;
-          val_a += 0.5f;
-
-          val_b = nval_b;
-          nval_b = rect[1];
-          diff_b = nval_b - val_b;
-          val_b += 0.5f;
-
-          val_g = nval_g;
-          nval_g = rect[2];
-          diff_g = nval_g - val_g;
-          val_g += 0.5f;
-
-          val_r = nval_r;
-          nval_r = rect[3];
-          diff_r = nval_r - val_r;
-          val_r += 0.5f;
-          rect += skipx;
-        }
-        if (do_float) {
-          val_af = nval_af;
-          nval_af = rectf[0];
-          diff_af = nval_af - val_af;
-
-          val_bf = nval_bf;
-          nval_bf = rectf[1];
-          diff_bf = nval_bf - val_bf;
-
-          val_gf = nval_gf;
-          nval_gf = rectf[2];
-          diff_gf = nval_gf - val_gf;
-
-          val_rf = nval_rf;
-          nval_rf = rectf[3];
-          diff_rf = nval_rf - val_rf;
-          rectf += skipx;
-        }
-      }
-      if (do_rect) {
-        newrect[0] = val_a + sample * diff_a;
-        newrect[1] = val_b + sample * diff_b;
-        newrect[2] = val_g + sample * diff_g;
-        newrect[3] = val_r + sample * diff_r;
-        newrect += skipx;
-      }
-      if (do_float) {
-        newrectf[0] = val_af + sample * diff_af;
-        newrectf[1] = val_bf + sample * diff_bf;
-        newrectf[2] = val_gf + sample * diff_gf;
-        newrectf[3] = val_rf + sample * diff_rf;
-        newrectf += skipx;
-      }
-      sample += add;
-    }
-  }
-
-  if (do_rect) {
-    imb_freerectImBuf(ibuf);
-    ibuf->mall |= IB_rect;
-    ibuf->rect = (unsigned int *)_newrect;
-  }
-  if (do_float) {
-    imb_freerectfloatImBuf(ibuf);
-    ibuf->mall |= IB_rectfloat;
-    ibuf->rect_float = (float *)_newrectf;
-  }
-
-  ibuf->y = newy;
-  return (ibuf);
-}
-
 static void scalefast_Z_ImBuf(ImBuf *ibuf, int newx, int newy)
 {
   int *zbuf, *newzbuf, *_newzbuf = NULL;
@@ -1618,41 +981,13 @@ static void scalefast_Z_ImBuf(ImBuf *ibuf, int newx, int newy)
  */
 bool IMB_scaleImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy)
 {
-  if (ibuf == NULL) {
-    return false;
-  }
-  if (ibuf->rect == NULL && ibuf->rect_float == NULL) {
-    return false;
-  }
-
-  if (newx == ibuf->x && newy == ibuf->y) {
-    return false;
-  }
-
-  /* Scale-up / scale-down functions below change ibuf->x and ibuf->y
-   * so we first scale the Z-buffer (if any). */
-  scalefast_Z_ImBuf(ibuf, newx, newy);
-
   /* try to scale common cases in a fast way */
   /* disabled, quality loss is unacceptable, see report #18609  (ton) */
   if (0 && q_scale_linear_interpolation(ibuf, newx, newy)) {
     return true;
   }
 
-  if (newx && (newx < ibuf->x)) {
-    scaledownx(ibuf, newx);
-  }
-  if (newy && (newy < ibuf->y)) {
-    scaledowny(ibuf, newy);
-  }
-  if (newx && (newx > ibuf->x)) {
-    scaleupx(ibuf, newx);
-  }
-  if (newy && (newy > ibuf->y)) {
-    scaleupy(ibuf, newy);
-  }
-
-  return true;
+  return IMB_scaleImBuf_filter(ibuf, newx, newy, IMB_SCALE_FILTER_DEFAULT);
 }
 
 struct imbufRGBA {
@@ -1758,119 +1093,370 @@ bool IMB_scalefastImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy
   return true;
 }
 
-/* ******** threaded scaling ******** */
+/* ******** filtered scaling ******** */
 
-typedef struct ScaleTreadInitData {
-  ImBuf *ibuf;
+/* Buffers are resampled separably: the rows are filtered into a float buffer of the new width,
+ * then its columns are filtered into the new buffer. Both passes are multithreaded, and filter
+ * the channels of a pixel or 4 floats of a row at once with SSE2. Byte buffers are filtered
+ * with straight alpha, like before. */
 
-  unsigned int newx;
-  unsigned int newy;
+#define SCALE_MIN_ITER_PER_THREAD 8
 
-  unsigned char *byte_buffer;
-  float *float_buffer;
-} ScaleTreadInitData;
+static float scale_filter_bilinear(float x)
+{
+  x = fabsf(x);
+  return (x < 1.0f) ? 1.0f - x : 0.0f;
+}
 
-typedef struct ScaleThreadData {
-  ImBuf *ibuf;
+/* Keys cubic with a = -0.5, also known as Catmull-Rom. */
+static float scale_filter_bicubic(float x)
+{
+  const float a = -0.5f;
+  x = fabsf(x);
+  if (x < 1.0f) {
+    return ((a + 2.0f) * x - (a + 3.0f)) * x * x + 1.0f;
+  }
+  if (x < 2.0f) {
+    return (((x - 5.0f) * x + 8.0f) * x - 4.0f) * a;
+  }
+  return 0.0f;
+}
 
-  unsigned int newx;
-  unsigned int newy;
+static float scale_filter_sinc(float x)
+{
+  if (x == 0.0f) {
+    return 1.0f;
+  }
+  x *= (float)M_PI;
+  return sinf(x) / x;
+}
 
-  int start_line;
-  int tot_line;
+static float scale_filter_lanczos(float x)
+{
+  return (fabsf(x) < 3.0f) ? scale_filter_sinc(x) * scale_filter_sinc(x / 3.0f) : 0.0f;
+}
 
-  unsigned char *byte_buffer;
-  float *float_buffer;
-} ScaleThreadData;
+/* Source pixels and their weights for every new pixel along one axis. */
+typedef struct ScaleAxis {
+  int *first;
+  int *num;
+  /* Weights of a new pixel, max_num apart. */
+  float *weights;
+  int max_num;
+} ScaleAxis;
 
-static void scale_thread_init(void *data_v, int start_line, int tot_line, void *init_data_v)
+static void scale_axis_init(ScaleAxis *axis, int size, int newsize, IMB_ScaleFilter filter)
 {
-  ScaleThreadData *data = (ScaleThreadData *)data_v;
-  ScaleTreadInitData *init_data = (ScaleTreadInitData *)init_data_v;
-
-  data->ibuf = init_data->ibuf;
+  float (*filter_func)(float) = NULL;
+  float support = 0.5f;
+
+  if (filter == IMB_SCALE_FILTER_DEFAULT) {
+    filter = (newsize < size) ? IMB_SCALE_FILTER_BOX : IMB_SCALE_FILTER_BILINEAR;
+  }
+  switch (filter) {
+    case IMB_SCALE_FILTER_BILINEAR:
+      filter_func = scale_filter_bilinear;
+      support = 1.0f;
+      break;
+    case IMB_SCALE_FILTER_BICUBIC:
+      filter_func = scale_filter_bicubic;
+      support = 2.0f;
+      break;
+    case IMB_SCALE_FILTER_LANCZOS:
+      filter_func = scale_filter_lanczos;
+      support = 3.0f;
+      break;
+    case IMB_SCALE_FILTER_BOX:
+    default:
+      /* Weights are the area of the source pixels covered by the new pixel. */
+      break;
+  }
+
+  /* When shrinking the filter is stretched over the source pixels of a new pixel. */
+  const float scale = (float)size / newsize;
+  const float filterscale = max_ff(scale, 1.0f);
+  support *= filterscale;
+
+  axis->max_num = (int)ceilf(support) * 2 + 1;
+  axis->first = MEM_mallocN(sizeof(int) * newsize, "scale axis first");
+  axis->num = MEM_mallocN(sizeof(int) * newsize, "scale axis num");
+  axis->weights = MEM_calloc_arrayN(
+      (size_t)newsize * axis->max_num, sizeof(float), "scale axis weights");
+
+  for (int i = 0; i < newsize; i++) {
+    const float center = (i + 0.5f) * scale;
+    const int first = max_ii((int)floorf(center - support + 0.5f), 0);
+    const int last = min_ii((int)floorf(center + support + 0.5f), size);
+    float *weights = axis->weights + (size_t)i * axis->max_num;
+    float total = 0.0f;
+
+    BLI_assert(last - first <= axis->max_num);
+
+    for (int j = first; j < last; j++) {
+      float weight;
+      if (filter_func) {
+        weight = filter_func((j + 0.5f - center) / filterscale);
+      }
+      else {
+        weight = max_ff(0.0f,
+                        min_ff(j + 1.0f, center + support) - max_ff((float)j, center - support));
+      }
+      weights[j - first] = weight;
+      total += weight;
+    }
 
-  data->newx = init_data->newx;
-  data->newy = init_data->newy;
+    if (total != 0.0f) {
+      for (int j = first; j < last; j++) {
+        weights[j - first] /= total;
+      }
+    }
 
-  data->start_line = start_line;
-  data->tot_line = tot_line;
+    axis->first[i] = first;
+    axis->num[i] = max_ii(last - first, 0);
+  }
+}
 
-  data->byte_buffer = init_data->byte_buffer;
-  data->float_buffer = init_data->float_buffer;
+static void scale_axis_free(ScaleAxis *axis)
+{
+  MEM_freeN(axis->first);
+  MEM_freeN(axis->num);
+  MEM_freeN(axis->weights);
 }
 
-static void *do_scale_thread(void *data_v)
+typedef struct ScaleData {
+  const ScaleAxis *axis;
+
+  const unsigned char *byte_in;
+  const float *float_in;
+  unsigned char *byte_out;
+  float *float_out;
+
+  int channels;
+  int width, newwidth;
+} ScaleData;
+
+/* Filter a row of the source buffer into the float buffer of the new width. */
+static void scale_rows_task(void *__restrict userdata,
+                            const int y,
+                            const TaskParallelTLS *__restrict UNUSED(tls))
 {
-  ScaleThreadData *data = (ScaleThreadData *)data_v;
-  ImBuf *ibuf = data->ibuf;
-  int i;
-  float factor_x = (float)ibuf->x / data->newx;
-  float factor_y = (float)ibuf->y / data->newy;
-
-  for (i = 0; i < data->tot_line; i++) {
-    int y = data->start_line + i;
-    int x;
-
-    for (x = 0; x < data->newx; x++) {
-      float u = (float)x * factor_x;
-      float v = (float)y * factor_y;
-      int offset = y * data->newx + x;
-
-      if (data->byte_buffer) {
-        unsigned char *pixel = data->byte_buffer + 4 * offset;
-        BLI_bilinear_interpolation_char(
-            (unsigned char *)ibuf->rect, pixel, ibuf->x, ibuf->y, 4, u, v);
+  const ScaleData *data = userdata;
+  const ScaleAxis *axis = data->axis;
+  const int channels = data->channels;
+  float *out = data->float_out + (size_t)y * data->newwidth * channels;
+
+  for (int x = 0; x < data->newwidth; x++, out += channels) {
+    const float *weights = axis->weights + (size_t)x * axis->max_num;
+    const int num = axis->num[x];
+    const size_t offset = ((size_t)y * data->width + axis->first[x]) * channels;
+
+    if (data->byte_in) {
+      const unsigned char *in = data->byte_in + offset;
+#ifdef __SSE2__
+      const __m128i zero = _mm_setzero_si128();
+      __m128 sum = _mm_setzero_ps();
+      for (int i = 0; i < num; i++, in += 4) {
+        int pixel;
+        memcpy(&pixel, in, sizeof(pixel));
+        const __m128i pixel_i = _mm_unpacklo_epi16(
+            _mm_unpacklo_epi8(_mm_cvtsi32_si128(pixel), zero), zero);
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_cvtepi32_ps(pixel_i), _mm_set1_ps(weights[i])));
       }
-
-      if (data->float_buffer) {
-        float *pixel = data->float_buffer + ibuf->channels * offset;
-        BLI_bilinear_interpolation_fl(
-            ibuf->rect_float, pixel, ibuf->x, ibuf->y, ibuf->channels, u, v);
+      _mm_storeu_ps(out, sum);
+#else
+      zero_v4(out);
+      for (int i = 0; i < num; i++, in += 4) {
+        out[0] += in[0] * weights[i];
+        out[1] += in[1] * weights[i];
+        out[2] += in[2] * weights[i];
+        out[3] += in[3] * weights[i];
+      }
+#endif
+    }
+    else {
+      const float *in = data->float_in + offset;
+#ifdef __SSE2__
+      if (channels == 4) {
+        __m128 sum = _mm_setzero_ps();
+        for (int i = 0; i < num; i++, in += 4) {
+          sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(in), _mm_set1_ps(weights[i])));
+        }
+        _mm_storeu_ps(out, sum);
+        continue;
+      }
+#endif
+      for (int c = 0; c < channels; c++) {
+        out[c] = 0.0f;
+      }
+      for (int i = 0; i < num; i++, in += channels) {
+        for (int c = 0; c < channels; c++) {
+          out[c] += in[c] * weights[i];
+        }
       }
     }
   }
+}
 
-  return NULL;
+/* Filter the columns of the float buffer of the new width into a row of the new buffer. */
+static void scale_columns_task(void *__restrict userdata,
+                               const int y,
+                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ScaleData *data = userdata;
+  const ScaleAxis *axis = data->axis;
+  const size_t row_size = (size_t)data->newwidth * data->channels;
+  const float *weights = axis->weights + (size_t)y * axis->max_num;
+  const float *in = data->float_in + axis->first[y] * row_size;
+  const int num = axis->num[y];
+  size_t i = 0;
+
+#ifdef __SSE2__
+  /* 4 floats at a time, also for buffers with less channels. */
+  for (; i + 4 <= row_size; i += 4) {
+    __m128 sum = _mm_setzero_ps();
+    for (int j = 0; j < num; j++) {
+      const __m128 value = _mm_loadu_ps(in + j * row_size + i);
+      sum = _mm_add_ps(sum, _mm_mul_ps(value, _mm_set1_ps(weights[j])));
+    }
+    if (data->byte_out) {
+      sum = _mm_min_ps(_mm_add_ps(_mm_max_ps(sum, _mm_setzero_ps()), _mm_set1_ps(0.5f)),
+                       _mm_set1_ps(255.0f));
+      const __m128i sum_i = _mm_cvttps_epi32(sum);
+      const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(sum_i, sum_i), sum_i);
+      const int pixel = _mm_cvtsi128_si32(bytes);
+      memcpy(data->byte_out + y * row_size + i, &pixel, sizeof(pixel));
+    }
+    else {
+      _mm_storeu_ps(data->float_out + y * row_size + i, sum);
+    }
+  }
+#endif
+
+  for (; i < row_size; i++) {
+    float sum = 0.0f;
+    for (int j = 0; j < num; j++) {
+      sum += in[j * row_size + i] * weights[j];
+    }
+    if (data->byte_out) {
+      data->byte_out[y * row_size + i] = (unsigned char)clamp_f(sum + 0.5f, 0.0f, 255.0f);
+    }
+    else {
+      data->float_out[y * row_size + i] = sum;
+    }
+  }
 }
 
-void IMB_scaleImBuf_threaded(ImBuf *ibuf, unsigned int newx, unsigned int newy)
+/* Resample a byte buffer when \a byte_in is set, a float buffer otherwise. */
+static void *scale_buffer(const unsigned char *byte_in,
+                          const float *float_in,
+                          int channels,
+                          int width,
+                          int height,
+                          const ScaleAxis *axis_x,
+                          int newwidth,
+                          const ScaleAxis *axis_y,
+                          int newheight)
 {
-  ScaleTreadInitData init_data = {NULL};
+  const size_t tmp_size = (size_t)newwidth * height * channels;
+  float *tmp = MEM_mallocN(sizeof(float) * tmp_size, "scale rows");
+  void *result;
+  ScaleData data = {NULL};
+  TaskParallelSettings settings;
+
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = SCALE_MIN_ITER_PER_THREAD;
+
+  data.axis = axis_x;
+  data.byte_in = byte_in;
+  data.float_in = float_in;
+  data.float_out = tmp;
+  data.channels = channels;
+  data.width = width;
+  data.newwidth = newwidth;
+  BLI_task_parallel_range(0, height, &data, scale_rows_task, &settings);
+
+  const size_t result_size = (size_t)newwidth * newheight * channels;
+  if (byte_in) {
+    result = MEM_mallocN(sizeof(unsigned char) * result_size, "scale byte buffer");
+  }
+  else {
+    result = MEM_mallocN(sizeof(float) * result_size, "scale float buffer");
+  }
 
-  /* prepare initialization data */
-  init_data.ibuf = ibuf;
+  memset(&data, 0, sizeof(data));
+  data.axis = axis_y;
+  data.float_in = tmp;
+  data.byte_out = byte_in ? result : NULL;
+  data.float_out = byte_in ? NULL : result;
+  data.channels = channels;
+  data.newwidth = newwidth;
+  BLI_task_parallel_range(0, newheight, &data, scale_columns_task, &settings);
 
-  init_data.newx = newx;
-  init_data.newy = newy;
+  MEM_freeN(tmp);
+  return result;
+}
 
-  if (ibuf->rect) {
-    init_data.byte_buffer = MEM_mallocN(4 * newx * newy * sizeof(char),
-                                        "threaded scale byte buffer");
+bool IMB_scaleImBuf_filter(struct ImBuf *ibuf,
+                           unsigned int newx,
+                           unsigned int newy,
+                           IMB_ScaleFilter filter)
+{
+  if (ibuf == NULL) {
+    return false;
+  }
+  if (ibuf->rect == NULL && ibuf->rect_float == NULL) {
+    return false;
   }
 
-  if (ibuf->rect_float) {
-    init_data.float_buffer = MEM_mallocN(ibuf->channels * newx * newy * sizeof(float),
-                                         "threaded scale float buffer");
+  /* Zero keeps the size of an axis. */
+  if (newx == 0) {
+    newx = ibuf->x;
+  }
+  if (newy == 0) {
+    newy = ibuf->y;
+  }
+  if (newx == ibuf->x && newy == ibuf->y) {
+    return false;
   }
 
-  /* actual scaling threads */
-  IMB_processor_apply_threaded(
-      newy, sizeof(ScaleThreadData), &init_data, scale_thread_init, do_scale_thread);
+  /* Z-buffers aren't filtered. */
+  scalefast_Z_ImBuf(ibuf, newx, newy);
 
-  /* alter image buffer */
-  ibuf->x = newx;
-  ibuf->y = newy;
+  ScaleAxis axis_x, axis_y;
+  scale_axis_init(&axis_x, ibuf->x, newx, filter);
+  scale_axis_init(&axis_y, ibuf->y, newy, filter);
 
   if (ibuf->rect) {
+    unsigned char *rect = scale_buffer(
+        (unsigned char *)ibuf->rect, NULL, 4, ibuf->x, ibuf->y, &axis_x, newx, &axis_y, newy);
     imb_freerectImBuf(ibuf);
     ibuf->mall |= IB_rect;
-    ibuf->rect = (unsigned int *)init_data.byte_buffer;
+    ibuf->rect = (unsigned int *)rect;
   }
-
   if (ibuf->rect_float) {
+    float *rect_float = scale_buffer(NULL,
+                                     ibuf->rect_float,
+                                     ibuf->channels,
+                                     ibuf->x,
+                                     ibuf->y,
+                                     &axis_x,
+                                     newx,
+                                     &axis_y,
+                                     newy);
     imb_freerectfloatImBuf(ibuf);
     ibuf->mall |= IB_rectfloat;
-    ibuf->rect_float = init_data.float_buffer;
+    ibuf->rect_float = rect_float;
   }
+
+  scale_axis_free(&axis_x);
+  scale_axis_free(&axis_y);
+
+  ibuf->x = newx;
+  ibuf->y = newy;
+  return true;
+}
+
+void IMB_scaleImBuf_threaded(ImBuf *ibuf, unsigned int newx, unsigned int newy)
+{
+  IMB_scaleImBuf_filter(ibuf, newx, newy, IMB_SCALE_FILTER_BILINEAR);
 }
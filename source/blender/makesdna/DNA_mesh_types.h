@@ -47,6 +47,7 @@ struct MPoly;
 struct MVert;
 struct Material;
 struct Mesh;
+struct MeshLoopSplitCache;
 struct Multires;
 struct SubdivCCG;
 
@@ -105,6 +106,12 @@ typedef struct Mesh_Runtime {
   /** Non-manifold boundary data for Shrinkwrap Target Project. */
   struct ShrinkwrapBoundaryData *shrinkwrap_data;
 
+  /**
+   * Smooth fans of split normals, see #BKE_mesh_normals_loop_split_ex.
+   * Shared with copies of the mesh, which usually keep its topology.
+   */
+  struct MeshLoopSplitCache *loop_split_cache;
+
   /** Set by modifier stack if only deformed from original. */
   char deformed_only;
   /**
@@ -35,6 +35,7 @@ struct ID;
 struct Image;
 struct ListBase;
 struct bGPdata;
+struct bNodeExecutionStats;
 struct bNodeInstanceHash;
 struct bNodeLink;
 struct bNodePreview;
@@ -296,6 +297,9 @@ typedef struct bNode {
    * needs to be a float to feed GPU_uniform.
    */
   float sss_id;
+
+  /** Compositor: profiling of the last execution, runtime only. */
+  struct bNodeExecutionStats *execution_stats;
 } bNode;
 
 /* node->flag */
@@ -397,6 +401,10 @@ typedef struct bNodeLink {
 #define NTREE_QUALITY_MEDIUM 1
 #define NTREE_QUALITY_LOW 2
 
+/* tree->execution_mode */
+#define NTREE_EXECUTION_MODE_TILED 0
+#define NTREE_EXECUTION_MODE_FULL_FRAME 1
+
 /* tree->chunksize */
 #define NTREE_CHUNKSIZE_32 32
 #define NTREE_CHUNKSIZE_64 64
@@ -442,7 +450,9 @@ typedef struct bNodeTree {
   short is_updating;
   /** Generic temporary flag for recursion check (DFS/BFS). */
   short done;
-  char _pad2[4];
+  /** Execution model of the compositor engine. */
+  short execution_mode;
+  char _pad2[2];
 
   /** Specific node type this tree is used for. */
   int nodetype DNA_DEPRECATED;
@@ -470,7 +480,8 @@ typedef struct bNodeTree {
    * in case multiple different editors are used and make context ambiguous.
    */
   bNodeInstanceKey active_viewer_key;
-  char _pad[4];
+  /** Memory limit of the compositor result cache in MB, zero disables it. */
+  int cache_size;
 
   /** Execution data.
    *
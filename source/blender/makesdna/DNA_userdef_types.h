@@ -602,7 +602,9 @@ typedef struct UserDef_FileSpaceData {
 } UserDef_FileSpaceData;
 
 typedef struct UserDef_Experimental {
-  char _pad0[8]; /* makesdna does not allow empty structs. */
+  /** Reuse unchanged data-blocks when reading global undo steps. */
+  char use_undo_speedup;
+  char _pad0[7];
 } UserDef_Experimental;
 
 #define USER_EXPERIMENTAL_TEST(userdef, member) \
@@ -2932,6 +2932,18 @@ static void rna_CompositorNode_tag_need_exec(bNode *node)
   node->need_exec = true;
 }
 
+static float rna_CompositorNode_execution_time_get(PointerRNA *ptr)
+{
+  bNode *node = (bNode *)ptr->data;
+  return node->execution_stats ? node->execution_stats->time : 0.0f;
+}
+
+static float rna_CompositorNode_execution_memory_get(PointerRNA *ptr)
+{
+  bNode *node = (bNode *)ptr->data;
+  return node->execution_stats ? node->execution_stats->memory : 0.0f;
+}
+
 static void rna_Node_tex_image_update(Main *bmain, Scene *UNUSED(scene), PointerRNA *ptr)
 {
   bNodeTree *ntree = (bNodeTree *)ptr->owner_id;
@@ -7935,6 +7947,7 @@ static void rna_def_shader_node(BlenderRNA *brna)
 static void rna_def_compositor_node(BlenderRNA *brna)
 {
   StructRNA *srna;
+  PropertyRNA *prop;
   FunctionRNA *func;
 
   srna = RNA_def_struct(brna, "CompositorNode", "NodeInternal");
@@ -7945,6 +7958,20 @@ static void rna_def_compositor_node(BlenderRNA *brna)
   /* compositor node need_exec flag */
   func = RNA_def_function(srna, "tag_need_exec", "rna_CompositorNode_tag_need_exec");
   RNA_def_function_ui_description(func, "Tag the node for compositor update");
+
+  /* profiling */
+  prop = RNA_def_property(srna, "execution_time", PROP_FLOAT, PROP_NONE);
+  RNA_def_property_float_funcs(prop, "rna_CompositorNode_execution_time_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(
+      prop, "Execution Time", "Time in seconds of calculating the node in the last execution");
+
+  prop = RNA_def_property(srna, "execution_memory", PROP_FLOAT, PROP_NONE);
+  RNA_def_property_float_funcs(prop, "rna_CompositorNode_execution_memory_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop,
+                           "Execution Memory",
+                           "Memory in MB of the results of the node in the last execution");
 }
 
 static void rna_def_texture_node(BlenderRNA *brna)
@@ -9414,12 +9441,41 @@ static void rna_def_composite_nodetree(BlenderRNA *brna)
   StructRNA *srna;
   PropertyRNA *prop;
 
+  static const EnumPropertyItem execution_mode_items[] = {
+      {NTREE_EXECUTION_MODE_TILED,
+       "TILED",
+       0,
+       "Tiled",
+       "Calculate the image in tiles, evaluating the nodes for every pixel"},
+      {NTREE_EXECUTION_MODE_FULL_FRAME,
+       "FULL_FRAME",
+       0,
+       "Full Frame",
+       "Calculate the nodes one at a time for the whole image, keeping their results in memory"},
+      {0, NULL, 0, NULL, NULL},
+  };
+
   srna = RNA_def_struct(brna, "CompositorNodeTree", "NodeTree");
   RNA_def_struct_ui_text(
       srna, "Compositor Node Tree", "Node tree consisting of linked nodes used for compositing");
   RNA_def_struct_sdna(srna, "bNodeTree");
   RNA_def_struct_ui_icon(srna, ICON_RENDERLAYERS);
 
+  prop = RNA_def_property(srna, "execution_mode", PROP_ENUM, PROP_NONE);
+  RNA_def_property_enum_sdna(prop, NULL, "execution_mode");
+  RNA_def_property_enum_items(prop, execution_mode_items);
+  RNA_def_property_ui_text(prop, "Execution Mode", "How the compositor calculates the nodes");
+
+  prop = RNA_def_property(srna, "cache_size", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, NULL, "cache_size");
+  RNA_def_property_range(prop, 0, INT_MAX);
+  RNA_def_property_ui_range(prop, 0, 16384, 64, -1);
+  RNA_def_property_ui_text(prop,
+                           "Cache Size",
+                           "Memory in MB for results of the Full Frame execution mode kept "
+                           "between executions, so only the nodes downstream of changes are "
+                           "calculated again (0 disables the cache)");
+
   prop = RNA_def_property(srna, "render_quality", PROP_ENUM, PROP_NONE);
   RNA_def_property_enum_sdna(prop, NULL, "render_quality");
   RNA_def_property_enum_items(prop, node_quality_items);
@@ -1013,6 +1013,27 @@ static void rna_SequenceEditor_overlay_frame_set(PointerRNA *ptr, int value)
   }
 }
 
+static int rna_SequenceEditor_cache_hits_get(PointerRNA *ptr)
+{
+  SeqCacheStats stats;
+  BKE_sequencer_cache_stats_get((Scene *)ptr->owner_id, &stats);
+  return (int)min_zz(stats.hits, INT_MAX);
+}
+
+static int rna_SequenceEditor_cache_misses_get(PointerRNA *ptr)
+{
+  SeqCacheStats stats;
+  BKE_sequencer_cache_stats_get((Scene *)ptr->owner_id, &stats);
+  return (int)min_zz(stats.misses, INT_MAX);
+}
+
+static int rna_SequenceEditor_cache_evictions_get(PointerRNA *ptr)
+{
+  SeqCacheStats stats;
+  BKE_sequencer_cache_stats_get((Scene *)ptr->owner_id, &stats);
+  return (int)min_zz(stats.evictions, INT_MAX);
+}
+
 static int modifier_seq_cmp_cb(Sequence *seq, void *arg_pt)
 {
   SequenceSearchData *data = arg_pt;
@@ -1952,6 +1973,23 @@ static void rna_def_editor(BlenderRNA *brna)
   RNA_def_property_float_sdna(prop, NULL, "recycle_max_cost");
   RNA_def_property_ui_text(
       prop, "Recycle Up to Cost", "Only frames with cost lower than this value will be recycled");
+
+  prop = RNA_def_property(srna, "cache_hits", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_int_funcs(prop, "rna_SequenceEditor_cache_hits_get", NULL, NULL);
+  RNA_def_property_ui_text(prop, "Cache Hits", "Number of images found in the cache");
+
+  prop = RNA_def_property(srna, "cache_misses", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_int_funcs(prop, "rna_SequenceEditor_cache_misses_get", NULL, NULL);
+  RNA_def_property_ui_text(
+      prop, "Cache Misses", "Number of images looked up but not found in the cache");
+
+  prop = RNA_def_property(srna, "cache_evictions", PROP_INT, PROP_UNSIGNED);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_int_funcs(prop, "rna_SequenceEditor_cache_evictions_get", NULL, NULL);
+  RNA_def_property_ui_text(
+      prop, "Cache Evictions", "Number of images freed to make room for new ones in the cache");
 }
 
 static void rna_def_filter_video(StructRNA *srna)
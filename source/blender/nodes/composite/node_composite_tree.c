@@ -151,6 +151,7 @@ static void local_merge(Main *bmain, bNodeTree *localtree, bNodeTree *ntree)
 
   /* move over the compbufs and previews */
   BKE_node_preview_merge_tree(ntree, localtree, true);
+  ntreeCompositMergeExecutionStats(ntree, localtree);
 
   for (lnode = localtree->nodes.first; lnode; lnode = lnode->next) {
     if (ntreeNodeExists(ntree, lnode->new_node)) {
@@ -255,6 +256,30 @@ void ntreeCompositExecTree(Scene *scene,
   UNUSED_VARS(do_preview);
 }
 
+/* Move the profiling of an executed copy of the tree (localized or evaluated) to the original,
+ * the original may have been edited in the meantime so nodes are found by name. */
+void ntreeCompositMergeExecutionStats(bNodeTree *ntree, bNodeTree *exec_ntree)
+{
+  for (bNode *exec_node = exec_ntree->nodes.first; exec_node; exec_node = exec_node->next) {
+    bNode *node = nodeFindNodebyName(ntree, exec_node->name);
+    if (node == NULL || node->type != exec_node->type) {
+      continue;
+    }
+
+    /* Group trees can be used by multiple nodes, they are only merged once. */
+    if (exec_node->execution_stats) {
+      MEM_SAFE_FREE(node->execution_stats);
+      node->execution_stats = exec_node->execution_stats;
+      exec_node->execution_stats = NULL;
+    }
+
+    if (ELEM(node->type, NODE_GROUP, NODE_CUSTOM_GROUP) && node->id && exec_node->id &&
+        node->id != exec_node->id) {
+      ntreeCompositMergeExecutionStats((bNodeTree *)node->id, (bNodeTree *)exec_node->id);
+    }
+  }
+}
+
 /* *********************************************** */
 
 /* Update the outputs of the render layer nodes.
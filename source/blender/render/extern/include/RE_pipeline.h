@@ -147,11 +147,19 @@ typedef struct RenderResult {
   /* for acquire image, to indicate if it there is a combined layer */
   int have_combined;
 
+  /* changes whenever passes are written, identifies the contents for caches */
+  unsigned int update_counter;
+
   /* render info text */
   char *text;
   char *error;
 
   struct StampData *stamp_data;
+
+  /* multilayer file that passes without rect are read from, see RE_RenderResult_load_pass */
+  void *exrhandle;
+  char exr_colorspace[64];
+  bool exr_predivide;
 } RenderResult;
 
 typedef struct RenderStats {
@@ -320,6 +328,7 @@ bool RE_WriteRenderResult(struct ReportList *reports,
                           struct ImageFormatData *imf,
                           const char *view,
                           int layer);
+/* takes over exrhandle, passes of lazily loaded files are read by RE_RenderResult_load_pass */
 struct RenderResult *RE_MultilayerConvert(
     void *exrhandle, const char *colorspace, bool predivide, int rectx, int recty);
 
@@ -384,6 +393,8 @@ bool RE_allow_render_generic_object(struct Object *ob);
 bool RE_HasCombinedLayer(RenderResult *res);
 bool RE_HasFloatPixels(RenderResult *res);
 bool RE_RenderResult_is_stereo(RenderResult *res);
+void RE_RenderResult_load_pass(RenderResult *res, RenderLayer *rl, RenderPass *rpass);
+void RE_RenderResult_load_all_passes(RenderResult *res);
 struct RenderView *RE_RenderViewGetById(struct RenderResult *res, const int view_id);
 struct RenderView *RE_RenderViewGetByName(struct RenderResult *res, const char *viewname);
 
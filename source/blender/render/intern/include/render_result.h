@@ -62,6 +62,7 @@ void render_result_views_new(struct RenderResult *rr, struct RenderData *rd);
 /* Merge */
 
 void render_result_merge(struct RenderResult *rr, struct RenderResult *rrpart);
+void render_result_tag_update(struct RenderResult *rr);
 
 /* Add Passes */
 
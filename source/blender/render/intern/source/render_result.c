@@ -28,6 +28,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
 #include "BLI_listbase.h"
@@ -55,6 +57,9 @@
 #include "render_result.h"
 #include "render_types.h"
 
+/* Serializes reading passes of multilayer files on demand. */
+static ThreadMutex exr_pass_lock = BLI_MUTEX_INITIALIZER;
+
 /********************************** Free *************************************/
 
 static void render_result_views_free(RenderResult *res)
@@ -122,6 +127,10 @@ void render_result_free(RenderResult *res)
 
   BKE_stamp_data_free(res->stamp_data);
 
+  if (res->exrhandle) {
+    IMB_exr_close(res->exrhandle);
+  }
+
   MEM_freeN(res);
 }
 
@@ -303,6 +312,7 @@ RenderResult *render_result_new(Render *re,
   }
 
   rr = MEM_callocN(sizeof(RenderResult), "new render result");
+  render_result_tag_update(rr);
   rr->rectx = rectx;
   rr->recty = recty;
   rr->renrect.xmin = 0;
@@ -744,6 +754,7 @@ RenderResult *render_result_new_from_exr(
   const char *to_colorspace = IMB_colormanagement_role_colorspace_name_get(
       COLOR_ROLE_SCENE_LINEAR);
 
+  render_result_tag_update(rr);
   rr->rectx = rectx;
   rr->recty = recty;
 
@@ -759,7 +770,11 @@ RenderResult *render_result_new_from_exr(
       rpass->rectx = rectx;
       rpass->recty = recty;
 
-      if (rpass->channels >= 3) {
+      if (rpass->rect == NULL) {
+        /* Read on demand from the file. */
+        rr->exrhandle = exrhandle;
+      }
+      else if (rpass->channels >= 3) {
         IMB_colormanagement_transform(rpass->rect,
                                       rpass->rectx,
                                       rpass->recty,
@@ -771,9 +786,75 @@ RenderResult *render_result_new_from_exr(
     }
   }
 
+  if (rr->exrhandle) {
+    BLI_strncpy(rr->exr_colorspace, colorspace, sizeof(rr->exr_colorspace));
+    rr->exr_predivide = predivide;
+  }
+  else {
+    IMB_exr_close(exrhandle);
+  }
+
   return rr;
 }
 
+static bool render_result_exr_passes_loaded(RenderResult *rr)
+{
+  for (RenderLayer *rl = rr->layers.first; rl; rl = rl->next) {
+    for (RenderPass *rpass = rl->passes.first; rpass; rpass = rpass->next) {
+      if (rpass->rect == NULL) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void RE_RenderResult_load_pass(RenderResult *rr, RenderLayer *rl, RenderPass *rpass)
+{
+  if (rpass->rect || rr->exrhandle == NULL) {
+    return;
+  }
+
+  BLI_mutex_lock(&exr_pass_lock);
+
+  if (rpass->rect == NULL && rr->exrhandle) {
+    float *rect = IMB_exr_read_pass(rr->exrhandle, rl->name, rpass->name, rpass->view);
+
+    if (rect == NULL) {
+      rect = MEM_calloc_arrayN(
+          (size_t)rpass->rectx * rpass->recty, sizeof(float) * rpass->channels, "loaded pass");
+    }
+    else if (rpass->channels >= 3) {
+      IMB_colormanagement_transform(rect,
+                                    rpass->rectx,
+                                    rpass->recty,
+                                    rpass->channels,
+                                    rr->exr_colorspace,
+                                    IMB_colormanagement_role_colorspace_name_get(
+                                        COLOR_ROLE_SCENE_LINEAR),
+                                    rr->exr_predivide);
+    }
+    rpass->rect = rect;
+
+    /* The file is no longer needed once every pass is read. */
+    if (render_result_exr_passes_loaded(rr)) {
+      IMB_exr_close(rr->exrhandle);
+      rr->exrhandle = NULL;
+    }
+  }
+
+  BLI_mutex_unlock(&exr_pass_lock);
+}
+
+void RE_RenderResult_load_all_passes(RenderResult *rr)
+{
+  for (RenderLayer *rl = rr->layers.first; rl; rl = rl->next) {
+    for (RenderPass *rpass = rl->passes.first; rpass; rpass = rpass->next) {
+      RE_RenderResult_load_pass(rr, rl, rpass);
+    }
+  }
+}
+
 void render_result_view_new(RenderResult *rr, const char *viewname)
 {
   RenderView *rv = MEM_callocN(sizeof(RenderView), "new render view");
@@ -877,6 +958,16 @@ void render_result_merge(RenderResult *rr, RenderResult *rrpart)
       }
     }
   }
+
+  render_result_tag_update(rr);
+}
+
+/* Render results are written in place, give the contents a new identifier. */
+static unsigned int render_result_update_counter = 0;
+
+void render_result_tag_update(RenderResult *rr)
+{
+  rr->update_counter = atomic_add_and_fetch_u(&render_result_update_counter, 1);
 }
 
 /* Called from the UI and render pipeline, to save multilayer and multiview
@@ -1097,6 +1188,7 @@ void render_result_single_layer_end(Render *re)
 
   RE_FreeRenderResult(re->pushedresult);
   re->pushedresult = NULL;
+  render_result_tag_update(re->result);
 }
 
 /************************* EXR Tile File Rendering ***************************/
@@ -1371,6 +1463,7 @@ int render_result_exr_file_read_path(RenderResult *rr,
 
   IMB_exr_read_channels(exrhandle);
   IMB_exr_close(exrhandle);
+  render_result_tag_update(rr);
 
   return 1;
 }
@@ -1667,8 +1760,10 @@ static RenderView *duplicate_render_view(RenderView *rview)
 RenderResult *RE_DuplicateRenderResult(RenderResult *rr)
 {
   RenderResult *new_rr = MEM_mallocN(sizeof(RenderResult), "new duplicated render result");
+  RE_RenderResult_load_all_passes(rr);
   *new_rr = *rr;
   new_rr->next = new_rr->prev = NULL;
+  render_result_tag_update(new_rr);
   new_rr->layers.first = new_rr->layers.last = NULL;
   new_rr->views.first = new_rr->views.last = NULL;
   for (RenderLayer *rl = rr->layers.first; rl != NULL; rl = rl->next) {
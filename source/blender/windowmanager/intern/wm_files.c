@@ -375,6 +375,7 @@ static void wm_init_userdef(Main *bmain)
 }
 
 /* return codes */
+#define BKE_READ_EXOTIC_FAIL_ZSTD -4   /* zstd compressed file, built without zstd support */
 #define BKE_READ_EXOTIC_FAIL_PATH -3   /* file format is not supported */
 #define BKE_READ_EXOTIC_FAIL_FORMAT -2 /* file format is not supported */
 #define BKE_READ_EXOTIC_FAIL_OPEN -1   /* Can't open the file */
@@ -408,6 +409,14 @@ static int wm_read_exotic(const char *name)
       if (len == sizeof(header) && STREQLEN(header, "BLENDER", 7)) {
         retval = BKE_READ_EXOTIC_OK_BLEND;
       }
+      else if (len == sizeof(header) && STREQLEN(header, "\x28\xb5\x2f\xfd", 4)) {
+        /* Zstandard compressed file, the header is checked when reading. */
+#ifdef WITH_ZSTD
+        retval = BKE_READ_EXOTIC_OK_BLEND;
+#else
+        retval = BKE_READ_EXOTIC_FAIL_ZSTD;
+#endif
+      }
       else {
         /* We may want to support loading other file formats
          * from their header bytes or file extension.
@@ -691,6 +700,12 @@ bool WM_file_read(bContext *C, const char *filepath, ReportList *reports)
   else if (retval == BKE_READ_EXOTIC_FAIL_PATH) {
     BKE_reportf(reports, RPT_ERROR, "File path '%s' invalid", filepath);
   }
+  else if (retval == BKE_READ_EXOTIC_FAIL_ZSTD) {
+    BKE_reportf(reports,
+                RPT_ERROR,
+                "Cannot read file '%s': Zstandard compression is not supported by this build",
+                filepath);
+  }
   else {
     BKE_reportf(reports, RPT_ERROR, "Unknown error loading '%s'", filepath);
     BLI_assert(!"invalid 'retval'");
@@ -1410,6 +1425,7 @@ static bool wm_file_write(bContext *C, const char *filepath, int fileflags, Repo
     }
 
     SET_FLAG_FROM_TEST(G.fileflags, fileflags & G_FILE_COMPRESS, G_FILE_COMPRESS);
+    SET_FLAG_FROM_TEST(G.fileflags, fileflags & G_FILE_COMPRESS_ZSTD, G_FILE_COMPRESS_ZSTD);
 
     /* prevent background mode scripts from clobbering history */
     if (do_history) {
@@ -2543,6 +2559,13 @@ static void save_set_compress(wmOperator *op)
       RNA_property_boolean_set(op->ptr, prop, (U.flag & USER_FILECOMPRESS) != 0);
     }
   }
+
+  prop = RNA_struct_find_property(op->ptr, "compress_zstd");
+  if (!RNA_property_is_set(op->ptr, prop)) {
+    if (G.save_over) { /* keep compression method of existing file */
+      RNA_property_boolean_set(op->ptr, prop, (G.fileflags & G_FILE_COMPRESS_ZSTD) != 0);
+    }
+  }
 }
 
 static void save_set_filepath(bContext *C, wmOperator *op)
@@ -2600,6 +2623,7 @@ static int wm_save_as_mainfile_exec(bContext *C, wmOperator *op)
 
   /* set compression flag */
   SET_FLAG_FROM_TEST(fileflags, RNA_boolean_get(op->ptr, "compress"), G_FILE_COMPRESS);
+  SET_FLAG_FROM_TEST(fileflags, RNA_boolean_get(op->ptr, "compress_zstd"), G_FILE_COMPRESS_ZSTD);
   SET_FLAG_FROM_TEST(fileflags, RNA_boolean_get(op->ptr, "relative_remap"), G_FILE_RELATIVE_REMAP);
   SET_FLAG_FROM_TEST(
       fileflags,
@@ -2664,6 +2688,12 @@ void WM_OT_save_as_mainfile(wmOperatorType *ot)
                                  FILE_DEFAULTDISPLAY,
                                  FILE_SORT_ALPHA);
   RNA_def_boolean(ot->srna, "compress", false, "Compress", "Write compressed .blend file");
+  RNA_def_boolean(ot->srna,
+                  "compress_zstd",
+                  false,
+                  "Zstandard Compression",
+                  "Use multi-threaded Zstandard compression instead of gzip, faster to write and "
+                  "read, but files can not be opened by older versions of Blender");
   RNA_def_boolean(ot->srna,
                   "relative_remap",
                   true,
@@ -2736,6 +2766,12 @@ void WM_OT_save_mainfile(wmOperatorType *ot)
                                  FILE_DEFAULTDISPLAY,
                                  FILE_SORT_ALPHA);
   RNA_def_boolean(ot->srna, "compress", false, "Compress", "Write compressed .blend file");
+  RNA_def_boolean(ot->srna,
+                  "compress_zstd",
+                  false,
+                  "Zstandard Compression",
+                  "Use multi-threaded Zstandard compression instead of gzip, faster to write and "
+                  "read, but files can not be opened by older versions of Blender");
   RNA_def_boolean(ot->srna,
                   "relative_remap",
                   false,
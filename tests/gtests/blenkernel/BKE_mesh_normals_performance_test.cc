@@ -0,0 +1,309 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_math.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_mesh.h"
+
+#include "DNA_meshdata_types.h"
+
+#include "PIL_time.h"
+}
+
+#define NUM_RUN_AVERAGED 10
+
+typedef struct GridMesh {
+  MVert *mverts;
+  MEdge *medges;
+  MLoop *mloops;
+  MPoly *mpolys;
+  int totvert, totedge, totloop, totpoly;
+} GridMesh;
+
+/* Edge from vertex (x, y) to (x + 1, y). */
+static int grid_mesh_edge_x(const int size, const int x, const int y)
+{
+  return y * size + x;
+}
+
+/* Edge from vertex (x, y) to (x, y + 1), after all edges along x. */
+static int grid_mesh_edge_y(const int size, const int x, const int y)
+{
+  return (size + 1) * size + y * (size + 1) + x;
+}
+
+/* A grid of quads with some relief, so that vertex normals differ. */
+static void grid_mesh_create(GridMesh *grid, const int size)
+{
+  const int verts_row = size + 1;
+  grid->totvert = verts_row * verts_row;
+  grid->totedge = verts_row * size * 2;
+  grid->totpoly = size * size;
+  grid->totloop = grid->totpoly * 4;
+  grid->mverts = (MVert *)MEM_calloc_arrayN(grid->totvert, sizeof(MVert), __func__);
+  grid->medges = (MEdge *)MEM_calloc_arrayN(grid->totedge, sizeof(MEdge), __func__);
+  grid->mloops = (MLoop *)MEM_calloc_arrayN(grid->totloop, sizeof(MLoop), __func__);
+  grid->mpolys = (MPoly *)MEM_calloc_arrayN(grid->totpoly, sizeof(MPoly), __func__);
+
+  for (int y = 0; y < verts_row; y++) {
+    for (int x = 0; x < verts_row; x++) {
+      float *co = grid->mverts[y * verts_row + x].co;
+      co[0] = (float)x / (float)size;
+      co[1] = (float)y / (float)size;
+      co[2] = sinf((float)x * 0.3f) * cosf((float)y * 0.2f) / (float)size;
+    }
+  }
+
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      const int poly_index = y * size + x;
+      MPoly *mp = &grid->mpolys[poly_index];
+      mp->loopstart = poly_index * 4;
+      mp->totloop = 4;
+      MLoop *ml = &grid->mloops[mp->loopstart];
+      ml[0].v = (uint)(y * verts_row + x);
+      ml[1].v = (uint)(y * verts_row + x + 1);
+      ml[2].v = (uint)((y + 1) * verts_row + x + 1);
+      ml[3].v = (uint)((y + 1) * verts_row + x);
+      ml[0].e = (uint)grid_mesh_edge_x(size, x, y);
+      ml[1].e = (uint)grid_mesh_edge_y(size, x + 1, y);
+      ml[2].e = (uint)grid_mesh_edge_x(size, x, y + 1);
+      ml[3].e = (uint)grid_mesh_edge_y(size, x, y);
+    }
+  }
+
+  for (int y = 0; y < verts_row; y++) {
+    for (int x = 0; x < size; x++) {
+      MEdge *me = &grid->medges[grid_mesh_edge_x(size, x, y)];
+      me->v1 = (uint)(y * verts_row + x);
+      me->v2 = (uint)(y * verts_row + x + 1);
+    }
+  }
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < verts_row; x++) {
+      MEdge *me = &grid->medges[grid_mesh_edge_y(size, x, y)];
+      me->v1 = (uint)(y * verts_row + x);
+      me->v2 = (uint)((y + 1) * verts_row + x);
+    }
+  }
+}
+
+static void grid_mesh_free(GridMesh *grid)
+{
+  MEM_freeN(grid->mverts);
+  MEM_freeN(grid->medges);
+  MEM_freeN(grid->mloops);
+  MEM_freeN(grid->mpolys);
+}
+
+/* Single threaded reference, accumulating poly normals into vertices one poly at a time. */
+static void mesh_calc_normals_reference(const GridMesh *grid,
+                                        float (*r_polynors)[3],
+                                        float (*r_vertnors)[3])
+{
+  memset(r_vertnors, 0, sizeof(*r_vertnors) * (size_t)grid->totvert);
+
+  for (int i = 0; i < grid->totpoly; i++) {
+    const MPoly *mp = &grid->mpolys[i];
+    const MLoop *ml = &grid->mloops[mp->loopstart];
+    BKE_mesh_calc_poly_normal(mp, ml, grid->mverts, r_polynors[i]);
+
+    float *vertnos[4];
+    const float *vertcos[4];
+    float vdiffs[4][3];
+    for (int j = 0; j < mp->totloop; j++) {
+      vertnos[j] = r_vertnors[ml[j].v];
+      vertcos[j] = grid->mverts[ml[j].v].co;
+    }
+    accumulate_vertex_normals_poly_v3(vertnos, r_polynors[i], vertcos, vdiffs, mp->totloop);
+  }
+
+  for (int i = 0; i < grid->totvert; i++) {
+    normalize_v3(r_vertnors[i]);
+  }
+}
+
+static void mesh_calc_normals_poly_test_do(const int size)
+{
+  GridMesh grid;
+  grid_mesh_create(&grid, size);
+
+  float(*polynors)[3] = (float(*)[3])MEM_malloc_arrayN(grid.totpoly, sizeof(float[3]), __func__);
+  float(*vertnors)[3] = (float(*)[3])MEM_malloc_arrayN(grid.totvert, sizeof(float[3]), __func__);
+  float(*vertnors_ref)[3] = (float(*)[3])MEM_malloc_arrayN(
+      grid.totvert, sizeof(float[3]), __func__);
+
+  double timing_ref = 0.0;
+  double timing = 0.0;
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    double init_time = PIL_check_seconds_timer();
+    mesh_calc_normals_reference(&grid, polynors, vertnors_ref);
+    timing_ref += PIL_check_seconds_timer() - init_time;
+
+    init_time = PIL_check_seconds_timer();
+    BKE_mesh_calc_normals_poly(grid.mverts,
+                               vertnors,
+                               grid.totvert,
+                               grid.mloops,
+                               grid.mpolys,
+                               grid.totloop,
+                               grid.totpoly,
+                               polynors,
+                               false);
+    timing += PIL_check_seconds_timer() - init_time;
+  }
+
+  printf("\t%dx%d grid (%d polys): reference %fs, BKE_mesh_calc_normals_poly %fs (x%.2f)\n",
+         size,
+         size,
+         grid.totpoly,
+         timing_ref / NUM_RUN_AVERAGED,
+         timing / NUM_RUN_AVERAGED,
+         timing_ref / timing);
+
+  /* The reference computes corner angles from differently rounded edge vectors. */
+  int num_mismatch = 0;
+  for (int i = 0; i < grid.totvert; i++) {
+    if (!compare_v3v3(vertnors[i], vertnors_ref[i], 1e-4f)) {
+      num_mismatch++;
+    }
+  }
+  EXPECT_EQ(0, num_mismatch);
+
+  MEM_freeN(polynors);
+  MEM_freeN(vertnors);
+  MEM_freeN(vertnors_ref);
+  grid_mesh_free(&grid);
+}
+
+TEST(mesh_normals, CalcNormalsPoly10k)
+{
+  mesh_calc_normals_poly_test_do(100);
+}
+
+TEST(mesh_normals, CalcNormalsPoly1M)
+{
+  mesh_calc_normals_poly_test_do(1000);
+}
+
+TEST(mesh_normals, CalcNormalsPoly4M)
+{
+  mesh_calc_normals_poly_test_do(2000);
+}
+
+static void mesh_normals_loop_split_test_do(const int size, const bool use_custom_normals)
+{
+  GridMesh grid;
+  grid_mesh_create(&grid, size);
+
+  /* Smooth polys, with a few sharp edges to get fans of different sizes. */
+  for (int i = 0; i < grid.totpoly; i++) {
+    grid.mpolys[i].flag |= ME_SMOOTH;
+  }
+  for (int i = 0; i < grid.totedge; i += 7) {
+    grid.medges[i].flag |= ME_SHARP;
+  }
+
+  float(*polynors)[3] = (float(*)[3])MEM_malloc_arrayN(grid.totpoly, sizeof(float[3]), __func__);
+  float(*loopnors)[3] = (float(*)[3])MEM_malloc_arrayN(grid.totloop, sizeof(float[3]), __func__);
+  float(*loopnors_ref)[3] = (float(*)[3])MEM_malloc_arrayN(
+      grid.totloop, sizeof(float[3]), __func__);
+  /* Neutral custom normals, computing them needs the lnor spaces. */
+  short(*clnors)[2] = use_custom_normals ? (short(*)[2])MEM_calloc_arrayN(
+                                               grid.totloop, sizeof(short[2]), __func__) :
+                                           NULL;
+  struct MeshLoopSplitCache *loop_split_cache = BKE_mesh_loop_split_cache_create();
+
+  double timing_ref = 0.0;
+  double timing = 0.0;
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    /* Deform, so only positions change between runs. */
+    for (int v = 0; v < grid.totvert; v++) {
+      grid.mverts[v].co[2] = sinf(grid.mverts[v].co[0] * (float)(size + i)) / (float)size;
+    }
+    BKE_mesh_calc_normals_poly(grid.mverts,
+                               NULL,
+                               grid.totvert,
+                               grid.mloops,
+                               grid.mpolys,
+                               grid.totloop,
+                               grid.totpoly,
+                               polynors,
+                               false);
+
+    double init_time = PIL_check_seconds_timer();
+    BKE_mesh_normals_loop_split(grid.mverts,
+                                grid.totvert,
+                                grid.medges,
+                                grid.totedge,
+                                grid.mloops,
+                                loopnors_ref,
+                                grid.totloop,
+                                grid.mpolys,
+                                (const float(*)[3])polynors,
+                                grid.totpoly,
+                                true,
+                                (float)M_PI,
+                                NULL,
+                                clnors,
+                                NULL);
+    timing_ref += PIL_check_seconds_timer() - init_time;
+
+    init_time = PIL_check_seconds_timer();
+    BKE_mesh_normals_loop_split_ex(grid.mverts,
+                                   grid.totvert,
+                                   grid.medges,
+                                   grid.totedge,
+                                   grid.mloops,
+                                   loopnors,
+                                   grid.totloop,
+                                   grid.mpolys,
+                                   (const float(*)[3])polynors,
+                                   grid.totpoly,
+                                   true,
+                                   (float)M_PI,
+                                   NULL,
+                                   clnors,
+                                   NULL,
+                                   loop_split_cache);
+    timing += PIL_check_seconds_timer() - init_time;
+
+    EXPECT_EQ(0, memcmp(loopnors, loopnors_ref, sizeof(*loopnors) * (size_t)grid.totloop));
+  }
+
+  printf("\t%dx%d grid (%d polys%s): uncached %fs, cached fans %fs (x%.2f)\n",
+         size,
+         size,
+         grid.totpoly,
+         use_custom_normals ? ", custom normals" : "",
+         timing_ref / NUM_RUN_AVERAGED,
+         timing / NUM_RUN_AVERAGED,
+         timing_ref / timing);
+
+  BKE_mesh_loop_split_cache_free(loop_split_cache);
+  MEM_SAFE_FREE(clnors);
+  MEM_freeN(polynors);
+  MEM_freeN(loopnors);
+  MEM_freeN(loopnors_ref);
+  grid_mesh_free(&grid);
+}
+
+TEST(mesh_normals, NormalsLoopSplit10k)
+{
+  mesh_normals_loop_split_test_do(100, false);
+}
+
+TEST(mesh_normals, NormalsLoopSplit1M)
+{
+  mesh_normals_loop_split_test_do(1000, false);
+}
+
+TEST(mesh_normals, NormalsLoopSplitCustom1M)
+{
+  mesh_normals_loop_split_test_do(1000, true);
+}
@@ -0,0 +1,266 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_compiler_attrs.h"
+#include "BLI_kdopbvh.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+#include "PIL_time.h"
+}
+
+#include "stubs/bf_intern_eigen_stubs.h"
+
+/* -------------------------------------------------------------------- */
+/* Helper Functions */
+
+static void rng_v3_round(float *coords, int coords_len, struct RNG *rng, int round, float scale)
+{
+  for (int i = 0; i < coords_len; i++) {
+    float f = BLI_rng_get_float(rng) * 2.0f - 1.0f;
+    coords[i] = ((float)((int)(f * round)) / (float)round) * scale;
+  }
+}
+
+/* Small cubes around random points, so rays can hit them. */
+static BVHTree *cubes_tree_create(int cubes_len, float size, int random_seed, int flag = 0)
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+  BVHTree *tree = BLI_bvhtree_new_ex(cubes_len, 0.0, 4, 6, flag);
+  for (int i = 0; i < cubes_len; i++) {
+    float co[2][3];
+    rng_v3_round(co[0], 3, rng, 1000, 1.0f);
+    copy_v3_v3(co[1], co[0]);
+    add_v3_fl(co[1], size);
+    BLI_bvhtree_insert(tree, i, co[0], 2);
+  }
+  BLI_bvhtree_balance(tree);
+  BLI_rng_free(rng);
+  return tree;
+}
+
+/* Coherent queries, like a camera: a grid of points on a plane in front of the cubes. */
+static void grid_queries_create(int grid_size, float (*r_co)[3], float (*r_dir)[3])
+{
+  for (int y = 0; y < grid_size; y++) {
+    for (int x = 0; x < grid_size; x++) {
+      const int i = y * grid_size + x;
+      r_co[i][0] = ((float)x / (float)grid_size) * 2.0f - 1.0f;
+      r_co[i][1] = ((float)y / (float)grid_size) * 2.0f - 1.0f;
+      r_co[i][2] = -2.0f;
+      if (r_dir) {
+        /* Slightly diverging rays. */
+        r_dir[i][0] = r_co[i][0] * 0.1f;
+        r_dir[i][1] = r_co[i][1] * 0.1f;
+        r_dir[i][2] = 1.0f;
+        normalize_v3(r_dir[i]);
+      }
+    }
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/* Batched Queries, compared to one query at a time */
+
+static void ray_cast_batch_benchmark(int cubes_len, int grid_size)
+{
+  BVHTree *tree = cubes_tree_create(cubes_len, 0.02f, 1234);
+
+  const int rays_len = grid_size * grid_size;
+  float(*co)[3] = (float(*)[3])MEM_malloc_arrayN(rays_len, sizeof(float[3]), __func__);
+  float(*dir)[3] = (float(*)[3])MEM_malloc_arrayN(rays_len, sizeof(float[3]), __func__);
+  BVHTreeRayHit *hits = (BVHTreeRayHit *)MEM_malloc_arrayN(
+      rays_len, sizeof(BVHTreeRayHit), __func__);
+  grid_queries_create(grid_size, co, dir);
+
+  double time_start = PIL_check_seconds_timer();
+  for (int i = 0; i < rays_len; i++) {
+    hits[i].index = -1;
+    hits[i].dist = BVH_RAYCAST_DIST_MAX;
+    BLI_bvhtree_ray_cast(tree, co[i], dir[i], 0.0f, &hits[i], NULL, NULL);
+  }
+  const double time_ref = PIL_check_seconds_timer() - time_start;
+
+  time_start = PIL_check_seconds_timer();
+  for (int i = 0; i < rays_len; i++) {
+    hits[i].index = -1;
+    hits[i].dist = BVH_RAYCAST_DIST_MAX;
+  }
+  BLI_bvhtree_ray_cast_batch(tree, co, dir, rays_len, 0.0f, hits, NULL, NULL, 0);
+  const double time_batch = PIL_check_seconds_timer() - time_start;
+
+  int hits_len = 0;
+  for (int i = 0; i < rays_len; i++) {
+    hits_len += (hits[i].index != -1);
+  }
+
+  printf("\t%d rays, %d cubes (%d hits): single %fs, batch %fs (x%.2f)\n",
+         rays_len,
+         cubes_len,
+         hits_len,
+         time_ref,
+         time_batch,
+         time_ref / time_batch);
+
+  BLI_bvhtree_free(tree);
+  MEM_freeN(co);
+  MEM_freeN(dir);
+  MEM_freeN(hits);
+}
+
+static void find_nearest_batch_benchmark(int cubes_len, int grid_size)
+{
+  BVHTree *tree = cubes_tree_create(cubes_len, 0.02f, 4321);
+
+  const int co_len = grid_size * grid_size;
+  float(*co)[3] = (float(*)[3])MEM_malloc_arrayN(co_len, sizeof(float[3]), __func__);
+  BVHTreeNearest *nearest = (BVHTreeNearest *)MEM_malloc_arrayN(
+      co_len, sizeof(BVHTreeNearest), __func__);
+  grid_queries_create(grid_size, co, NULL);
+  /* Within the cubes, so nodes are actually pruned. */
+  for (int i = 0; i < co_len; i++) {
+    co[i][2] = co[i][0] * co[i][1];
+  }
+
+  double time_start = PIL_check_seconds_timer();
+  for (int i = 0; i < co_len; i++) {
+    nearest[i].index = -1;
+    nearest[i].dist_sq = FLT_MAX;
+    BLI_bvhtree_find_nearest(tree, co[i], &nearest[i], NULL, NULL);
+  }
+  const double time_ref = PIL_check_seconds_timer() - time_start;
+
+  time_start = PIL_check_seconds_timer();
+  for (int i = 0; i < co_len; i++) {
+    nearest[i].index = -1;
+    nearest[i].dist_sq = FLT_MAX;
+  }
+  BLI_bvhtree_find_nearest_batch(tree, co, co_len, nearest, NULL, NULL, 0);
+  const double time_batch = PIL_check_seconds_timer() - time_start;
+
+  printf("\t%d points, %d cubes: single %fs, batch %fs (x%.2f)\n",
+         co_len,
+         cubes_len,
+         time_ref,
+         time_batch,
+         time_ref / time_batch);
+
+  BLI_bvhtree_free(tree);
+  MEM_freeN(co);
+  MEM_freeN(nearest);
+}
+
+TEST(kdopbvh, RayCastBatch)
+{
+  ray_cast_batch_benchmark(50000, 256);
+}
+TEST(kdopbvh, FindNearestBatch)
+{
+  find_nearest_batch_benchmark(50000, 256);
+}
+
+/* -------------------------------------------------------------------- */
+/* Refit, compared to building the tree again */
+
+static int cubes_refit_cb(void *userdata, int index, float r_co[BVH_REFIT_POINTS_MAX][3])
+{
+  const float(*co)[2][3] = (const float(*)[2][3])userdata;
+  copy_v3_v3(r_co[0], co[index][0]);
+  copy_v3_v3(r_co[1], co[index][1]);
+  return 2;
+}
+
+TEST(kdopbvh, Refit)
+{
+  const int cubes_len = 200000;
+  float(*cubes_co)[2][3] = (float(*)[2][3])MEM_malloc_arrayN(
+      cubes_len, sizeof(*cubes_co), __func__);
+  struct RNG *rng = BLI_rng_new(1234);
+  for (int i = 0; i < cubes_len; i++) {
+    rng_v3_round(cubes_co[i][0], 3, rng, 1000, 1.0f);
+    copy_v3_v3(cubes_co[i][1], cubes_co[i][0]);
+    add_v3_fl(cubes_co[i][1], 0.01f);
+  }
+  BLI_rng_free(rng);
+
+  double time_start = PIL_check_seconds_timer();
+  BVHTree *tree = BLI_bvhtree_new(cubes_len, 0.0, 4, 6);
+  for (int i = 0; i < cubes_len; i++) {
+    BLI_bvhtree_insert(tree, i, cubes_co[i][0], 2);
+  }
+  BLI_bvhtree_balance(tree);
+  const double time_build = PIL_check_seconds_timer() - time_start;
+
+  time_start = PIL_check_seconds_timer();
+  BLI_bvhtree_refit(tree, cubes_refit_cb, cubes_co);
+  const double time_refit = PIL_check_seconds_timer() - time_start;
+
+  printf("\t%d cubes: build %fs, refit %fs (x%.2f)\n",
+         cubes_len,
+         time_build,
+         time_refit,
+         time_build / time_refit);
+
+  BLI_bvhtree_free(tree);
+  MEM_freeN(cubes_co);
+}
+
+/* -------------------------------------------------------------------- */
+/* SAH build, compared to the median split */
+
+static double ray_cast_time(BVHTree *tree,
+                            const float (*co)[3],
+                            const float (*dir)[3],
+                            int rays_len)
+{
+  const double time_start = PIL_check_seconds_timer();
+  for (int i = 0; i < rays_len; i++) {
+    BVHTreeRayHit hit;
+    hit.index = -1;
+    hit.dist = BVH_RAYCAST_DIST_MAX;
+    BLI_bvhtree_ray_cast(tree, co[i], dir[i], 0.0f, &hit, NULL, NULL);
+  }
+  return PIL_check_seconds_timer() - time_start;
+}
+
+TEST(kdopbvh, BuildSAH)
+{
+  const int cubes_len = 200000;
+  const int grid_size = 256;
+
+  double time_start = PIL_check_seconds_timer();
+  BVHTree *tree = cubes_tree_create(cubes_len, 0.02f, 1234);
+  const double time_build = PIL_check_seconds_timer() - time_start;
+
+  time_start = PIL_check_seconds_timer();
+  BVHTree *tree_sah = cubes_tree_create(cubes_len, 0.02f, 1234, BVH_BUILD_SAH);
+  const double time_build_sah = PIL_check_seconds_timer() - time_start;
+
+  const int rays_len = grid_size * grid_size;
+  float(*co)[3] = (float(*)[3])MEM_malloc_arrayN(rays_len, sizeof(float[3]), __func__);
+  float(*dir)[3] = (float(*)[3])MEM_malloc_arrayN(rays_len, sizeof(float[3]), __func__);
+  grid_queries_create(grid_size, co, dir);
+
+  const double time_rays = ray_cast_time(tree, co, dir, rays_len);
+  const double time_rays_sah = ray_cast_time(tree_sah, co, dir, rays_len);
+
+  printf("\t%d cubes: build %fs, SAH build %fs (x%.2f)\n",
+         cubes_len,
+         time_build,
+         time_build_sah,
+         time_build / time_build_sah);
+  printf("\t%d rays: %fs, SAH %fs (x%.2f)\n",
+         rays_len,
+         time_rays,
+         time_rays_sah,
+         time_rays / time_rays_sah);
+
+  BLI_bvhtree_free(tree);
+  BLI_bvhtree_free(tree_sah);
+  MEM_freeN(co);
+  MEM_freeN(dir);
+}
+
@@ -10,6 +10,7 @@ extern "C" {
 #include "BLI_compiler_attrs.h"
 #include "BLI_kdopbvh.h"
 #include "BLI_rand.h"
+#include "BLI_math_geom.h"
 #include "BLI_math_vector.h"
 }
 
@@ -136,3 +137,347 @@ TEST(kdopbvh, OptimalFindNearest_500)
 {
   find_nearest_points_test(500, 1.0, 1000, 12, true);
 }
+
+/* -------------------------------------------------------------------- */
+/* Batched Queries */
+
+/* Small cubes around random points, so rays can hit them. */
+static BVHTree *cubes_tree_create(int cubes_len, float size, int random_seed)
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+  BVHTree *tree = BLI_bvhtree_new(cubes_len, 0.0, 4, 6);
+  for (int i = 0; i < cubes_len; i++) {
+    float co[2][3];
+    rng_v3_round(co[0], 3, rng, 1000, 1.0f);
+    copy_v3_v3(co[1], co[0]);
+    add_v3_fl(co[1], size);
+    BLI_bvhtree_insert(tree, i, co[0], 2);
+  }
+  BLI_bvhtree_balance(tree);
+  BLI_rng_free(rng);
+  return tree;
+}
+
+/* Coherent queries, like a camera: a grid of points on a plane in front of the cubes. */
+static void grid_queries_create(int grid_size, float (*r_co)[3], float (*r_dir)[3])
+{
+  for (int y = 0; y < grid_size; y++) {
+    for (int x = 0; x < grid_size; x++) {
+      const int i = y * grid_size + x;
+      r_co[i][0] = ((float)x / (float)grid_size) * 2.0f - 1.0f;
+      r_co[i][1] = ((float)y / (float)grid_size) * 2.0f - 1.0f;
+      r_co[i][2] = -2.0f;
+      if (r_dir) {
+        /* Slightly diverging rays. */
+        r_dir[i][0] = r_co[i][0] * 0.1f;
+        r_dir[i][1] = r_co[i][1] * 0.1f;
+        r_dir[i][2] = 1.0f;
+        normalize_v3(r_dir[i]);
+      }
+    }
+  }
+}
+
+static void ray_cast_batch_test(int cubes_len, int grid_size)
+{
+  BVHTree *tree = cubes_tree_create(cubes_len, 0.02f, 1234);
+
+  const int rays_len = grid_size * grid_size;
+  float(*co)[3] = (float(*)[3])MEM_malloc_arrayN(rays_len, sizeof(float[3]), __func__);
+  float(*dir)[3] = (float(*)[3])MEM_malloc_arrayN(rays_len, sizeof(float[3]), __func__);
+  BVHTreeRayHit *hits = (BVHTreeRayHit *)MEM_malloc_arrayN(
+      rays_len, sizeof(BVHTreeRayHit), __func__);
+  BVHTreeRayHit *hits_ref = (BVHTreeRayHit *)MEM_malloc_arrayN(
+      rays_len, sizeof(BVHTreeRayHit), __func__);
+  grid_queries_create(grid_size, co, dir);
+
+  for (int i = 0; i < rays_len; i++) {
+    hits_ref[i].index = -1;
+    hits_ref[i].dist = BVH_RAYCAST_DIST_MAX;
+    BLI_bvhtree_ray_cast(tree, co[i], dir[i], 0.0f, &hits_ref[i], NULL, NULL);
+  }
+
+  for (int i = 0; i < rays_len; i++) {
+    hits[i].index = -1;
+    hits[i].dist = BVH_RAYCAST_DIST_MAX;
+  }
+  BLI_bvhtree_ray_cast_batch(tree, co, dir, rays_len, 0.0f, hits, NULL, NULL, 0);
+
+  int hits_len = 0;
+  for (int i = 0; i < rays_len; i++) {
+    /* Cubes may overlap, only the distance is unique. */
+    EXPECT_EQ(hits_ref[i].index == -1, hits[i].index == -1);
+    EXPECT_EQ(hits_ref[i].dist, hits[i].dist);
+    hits_len += (hits[i].index != -1);
+  }
+  if (cubes_len > 1) {
+    EXPECT_GT(hits_len, 0);
+  }
+
+  BLI_bvhtree_free(tree);
+  MEM_freeN(co);
+  MEM_freeN(dir);
+  MEM_freeN(hits);
+  MEM_freeN(hits_ref);
+}
+
+/* Nearest point on the diagonal of the cube, which is what its leaf bounds with any k-DOP. */
+static void cube_diagonal_nearest_cb(void *userdata,
+                                     int index,
+                                     const float co[3],
+                                     BVHTreeNearest *nearest)
+{
+  const float(*cubes_co)[2][3] = (const float(*)[2][3])userdata;
+  float co_nearest[3];
+  closest_to_line_segment_v3(co_nearest, co, cubes_co[index][0], cubes_co[index][1]);
+  const float dist_sq = len_squared_v3v3(co, co_nearest);
+  if (dist_sq < nearest->dist_sq) {
+    nearest->index = index;
+    nearest->dist_sq = dist_sq;
+    copy_v3_v3(nearest->co, co_nearest);
+  }
+}
+
+static void find_nearest_batch_test(int cubes_len, int grid_size, int axis, bool use_callback)
+{
+  const int co_len = grid_size * grid_size;
+  float(*cubes_co)[2][3] = (float(*)[2][3])MEM_malloc_arrayN(
+      cubes_len, sizeof(*cubes_co), __func__);
+  float(*co)[3] = (float(*)[3])MEM_malloc_arrayN(co_len, sizeof(float[3]), __func__);
+  BVHTreeNearest *nearest = (BVHTreeNearest *)MEM_malloc_arrayN(
+      co_len, sizeof(BVHTreeNearest), __func__);
+  BVHTreeNearest *nearest_ref = (BVHTreeNearest *)MEM_malloc_arrayN(
+      co_len, sizeof(BVHTreeNearest), __func__);
+
+  struct RNG *rng = BLI_rng_new(4321);
+  BVHTree *tree = BLI_bvhtree_new(cubes_len, 0.0, 4, axis);
+  for (int i = 0; i < cubes_len; i++) {
+    rng_v3_round(cubes_co[i][0], 3, rng, 1000, 1.0f);
+    copy_v3_v3(cubes_co[i][1], cubes_co[i][0]);
+    add_v3_fl(cubes_co[i][1], 0.02f);
+    BLI_bvhtree_insert(tree, i, cubes_co[i][0], 2);
+  }
+  BLI_bvhtree_balance(tree);
+  BLI_rng_free(rng);
+
+  grid_queries_create(grid_size, co, NULL);
+  /* Within the cubes, so nodes are actually pruned. */
+  for (int i = 0; i < co_len; i++) {
+    co[i][2] = co[i][0] * co[i][1];
+  }
+
+  BVHTree_NearestPointCallback callback = use_callback ? cube_diagonal_nearest_cb : NULL;
+  for (int i = 0; i < co_len; i++) {
+    nearest_ref[i].index = -1;
+    nearest_ref[i].dist_sq = FLT_MAX;
+    BLI_bvhtree_find_nearest(tree, co[i], &nearest_ref[i], callback, cubes_co);
+  }
+
+  for (int i = 0; i < co_len; i++) {
+    nearest[i].index = -1;
+    nearest[i].dist_sq = FLT_MAX;
+  }
+  BLI_bvhtree_find_nearest_batch(tree, co, co_len, nearest, callback, cubes_co, 0);
+
+  for (int i = 0; i < co_len; i++) {
+    EXPECT_NE(-1, nearest[i].index);
+    EXPECT_EQ(nearest_ref[i].dist_sq, nearest[i].dist_sq);
+  }
+
+  BLI_bvhtree_free(tree);
+  MEM_freeN(cubes_co);
+  MEM_freeN(co);
+  MEM_freeN(nearest);
+  MEM_freeN(nearest_ref);
+}
+
+TEST(kdopbvh, RayCastBatch_1)
+{
+  ray_cast_batch_test(1, 3);
+}
+TEST(kdopbvh, RayCastBatch_500)
+{
+  ray_cast_batch_test(500, 33);
+}
+TEST(kdopbvh, FindNearestBatch_1)
+{
+  find_nearest_batch_test(1, 3, 6, false);
+}
+TEST(kdopbvh, FindNearestBatch_500)
+{
+  find_nearest_batch_test(500, 33, 6, false);
+}
+TEST(kdopbvh, FindNearestBatch_500_Callback)
+{
+  find_nearest_batch_test(500, 33, 6, true);
+}
+TEST(kdopbvh, FindNearestBatch_500_KDOP14)
+{
+  find_nearest_batch_test(500, 33, 14, false);
+}
+TEST(kdopbvh, FindNearestBatch_500_KDOP26_Callback)
+{
+  find_nearest_batch_test(500, 33, 26, true);
+}
+
+/* -------------------------------------------------------------------- */
+/* Refit */
+
+static void cubes_co_random(float (*r_co)[2][3], int cubes_len, float size, int random_seed)
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+  for (int i = 0; i < cubes_len; i++) {
+    rng_v3_round(r_co[i][0], 3, rng, 1000, 1.0f);
+    copy_v3_v3(r_co[i][1], r_co[i][0]);
+    add_v3_fl(r_co[i][1], size);
+  }
+  BLI_rng_free(rng);
+}
+
+static BVHTree *cubes_tree_create_from_co(const float (*co)[2][3],
+                                          int cubes_len,
+                                          int tree_type,
+                                          int flag = 0)
+{
+  BVHTree *tree = BLI_bvhtree_new_ex(cubes_len, 0.0, tree_type, 6, flag);
+  for (int i = 0; i < cubes_len; i++) {
+    BLI_bvhtree_insert(tree, i, co[i][0], 2);
+  }
+  BLI_bvhtree_balance(tree);
+  return tree;
+}
+
+static int cubes_refit_cb(void *userdata, int index, float r_co[BVH_REFIT_POINTS_MAX][3])
+{
+  const float(*co)[2][3] = (const float(*)[2][3])userdata;
+  copy_v3_v3(r_co[0], co[index][0]);
+  copy_v3_v3(r_co[1], co[index][1]);
+  return 2;
+}
+
+/* Trees of the same cubes must find the same distances, whatever their structure. */
+static void trees_queries_compare(BVHTree *tree_a, BVHTree *tree_b, int queries_len)
+{
+  struct RNG *rng = BLI_rng_new(queries_len);
+  for (int i = 0; i < queries_len; i++) {
+    float co[3], dir[3];
+    rng_v3_round(co, 3, rng, 1000, 1.5f);
+    rng_v3_round(dir, 3, rng, 1000, 1.0f);
+    if (normalize_v3(dir) == 0.0f) {
+      dir[2] = 1.0f;
+    }
+
+    BVHTreeNearest nearest_a = {-1}, nearest_b = {-1};
+    nearest_a.dist_sq = nearest_b.dist_sq = FLT_MAX;
+    BLI_bvhtree_find_nearest(tree_a, co, &nearest_a, NULL, NULL);
+    BLI_bvhtree_find_nearest(tree_b, co, &nearest_b, NULL, NULL);
+    EXPECT_NE(-1, nearest_b.index);
+    EXPECT_EQ(nearest_a.dist_sq, nearest_b.dist_sq);
+
+    BVHTreeRayHit hit_a = {-1}, hit_b = {-1};
+    hit_a.dist = hit_b.dist = BVH_RAYCAST_DIST_MAX;
+    BLI_bvhtree_ray_cast(tree_a, co, dir, 0.0f, &hit_a, NULL, NULL);
+    BLI_bvhtree_ray_cast(tree_b, co, dir, 0.0f, &hit_b, NULL, NULL);
+    EXPECT_EQ(hit_a.index == -1, hit_b.index == -1);
+    EXPECT_EQ(hit_a.dist, hit_b.dist);
+  }
+  BLI_rng_free(rng);
+}
+
+static void refit_test(int cubes_len, int tree_type, int flag = 0)
+{
+  float(*co)[2][3] = (float(*)[2][3])MEM_malloc_arrayN(cubes_len, sizeof(*co), __func__);
+  cubes_co_random(co, cubes_len, 0.05f, cubes_len);
+
+  BVHTree *tree_refit = cubes_tree_create_from_co(co, cubes_len, tree_type, flag);
+
+  /* Deform: scale and move each cube a little. */
+  struct RNG *rng = BLI_rng_new(cubes_len);
+  for (int i = 0; i < cubes_len; i++) {
+    float offset[3];
+    rng_v3_round(offset, 3, rng, 1000, 0.1f);
+    for (int j = 0; j < 2; j++) {
+      mul_v3_fl(co[i][j], 0.5f);
+      add_v3_v3(co[i][j], offset);
+    }
+  }
+  BLI_rng_free(rng);
+
+  BLI_bvhtree_refit(tree_refit, cubes_refit_cb, co);
+  BVHTree *tree = cubes_tree_create_from_co(co, cubes_len, tree_type);
+  trees_queries_compare(tree, tree_refit, 100);
+
+  BLI_bvhtree_free(tree);
+  BLI_bvhtree_free(tree_refit);
+  MEM_freeN(co);
+}
+
+TEST(kdopbvh, Refit_1)
+{
+  refit_test(1, 2);
+}
+TEST(kdopbvh, Refit_500)
+{
+  refit_test(500, 2);
+}
+TEST(kdopbvh, Refit_500_Quad)
+{
+  refit_test(500, 4);
+}
+TEST(kdopbvh, Refit_500_SAH)
+{
+  refit_test(500, 4, BVH_BUILD_SAH);
+}
+
+/* -------------------------------------------------------------------- */
+/* SAH Build */
+
+static void sah_build_test(int cubes_len, int tree_type, bool use_same_co = false)
+{
+  float(*co)[2][3] = (float(*)[2][3])MEM_malloc_arrayN(cubes_len, sizeof(*co), __func__);
+  cubes_co_random(co, cubes_len, 0.05f, cubes_len);
+  if (use_same_co) {
+    /* Leafs can't be split by their centers. */
+    for (int i = 1; i < cubes_len; i++) {
+      copy_v3_v3(co[i][0], co[0][0]);
+      copy_v3_v3(co[i][1], co[0][1]);
+    }
+  }
+
+  BVHTree *tree = cubes_tree_create_from_co(co, cubes_len, tree_type);
+  BVHTree *tree_sah = cubes_tree_create_from_co(co, cubes_len, tree_type, BVH_BUILD_SAH);
+  EXPECT_EQ(cubes_len, BLI_bvhtree_get_len(tree_sah));
+  trees_queries_compare(tree, tree_sah, 100);
+
+  BLI_bvhtree_free(tree);
+  BLI_bvhtree_free(tree_sah);
+  MEM_freeN(co);
+}
+
+TEST(kdopbvh, BuildSAH_Empty)
+{
+  BVHTree *tree = BLI_bvhtree_new_ex(0, 0.0, 4, 6, BVH_BUILD_SAH);
+  BLI_bvhtree_balance(tree);
+  EXPECT_EQ(0, BLI_bvhtree_get_len(tree));
+  BLI_bvhtree_free(tree);
+}
+TEST(kdopbvh, BuildSAH_1)
+{
+  sah_build_test(1, 2);
+}
+TEST(kdopbvh, BuildSAH_500)
+{
+  sah_build_test(500, 2);
+}
+TEST(kdopbvh, BuildSAH_500_Quad)
+{
+  sah_build_test(500, 4);
+}
+TEST(kdopbvh, BuildSAH_500_Oct)
+{
+  sah_build_test(500, 8);
+}
+TEST(kdopbvh, BuildSAH_500_SameCenter)
+{
+  sah_build_test(500, 4, true);
+}
@@ -0,0 +1,77 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <stdio.h>
+
+#ifndef _WIN32
+#  include <unistd.h>
+#endif
+
+extern "C" {
+#include "BLI_mmap.h"
+#include "BLI_utildefines.h"
+}
+
+TEST(mmap, ReadRange)
+{
+  FILE *f = tmpfile();
+  ASSERT_NE(nullptr, f);
+
+  char data[10000];
+  for (int i = 0; i < ARRAY_SIZE(data); i++) {
+    data[i] = (char)(i * 7);
+  }
+  fwrite(data, 1, sizeof(data), f);
+  fflush(f);
+
+  BLI_mmap_file *file = BLI_mmap_open(fileno(f));
+  /* The mapping must stay valid once the file is closed. */
+  fclose(f);
+  ASSERT_NE(nullptr, file);
+  EXPECT_EQ(sizeof(data), BLI_mmap_get_length(file));
+  EXPECT_EQ(0, memcmp(BLI_mmap_get_pointer(file), data, sizeof(data)));
+
+  char buf[100];
+  EXPECT_TRUE(BLI_mmap_read(file, buf, 5000, sizeof(buf)));
+  EXPECT_EQ(0, memcmp(buf, data + 5000, sizeof(buf)));
+  EXPECT_TRUE(BLI_mmap_read(file, buf, sizeof(data) - sizeof(buf), sizeof(buf)));
+  EXPECT_EQ(0, memcmp(buf, data + sizeof(data) - sizeof(buf), sizeof(buf)));
+
+  /* Reading past the end fails. */
+  EXPECT_FALSE(BLI_mmap_read(file, buf, sizeof(data) - 10, sizeof(buf)));
+  EXPECT_FALSE(BLI_mmap_read(file, buf, sizeof(data) + 10, 1));
+
+  BLI_mmap_free(file);
+}
+
+TEST(mmap, EmptyFile)
+{
+  FILE *f = tmpfile();
+  ASSERT_NE(nullptr, f);
+  EXPECT_EQ(nullptr, BLI_mmap_open(fileno(f)));
+  fclose(f);
+}
+
+#ifndef _WIN32
+TEST(mmap, TruncatedFile)
+{
+  FILE *f = tmpfile();
+  ASSERT_NE(nullptr, f);
+
+  static char data[1 << 16] = {1};
+  fwrite(data, 1, sizeof(data), f);
+  fflush(f);
+
+  BLI_mmap_file *file = BLI_mmap_open(fileno(f));
+  ASSERT_NE(nullptr, file);
+
+  /* Accessing pages beyond the new end raises SIGBUS, this must fail the read instead. */
+  ASSERT_EQ(0, ftruncate(fileno(f), 0));
+  char buf[16];
+  EXPECT_FALSE(BLI_mmap_read(file, buf, sizeof(data) - sizeof(buf), sizeof(buf)));
+
+  BLI_mmap_free(file);
+  fclose(f);
+}
+#endif
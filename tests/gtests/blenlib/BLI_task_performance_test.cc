@@ -122,6 +122,76 @@ TEST(task, RangeIter1000k)
   task_parallel_range_test_do("Range parallel iteration - Threaded - 1000K items", 1000000, true);
 }
 
+/* *** Nested parallel iterations over range of indices, with various amount of threads. *** */
+
+static void task_parallel_range_nested_func(void *userdata,
+                                            int index,
+                                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const int num_items = POINTER_AS_INT(userdata);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+
+  BLI_task_parallel_range(index, index + num_items, NULL, task_parallel_range_func, &settings);
+}
+
+static void task_parallel_range_nested_test_do(const char *id,
+                                               const int num_outer_items,
+                                               const int num_inner_items)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  const int num_threads_override = BLI_system_num_threads_override_get();
+
+  double single_thread_timing = 0.0;
+  for (int num_threads = 1; num_threads <= 128; num_threads *= 2) {
+    /* Re-create the scheduler with the requested amount of threads. */
+    BLI_system_num_threads_override_set(num_threads);
+    BLI_threadapi_init();
+
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = 1;
+
+    const double init_time = PIL_check_seconds_timer();
+    for (int i = 0; i < 10; i++) {
+      BLI_task_parallel_range(0,
+                              num_outer_items,
+                              POINTER_FROM_INT(num_inner_items),
+                              task_parallel_range_nested_func,
+                              &settings);
+    }
+    const double timing = (PIL_check_seconds_timer() - init_time) / 10;
+    if (num_threads == 1) {
+      single_thread_timing = timing;
+    }
+
+    printf("\t%3d threads: done in %fs on average over 10 runs (x%.2f speedup)\n",
+           num_threads,
+           timing,
+           single_thread_timing / timing);
+
+    BLI_threadapi_exit();
+  }
+
+  BLI_system_num_threads_override_set(num_threads_override);
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(task, RangeIterNested64x10k)
+{
+  task_parallel_range_nested_test_do(
+      "Nested range parallel iteration - 64 x 10K items", 64, 10000);
+}
+
+TEST(task, RangeIterNested1kx1k)
+{
+  task_parallel_range_nested_test_do(
+      "Nested range parallel iteration - 1K x 1K items", 1000, 1000);
+}
+
 /* *** Parallel iterations over double-linked list items. *** */
 
 static void task_listbase_light_iter_func(void *UNUSED(userdata),
@@ -137,6 +137,54 @@ TEST(task, RangeIterPool)
   BLI_threadapi_exit();
 }
 
+/* *** Nested parallel iterations over range of integer values. *** */
+
+#define NUM_NESTED_ITEMS 200
+
+static void task_range_nested_inner_func(void *userdata,
+                                         int index,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  int *data = (int *)userdata;
+  atomic_add_and_fetch_int32(&data[index], 1);
+}
+
+static void task_range_nested_outer_func(void *userdata,
+                                         int index,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  int(*data)[NUM_NESTED_ITEMS] = (int(*)[NUM_NESTED_ITEMS])userdata;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+
+  BLI_task_parallel_range(
+      0, NUM_NESTED_ITEMS, data[index], task_range_nested_inner_func, &settings);
+}
+
+TEST(task, RangeIterNested)
+{
+  static int data[NUM_NESTED_ITEMS][NUM_NESTED_ITEMS] = {{0}};
+
+  BLI_threadapi_init();
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+
+  BLI_task_parallel_range(0, NUM_NESTED_ITEMS, data, task_range_nested_outer_func, &settings);
+
+  /* Every item of every nested range is to be processed once, and only once. */
+  for (int i = 0; i < NUM_NESTED_ITEMS; i++) {
+    for (int j = 0; j < NUM_NESTED_ITEMS; j++) {
+      EXPECT_EQ(data[i][j], 1);
+    }
+  }
+
+  BLI_threadapi_exit();
+}
+
 /* *** Parallel iterations over mempool items. *** */
 
 static void task_mempool_iter_func(void *userdata, MempoolIterData *item)
@@ -17,7 +17,32 @@
  */
 #include "blendfile_loading_base_test.h"
 
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BKE_appdir.h"
+#include "BKE_customdata.h"
+#include "BKE_global.h"
+#include "BKE_main.h"
+#include "BKE_material.h"
+#include "BKE_mesh.h"
+
+#include "BLI_listbase.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+
+#include "BLO_readfile.h"
+#include "BLO_undofile.h"
+#include "BLO_writefile.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+}
+
 class BlendfileLoadingTest : public BlendfileLoadingBaseTest {
+ protected:
+  /* Writes a file with a large mesh and checks it reads back identically. */
+  void write_read_roundtrip(const int write_flags);
 };
 
 TEST_F(BlendfileLoadingTest, CanaryTest)
@@ -29,3 +54,152 @@ TEST_F(BlendfileLoadingTest, CanaryTest)
   depsgraph_create(DAG_EVAL_RENDER);
   EXPECT_NE(nullptr, this->depsgraph);
 }
+
+void BlendfileLoadingTest::write_read_roundtrip(const int write_flags)
+{
+  /* Large enough to span several compressed frames, so that reading exercises
+   * the frame window and seek table of the Zstandard reader when available. */
+  const int totvert = 300000;
+
+  Main *bmain = BKE_main_new();
+  Mesh *me = BKE_mesh_add(bmain, "RoundTripMesh");
+  me->totvert = totvert;
+  me->mvert = (MVert *)CustomData_add_layer(&me->vdata, CD_MVERT, CD_CALLOC, NULL, totvert);
+  for (int i = 0; i < totvert; i++) {
+    me->mvert[i].co[0] = (float)i;
+    me->mvert[i].co[1] = (float)(i % 97);
+    me->mvert[i].co[2] = -(float)i;
+  }
+
+  char filepath[FILE_MAX];
+  BLI_join_dirfile(filepath, sizeof(filepath), BKE_tempdir_session(), "roundtrip.blend");
+  BLI_strncpy(bmain->name, filepath, sizeof(bmain->name));
+
+  const bool write_ok = BLO_write_file(bmain, filepath, write_flags, NULL, NULL);
+  BKE_main_free(bmain);
+  ASSERT_TRUE(write_ok);
+
+  bfile = BLO_read_from_file(filepath, BLO_READ_SKIP_NONE, NULL);
+  ASSERT_NE(nullptr, bfile);
+
+  const Mesh *me_read = (const Mesh *)BLI_findstring(
+      &bfile->main->meshes, "MERoundTripMesh", offsetof(ID, name));
+  ASSERT_NE(nullptr, me_read);
+  ASSERT_EQ(totvert, me_read->totvert);
+  ASSERT_NE(nullptr, me_read->mvert);
+  int num_mismatch = 0;
+  for (int i = 0; i < totvert; i++) {
+    const float *co = me_read->mvert[i].co;
+    if (co[0] != (float)i || co[1] != (float)(i % 97) || co[2] != -(float)i) {
+      num_mismatch++;
+    }
+  }
+  EXPECT_EQ(0, num_mismatch);
+}
+
+TEST_F(BlendfileLoadingTest, CompressedWriteReadRoundTrip)
+{
+  write_read_roundtrip(G_FILE_COMPRESS | G_FILE_COMPRESS_ZSTD);
+}
+
+TEST_F(BlendfileLoadingTest, UncompressedWriteReadRoundTrip)
+{
+  /* Uncompressed files are read through a memory mapping. */
+  write_read_roundtrip(0);
+}
+
+static Mesh *undo_reuse_mesh_add(Main *bmain, const char *name, const float value)
+{
+  Mesh *me = BKE_mesh_add(bmain, name);
+  me->totvert = 16;
+  me->mvert = (MVert *)CustomData_add_layer(&me->vdata, CD_MVERT, CD_CALLOC, NULL, me->totvert);
+  me->mvert[0].co[0] = value;
+  return me;
+}
+
+TEST_F(BlendfileLoadingTest, MemfileUndoReuse)
+{
+  Main *bmain = BKE_main_new();
+  Mesh *me_static = undo_reuse_mesh_add(bmain, "Static", 1.0f);
+  Mesh *me_edit = undo_reuse_mesh_add(bmain, "Edit", 2.0f);
+  /* Materials are always read again, pointers to them from reused meshes must be updated. */
+  me_static->totcol = 1;
+  me_static->mat = (Material **)MEM_callocN(sizeof(*me_static->mat), __func__);
+  me_static->mat[0] = BKE_material_add(bmain, "Material");
+
+  MemFile memfile_a = {{NULL}};
+  MemFile memfile_b = {{NULL}};
+  ASSERT_TRUE(BLO_write_file_mem(bmain, NULL, &memfile_a, 0));
+  me_edit->mvert[0].co[0] = 3.0f;
+  ASSERT_TRUE(BLO_write_file_mem(bmain, &memfile_a, &memfile_b, 0));
+
+  /* Undo: the unchanged mesh is kept as is, the edited one is read again. */
+  BlendFileData *bfd_a = BLO_read_from_memfile(
+      bmain, "", &memfile_a, &memfile_b, BLO_READ_SKIP_NONE, NULL);
+  BKE_main_free(bmain);
+  ASSERT_NE(nullptr, bfd_a);
+  EXPECT_EQ(me_static, BLI_findstring(&bfd_a->main->meshes, "MEStatic", offsetof(ID, name)));
+  EXPECT_EQ(bfd_a->main->materials.first, me_static->mat[0]);
+  const Mesh *me_edit_a = (const Mesh *)BLI_findstring(
+      &bfd_a->main->meshes, "MEEdit", offsetof(ID, name));
+  ASSERT_NE(nullptr, me_edit_a);
+  EXPECT_EQ(2.0f, me_edit_a->mvert[0].co[0]);
+
+  /* Redo: the memfile read is now the reference, its addresses don't match the memory anymore. */
+  BlendFileData *bfd_b = BLO_read_from_memfile(
+      bfd_a->main, "", &memfile_b, &memfile_a, BLO_READ_SKIP_NONE, NULL);
+  BLO_blendfiledata_free(bfd_a);
+  ASSERT_NE(nullptr, bfd_b);
+  EXPECT_EQ(me_static, BLI_findstring(&bfd_b->main->meshes, "MEStatic", offsetof(ID, name)));
+  EXPECT_EQ(bfd_b->main->materials.first, me_static->mat[0]);
+  const Mesh *me_edit_b = (const Mesh *)BLI_findstring(
+      &bfd_b->main->meshes, "MEEdit", offsetof(ID, name));
+  ASSERT_NE(nullptr, me_edit_b);
+  EXPECT_EQ(3.0f, me_edit_b->mvert[0].co[0]);
+  BLO_blendfiledata_free(bfd_b);
+
+  BLO_memfile_free(&memfile_a);
+  BLO_memfile_free(&memfile_b);
+}
+
+TEST(memfile, ChunkSharing)
+{
+  char data[3][1024];
+  for (int i = 0; i < 3; i++) {
+    memset(data[i], 'a' + i, sizeof(data[i]));
+  }
+
+  MemFile memfile_a = {{NULL}};
+  MemFileChunk *compchunk = NULL;
+  for (int i = 0; i < 3; i++) {
+    memfile_chunk_add(&memfile_a, data[i], sizeof(data[i]), &compchunk, NULL);
+  }
+  EXPECT_EQ(3 * sizeof(data[0]), memfile_a.size);
+
+  /* Insert a chunk at the start, shifting all others: only the new chunk uses memory. */
+  char data_new[512];
+  memset(data_new, 'x', sizeof(data_new));
+  MemFile memfile_b = {{NULL}};
+  compchunk = (MemFileChunk *)memfile_a.chunks.first;
+  memfile_chunk_add(&memfile_b, data_new, sizeof(data_new), &compchunk, NULL);
+  for (int i = 0; i < 3; i++) {
+    memfile_chunk_add(&memfile_b, data[i], sizeof(data[i]), &compchunk, NULL);
+  }
+  EXPECT_EQ(sizeof(data_new), memfile_b.size);
+
+  MemFileChunkStats stats;
+  BLO_memfile_chunk_stats_get(&stats);
+  EXPECT_EQ(4, stats.num_buffers);
+  EXPECT_EQ(3 * sizeof(data[0]) + sizeof(data_new), stats.size_buffers);
+  EXPECT_EQ(7, stats.num_chunks);
+
+  /* Shared memory stays valid when the memfile that added it is freed. */
+  BLO_memfile_merge(&memfile_a, &memfile_b);
+  const MemFileChunk *chunk = (const MemFileChunk *)memfile_b.chunks.last;
+  EXPECT_EQ(0, memcmp(chunk->buf, data[2], sizeof(data[2])));
+
+  BLO_memfile_free(&memfile_b);
+  BLO_memfile_chunk_stats_get(&stats);
+  EXPECT_EQ(0, stats.num_buffers);
+  EXPECT_EQ(0, stats.size_chunks);
+}
@@ -0,0 +1,39 @@
+/* Apache License, Version 2.0 */
+
+#include "depsgraph_build_test_base.h"
+
+extern "C" {
+#include "BKE_global.h"
+
+#include "PIL_time.h"
+}
+
+#define NUM_RUN_AVERAGED 5
+
+class DepsgraphBuildPerformanceTest : public DepsgraphBuildTestBase {
+ protected:
+  double depsgraph_build_time()
+  {
+    double time = 0.0;
+    for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+      const double time_start = PIL_check_seconds_timer();
+      Depsgraph *graph = depsgraph_build();
+      time += PIL_check_seconds_timer() - time_start;
+      DEG_graph_free(graph);
+    }
+    return time / NUM_RUN_AVERAGED;
+  }
+};
+
+TEST_F(DepsgraphBuildPerformanceTest, Objects)
+{
+  /* Print the time spent in every build step. */
+  const int debug = G.debug;
+  G.debug |= G_DEBUG_DEPSGRAPH_TIME;
+  for (int num_objects : {1000, 10000, 50000}) {
+    scene_create(num_objects);
+    printf("\t%d objects: %fs\n", num_objects, depsgraph_build_time());
+    scene_free();
+  }
+  G.debug = debug;
+}
@@ -0,0 +1,104 @@
+/* Apache License, Version 2.0 */
+
+#include "depsgraph_build_test_base.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "BLI_threads.h"
+
+#include "BKE_global.h"
+
+#include "DEG_depsgraph_debug.h"
+}
+
+#include "intern/depsgraph.h"
+#include "intern/depsgraph_relation.h"
+#include "intern/node/deg_node_operation.h"
+#include "intern/node/deg_node_time.h"
+
+/* More bases than needed for the relations to be built in parallel. */
+#define NUM_OBJECTS 2000
+#define NUM_THREADS 8
+
+class DepsgraphBuildTest : public DepsgraphBuildTestBase {
+ public:
+  /* Build on several threads, also on machines with fewer cores. The task scheduler is created
+   * with this number of threads on first use. */
+  static void SetUpTestCase()
+  {
+    BLI_system_num_threads_override_set(NUM_THREADS);
+    DepsgraphBuildTestBase::SetUpTestCase();
+  }
+
+ protected:
+  static std::string relation_identifier(const DEG::Relation *rel)
+  {
+    std::string from = rel->from->identifier();
+    if (rel->from->type == DEG::NodeType::OPERATION) {
+      from = static_cast<const DEG::OperationNode *>(rel->from)->full_identifier();
+    }
+    const DEG::OperationNode *to = static_cast<const DEG::OperationNode *>(rel->to);
+    return from + " -> " + to->full_identifier();
+  }
+
+  /* All relations of the graph, sorted, so graphs which only differ in the order the relations
+   * were added in compare equal. */
+  static std::vector<std::string> depsgraph_relations(Depsgraph *graph)
+  {
+    DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
+    std::vector<std::string> relations;
+    std::vector<DEG::Node *> nodes(deg_graph->operations.begin(), deg_graph->operations.end());
+    nodes.push_back(deg_graph->time_source);
+    for (DEG::Node *node : nodes) {
+      for (DEG::Relation *rel : node->outlinks) {
+        relations.push_back(relation_identifier(rel) + " (" + rel->name + ", " +
+                            std::to_string(rel->flag) + ")");
+      }
+    }
+    std::sort(relations.begin(), relations.end());
+    return relations;
+  }
+
+  std::vector<std::string> depsgraph_relations_build(bool threaded)
+  {
+    const int debug = G.debug;
+    if (!threaded) {
+      G.debug |= G_DEBUG_DEPSGRAPH_NO_THREADS;
+    }
+    Depsgraph *graph = depsgraph_build();
+    G.debug = debug;
+    EXPECT_TRUE(DEG_debug_consistency_check(graph));
+    std::vector<std::string> relations = depsgraph_relations(graph);
+    DEG_graph_free(graph);
+    return relations;
+  }
+};
+
+TEST_F(DepsgraphBuildTest, ThreadedRelations)
+{
+  scene_create(NUM_OBJECTS);
+  const std::vector<std::string> relations = depsgraph_relations_build(false);
+  EXPECT_GT(relations.size(), NUM_OBJECTS);
+  EXPECT_EQ(depsgraph_relations_build(true), relations);
+}
+
+/* Relations are sorted after a threaded build, the order must not depend on scheduling. */
+TEST_F(DepsgraphBuildTest, ThreadedRelationsOrder)
+{
+  scene_create(NUM_OBJECTS);
+  std::vector<std::string> orders[2];
+  for (std::vector<std::string> &order : orders) {
+    Depsgraph *graph = depsgraph_build();
+    DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
+    for (DEG::OperationNode *op_node : deg_graph->operations) {
+      for (DEG::Relation *rel : op_node->outlinks) {
+        order.push_back(relation_identifier(rel));
+      }
+    }
+    DEG_graph_free(graph);
+  }
+  EXPECT_EQ(orders[0], orders[1]);
+}
@@ -0,0 +1,94 @@
+/* Apache License, Version 2.0 */
+
+#ifndef __DEPSGRAPH_BUILD_TEST_BASE_H__
+#define __DEPSGRAPH_BUILD_TEST_BASE_H__
+
+#include "blendfile_loading_base_test.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_listbase.h"
+#include "BLI_string.h"
+
+#include "BKE_collection.h"
+#include "BKE_lib_id.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BKE_modifier.h"
+#include "BKE_object.h"
+#include "BKE_scene.h"
+
+#include "DNA_collection_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "DEG_depsgraph_build.h"
+}
+
+class DepsgraphBuildTestBase : public BlendfileLoadingBaseTest {
+ protected:
+  Main *bmain = nullptr;
+  Scene *scene = nullptr;
+
+  void TearDown() override
+  {
+    scene_free();
+    BlendfileLoadingBaseTest::TearDown();
+  }
+
+  /* Objects with a mesh and a modifier, every other one parented to the previous one and every
+   * third one sharing the mesh of the previous one. Objects are linked to the collection
+   * directly, adding them one by one would sync the view layer every time. */
+  void scene_create(const int num_objects)
+  {
+    bmain = BKE_main_new();
+    scene = BKE_scene_add(bmain, "Scene");
+    Collection *collection = BKE_collection_add(bmain, nullptr, "Collection");
+
+    Object *ob_prev = nullptr;
+    for (int i = 0; i < num_objects; i++) {
+      char name[MAX_ID_NAME - 2];
+      BLI_snprintf(name, sizeof(name), "%d", i);
+      Object *ob = BKE_object_add_only_object(bmain, OB_MESH, name);
+      if (i % 3 == 2) {
+        ob->data = ob_prev->data;
+        id_us_plus((ID *)ob->data);
+      }
+      else {
+        ob->data = BKE_mesh_add(bmain, name);
+      }
+      BLI_addtail(&ob->modifiers, modifier_new(eModifierType_Subsurf));
+      if (i % 2) {
+        ob->parent = ob_prev;
+      }
+      ob_prev = ob;
+
+      CollectionObject *cob = (CollectionObject *)MEM_callocN(sizeof(CollectionObject), __func__);
+      cob->ob = ob;
+      BLI_addtail(&collection->gobject, cob);
+      id_us_plus(&ob->id);
+    }
+    BKE_collection_child_add(bmain, scene->master_collection, collection);
+  }
+
+  void scene_free()
+  {
+    if (bmain != nullptr) {
+      BKE_main_free(bmain);
+      bmain = nullptr;
+      scene = nullptr;
+    }
+  }
+
+  Depsgraph *depsgraph_build()
+  {
+    ViewLayer *view_layer = (ViewLayer *)scene->view_layers.first;
+    Depsgraph *graph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_VIEWPORT);
+    DEG_graph_build_from_view_layer(graph, bmain, scene, view_layer);
+    return graph;
+  }
+};
+
+#endif /* __DEPSGRAPH_BUILD_TEST_BASE_H__ */
@@ -0,0 +1,160 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <ImfChannelList.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfMultiPartOutputFile.h>
+#include <ImfOutputPart.h>
+#include <ImfStandardAttributes.h>
+#include <ImfStringAttribute.h>
+
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_fileops.h"
+#include "BLI_path_util.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_appdir.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+#include "openexr/openexr_multi.h"
+}
+
+#define WIDTH 7
+#define HEIGHT 5
+#define NUM_PARTS 2
+#define NUM_CHANNELS 5
+
+static const char *exr_views[NUM_PARTS] = {"left", "right"};
+/* The Combined pass followed by the Depth pass. */
+static const char *exr_channels[NUM_CHANNELS] = {
+    "RenderLayer.Combined.R",
+    "RenderLayer.Combined.G",
+    "RenderLayer.Combined.B",
+    "RenderLayer.Combined.A",
+    "RenderLayer.Depth.Z",
+};
+
+class ImbufOpenEXRTest : public testing::Test {
+ protected:
+  static void SetUpTestCase()
+  {
+    BLI_threadapi_init();
+    IMB_init();
+    BKE_tempdir_init(NULL);
+  }
+
+  static void TearDownTestCase()
+  {
+    BKE_tempdir_session_purge();
+    IMB_exit();
+    BLI_threadapi_exit();
+  }
+};
+
+/* Different for every pixel, channel and view, so that mixed up buffers are noticed. */
+static float exr_test_value(int part, int channel, int x, int y)
+{
+  return part * 1000.0f + channel * 100.0f + y * 10.0f + x;
+}
+
+/* A multilayer file with a part per view, each with the Combined and Depth passes of a layer. */
+static void exr_test_file_write(const char *filepath)
+{
+  std::vector<Imf::Header> headers;
+
+  for (int part = 0; part < NUM_PARTS; part++) {
+    Imf::Header header(WIDTH, HEIGHT);
+    header.setName(exr_views[part]);
+    header.setType(Imf::SCANLINEIMAGE);
+    header.setView(exr_views[part]);
+    header.insert("BlenderMultiChannel", Imf::StringAttribute("Blender V2.55.1 and newer"));
+    for (const char *channel : exr_channels) {
+      header.channels().insert(channel, Imf::Channel(Imf::FLOAT));
+    }
+    headers.push_back(header);
+  }
+
+  Imf::MultiPartOutputFile file(filepath, headers.data(), NUM_PARTS);
+  std::vector<float> pixels(NUM_CHANNELS * WIDTH * HEIGHT);
+
+  for (int part = 0; part < NUM_PARTS; part++) {
+    Imf::FrameBuffer frame_buffer;
+    for (int channel = 0; channel < NUM_CHANNELS; channel++) {
+      float *rect = &pixels[channel * WIDTH * HEIGHT];
+      for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+          rect[y * WIDTH + x] = exr_test_value(part, channel, x, y);
+        }
+      }
+      frame_buffer.insert(
+          exr_channels[channel],
+          Imf::Slice(Imf::FLOAT, (char *)rect, sizeof(float), sizeof(float) * WIDTH));
+    }
+
+    Imf::OutputPart out(file, part);
+    out.setFrameBuffer(frame_buffer);
+    out.writePixels(HEIGHT);
+  }
+}
+
+/* Passes are stored bottom to top in Blender, files are top to bottom. */
+static void exr_test_pass_check(const float *rect, int totchan, int part, int first_channel)
+{
+  for (int y = 0; y < HEIGHT; y++) {
+    for (int x = 0; x < WIDTH; x++) {
+      const float *pixel = rect + ((HEIGHT - 1 - y) * WIDTH + x) * totchan;
+      for (int c = 0; c < totchan; c++) {
+        EXPECT_EQ(pixel[c], exr_test_value(part, first_channel + c, x, y));
+      }
+    }
+  }
+}
+
+TEST_F(ImbufOpenEXRTest, ReadPassMultiPart)
+{
+  char filepath[FILE_MAX];
+  char colorspace[IM_MAX_SPACE] = "";
+  BLI_join_dirfile(filepath, sizeof(filepath), BKE_tempdir_session(), "multipart.exr");
+  exr_test_file_write(filepath);
+
+  ImBuf *ibuf = IMB_loadiffname(
+      filepath, IB_rect | IB_multilayer | IB_multilayer_lazy, colorspace);
+  ASSERT_NE(ibuf, nullptr);
+  void *handle = ibuf->userdata;
+  ASSERT_NE(handle, nullptr);
+
+  for (int part = 0; part < NUM_PARTS; part++) {
+    float *combined = IMB_exr_read_pass(handle, "RenderLayer", "Combined", exr_views[part]);
+    ASSERT_NE(combined, nullptr);
+    exr_test_pass_check(combined, 4, part, 0);
+    MEM_freeN(combined);
+
+    float *depth = IMB_exr_read_pass(handle, "RenderLayer", "Depth", exr_views[part]);
+    ASSERT_NE(depth, nullptr);
+    exr_test_pass_check(depth, 1, part, 4);
+    MEM_freeN(depth);
+  }
+
+  /* Reading a pass again gives the same result. */
+  float *combined = IMB_exr_read_pass(handle, "RenderLayer", "Combined", "right");
+  ASSERT_NE(combined, nullptr);
+  exr_test_pass_check(combined, 4, 1, 0);
+  MEM_freeN(combined);
+
+  EXPECT_EQ(IMB_exr_read_pass(handle, "RenderLayer", "Normal", "left"), nullptr);
+  EXPECT_EQ(IMB_exr_read_pass(handle, "ViewLayer", "Combined", "left"), nullptr);
+
+  IMB_exr_close(handle);
+  ibuf->userdata = NULL;
+  IMB_freeImBuf(ibuf);
+  BLI_delete(filepath, false, false);
+}
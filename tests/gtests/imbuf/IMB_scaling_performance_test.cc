@@ -0,0 +1,201 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_math.h"
+#include "BLI_math_interp.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+#include "PIL_time.h"
+}
+
+#define NUM_RUN_AVERAGED 5
+
+/* Scaling runs in the task scheduler, freeing buffers uses the lock of their reference count. */
+class ImbufScalingTest : public testing::Test {
+ protected:
+  static void SetUpTestCase()
+  {
+    BLI_threadapi_init();
+    IMB_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    IMB_exit();
+    BLI_threadapi_exit();
+  }
+};
+
+static const char *scale_filter_names[] = {"default", "box", "bilinear", "bicubic", "lanczos"};
+
+/* Gradients with some detail, so that filters give different results. */
+static ImBuf *scaling_test_ibuf_create(const int x, const int y, const bool use_float)
+{
+  ImBuf *ibuf = IMB_allocImBuf(x, y, 32, use_float ? IB_rectfloat : IB_rect);
+
+  for (int j = 0; j < y; j++) {
+    for (int i = 0; i < x; i++) {
+      float color[4];
+      color[0] = (float)i / (float)x;
+      color[1] = (float)j / (float)y;
+      color[2] = 0.5f + 0.5f * sinf((float)(i + j) * 0.1f);
+      color[3] = 1.0f;
+
+      const size_t offset = ((size_t)j * x + i) * 4;
+      if (use_float) {
+        copy_v4_v4(ibuf->rect_float + offset, color);
+      }
+      else {
+        rgba_float_to_uchar((unsigned char *)ibuf->rect + offset, color);
+      }
+    }
+  }
+  return ibuf;
+}
+
+/* Single threaded reference, sampling the source bilinearly at every new pixel.
+ * Coordinates are clamped, like the filter weights are normalized at the borders. */
+static float *scaling_reference(ImBuf *ibuf, const int newx, const int newy)
+{
+  float *rect_float = (float *)MEM_malloc_arrayN(
+      (size_t)newx * newy, sizeof(float[4]), __func__);
+  const float factor_x = (float)ibuf->x / newx;
+  const float factor_y = (float)ibuf->y / newy;
+
+  for (int j = 0; j < newy; j++) {
+    for (int i = 0; i < newx; i++) {
+      BLI_bilinear_interpolation_fl(ibuf->rect_float,
+                                    rect_float + ((size_t)j * newx + i) * 4,
+                                    ibuf->x,
+                                    ibuf->y,
+                                    4,
+                                    clamp_f((i + 0.5f) * factor_x - 0.5f, 0.0f, ibuf->x - 1),
+                                    clamp_f((j + 0.5f) * factor_y - 0.5f, 0.0f, ibuf->y - 1));
+    }
+  }
+
+  return rect_float;
+}
+
+/* Largest difference of the scaled buffer with the reference, ignoring \a border pixels at the
+ * edges. */
+static float scaling_reference_diff(const ImBuf *ibuf, const float *reference, const int border)
+{
+  float diff = 0.0f;
+  for (int j = border; j < ibuf->y - border; j++) {
+    for (int i = border; i < ibuf->x - border; i++) {
+      const size_t offset = ((size_t)j * ibuf->x + i) * 4;
+      for (int c = 0; c < 4; c++) {
+        const float value = ibuf->rect_float ?
+                                ibuf->rect_float[offset + c] :
+                                ((unsigned char *)ibuf->rect)[offset + c] / 255.0f;
+        diff = max_ff(diff, fabsf(value - reference[offset + c]));
+      }
+    }
+  }
+  return diff;
+}
+
+static void scaling_test_do(const int x,
+                            const int y,
+                            const int newx,
+                            const int newy,
+                            const bool use_float)
+{
+  ImBuf *ibuf_orig = scaling_test_ibuf_create(x, y, true);
+  float *reference = NULL;
+  double timing_ref = 0.0;
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    MEM_SAFE_FREE(reference);
+    const double init_time = PIL_check_seconds_timer();
+    reference = scaling_reference(ibuf_orig, newx, newy);
+    timing_ref += PIL_check_seconds_timer() - init_time;
+  }
+  IMB_freeImBuf(ibuf_orig);
+
+  printf("\t%dx%d to %dx%d %s: single threaded bilinear reference %fs\n",
+         x,
+         y,
+         newx,
+         newy,
+         use_float ? "float" : "byte",
+         timing_ref / NUM_RUN_AVERAGED);
+
+  /* When shrinking the bilinear filter is stretched over more source pixels than the reference
+   * samples, which shifts the weights of the pixels at the edges. Byte buffers add rounding of
+   * the source and result. */
+  const int border = (newx < x) ? 1 : 0;
+  const float limit = ((newx < x) ? 1e-2f : 1e-4f) + (use_float ? 0.0f : 2.0f / 255.0f);
+
+  ibuf_orig = scaling_test_ibuf_create(x, y, use_float);
+  for (int filter = IMB_SCALE_FILTER_DEFAULT; filter <= IMB_SCALE_FILTER_LANCZOS; filter++) {
+    double timing = 0.0;
+    for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+      ImBuf *ibuf = IMB_dupImBuf(ibuf_orig);
+      const double init_time = PIL_check_seconds_timer();
+      EXPECT_TRUE(IMB_scaleImBuf_filter(ibuf, newx, newy, (IMB_ScaleFilter)filter));
+      timing += PIL_check_seconds_timer() - init_time;
+
+      EXPECT_EQ(newx, ibuf->x);
+      EXPECT_EQ(newy, ibuf->y);
+      if (filter == IMB_SCALE_FILTER_BILINEAR && i == 0) {
+        EXPECT_LT(scaling_reference_diff(ibuf, reference, border), limit);
+      }
+      IMB_freeImBuf(ibuf);
+    }
+    printf("\t\t%s %fs (x%.2f)\n",
+           scale_filter_names[filter],
+           timing / NUM_RUN_AVERAGED,
+           timing_ref / timing);
+  }
+  IMB_freeImBuf(ibuf_orig);
+  MEM_freeN(reference);
+}
+
+/* Weights are normalized, a constant image stays constant with every filter. */
+TEST_F(ImbufScalingTest, ConstantColor)
+{
+  const float color[4] = {0.2f, 0.4f, 0.6f, 1.0f};
+  for (int filter = IMB_SCALE_FILTER_DEFAULT; filter <= IMB_SCALE_FILTER_LANCZOS; filter++) {
+    ImBuf *ibuf = IMB_allocImBuf(97, 61, 32, IB_rect | IB_rectfloat);
+    IMB_rectfill(ibuf, color);
+
+    EXPECT_TRUE(IMB_scaleImBuf_filter(ibuf, 250, 23, (IMB_ScaleFilter)filter));
+    for (int i = 0; i < ibuf->x * ibuf->y; i++) {
+      const float *color_float = ibuf->rect_float + i * 4;
+      unsigned char color_byte[4];
+      rgba_float_to_uchar(color_byte, color);
+      EXPECT_V4_NEAR(color, color_float, 1e-5f);
+      EXPECT_EQ(0, memcmp(color_byte, (unsigned char *)(ibuf->rect + i), sizeof(color_byte)));
+    }
+    IMB_freeImBuf(ibuf);
+  }
+}
+
+TEST_F(ImbufScalingTest, Downscale4KByte)
+{
+  scaling_test_do(3840, 2160, 1920, 1080, false);
+}
+
+TEST_F(ImbufScalingTest, Downscale4KFloat)
+{
+  scaling_test_do(3840, 2160, 1920, 1080, true);
+}
+
+TEST_F(ImbufScalingTest, UpscaleHDByte)
+{
+  scaling_test_do(1920, 1080, 3840, 2160, false);
+}
+
+TEST_F(ImbufScalingTest, UpscaleHDFloat)
+{
+  scaling_test_do(1920, 1080, 3840, 2160, true);
+}